@@ -49,26 +49,49 @@ BufferPoolManagerInstance::~BufferPoolManagerInstance() {
 
 bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
-  if(!page_table_.count(page_id))
+  std::lock_guard<std::mutex> guard(latch_);
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end()) {
     return false;
-  Page* pg = &pages_[page_table_[page_id]];
-  if(pg->is_dirty_){
-    this->disk_manager_->WritePage(pg->page_id_,pg->data_);
-    pg->is_dirty_ = false;
   }
+  Page *pg = &pages_[iter->second];
+  disk_manager_->WritePage(pg->page_id_, pg->data_);
+  pg->is_dirty_ = false;
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
   std::lock_guard<std::mutex> guard(latch_);
-  for(size_t i = 0;i!=pool_size_;i++){
-    if(pages_[i].is_dirty_){
-      this->disk_manager_->WritePage(pages_[i].page_id_,pages_[i].data_);
+  for (size_t i = 0; i != pool_size_; i++) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].is_dirty_) {
+      disk_manager_->WritePage(pages_[i].page_id_, pages_[i].data_);
       pages_[i].is_dirty_ = false;
     }
   }
 }
 
+bool BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id) {
+  //从没有用过的列表中取frame
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  //从LRU中淘汰取frame，所有页面均被pin住时失败
+  if (!replacer_->Victim(frame_id)) {
+    return false;
+  }
+  Page *frame = &pages_[*frame_id];
+  BUSTUB_ASSERT(frame->pin_count_ == 0, "victim frame must not be pinned");
+  //Victim后刷盘,lazy刷盘策略
+  if (frame->is_dirty_) {
+    disk_manager_->WritePage(frame->page_id_, frame->data_);
+    frame->is_dirty_ = false;
+  }
+  page_table_.erase(frame->page_id_);
+  return true;
+}
+
 Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
   // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
@@ -77,31 +100,18 @@ Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
   // 4.   Set the page ID output parameter. Return a pointer to P.
   //guard在构造时自动加锁，在析构时解锁，就避免了因为异常处理导致未解锁
   std::lock_guard<std::mutex> guard(latch_);
-  page_id_t new_pg_id = AllocatePage();
-  Page* frame = nullptr;
   frame_id_t frame_id;
-  *page_id = new_pg_id;
-  if(!free_list_.empty()){
-    //从没有用过的列表中取frame
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-    frame = &pages_[frame_id];
-  } else if(replacer_->Size()!=0){
-    //从LRU中淘汰取frame
-    replacer_->Victim(&frame_id);
-    frame = &pages_[frame_id];
-    FlushPgImp(frame->GetPageId()); //Victim后刷盘,lazy刷盘策略
-    //reuse
-    page_table_.erase(frame->page_id_);
-    assert(frame->pin_count_==0);
-    frame->ResetMemory();
-  }else{
-    //所有页面均被pin住
+  if (!AcquireFrame(&frame_id)) {
     return nullptr;
   }
-  //设置page_tables_,pin住页面返回
-  frame->page_id_ = new_pg_id;
-  page_table_[new_pg_id] = frame_id;
+  // only allocate once a frame is available, so a full pool does not leak page ids
+  *page_id = AllocatePage();
+  Page *frame = &pages_[frame_id];
+  frame->ResetMemory();
+  frame->page_id_ = *page_id;
+  frame->pin_count_ = 1;
+  frame->is_dirty_ = false;
+  page_table_[*page_id] = frame_id;
   replacer_->Pin(frame_id);
   return frame;
 }
@@ -114,45 +124,26 @@ Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  //相比NewPgImp首先要判断是否在内存中
-  //pin_count++?
-  //拿出frame的逻辑是一样的
-  //相比NewPgImp拿出之后要从磁盘读
   std::lock_guard<std::mutex> guard(latch_);
-  Page* frame = nullptr;
-  if(page_table_.count(page_id)){
-    //TODO 是否要pincount++
-    frame_id_t frame_id=page_table_[page_id];
-    replacer_->Pin(frame_id);
-    frame = &pages_[frame_id];
-  }else{
-    //这段代码和NewPgImp中的逻辑是一样的
-    frame_id_t frame_id;
-    if(!free_list_.empty()){
-      //从没有用过的列表中取frame
-      frame_id = free_list_.front();
-      free_list_.pop_front();
-      frame = &pages_[frame_id];
-    } else if(replacer_->Size()!=0){
-      //从LRU中淘汰取frame
-      replacer_->Victim(&frame_id);
-      frame = &pages_[frame_id];
-      FlushPgImp(frame->GetPageId()); //Victim后刷盘,lazy刷盘策略
-      //reuse
-      page_table_.erase(frame->page_id_);
-      assert(frame->pin_count_==0);
-      frame->ResetMemory();
-    }else{
-      //所有页面均被pin住
-      return nullptr;
-    }
-    //设置page_tables_,pin住页面返回
-    frame->page_id_ = page_id;
-    page_table_[page_id] = frame_id;
-    replacer_->Pin(frame_id);
-    //从磁盘读
-    disk_manager_->ReadPage(page_id,frame->data_);
+  auto iter = page_table_.find(page_id);
+  if (iter != page_table_.end()) {
+    Page *frame = &pages_[iter->second];
+    frame->pin_count_++;
+    replacer_->Pin(iter->second);
+    return frame;
   }
+  frame_id_t frame_id;
+  if (!AcquireFrame(&frame_id)) {
+    return nullptr;
+  }
+  //设置page_tables_,pin住页面后从磁盘读
+  Page *frame = &pages_[frame_id];
+  frame->page_id_ = page_id;
+  frame->pin_count_ = 1;
+  frame->is_dirty_ = false;
+  page_table_[page_id] = frame_id;
+  replacer_->Pin(frame_id);
+  disk_manager_->ReadPage(page_id, frame->data_);
   return frame;
 }
 
@@ -163,16 +154,20 @@ bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
   std::lock_guard<std::mutex> guard(latch_);
-  if(!page_table_.count(page_id))
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end()) {
+    DeallocatePage(page_id);
     return true;
-  DeallocatePage(page_id);
-  frame_id_t frame_id = page_table_[page_id];
-  Page* frame = &pages_[frame_id];
-  if(frame->pin_count_!=0)
+  }
+  frame_id_t frame_id = iter->second;
+  Page *frame = &pages_[frame_id];
+  if (frame->pin_count_ != 0) {
     return false;
-  //删除页面
-  //TODO disk上的删除
-  page_table_.erase(page_id);
+  }
+  DeallocatePage(page_id);
+  page_table_.erase(iter);
+  // the frame goes back to the free list, so the replacer must stop tracking it
+  replacer_->Pin(frame_id);
   frame->ResetMemory();
   frame->is_dirty_ = false;
   frame->page_id_ = INVALID_PAGE_ID;
@@ -180,22 +175,31 @@ bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
   return true;
 }
 
-bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) { 
-  //会在pincount为0的时候被调用
+bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   //unpin的时候不刷盘
   //dirty参数表示这个page在pin住的过程中有没有被修改
   std::lock_guard<std::mutex> guard(latch_);
-  if(!page_table_.count(page_id))
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end()) {
+    return false;
+  }
+  Page *frame = &pages_[iter->second];
+  if (frame->pin_count_ <= 0) {
     return false;
-  frame_id_t frame_id = page_table_[page_id];
-  // if(pages_[frame_id].pin_count_<=0)
-  //   return false;
-  pages_[frame_id].is_dirty_ = is_dirty;
-  replacer_->Unpin(frame_id);
+  }
+  frame->is_dirty_ = frame->is_dirty_ || is_dirty;
+  if (--frame->pin_count_ == 0) {
+    replacer_->Unpin(iter->second);
+  }
   return true;
 }
 
 page_id_t BufferPoolManagerInstance::AllocatePage() {
+  if (!free_page_ids_.empty()) {
+    const page_id_t page_id = *free_page_ids_.begin();
+    free_page_ids_.erase(free_page_ids_.begin());
+    return page_id;
+  }
   const page_id_t next_page_id = next_page_id_;
   next_page_id_ += num_instances_;
   ValidatePageId(next_page_id);
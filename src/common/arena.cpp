@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena.cpp
+//
+// Identification: src/common/arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/arena.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bustub {
+
+Arena::Arena(Arena &&other) noexcept
+    : initial_block_size_(other.initial_block_size_),
+      next_block_size_(other.next_block_size_),
+      blocks_(std::move(other.blocks_)),
+      cursor_(other.cursor_),
+      end_(other.end_),
+      memory_usage_(other.memory_usage_) {
+  other.Reset();
+}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+  if (this != &other) {
+    initial_block_size_ = other.initial_block_size_;
+    next_block_size_ = other.next_block_size_;
+    blocks_ = std::move(other.blocks_);
+    cursor_ = other.cursor_;
+    end_ = other.end_;
+    memory_usage_ = other.memory_usage_;
+    other.Reset();
+  }
+  return *this;
+}
+
+void Arena::Reset() {
+  blocks_.clear();
+  next_block_size_ = 0;
+  cursor_ = nullptr;
+  end_ = nullptr;
+  memory_usage_ = 0;
+}
+
+/*
+ * The rest of the current block is given up; with blocks doubling, that is
+ * a small share of the memory held.
+ */
+void *Arena::AllocateSlow(size_t size, size_t alignment) {
+  if (next_block_size_ == 0) {
+    next_block_size_ = initial_block_size_;
+  }
+  // new[] aligns a block only to the default new alignment, so leave room to align inside it
+  const size_t block_size = std::max(next_block_size_, size + alignment);
+  next_block_size_ = std::min(next_block_size_ * 2, MAX_BLOCK_SIZE);
+  blocks_.emplace_back(new char[block_size]);
+  memory_usage_ += block_size;
+  cursor_ = blocks_.back().get();
+  end_ = cursor_ + block_size;
+  return Allocate(size, alignment);
+}
+
+}  // namespace bustub
@@ -0,0 +1,48 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_util.cpp
+//
+// Identification: src/common/util/thread_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <exception>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/util/thread_util.h"
+
+namespace bustub {
+
+void ThreadUtil::RunWorkers(uint32_t num_threads, const std::function<void(uint32_t worker)> &work) {
+  std::mutex error_latch;
+  std::exception_ptr error;
+  auto run = [&](uint32_t worker) {
+    try {
+      work(worker);
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(error_latch);
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> helpers;
+  for (uint32_t worker = 1; worker < num_threads; worker++) {
+    helpers.emplace_back(run, worker);
+  }
+  run(0);
+  for (auto &helper : helpers) {
+    helper.join();
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bucket_bloom_filters.cpp
+//
+// Identification: src/container/hash/bucket_bloom_filters.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/bucket_bloom_filters.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace bustub {
+
+/*
+ * The same odd multipliers as the split block Bloom filter of Parquet, each
+ * one picks a bit of its word from the top six bits of the product.
+ */
+uint64_t BlockedBloomFilter::BitOf(uint32_t hash, size_t i) {
+  static constexpr uint32_t SALT[WORDS_PER_BLOCK] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                     0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+  return uint64_t{1} << ((hash * SALT[i]) >> 26);
+}
+
+void BlockedBloomFilter::Insert(uint32_t hash) {
+  std::atomic<uint64_t> *block = &words_[BlockOf(hash) * WORDS_PER_BLOCK];
+  for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+    block[i].fetch_or(BitOf(hash, i), std::memory_order_relaxed);
+  }
+}
+
+bool BlockedBloomFilter::MayContain(uint32_t hash) const {
+  const std::atomic<uint64_t> *block = &words_[BlockOf(hash) * WORDS_PER_BLOCK];
+  for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+    const uint64_t bit = BitOf(hash, i);
+    if ((block[i].load(std::memory_order_relaxed) & bit) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+BucketBloomFilters::BucketBloomFilters(size_t budget_bytes, size_t bucket_capacity)
+    : budget_bytes_(budget_bytes), bucket_capacity_(bucket_capacity), filters_(1) {
+  Rebuild(0, 1, 0, {});
+}
+
+bool BucketBloomFilters::MayContain(uint64_t hash) {
+  latch_.RLock();
+  const BlockedBloomFilter *filter = filters_[hash & (filters_.size() - 1)].get();
+  const bool may_contain = filter == nullptr || filter->MayContain(FilterHash(hash));
+  latch_.RUnlock();
+  if (!may_contain) {
+    negatives_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return may_contain;
+}
+
+/*
+ * The caller's directory latch keeps the filter array from changing, and the
+ * filter bits are atomic, so no latch is needed here.
+ */
+void BucketBloomFilters::Insert(uint64_t hash) {
+  BlockedBloomFilter *filter = filters_[hash & (filters_.size() - 1)].get();
+  if (filter != nullptr) {
+    filter->Insert(FilterHash(hash));
+  }
+}
+
+void BucketBloomFilters::SetGlobalDepth(uint32_t depth) {
+  latch_.WLock();
+  const size_t size = size_t{1} << depth;
+  while (filters_.size() < size) {
+    filters_.insert(filters_.end(), filters_.begin(), filters_.end());
+  }
+  filters_.resize(size);
+  latch_.WUnlock();
+}
+
+void BucketBloomFilters::Rebuild(uint32_t first, uint32_t step, uint32_t local_depth,
+                                 const std::vector<uint64_t> &hashes) {
+  // a full bucket's worth of bits, cut down to the bucket's share of the budget
+  const size_t block_bits = BlockedBloomFilter::BLOCK_SIZE * 8;
+  const size_t wanted_blocks = (bucket_capacity_ * BITS_PER_KEY + block_bits - 1) / block_bits;
+  const size_t num_blocks = std::min(wanted_blocks, (budget_bytes_ >> local_depth) / BlockedBloomFilter::BLOCK_SIZE);
+  std::shared_ptr<BlockedBloomFilter> filter;
+  if (num_blocks > 0) {
+    filter = std::make_shared<BlockedBloomFilter>(num_blocks);
+    for (uint64_t hash : hashes) {
+      filter->Insert(FilterHash(hash));
+    }
+  }
+
+  latch_.WLock();
+  for (size_t idx = first; idx < filters_.size(); idx += step) {
+    filters_[idx] = filter;
+  }
+  latch_.WUnlock();
+}
+
+BloomFilterStats BucketBloomFilters::GetStats() {
+  BloomFilterStats stats;
+  latch_.RLock();
+  std::unordered_set<const BlockedBloomFilter *> seen;
+  for (const auto &filter : filters_) {
+    if (filter != nullptr && seen.insert(filter.get()).second) {
+      stats.memory_bytes_ += filter->MemoryUsage();
+    }
+  }
+  latch_.RUnlock();
+  stats.negatives_ = negatives_.load(std::memory_order_relaxed);
+  stats.false_positives_ = false_positives_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace bustub
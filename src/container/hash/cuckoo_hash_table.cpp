@@ -0,0 +1,378 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// cuckoo_hash_table.cpp
+//
+// Identification: src/container/hash/cuckoo_hash_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "common/rid.h"
+#include "container/hash/cuckoo_hash_table.h"
+#include "storage/index/generic_key.h"
+#include "storage/index/integer_key.h"
+
+namespace bustub {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+CUCKOO_HASH_TABLE_TYPE::CuckooHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                        const KeyComparator &comparator, size_t num_buckets,
+                                        HashFunction<KeyType> hash_fn)
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  initial_num_buckets_ = 2;
+  while (initial_num_buckets_ < num_buckets) {
+    initial_num_buckets_ *= 2;
+  }
+  directory_[0] = std::make_unique<BucketEntry[]>(initial_num_buckets_);
+  for (size_t i = 0; i < initial_num_buckets_; i++) {
+    Page *page = buffer_pool_manager_->NewPage(&directory_[0][i].page_id_);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate cuckoo hash table bucket page");
+    }
+    reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(page->GetData())->Init();
+    buffer_pool_manager_->UnpinPage(directory_[0][i].page_id_, true);
+  }
+  num_buckets_.store(initial_num_buckets_, std::memory_order_release);
+}
+
+/*****************************************************************************
+ * BUCKETS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t CUCKOO_HASH_TABLE_TYPE::OtherBucket(uint64_t hash, size_t bucket_idx) const {
+  const size_t num_buckets = num_buckets_.load(std::memory_order_relaxed);
+  const size_t first_bucket = FirstBucket(hash, num_buckets);
+  return first_bucket == bucket_idx ? SecondBucket(hash, num_buckets) : first_bucket;
+}
+
+/*
+ * Chunk k > 0 starts at bucket initial_num_buckets_ << (k - 1), so the chunk
+ * of a bucket is the bit length of bucket_idx / initial_num_buckets_.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+typename CUCKOO_HASH_TABLE_TYPE::BucketEntry &CUCKOO_HASH_TABLE_TYPE::Entry(size_t bucket_idx) const {
+  if (bucket_idx < initial_num_buckets_) {
+    return directory_[0][bucket_idx];
+  }
+  const auto chunk = static_cast<size_t>(64 - __builtin_clzll(bucket_idx / initial_num_buckets_));
+  return directory_[chunk][bucket_idx - (initial_num_buckets_ << (chunk - 1))];
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *CUCKOO_HASH_TABLE_TYPE::FetchBucket(size_t bucket_idx) const {
+  Page *page = buffer_pool_manager_->FetchPage(Entry(bucket_idx).page_id_);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch cuckoo hash table bucket page");
+  }
+  return page;
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Neither bucket is latched. The versions of both are read before either is
+ * scanned and checked after both are, so that a pair moving from one to the
+ * other and back in between cannot go unseen; the table version catches a
+ * doubling, which does not touch the bucket versions.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool CUCKOO_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
+  const uint64_t hash = Hash(key);
+  const uint8_t tag = HASH_TABLE_CUCKOO_BUCKET_TYPE::TagOf(hash);
+  std::vector<MappingType> matches;
+  while (true) {
+    const uint64_t table_version = table_version_.load(std::memory_order_acquire);
+    if ((table_version & 1) != 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    const size_t num_buckets = num_buckets_.load(std::memory_order_acquire);
+    const size_t first_bucket_idx = FirstBucket(hash, num_buckets);
+    const size_t second_bucket_idx = SecondBucket(hash, num_buckets);
+
+    Page *first_page = FetchBucket(first_bucket_idx);
+    Page *second_page = nullptr;
+    if (second_bucket_idx != first_bucket_idx) {
+      try {
+        second_page = FetchBucket(second_bucket_idx);
+      } catch (...) {
+        buffer_pool_manager_->UnpinPage(first_page->GetPageId(), false);
+        throw;
+      }
+    }
+    auto *first_bucket = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(first_page->GetData());
+    auto *second_bucket =
+        second_page == nullptr ? nullptr : reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(second_page->GetData());
+
+    matches.clear();
+    const uint64_t first_version = first_bucket->ReadBegin();
+    const uint64_t second_version = second_bucket == nullptr ? 0 : second_bucket->ReadBegin();
+    first_bucket->CollectTagMatches(tag, &matches);
+    if (second_bucket != nullptr) {
+      second_bucket->CollectTagMatches(tag, &matches);
+    }
+    bool valid = first_bucket->ReadValidate(first_version) &&
+                 (second_bucket == nullptr || second_bucket->ReadValidate(second_version));
+    valid = valid && table_version_.load(std::memory_order_relaxed) == table_version;
+
+    buffer_pool_manager_->UnpinPage(first_page->GetPageId(), false);
+    if (second_page != nullptr) {
+      buffer_pool_manager_->UnpinPage(second_page->GetPageId(), false);
+    }
+    if (valid) {
+      break;
+    }
+  }
+
+  bool found = false;
+  for (const MappingType &match : matches) {
+    if (comparator_(key, match.first) == 0) {
+      result->push_back(match.second);
+      found = true;
+    }
+  }
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool CUCKOO_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  std::scoped_lock lock(write_latch_);
+  const uint64_t hash = Hash(key);
+  const uint8_t tag = HASH_TABLE_CUCKOO_BUCKET_TYPE::TagOf(hash);
+
+  // moves and doublings keep every pair in one of its buckets, so the duplicate check holds throughout
+  size_t num_buckets = num_buckets_.load(std::memory_order_relaxed);
+  for (size_t bucket_idx : {FirstBucket(hash, num_buckets), SecondBucket(hash, num_buckets)}) {
+    Page *page = FetchBucket(bucket_idx);
+    auto *bucket = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(page->GetData());
+    const bool duplicate = bucket->Find(key, value, tag, comparator_) != -1;
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (duplicate) {
+      return false;
+    }
+  }
+
+  while (true) {
+    num_buckets = num_buckets_.load(std::memory_order_relaxed);
+    const size_t first_bucket_idx = FirstBucket(hash, num_buckets);
+    const size_t second_bucket_idx = SecondBucket(hash, num_buckets);
+    size_t bucket_idx;
+    if (Entry(first_bucket_idx).num_pairs_ < CUCKOO_BUCKET_ARRAY_SIZE) {
+      bucket_idx = first_bucket_idx;
+    } else if (Entry(second_bucket_idx).num_pairs_ < CUCKOO_BUCKET_ARRAY_SIZE) {
+      bucket_idx = second_bucket_idx;
+    } else if (MakeRoom(first_bucket_idx, second_bucket_idx)) {
+      continue;
+    } else if (2 * GetSize() >= num_buckets * CUCKOO_BUCKET_ARRAY_SIZE) {
+      Grow();
+      continue;
+    } else {
+      // a half empty table without a chain of moves: both buckets hold little but values of this key
+      return false;
+    }
+
+    Page *page = FetchBucket(bucket_idx);
+    auto *bucket = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(page->GetData());
+    bucket->WriteBegin();
+    bucket->Insert(key, value, tag);
+    bucket->WriteEnd();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+    Entry(bucket_idx).num_pairs_++;
+    num_pairs_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+}
+
+/*
+ * Every bucket in the search is full, and the search ends at the first pair
+ * whose other bucket is not, so the buckets on the chain are distinct and
+ * each move has a free slot to go to.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool CUCKOO_HASH_TABLE_TYPE::MakeRoom(size_t first_bucket, size_t second_bucket) {
+  std::vector<SearchNode> nodes{{first_bucket, SIZE_MAX, 0}};
+  if (second_bucket != first_bucket) {
+    nodes.push_back({second_bucket, SIZE_MAX, 0});
+  }
+  auto visited = [&nodes](size_t bucket_idx) {
+    return std::any_of(nodes.begin(), nodes.end(),
+                       [bucket_idx](const SearchNode &node) { return node.bucket_idx_ == bucket_idx; });
+  };
+
+  for (size_t node_idx = 0; node_idx < nodes.size(); node_idx++) {
+    const size_t bucket_idx = nodes[node_idx].bucket_idx_;
+    Page *page = FetchBucket(bucket_idx);
+    auto *bucket = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(page->GetData());
+    uint32_t free_slot = 0;
+    size_t free_bucket_idx = SIZE_MAX;
+    for (uint32_t slot = 0; slot < bucket->NumReadable(); slot++) {
+      const size_t other_bucket_idx = OtherBucket(Hash(bucket->KeyAt(slot)), bucket_idx);
+      if (other_bucket_idx == bucket_idx) {
+        continue;
+      }
+      if (Entry(other_bucket_idx).num_pairs_ < CUCKOO_BUCKET_ARRAY_SIZE) {
+        free_slot = slot;
+        free_bucket_idx = other_bucket_idx;
+        break;
+      }
+      if (nodes.size() < MAX_SEARCH_BUCKETS && !visited(other_bucket_idx)) {
+        nodes.push_back({other_bucket_idx, node_idx, slot});
+      }
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+
+    if (free_bucket_idx != SIZE_MAX) {
+      MovePair(bucket_idx, free_slot, free_bucket_idx);
+      for (size_t node = node_idx; nodes[node].parent_ != SIZE_MAX; node = nodes[node].parent_) {
+        MovePair(nodes[nodes[node].parent_].bucket_idx_, nodes[node].parent_slot_, nodes[node].bucket_idx_);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void CUCKOO_HASH_TABLE_TYPE::MovePair(size_t from_bucket, uint32_t slot, size_t to_bucket) {
+  Page *from_page = FetchBucket(from_bucket);
+  Page *to_page;
+  try {
+    to_page = FetchBucket(to_bucket);
+  } catch (...) {
+    buffer_pool_manager_->UnpinPage(from_page->GetPageId(), false);
+    throw;
+  }
+  auto *from = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(from_page->GetData());
+  auto *to = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(to_page->GetData());
+
+  // the pair is in its new bucket before it leaves the old one
+  to->WriteBegin();
+  to->Insert(from->KeyAt(slot), from->ValueAt(slot), from->TagAt(slot));
+  to->WriteEnd();
+  from->WriteBegin();
+  from->RemoveAt(slot);
+  from->WriteEnd();
+  Entry(to_bucket).num_pairs_++;
+  Entry(from_bucket).num_pairs_--;
+
+  buffer_pool_manager_->UnpinPage(from_page->GetPageId(), true);
+  buffer_pool_manager_->UnpinPage(to_page->GetPageId(), true);
+}
+
+/*
+ * All new bucket pages are allocated before the table version turns odd, so
+ * running out of frames leaves the table as it was. The pairs are then split
+ * without bumping the bucket versions: lookups wait on the table version.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void CUCKOO_HASH_TABLE_TYPE::Grow() {
+  const size_t num_buckets = num_buckets_.load(std::memory_order_relaxed);
+  const auto chunk = static_cast<size_t>(64 - __builtin_clzll(num_buckets / initial_num_buckets_));
+  if (chunk >= MAX_DIRECTORY_CHUNKS) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "cuckoo hash table directory is full");
+  }
+  auto entries = std::make_unique<BucketEntry[]>(num_buckets);
+  for (size_t i = 0; i < num_buckets; i++) {
+    Page *page = buffer_pool_manager_->NewPage(&entries[i].page_id_);
+    if (page == nullptr) {
+      for (size_t j = 0; j < i; j++) {
+        buffer_pool_manager_->DeletePage(entries[j].page_id_);
+      }
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate cuckoo hash table bucket page");
+    }
+    reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(page->GetData())->Init();
+    buffer_pool_manager_->UnpinPage(entries[i].page_id_, true);
+  }
+  directory_[chunk] = std::move(entries);
+
+  const uint64_t table_version = table_version_.load(std::memory_order_relaxed);
+  table_version_.store(table_version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const size_t new_num_buckets = 2 * num_buckets;
+  for (size_t bucket_idx = 0; bucket_idx < num_buckets; bucket_idx++) {
+    const size_t image_idx = bucket_idx + num_buckets;
+    Page *page = FetchBucket(bucket_idx);
+    Page *image_page;
+    try {
+      image_page = FetchBucket(image_idx);
+    } catch (...) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      throw;
+    }
+    auto *bucket = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(page->GetData());
+    auto *image = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(image_page->GetData());
+    // from the back, so that the pair RemoveAt moves into a slot has been looked at already
+    for (uint32_t slot = bucket->NumReadable(); slot-- > 0;) {
+      const uint64_t hash = Hash(bucket->KeyAt(slot));
+      if (FirstBucket(hash, new_num_buckets) != bucket_idx && SecondBucket(hash, new_num_buckets) != bucket_idx) {
+        image->Insert(bucket->KeyAt(slot), bucket->ValueAt(slot), bucket->TagAt(slot));
+        bucket->RemoveAt(slot);
+      }
+    }
+    Entry(bucket_idx).num_pairs_ = bucket->NumReadable();
+    directory_[chunk][bucket_idx].num_pairs_ = image->NumReadable();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+    buffer_pool_manager_->UnpinPage(image_page->GetPageId(), true);
+  }
+
+  num_buckets_.store(new_num_buckets, std::memory_order_release);
+  table_version_.store(table_version + 2, std::memory_order_release);
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool CUCKOO_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  std::scoped_lock lock(write_latch_);
+  const uint64_t hash = Hash(key);
+  const uint8_t tag = HASH_TABLE_CUCKOO_BUCKET_TYPE::TagOf(hash);
+  const size_t num_buckets = num_buckets_.load(std::memory_order_relaxed);
+  for (size_t bucket_idx : {FirstBucket(hash, num_buckets), SecondBucket(hash, num_buckets)}) {
+    Page *page = FetchBucket(bucket_idx);
+    auto *bucket = reinterpret_cast<HASH_TABLE_CUCKOO_BUCKET_TYPE *>(page->GetData());
+    const int64_t slot = bucket->Find(key, value, tag, comparator_);
+    if (slot != -1) {
+      bucket->WriteBegin();
+      bucket->RemoveAt(slot);
+      bucket->WriteEnd();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+      Entry(bucket_idx).num_pairs_--;
+      num_pairs_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+  return false;
+}
+
+template class CuckooHashTable<int, int, IntComparator>;
+
+template class CuckooHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class CuckooHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class CuckooHashTable<GenericKey<16>, RID, GenericComparator<16>>;
+template class CuckooHashTable<GenericKey<32>, RID, GenericComparator<32>>;
+template class CuckooHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+
+template class CuckooHashTable<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class CuckooHashTable<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class CuckooHashTable<IntegerKey<16>, RID, IntegerComparator<16>>;
+
+}  // namespace bustub
@@ -10,8 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -19,14 +24,47 @@
 #include "common/logger.h"
 #include "common/rid.h"
 #include "container/hash/extendible_hash_table.h"
+#include "storage/index/integer_key.h"
 
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
+                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                     size_t bloom_filter_budget)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)),
+      filters_(bloom_filter_budget, TAGGED_BUCKET_ARRAY_SIZE) {
+  // start with global depth 0: one directory page with a single bucket that every key maps to
+  Page *header_page = buffer_pool_manager_->NewPage(&header_page_id_);
+  if (header_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate hash table header page");
+  }
+  page_id_t directory_page_id;
+  Page *dir_page = buffer_pool_manager_->NewPage(&directory_page_id);
+  if (dir_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate hash table directory page");
+  }
+  page_id_t bucket_page_id;
+  Page *bucket_page = buffer_pool_manager_->NewPage(&bucket_page_id);
+  if (bucket_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(directory_page_id, false);
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate hash table bucket page");
+  }
+  auto *header = AsHeaderPage(header_page);
+  header->SetPageId(header_page_id_);
+  header->SetDirectoryPageId(0, directory_page_id);
+  auto *dir = AsDirectoryPage(dir_page);
+  dir->SetPageId(directory_page_id);
+  dir->SetBucketPageId(0, bucket_page_id);
+  dir->SetLocalDepth(0, 0);
+  AsBucketPage(bucket_page)->Init();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id, true);
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
 }
 
 /*****************************************************************************
@@ -45,23 +83,171 @@ uint32_t HASH_TABLE_TYPE::Hash(KeyType key) {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) {
-  return 0;
+void HASH_TABLE_TYPE::RebuildFilter(HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, uint32_t bucket_idx, uint32_t local_depth) {
+  std::vector<uint64_t> hashes;
+  for (uint32_t slot = 0; slot < TAGGED_BUCKET_ARRAY_SIZE && bucket->IsOccupied(slot); slot++) {
+    if (bucket->IsReadable(slot)) {
+      hashes.push_back(hash_fn_.GetHash(bucket->KeyAt(slot)));
+    }
+  }
+  // every pair of the overflow chain has the same hash
+  if (bucket->HasOverflow()) {
+    hashes.push_back(bucket->GetOverflowHash());
+  }
+  const uint32_t step = 1U << local_depth;
+  filters_.Rebuild(bucket_idx & (step - 1), step, local_depth, hashes);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) {
-  return 0;
+Page *HASH_TABLE_TYPE::FetchHeaderPage() {
+  Page *page = buffer_pool_manager_->FetchPage(header_page_id_);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table header page");
+  }
+  return page;
+}
+
+/*
+ * The caller holds the header latch, so a failed fetch is reported as
+ * nullptr for the caller to release it before throwing.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *HASH_TABLE_TYPE::FetchBucketPage(HashTableDirectoryHeaderPage *header, uint32_t bucket_idx) {
+  page_id_t bucket_page_id;
+  uint32_t local_depth;
+  if (!GetDirectoryEntry(header, bucket_idx, &bucket_page_id, &local_depth)) {
+    return nullptr;
+  }
+  return buffer_pool_manager_->FetchPage(bucket_page_id);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
-  return nullptr;
+bool HASH_TABLE_TYPE::GetDirectoryEntry(HashTableDirectoryHeaderPage *header, uint32_t bucket_idx,
+                                        page_id_t *bucket_page_id, uint32_t *local_depth) {
+  const page_id_t directory_page_id =
+      header->GetDirectoryPageId(HashTableDirectoryHeaderPage::DirectoryIndex(bucket_idx));
+  Page *dir_page = buffer_pool_manager_->FetchPage(directory_page_id);
+  if (dir_page == nullptr) {
+    return false;
+  }
+  auto *dir = AsDirectoryPage(dir_page);
+  const uint32_t slot = HashTableDirectoryHeaderPage::DirectorySlot(bucket_idx);
+  *bucket_page_id = dir->GetBucketPageId(slot);
+  *local_depth = dir->GetLocalDepth(slot);
+  buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
-  return nullptr;
+bool HASH_TABLE_TYPE::ForEachDirectoryEntry(
+    HashTableDirectoryHeaderPage *header, uint32_t first, uint32_t step,
+    const std::function<bool(HashTableDirectoryPage *, uint32_t, uint32_t)> &fn) {
+  uint32_t bucket_idx = first;
+  while (bucket_idx < header->Size()) {
+    const uint32_t directory_idx = HashTableDirectoryHeaderPage::DirectoryIndex(bucket_idx);
+    const page_id_t directory_page_id = header->GetDirectoryPageId(directory_idx);
+    Page *dir_page = buffer_pool_manager_->FetchPage(directory_page_id);
+    if (dir_page == nullptr) {
+      return false;
+    }
+    auto *dir = AsDirectoryPage(dir_page);
+    bool is_dirty = false;
+    for (; bucket_idx < header->Size() && HashTableDirectoryHeaderPage::DirectoryIndex(bucket_idx) == directory_idx;
+         bucket_idx += step) {
+      is_dirty = fn(dir, HashTableDirectoryHeaderPage::DirectorySlot(bucket_idx), bucket_idx) || is_dirty;
+    }
+    buffer_pool_manager_->UnpinPage(directory_page_id, is_dirty);
+  }
+  return true;
+}
+
+/*
+ * A directory page keeps its own global depth at min(global depth,
+ * DIRECTORY_MAX_DEPTH), so until the directory outgrows its first page the
+ * page doubles in place as before.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GrowDirectory(HashTableDirectoryHeaderPage *header) {
+  if (header->Size() < DIRECTORY_ARRAY_SIZE) {
+    Page *dir_page = buffer_pool_manager_->FetchPage(header->GetDirectoryPageId(0));
+    if (dir_page == nullptr) {
+      return false;
+    }
+    AsDirectoryPage(dir_page)->IncrGlobalDepth();
+    buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), true);
+    header->IncrGlobalDepth();
+    return true;
+  }
+
+  // directory page i + n starts as a copy of directory page i
+  const uint32_t num_pages = header->NumDirectoryPages();
+  for (uint32_t i = 0; i < num_pages; i++) {
+    page_id_t copy_page_id;
+    Page *copy_page = buffer_pool_manager_->NewPage(&copy_page_id);
+    Page *dir_page = copy_page == nullptr ? nullptr : buffer_pool_manager_->FetchPage(header->GetDirectoryPageId(i));
+    if (dir_page == nullptr) {
+      if (copy_page != nullptr) {
+        buffer_pool_manager_->UnpinPage(copy_page_id, false);
+        buffer_pool_manager_->DeletePage(copy_page_id);
+      }
+      for (uint32_t j = 0; j < i; j++) {
+        buffer_pool_manager_->DeletePage(header->GetDirectoryPageId(num_pages + j));
+      }
+      return false;
+    }
+    memcpy(copy_page->GetData(), dir_page->GetData(), PAGE_SIZE);
+    AsDirectoryPage(copy_page)->SetPageId(copy_page_id);
+    header->SetDirectoryPageId(num_pages + i, copy_page_id);
+    buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false);
+    buffer_pool_manager_->UnpinPage(copy_page_id, true);
+  }
+  header->IncrGlobalDepth();
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::ShrinkDirectory(HashTableDirectoryHeaderPage *header) {
+  bool shrunk = false;
+  while (header->GetGlobalDepth() > 0) {
+    const uint32_t global_depth = header->GetGlobalDepth();
+    bool can_shrink = true;
+    const bool fetched = ForEachDirectoryEntry(header, 0, 1, [&](HashTableDirectoryPage *dir, uint32_t slot, uint32_t) {
+      can_shrink = can_shrink && dir->GetLocalDepth(slot) < global_depth;
+      return false;
+    });
+    if (!fetched || !can_shrink) {
+      break;
+    }
+    if (header->Size() <= DIRECTORY_ARRAY_SIZE) {
+      Page *dir_page = buffer_pool_manager_->FetchPage(header->GetDirectoryPageId(0));
+      if (dir_page == nullptr) {
+        break;
+      }
+      AsDirectoryPage(dir_page)->DecrGlobalDepth();
+      buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), true);
+      header->DecrGlobalDepth();
+    } else {
+      header->DecrGlobalDepth();
+      // nothing can reach the upper half once the header no longer counts it
+      const uint32_t num_pages = header->NumDirectoryPages();
+      for (uint32_t i = num_pages; i < 2 * num_pages; i++) {
+        buffer_pool_manager_->DeletePage(header->GetDirectoryPageId(i));
+      }
+    }
+    shrunk = true;
+  }
+  return shrunk;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::ThrowOutOfMemory(Page *header_page, bool exclusive, bool is_dirty, const std::string &message) {
+  if (exclusive) {
+    header_page->WUnlatch();
+  } else {
+    header_page->RUnlatch();
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, is_dirty);
+  throw Exception(ExceptionType::OUT_OF_MEMORY, message);
 }
 
 /*****************************************************************************
@@ -69,20 +255,425 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+  const uint64_t full_hash = hash_fn_.GetHash(key);
+  if (!filters_.MayContain(full_hash)) {
+    return false;
+  }
+  const auto hash = static_cast<uint32_t>(full_hash);
+  Page *header_page = FetchHeaderPage();
+  header_page->RLatch();
+  auto *header = AsHeaderPage(header_page);
+  Page *bucket_page = FetchBucketPage(header, hash & header->GetGlobalDepthMask());
+  if (bucket_page == nullptr) {
+    ThrowOutOfMemory(header_page, false, false, "cannot fetch hash table bucket page");
+  }
+  bucket_page->RLatch();
+  auto *bucket = AsBucketPage(bucket_page);
+  bool found = bucket->GetValue(key, hash, comparator_, result);
+  const bool fetched = GetOverflowValues(bucket, key, full_hash, result, &found);
+  bucket_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page->GetPageId(), false);
+  if (!fetched) {
+    ThrowOutOfMemory(header_page, false, false, "cannot fetch hash table overflow page");
+  }
+  header_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  if (!found) {
+    filters_.RecordFalsePositive();
+  }
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                                std::vector<std::vector<ValueType>> *result) {
+  std::vector<uint64_t> hashes(keys.size());
+  hash_fn_.GetHashBatch(keys.data(), keys.size(), hashes.data());
+  result->assign(keys.size(), std::vector<ValueType>{});
+  std::vector<size_t> candidates;
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (filters_.MayContain(hashes[i])) {
+      candidates.push_back(i);
+    }
+  }
+  if (candidates.empty()) {
+    return;
+  }
+
+  Page *header_page = FetchHeaderPage();
+  header_page->RLatch();
+  auto *header = AsHeaderPage(header_page);
+  for (size_t i : candidates) {
+    const auto hash = static_cast<uint32_t>(hashes[i]);
+    Page *bucket_page = FetchBucketPage(header, hash & header->GetGlobalDepthMask());
+    if (bucket_page == nullptr) {
+      ThrowOutOfMemory(header_page, false, false, "cannot fetch hash table bucket page");
+    }
+    bucket_page->RLatch();
+    auto *bucket = AsBucketPage(bucket_page);
+    bool found = bucket->GetValue(keys[i], hash, comparator_, &(*result)[i]);
+    const bool fetched = GetOverflowValues(bucket, keys[i], hashes[i], &(*result)[i], &found);
+    bucket_page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page->GetPageId(), false);
+    if (!fetched) {
+      ThrowOutOfMemory(header_page, false, false, "cannot fetch hash table overflow page");
+    }
+    if (!found) {
+      filters_.RecordFalsePositive();
+    }
+  }
+  header_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GetOverflowValues(HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, const KeyType &key, uint64_t full_hash,
+                                        std::vector<ValueType> *result, bool *found) {
+  if (!bucket->HasOverflow() || bucket->GetOverflowHash() != full_hash) {
+    return true;
+  }
+  const auto hash = static_cast<uint32_t>(full_hash);
+  page_id_t page_id = bucket->GetOverflowPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      return false;
+    }
+    auto *overflow = AsBucketPage(page);
+    *found = overflow->GetValue(key, hash, comparator_, result) || *found;
+    const page_id_t next_page_id = overflow->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return true;
 }
 
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
+/*
+ * Insert into the key's bucket under a shared header latch. Only a full
+ * bucket escalates to SplitInsert, which retries under the exclusive latch.
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  const uint64_t full_hash = hash_fn_.GetHash(key);
+  const auto hash = static_cast<uint32_t>(full_hash);
+  Page *header_page = FetchHeaderPage();
+  header_page->RLatch();
+  auto *header = AsHeaderPage(header_page);
+  Page *bucket_page = FetchBucketPage(header, hash & header->GetGlobalDepthMask());
+  if (bucket_page == nullptr) {
+    ThrowOutOfMemory(header_page, false, false, "cannot fetch hash table bucket page");
+  }
+  bucket_page->WLatch();
+  bool inserted;
+  bool needs_split;
+  const bool fetched = InsertIntoBucket(bucket_page, key, value, full_hash, false, &inserted, &needs_split);
+  bucket_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page->GetPageId(), inserted);
+  if (!fetched) {
+    ThrowOutOfMemory(header_page, false, false, "cannot fetch hash table overflow page");
+  }
+  header_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  if (!needs_split) {
+    return inserted;
+  }
+  return SplitInsert(transaction, key, value);
 }
 
+/*
+ * Once a bucket has a chain, every pair of the chain's hash lives in the
+ * chain, which leaves the bucket's own slots to the other keys.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::InsertIntoBucket(Page *bucket_page, const KeyType &key, const ValueType &value,
+                                       uint64_t full_hash, bool may_start_chain, bool *inserted, bool *needs_split) {
+  auto *bucket = AsBucketPage(bucket_page);
+  const page_id_t bucket_page_id = bucket_page->GetPageId();
+  const auto hash = static_cast<uint32_t>(full_hash);
+  *inserted = false;
+  *needs_split = false;
+  if (bucket->HasOverflow() && bucket->GetOverflowHash() == full_hash) {
+    bool contains;
+    if (!OverflowContains(bucket_page_id, bucket, key, value, full_hash, &contains)) {
+      return false;
+    }
+    if (!contains) {
+      if (!AppendOverflow(bucket_page_id, bucket, key, value, full_hash)) {
+        return false;
+      }
+      *inserted = true;
+    }
+  } else if (!bucket->IsFull()) {
+    *inserted = bucket->Insert(key, value, hash, comparator_);
+  } else if (may_start_chain && !bucket->HasOverflow() && CountHash(bucket, full_hash) >= MIN_OVERFLOW_PAIRS) {
+    std::vector<ValueType> values;
+    bucket->GetValue(key, hash, comparator_, &values);
+    if (std::find(values.begin(), values.end(), value) != values.end()) {
+      return true;
+    }
+    if (!StartOverflow(bucket, full_hash) || !AppendOverflow(bucket_page_id, bucket, key, value, full_hash)) {
+      return false;
+    }
+    *inserted = true;
+  } else {
+    *needs_split = true;
+  }
+  if (*inserted) {
+    filters_.Insert(full_hash);
+  }
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_TYPE::CountHash(HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, uint64_t full_hash) {
+  uint32_t count = 0;
+  for (uint32_t slot = 0; slot < TAGGED_BUCKET_ARRAY_SIZE && bucket->IsOccupied(slot); slot++) {
+    if (bucket->IsReadable(slot) && hash_fn_.GetHash(bucket->KeyAt(slot)) == full_hash) {
+      count++;
+    }
+  }
+  return count;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::StartOverflow(HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, uint64_t full_hash) {
+  page_id_t overflow_page_id;
+  Page *overflow_page = buffer_pool_manager_->NewPage(&overflow_page_id);
+  if (overflow_page == nullptr) {
+    return false;
+  }
+  auto *overflow = AsBucketPage(overflow_page);
+  overflow->Init();
+  overflow->SetOverflowHash(full_hash);
+  const auto hash = static_cast<uint32_t>(full_hash);
+  for (uint32_t slot = 0; slot < TAGGED_BUCKET_ARRAY_SIZE && bucket->IsOccupied(slot); slot++) {
+    if (bucket->IsReadable(slot) && hash_fn_.GetHash(bucket->KeyAt(slot)) == full_hash) {
+      overflow->Insert(bucket->KeyAt(slot), bucket->ValueAt(slot), hash, comparator_);
+      bucket->RemoveAt(slot);
+    }
+  }
+  buffer_pool_manager_->UnpinPage(overflow_page_id, true);
+  bucket->SetOverflowPageId(overflow_page_id);
+  bucket->SetOverflowHash(full_hash);
+  return true;
+}
+
+/*
+ * The filter counts the pairs added since it was built and is rebuilt from
+ * the chain, twice as large, once that count reaches what it was sized for,
+ * so its rebuilds cost O(1) page reads per insert on average.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::OverflowContains(page_id_t bucket_page_id, HASH_TABLE_TAGGED_BUCKET_TYPE *bucket,
+                                       const KeyType &key, const ValueType &value, uint64_t full_hash,
+                                       bool *contains) {
+  OverflowFilter *entry;
+  {
+    std::lock_guard<std::mutex> guard(overflow_filters_latch_);
+    entry = &overflow_filters_[bucket_page_id];
+  }
+  if (entry->filter_ == nullptr || entry->size_ >= entry->capacity_) {
+    std::vector<uint32_t> pair_hashes;
+    page_id_t page_id = bucket->GetOverflowPageId();
+    while (page_id != INVALID_PAGE_ID) {
+      Page *page = buffer_pool_manager_->FetchPage(page_id);
+      if (page == nullptr) {
+        return false;
+      }
+      auto *overflow = AsBucketPage(page);
+      for (uint32_t slot = 0; slot < TAGGED_BUCKET_ARRAY_SIZE && overflow->IsOccupied(slot); slot++) {
+        if (overflow->IsReadable(slot)) {
+          pair_hashes.push_back(PairHash(full_hash, overflow->ValueAt(slot)));
+        }
+      }
+      const page_id_t next_page_id = overflow->GetOverflowPageId();
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    const size_t block_bits = BlockedBloomFilter::BLOCK_SIZE * 8;
+    entry->capacity_ = std::max(MIN_OVERFLOW_FILTER_PAIRS, 2 * pair_hashes.size());
+    entry->filter_ = std::make_unique<BlockedBloomFilter>(
+        (entry->capacity_ * OVERFLOW_FILTER_BITS_PER_PAIR + block_bits - 1) / block_bits);
+    for (uint32_t pair_hash : pair_hashes) {
+      entry->filter_->Insert(pair_hash);
+    }
+    entry->size_ = pair_hashes.size();
+  }
+  *contains = false;
+  if (!entry->filter_->MayContain(PairHash(full_hash, value))) {
+    return true;
+  }
+  std::vector<ValueType> values;
+  bool found = false;
+  if (!GetOverflowValues(bucket, key, full_hash, &values, &found)) {
+    return false;
+  }
+  *contains = std::find(values.begin(), values.end(), value) != values.end();
+  return true;
+}
+
+/*
+ * Only the first page of the chain takes new pairs. Slots that removes free
+ * further down stay empty until their page empties and is unlinked, which
+ * keeps an insert at two page accesses.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::AppendOverflow(page_id_t bucket_page_id, HASH_TABLE_TAGGED_BUCKET_TYPE *bucket,
+                                     const KeyType &key, const ValueType &value, uint64_t full_hash) {
+  const auto hash = static_cast<uint32_t>(full_hash);
+  bool appended = false;
+  if (bucket->HasOverflow()) {
+    const page_id_t first_page_id = bucket->GetOverflowPageId();
+    Page *first_page = buffer_pool_manager_->FetchPage(first_page_id);
+    if (first_page == nullptr) {
+      return false;
+    }
+    appended = AsBucketPage(first_page)->Insert(key, value, hash, comparator_);
+    buffer_pool_manager_->UnpinPage(first_page_id, appended);
+  }
+  if (!appended) {
+    page_id_t new_page_id;
+    Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);
+    if (new_page == nullptr) {
+      return false;
+    }
+    auto *overflow = AsBucketPage(new_page);
+    overflow->Init();
+    overflow->SetOverflowPageId(bucket->GetOverflowPageId());
+    overflow->SetOverflowHash(full_hash);
+    overflow->Insert(key, value, hash, comparator_);
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    bucket->SetOverflowPageId(new_page_id);
+    bucket->SetOverflowHash(full_hash);
+  }
+
+  std::lock_guard<std::mutex> guard(overflow_filters_latch_);
+  auto entry = overflow_filters_.find(bucket_page_id);
+  if (entry != overflow_filters_.end() && entry->second.filter_ != nullptr) {
+    entry->second.filter_->Insert(PairHash(full_hash, value));
+    entry->second.size_++;
+  }
+  return true;
+}
+
+/*
+ * With the header latched exclusively no other operation is inside the
+ * table, so buckets are used without their latches. The key's bucket is split
+ * (growing the directory if its local depth is already global) until it has
+ * room, which may take several rounds if the keys keep landing on one side.
+ * A full bucket at least half filled with pairs of the key's hash is not
+ * split, since no split could separate those; they move to a new overflow
+ * chain of the bucket, which the pair joins.
+ * Gives up if the pair is already present or the directory cannot grow.
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  Page *header_page = FetchHeaderPage();
+  header_page->WLatch();
+  auto *header = AsHeaderPage(header_page);
+  bool header_dirty = false;
+  bool inserted = false;
+  const uint64_t full_hash = hash_fn_.GetHash(key);
+  const auto hash = static_cast<uint32_t>(full_hash);
+  while (true) {
+    const uint32_t bucket_idx = hash & header->GetGlobalDepthMask();
+    page_id_t bucket_page_id;
+    uint32_t local_depth;
+    Page *bucket_page = nullptr;
+    if (GetDirectoryEntry(header, bucket_idx, &bucket_page_id, &local_depth)) {
+      bucket_page = buffer_pool_manager_->FetchPage(bucket_page_id);
+    }
+    if (bucket_page == nullptr) {
+      ThrowOutOfMemory(header_page, true, header_dirty, "cannot fetch hash table bucket page");
+    }
+    auto *bucket = AsBucketPage(bucket_page);
+    // another remove may have left room, or an earlier round of this split did
+    bool needs_split;
+    if (!InsertIntoBucket(bucket_page, key, value, full_hash, true, &inserted, &needs_split)) {
+      // the bucket's pairs may have moved to a new chain already
+      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      ThrowOutOfMemory(header_page, true, header_dirty, "cannot fetch hash table overflow page");
+    }
+    if (!needs_split) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+      break;
+    }
+    std::vector<ValueType> values;
+    bucket->GetValue(key, hash, comparator_, &values);
+    const bool duplicate = std::find(values.begin(), values.end(), value) != values.end();
+    const bool can_grow = local_depth < header->GetGlobalDepth() || header->CanGrow();
+    if (duplicate || !can_grow) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    page_id_t image_page_id;
+    Page *image_page = buffer_pool_manager_->NewPage(&image_page_id);
+    if (image_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      ThrowOutOfMemory(header_page, true, header_dirty, "cannot allocate hash table bucket page");
+    }
+
+    if (local_depth == header->GetGlobalDepth()) {
+      if (!GrowDirectory(header)) {
+        buffer_pool_manager_->UnpinPage(image_page_id, false);
+        buffer_pool_manager_->DeletePage(image_page_id);
+        buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+        ThrowOutOfMemory(header_page, true, header_dirty, "cannot grow hash table directory");
+      }
+      filters_.SetGlobalDepth(header->GetGlobalDepth());
+      header_dirty = true;
+    }
+    // every directory entry of the bucket gains a hash bit, the entries with that bit set now point at the image
+    const uint32_t high_bit = 1U << local_depth;
+    const bool updated = ForEachDirectoryEntry(
+        header, bucket_idx & (high_bit - 1), high_bit, [&](HashTableDirectoryPage *dir, uint32_t slot, uint32_t idx) {
+          dir->IncrLocalDepth(slot);
+          if ((idx & high_bit) != 0) {
+            dir->SetBucketPageId(slot, image_page_id);
+          }
+          return true;
+        });
+    if (!updated) {
+      // the directory is half rewritten, there is no consistent state left to return to
+      buffer_pool_manager_->UnpinPage(image_page_id, false);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      ThrowOutOfMemory(header_page, true, header_dirty, "cannot fetch hash table directory page");
+    }
+    auto *image = AsBucketPage(image_page);
+    image->Init();
+    for (uint32_t slot = 0; slot < TAGGED_BUCKET_ARRAY_SIZE && bucket->IsOccupied(slot); slot++) {
+      if (!bucket->IsReadable(slot)) {
+        continue;
+      }
+      const uint32_t slot_hash = Hash(bucket->KeyAt(slot));
+      if ((slot_hash & high_bit) != 0) {
+        image->Insert(bucket->KeyAt(slot), bucket->ValueAt(slot), slot_hash, comparator_);
+        bucket->RemoveAt(slot);
+      }
+    }
+    // the overflow chain moves as one, all its pairs share a hash
+    if (bucket->HasOverflow() && (static_cast<uint32_t>(bucket->GetOverflowHash()) & high_bit) != 0) {
+      image->SetOverflowPageId(bucket->GetOverflowPageId());
+      image->SetOverflowHash(bucket->GetOverflowHash());
+      bucket->SetOverflowPageId(INVALID_PAGE_ID);
+      std::lock_guard<std::mutex> guard(overflow_filters_latch_);
+      auto entry = overflow_filters_.extract(bucket_page_id);
+      if (!entry.empty()) {
+        entry.key() = image_page_id;
+        overflow_filters_.insert(std::move(entry));
+      }
+    }
+    RebuildFilter(bucket, bucket_idx & (high_bit - 1), local_depth + 1);
+    RebuildFilter(image, (bucket_idx & (high_bit - 1)) | high_bit, local_depth + 1);
+    buffer_pool_manager_->UnpinPage(image_page_id, true);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  }
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, header_dirty);
+  return inserted;
 }
 
 /*****************************************************************************
@@ -90,38 +681,293 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  const uint64_t full_hash = hash_fn_.GetHash(key);
+  const auto hash = static_cast<uint32_t>(full_hash);
+  Page *header_page = FetchHeaderPage();
+  header_page->RLatch();
+  auto *header = AsHeaderPage(header_page);
+  Page *bucket_page = FetchBucketPage(header, hash & header->GetGlobalDepthMask());
+  if (bucket_page == nullptr) {
+    ThrowOutOfMemory(header_page, false, false, "cannot fetch hash table bucket page");
+  }
+  bucket_page->WLatch();
+  auto *bucket = AsBucketPage(bucket_page);
+  const page_id_t bucket_page_id = bucket_page->GetPageId();
+  bool removed = bucket->Remove(key, value, hash, comparator_);
+  const bool fetched = removed || RemoveOverflow(bucket_page_id, bucket, key, value, full_hash, &removed);
+  const bool underfull = removed && !bucket->HasOverflow() && bucket->NumReadable() <= MERGE_CANDIDATE_SIZE;
+  bucket_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, removed);
+  if (!fetched) {
+    ThrowOutOfMemory(header_page, false, false, "cannot fetch hash table overflow page");
+  }
+  header_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  if (underfull) {
+    QueueMerge(bucket_page_id, hash);
+    TryMergeQueued();
+  }
+  return removed;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::RemoveOverflow(page_id_t bucket_page_id, HASH_TABLE_TAGGED_BUCKET_TYPE *bucket,
+                                     const KeyType &key, const ValueType &value, uint64_t full_hash, bool *removed) {
+  *removed = false;
+  if (!bucket->HasOverflow() || bucket->GetOverflowHash() != full_hash) {
+    return true;
+  }
+  const auto hash = static_cast<uint32_t>(full_hash);
+  // the page before the current one stays pinned to unlink the current one if it empties
+  HASH_TABLE_TAGGED_BUCKET_TYPE *prev = bucket;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  bool prev_dirty = false;
+  bool fetched = true;
+  page_id_t page_id = bucket->GetOverflowPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      fetched = false;
+      break;
+    }
+    auto *overflow = AsBucketPage(page);
+    if (overflow->Remove(key, value, hash, comparator_)) {
+      *removed = true;
+      if (overflow->IsEmpty()) {
+        prev->SetOverflowPageId(overflow->GetOverflowPageId());
+        prev_dirty = true;
+        buffer_pool_manager_->UnpinPage(page_id, false);
+        buffer_pool_manager_->DeletePage(page_id);
+      } else {
+        buffer_pool_manager_->UnpinPage(page_id, true);
+      }
+      break;
+    }
+    if (prev_page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(prev_page_id, false);
+    }
+    prev = overflow;
+    prev_page_id = page_id;
+    page_id = overflow->GetOverflowPageId();
+  }
+  if (prev_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->UnpinPage(prev_page_id, prev_dirty);
+  }
+  if (!bucket->HasOverflow()) {
+    std::lock_guard<std::mutex> guard(overflow_filters_latch_);
+    overflow_filters_.erase(bucket_page_id);
+  }
+  return fetched;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::QueueMerge(page_id_t bucket_page_id, uint32_t hash) {
+  std::lock_guard<std::mutex> guard(merge_queue_latch_);
+  merge_queue_[bucket_page_id] = hash;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::TryMergeQueued() {
+  Page *header_page = FetchHeaderPage();
+  if (!header_page->TryWLatch()) {
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+    return;
+  }
+  bool header_dirty = false;
+  try {
+    RunQueuedMerges(AsHeaderPage(header_page), MERGES_PER_REMOVE, &header_dirty);
+  } catch (Exception &e) {
+    header_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(header_page_id_, header_dirty);
+    throw;
+  }
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, header_dirty);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::MergeBuckets() {
+  Page *header_page = FetchHeaderPage();
+  header_page->WLatch();
+  bool header_dirty = false;
+  size_t freed;
+  try {
+    freed = RunQueuedMerges(AsHeaderPage(header_page), std::numeric_limits<size_t>::max(), &header_dirty);
+  } catch (Exception &e) {
+    header_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(header_page_id_, header_dirty);
+    throw;
+  }
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, header_dirty);
+  return freed;
+}
+
+/*
+ * A queued bucket may have merged, split or even been freed since it was
+ * queued, so it is looked up again through its hash and skipped if the
+ * directory no longer points there at that page.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::RunQueuedMerges(HashTableDirectoryHeaderPage *header, size_t max_buckets,
+                                        bool *header_dirty) {
+  size_t freed = 0;
+  for (size_t taken = 0; taken < max_buckets; taken++) {
+    page_id_t queued_page_id;
+    uint32_t hash;
+    {
+      std::lock_guard<std::mutex> guard(merge_queue_latch_);
+      if (merge_queue_.empty()) {
+        break;
+      }
+      queued_page_id = merge_queue_.begin()->first;
+      hash = merge_queue_.begin()->second;
+      merge_queue_.erase(merge_queue_.begin());
+    }
+    page_id_t bucket_page_id;
+    uint32_t local_depth;
+    if (!GetDirectoryEntry(header, hash & header->GetGlobalDepthMask(), &bucket_page_id, &local_depth) ||
+        bucket_page_id != queued_page_id) {
+      continue;
+    }
+    while (MergeBucket(header, hash & header->GetGlobalDepthMask(), header_dirty)) {
+      freed++;
+    }
+  }
+  return freed;
+}
+
+/*
+ * The directory is rewritten before any pair moves, so a directory page the
+ * buffer pool cannot supply leaves both buckets intact; but a rewrite that
+ * fails halfway has no consistent state to return to and is reported.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::MergeBucket(HashTableDirectoryHeaderPage *header, uint32_t bucket_idx, bool *header_dirty) {
+  page_id_t bucket_page_id;
+  uint32_t local_depth;
+  if (!GetDirectoryEntry(header, bucket_idx, &bucket_page_id, &local_depth) || local_depth == 0) {
+    return false;
+  }
+  const uint32_t low_bits = 1U << (local_depth - 1);
+  page_id_t image_page_id;
+  uint32_t image_local_depth;
+  if (!GetDirectoryEntry(header, bucket_idx ^ low_bits, &image_page_id, &image_local_depth) ||
+      image_local_depth != local_depth) {
+    return false;
+  }
+  Page *bucket_page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  if (bucket_page == nullptr) {
+    return false;
+  }
+  Page *image_page = buffer_pool_manager_->FetchPage(image_page_id);
+  if (image_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    return false;
+  }
+  auto *bucket = AsBucketPage(bucket_page);
+  auto *image = AsBucketPage(image_page);
+  const uint32_t bucket_size = bucket->NumReadable();
+  const uint32_t image_size = image->NumReadable();
+  // an overflow chain holds pairs that could never fit one bucket
+  if (bucket->HasOverflow() || image->HasOverflow() || bucket_size + image_size > MERGE_MAX_SIZE) {
+    buffer_pool_manager_->UnpinPage(image_page_id, false);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    return false;
+  }
+  // the emptier bucket moves into the other one and gives up its page
+  if (bucket_size > image_size) {
+    std::swap(bucket, image);
+    std::swap(bucket_page_id, image_page_id);
+  }
+
+  // the entries of the bucket and of its image are the ones agreeing on the low local_depth - 1 bits
+  const bool updated = ForEachDirectoryEntry(header, bucket_idx & (low_bits - 1), low_bits,
+                                             [&](HashTableDirectoryPage *dir, uint32_t slot, uint32_t) {
+                                               dir->SetBucketPageId(slot, image_page_id);
+                                               dir->DecrLocalDepth(slot);
+                                               return true;
+                                             });
+  if (!updated) {
+    buffer_pool_manager_->UnpinPage(image_page_id, false);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table directory page");
+  }
+  for (uint32_t slot = 0; slot < TAGGED_BUCKET_ARRAY_SIZE && bucket->IsOccupied(slot); slot++) {
+    if (bucket->IsReadable(slot)) {
+      image->Insert(bucket->KeyAt(slot), bucket->ValueAt(slot), Hash(bucket->KeyAt(slot)), comparator_);
+    }
+  }
+  // the image's filter also still has the bits of keys removed since it was built
+  RebuildFilter(image, bucket_idx, local_depth - 1);
+  buffer_pool_manager_->UnpinPage(image_page_id, std::min(bucket_size, image_size) > 0);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  // nothing can reach the bucket once the directory no longer points at it
+  buffer_pool_manager_->DeletePage(bucket_page_id);
+
+  // only a bucket that used the global depth can have kept the directory from shrinking
+  if (local_depth == header->GetGlobalDepth() && ShrinkDirectory(header)) {
+    filters_.SetGlobalDepth(header->GetGlobalDepth());
+    *header_dirty = true;
+  }
+  return true;
+}
 
 /*****************************************************************************
  * GETGLOBALDEPTH - DO NOT TOUCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
-  table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
-  table_latch_.RUnlock();
+  Page *header_page = FetchHeaderPage();
+  header_page->RLatch();
+  uint32_t global_depth = AsHeaderPage(header_page)->GetGlobalDepth();
+  header_page->RUnlatch();
+  assert(buffer_pool_manager_->UnpinPage(header_page_id_, false, nullptr));
   return global_depth;
 }
 
 /*****************************************************************************
  * VERIFY INTEGRITY - DO NOT TOUCH
  *****************************************************************************/
+/*
+ * Checks the invariants of HashTableDirectoryPage::VerifyIntegrity over the
+ * whole directory, across its directory pages.
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
-  table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
-  table_latch_.RUnlock();
+  Page *header_page = FetchHeaderPage();
+  header_page->RLatch();
+  auto *header = AsHeaderPage(header_page);
+  const uint32_t global_depth = header->GetGlobalDepth();
+  std::unordered_map<page_id_t, uint32_t> page_id_to_count;
+  std::unordered_map<page_id_t, uint32_t> page_id_to_ld;
+  const bool fetched = ForEachDirectoryEntry(header, 0, 1, [&](HashTableDirectoryPage *dir, uint32_t slot, uint32_t) {
+    assert(dir->GetGlobalDepth() == std::min<uint32_t>(global_depth, DIRECTORY_MAX_DEPTH));
+    const page_id_t page_id = dir->GetBucketPageId(slot);
+    const uint32_t local_depth = dir->GetLocalDepth(slot);
+    assert(local_depth <= global_depth);
+    ++page_id_to_count[page_id];
+    if (page_id_to_ld.count(page_id) > 0 && page_id_to_ld[page_id] != local_depth) {
+      LOG_WARN("Verify Integrity: curr_local_depth: %u, old_local_depth %u, for page_id: %u", local_depth,
+               page_id_to_ld[page_id], page_id);
+      assert(false);
+    }
+    page_id_to_ld[page_id] = local_depth;
+    return false;
+  });
+  assert(fetched);
+  for (const auto &[page_id, count] : page_id_to_count) {
+    const uint32_t required_count = 1U << (global_depth - page_id_to_ld[page_id]);
+    if (count != required_count) {
+      LOG_WARN("Verify Integrity: curr_count: %u, required_count %u, for page_id: %u", count, required_count, page_id);
+      assert(count == required_count);
+    }
+  }
+  header_page->RUnlatch();
+  assert(buffer_pool_manager_->UnpinPage(header_page_id_, false, nullptr));
 }
 
 /*****************************************************************************
@@ -135,4 +981,8 @@ template class ExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
 template class ExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
 template class ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class ExtendibleHashTable<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class ExtendibleHashTable<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class ExtendibleHashTable<IntegerKey<16>, RID, IntegerComparator<16>>;
+
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -17,52 +18,404 @@
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
 #include "common/rid.h"
 #include "container/hash/linear_probe_hash_table.h"
 
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                      const KeyComparator &comparator, size_t num_buckets,
-                                      HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+LINEAR_PROBE_HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                   const KeyComparator &comparator, size_t num_buckets,
+                                                   HashFunction<KeyType> hash_fn, size_t migrate_slots_per_op)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      migrate_slots_per_op_(migrate_slots_per_op),
+      hash_fn_(std::move(hash_fn)) {
+  NewBlockArray(&blocks_, num_buckets);
+  header_page_id_ = blocks_.header_page_id_;
+}
+
+/*****************************************************************************
+ * BLOCK ARRAYS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::NewBlockArray(BlockArray *blocks, size_t num_buckets) {
+  const size_t num_blocks =
+      std::min(std::max<size_t>((num_buckets + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE, 1),
+               HashTableHeaderPage::MaxBlocks());
+  page_id_t header_page_id;
+  Page *header_page = buffer_pool_manager_->NewPage(&header_page_id);
+  if (header_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate hash table header page");
+  }
+  auto *header = reinterpret_cast<HashTableHeaderPage *>(header_page->GetData());
+  header->SetPageId(header_page_id);
+  header->SetSize(num_blocks * BLOCK_ARRAY_SIZE);
+  for (size_t i = 0; i < num_blocks; i++) {
+    header->AddBlockPageId(INVALID_PAGE_ID);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id, true);
+
+  blocks->header_page_id_ = header_page_id;
+  blocks->num_slots_ = num_blocks * BLOCK_ARRAY_SIZE;
+  blocks->block_page_ids_ = std::vector<std::atomic<page_id_t>>(num_blocks);
+  for (auto &block_page_id : blocks->block_page_ids_) {
+    block_page_id.store(INVALID_PAGE_ID);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::DeleteBlockArray(BlockArray *blocks) {
+  for (const auto &block_page_id : blocks->block_page_ids_) {
+    if (block_page_id.load() != INVALID_PAGE_ID) {
+      buffer_pool_manager_->DeletePage(block_page_id.load());
+    }
+  }
+  buffer_pool_manager_->DeletePage(blocks->header_page_id_);
+  blocks->header_page_id_ = INVALID_PAGE_ID;
+  blocks->num_slots_ = 0;
+  blocks->block_page_ids_.clear();
+}
+
+/*
+ * Only inserts and removes create blocks, and they are serialized, so a block
+ * is never allocated twice; lookups only ever read the page id.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *LINEAR_PROBE_HASH_TABLE_TYPE::FetchBlock(BlockArray *blocks, size_t block_idx, bool create) {
+  page_id_t block_page_id = blocks->block_page_ids_[block_idx].load();
+  if (block_page_id != INVALID_PAGE_ID) {
+    Page *page = buffer_pool_manager_->FetchPage(block_page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table block page");
+    }
+    return page;
+  }
+  if (!create) {
+    return nullptr;
+  }
+  Page *page = buffer_pool_manager_->NewPage(&block_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate hash table block page");
+  }
+  Page *header_page = buffer_pool_manager_->FetchPage(blocks->header_page_id_);
+  if (header_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(block_page_id, false);
+    buffer_pool_manager_->DeletePage(block_page_id);
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table header page");
+  }
+  reinterpret_cast<HashTableHeaderPage *>(header_page->GetData())->SetBlockPageId(block_idx, block_page_id);
+  buffer_pool_manager_->UnpinPage(blocks->header_page_id_, true);
+  blocks->block_page_ids_[block_idx].store(block_page_id);
+  return page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visitor>
+void LINEAR_PROBE_HASH_TABLE_TYPE::Probe(BlockArray *blocks, uint32_t hash, bool exclusive, bool create,
+                                         Visitor &&visit) {
+  auto release = [this, exclusive](Page *page) {
+    if (exclusive) {
+      page->WUnlatch();
+    } else {
+      page->RUnlatch();
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), exclusive);
+  };
+
+  const size_t start = hash % blocks->num_slots_;
+  Page *page = nullptr;
+  size_t block_idx = 0;
+  for (size_t i = 0; i < blocks->num_slots_; i++) {
+    const size_t slot = (start + i) % blocks->num_slots_;
+    if (page == nullptr || slot / BLOCK_ARRAY_SIZE != block_idx) {
+      if (page != nullptr) {
+        release(page);
+      }
+      block_idx = slot / BLOCK_ARRAY_SIZE;
+      page = FetchBlock(blocks, block_idx, create);
+      if (page == nullptr) {
+        // a block not allocated yet holds no pair, its first slot ends the probe
+        return;
+      }
+      if (exclusive) {
+        page->WLatch();
+      } else {
+        page->RLatch();
+      }
+    }
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    const slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    const bool occupied = block->IsOccupied(offset);
+    if (visit(block, offset) || !occupied) {
+      break;
+    }
+  }
+  if (page != nullptr) {
+    release(page);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::CollectValues(BlockArray *blocks, const KeyType &key, uint32_t hash, size_t first,
+                                                 std::vector<ValueType> *result) {
+  Probe(blocks, hash, false, false, [&](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset) {
+    if (block->IsReadable(offset) && comparator_(key, block->KeyAt(offset)) == 0) {
+      const ValueType value = block->ValueAt(offset);
+      if (std::find(result->begin() + first, result->end(), value) == result->end()) {
+        result->push_back(value);
+      }
+    }
+    return false;
+  });
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool LINEAR_PROBE_HASH_TABLE_TYPE::Contains(BlockArray *blocks, const KeyType &key, const ValueType &value,
+                                            uint32_t hash) {
+  bool found = false;
+  Probe(blocks, hash, false, false, [&](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset) {
+    found = block->IsReadable(offset) && comparator_(key, block->KeyAt(offset)) == 0 && block->ValueAt(offset) == value;
+    return found;
+  });
+  return found;
+}
+
+/*
+ * Tombstones are not reused: a block slot, once claimed, stays occupied until
+ * the next resize leaves it behind.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool LINEAR_PROBE_HASH_TABLE_TYPE::InsertInto(BlockArray *blocks, const KeyType &key, const ValueType &value,
+                                              uint32_t hash, bool check_duplicate) {
+  bool inserted = false;
+  Probe(blocks, hash, true, true, [&](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset) {
+    if (!block->IsOccupied(offset)) {
+      inserted = block->Insert(offset, key, value);
+      return true;
+    }
+    return check_duplicate && block->IsReadable(offset) && comparator_(key, block->KeyAt(offset)) == 0 &&
+           block->ValueAt(offset) == value;
+  });
+  if (inserted && blocks == &blocks_) {
+    num_occupied_++;
+  }
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool LINEAR_PROBE_HASH_TABLE_TYPE::RemoveFrom(BlockArray *blocks, const KeyType &key, const ValueType &value,
+                                              uint32_t hash) {
+  bool removed = false;
+  Probe(blocks, hash, true, false, [&](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset) {
+    if (block->IsReadable(offset) && comparator_(key, block->KeyAt(offset)) == 0 && block->ValueAt(offset) == value) {
+      block->Remove(offset);
+      removed = true;
+    }
+    return removed;
+  });
+  return removed;
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+bool LINEAR_PROBE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                            std::vector<ValueType> *result) {
+  const uint32_t hash = Hash(key);
+  const size_t first = result->size();
+  table_latch_.RLock();
+  try {
+    // a pair is added to blocks_ before it leaves old_blocks_, so probing in this order cannot miss it
+    if (old_blocks_.header_page_id_ != INVALID_PAGE_ID) {
+      CollectValues(&old_blocks_, key, hash, first, result);
+    }
+    CollectValues(&blocks_, key, hash, first, result);
+  } catch (Exception &e) {
+    table_latch_.RUnlock();
+    throw;
+  }
+  table_latch_.RUnlock();
+  return result->size() > first;
 }
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+bool LINEAR_PROBE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  const uint32_t hash = Hash(key);
+  std::scoped_lock write_lock(write_latch_);
+  bool inserted;
+  table_latch_.RLock();
+  try {
+    MigrateSlots(migrate_slots_per_op_);
+    inserted = !(old_blocks_.header_page_id_ != INVALID_PAGE_ID && Contains(&old_blocks_, key, value, hash)) &&
+               InsertInto(&blocks_, key, value, hash, true);
+  } catch (Exception &e) {
+    table_latch_.RUnlock();
+    throw;
+  }
+  table_latch_.RUnlock();
+  if (inserted) {
+    num_pairs_++;
+  }
+  MaintainBlockArrays();
+  return inserted;
 }
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+bool LINEAR_PROBE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  const uint32_t hash = Hash(key);
+  std::scoped_lock write_lock(write_latch_);
+  bool removed;
+  table_latch_.RLock();
+  try {
+    MigrateSlots(migrate_slots_per_op_);
+    removed = RemoveFrom(&blocks_, key, value, hash) ||
+              (old_blocks_.header_page_id_ != INVALID_PAGE_ID && RemoveFrom(&old_blocks_, key, value, hash));
+  } catch (Exception &e) {
+    table_latch_.RUnlock();
+    throw;
+  }
+  table_latch_.RUnlock();
+  if (removed) {
+    num_pairs_--;
+  }
+  MaintainBlockArrays();
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
+/*
+ * Writers are serialized and lookups never modify a block, so the old block
+ * is read without its latch; it is latched only to leave the tombstone, after
+ * the pair is in blocks_.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::MigrateSlots(size_t max_slots) {
+  if (old_blocks_.header_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  size_t visited = 0;
+  while (visited < max_slots && migrate_cursor_ < old_blocks_.num_slots_) {
+    const size_t block_idx = migrate_cursor_ / BLOCK_ARRAY_SIZE;
+    const size_t block_end = (block_idx + 1) * BLOCK_ARRAY_SIZE;
+    Page *page = FetchBlock(&old_blocks_, block_idx, false);
+    if (page == nullptr) {
+      migrate_cursor_ = block_end;
+      visited++;
+      continue;
+    }
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    bool is_dirty = false;
+    for (; visited < max_slots && migrate_cursor_ < block_end; visited++, migrate_cursor_++) {
+      const slot_offset_t offset = migrate_cursor_ % BLOCK_ARRAY_SIZE;
+      if (!block->IsReadable(offset)) {
+        continue;
+      }
+      const KeyType key = block->KeyAt(offset);
+      const bool inserted = InsertInto(&blocks_, key, block->ValueAt(offset), Hash(key), false);
+      BUSTUB_ASSERT(inserted, "new block array ran out of slots during a resize");
+      page->WLatch();
+      block->Remove(offset);
+      page->WUnlatch();
+      is_dirty = true;
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void LINEAR_PROBE_HASH_TABLE_TYPE::FinishResize() {
+  if (old_blocks_.header_page_id_ == INVALID_PAGE_ID || migrate_cursor_ < old_blocks_.num_slots_) {
+    return;
+  }
+  BlockArray done;
+  // wait out the lookups still probing the old block array
+  table_latch_.WLock();
+  std::swap(done, old_blocks_);
+  table_latch_.WUnlock();
+  DeleteBlockArray(&done);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::StartResize(size_t num_buckets) {
+  BlockArray fresh;
+  NewBlockArray(&fresh, num_buckets);
+  table_latch_.WLock();
+  std::swap(old_blocks_, blocks_);
+  std::swap(blocks_, fresh);
+  header_page_id_ = blocks_.header_page_id_;
+  migrate_cursor_ = 0;
+  num_occupied_ = 0;
+  table_latch_.WUnlock();
+}
+
+/*
+ * A resize starts once three quarters of the slots are occupied. The new
+ * block array doubles if live pairs fill more than half of the occupied
+ * slots, otherwise it keeps the size and only drops the tombstones. Growing
+ * by half the table's slots before the next resize is due leaves the
+ * migration time to finish at any migrate_slots_per_op_.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::MaintainBlockArrays() {
+  FinishResize();
+  if (old_blocks_.header_page_id_ != INVALID_PAGE_ID || num_occupied_ * 4 <= blocks_.num_slots_ * 3) {
+    return;
+  }
+  const size_t max_slots = HashTableHeaderPage::MaxBlocks() * BLOCK_ARRAY_SIZE;
+  const size_t num_buckets = std::min(num_pairs_ * 2 > num_occupied_ ? blocks_.num_slots_ * 2 : blocks_.num_slots_,
+                                      max_slots);
+  // a rebuild that would leave the table as full as it is gains nothing
+  if (num_pairs_ * 4 > num_buckets * 3) {
+    return;
+  }
+  StartResize(num_buckets);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  std::scoped_lock write_lock(write_latch_);
+  if (old_blocks_.header_page_id_ != INVALID_PAGE_ID) {
+    table_latch_.RLock();
+    try {
+      MigrateSlots(old_blocks_.num_slots_);
+    } catch (Exception &e) {
+      table_latch_.RUnlock();
+      throw;
+    }
+    table_latch_.RUnlock();
+    FinishResize();
+  }
+  StartResize(2 * initial_size);
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-size_t HASH_TABLE_TYPE::GetSize() {
-  return 0;
+size_t LINEAR_PROBE_HASH_TABLE_TYPE::GetSize() {
+  table_latch_.RLock();
+  const size_t size = blocks_.num_slots_;
+  table_latch_.RUnlock();
+  return size;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool LINEAR_PROBE_HASH_TABLE_TYPE::IsResizing() {
+  table_latch_.RLock();
+  const bool resizing = old_blocks_.header_page_id_ != INVALID_PAGE_ID;
+  table_latch_.RUnlock();
+  return resizing;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
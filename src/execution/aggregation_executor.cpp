@@ -1,29 +1,272 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// aggregation_executor.cpp
-//
-// Identification: src/execution/aggregation_executor.cpp
-//
-// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include <memory>
-#include <vector>
-
-#include "execution/executors/aggregation_executor.h"
-
-namespace bustub {
-
-AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
-                                         std::unique_ptr<AbstractExecutor> &&child)
-    : AbstractExecutor(exec_ctx) {}
-
-void AggregationExecutor::Init() {}
-
-bool AggregationExecutor::Next(Tuple *tuple, RID *rid) { return false; }
-
-const AbstractExecutor *AggregationExecutor::GetChildExecutor() const { return child_.get(); }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_executor.cpp
+//
+// Identification: src/execution/aggregation_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/util/thread_util.h"
+#include "execution/executors/aggregation_executor.h"
+
+namespace bustub {
+
+AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
+                                         std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_(std::move(child)),
+      aht_(std::make_unique<AggregationHashTable>(plan)) {}
+
+void AggregationExecutor::Init() {
+  child_->Init();
+  aht_->Clear();
+  spilled_.clear();
+  merged_.clear();
+  next_merged_ = 0;
+  next_group_ = 0;
+  chunk_matches_.clear();
+  next_in_chunk_ = 0;
+  having_compiled_ = false;
+  if (exec_ctx_->GetParallelism() > 1) {
+    ParallelInit();
+    return;
+  }
+
+  std::vector<std::unique_ptr<TmpTupleFile>> partitions;
+  TupleBatch batch;
+  while (child_->NextBatch(&batch)) {
+    aht_->InsertBatch(batch, child_->GetOutputSchema());
+    if (aht_->MemoryUsage() > exec_ctx_->GetMemoryBudget()) {
+      Spill(&partitions, 0);
+    }
+  }
+  if (!partitions.empty()) {
+    Spill(&partitions, 0);
+    FinishSpill(&partitions, 0);
+  }
+}
+
+void AggregationExecutor::ParallelInit() {
+  const uint32_t num_workers = exec_ctx_->GetParallelism();
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (uint32_t w = 0; w < num_workers; w++) {
+    workers.push_back(std::make_unique<Worker>(plan_));
+  }
+
+  const Schema *child_schema = child_->GetOutputSchema();
+  child_->ParallelDrain([this, &workers, child_schema](uint32_t w, TupleBatch *batch) {
+    Worker *worker = workers[w].get();
+    worker->table_.InsertBatch(*batch, child_schema);
+    worker->rows_ += batch->Size();
+    if (worker->pass_through_ || worker->table_.Size() >= PREAGGREGATION_GROUPS) {
+      HandOn(worker);
+    }
+    return true;
+  });
+  ThreadUtil::RunWorkers(num_workers, [this, &workers](uint32_t w) { HandOn(workers[w].get()); });
+
+  // once any worker spilled, the groups of a partition may be on disk and all of them are merged from there
+  if (!parallel_spill_.empty()) {
+    for (auto &worker : workers) {
+      SpillPartials(worker.get());
+    }
+    FinishSpill(&parallel_spill_, 0);
+    return;
+  }
+
+  merged_.resize(SPILL_FANOUT);
+  ThreadUtil::RunWorkers(num_workers, [this, &workers, num_workers](uint32_t w) {
+    for (size_t p = w; p < SPILL_FANOUT; p += num_workers) {
+      merged_[p] = std::make_unique<AggregationHashTable>(plan_);
+      for (auto &worker : workers) {
+        merged_[p]->MergePartials(worker->partials_[p]);
+        std::vector<Tuple>().swap(worker->partials_[p]);
+      }
+    }
+  });
+}
+
+void AggregationExecutor::HandOn(Worker *worker) {
+  AggregationHashTable &table = worker->table_;
+  if (table.Size() == 0) {
+    return;
+  }
+  if (!worker->pass_through_ && worker->rows_ < table.Size() * MIN_REDUCTION) {
+    worker->pass_through_ = true;
+  }
+  for (size_t group = 0; group < table.Size(); group++) {
+    Tuple partial = table.GetPartial(group);
+    worker->partial_bytes_ += sizeof(Tuple) + partial.GetLength();
+    worker->partials_[SpillPartition(table.PartitionHash(group), 0)].push_back(std::move(partial));
+  }
+  table.Clear();
+  worker->rows_ = 0;
+  if (worker->partial_bytes_ > exec_ctx_->GetMemoryBudget() / exec_ctx_->GetParallelism()) {
+    SpillPartials(worker);
+  }
+}
+
+void AggregationExecutor::SpillPartials(Worker *worker) {
+  std::lock_guard<std::mutex> guard(spill_latch_);
+  if (parallel_spill_.empty()) {
+    for (size_t p = 0; p < SPILL_FANOUT; p++) {
+      parallel_spill_.push_back(std::make_unique<TmpTupleFile>(exec_ctx_->GetBufferPoolManager()));
+    }
+  }
+  for (size_t p = 0; p < SPILL_FANOUT; p++) {
+    for (const auto &partial : worker->partials_[p]) {
+      parallel_spill_[p]->Append(partial);
+    }
+    std::vector<Tuple>().swap(worker->partials_[p]);
+  }
+  worker->partial_bytes_ = 0;
+}
+
+void AggregationExecutor::Spill(std::vector<std::unique_ptr<TmpTupleFile>> *partitions, uint32_t level) {
+  if (partitions->empty()) {
+    for (size_t p = 0; p < SPILL_FANOUT; p++) {
+      partitions->push_back(std::make_unique<TmpTupleFile>(exec_ctx_->GetBufferPoolManager()));
+    }
+  }
+  for (size_t group = 0; group < aht_->Size(); group++) {
+    (*partitions)[SpillPartition(aht_->PartitionHash(group), level)]->Append(aht_->GetPartial(group));
+  }
+  aht_->Clear();
+}
+
+void AggregationExecutor::FinishSpill(std::vector<std::unique_ptr<TmpTupleFile>> *partitions, uint32_t level) {
+  for (auto &file : *partitions) {
+    file->Finish();
+    if (file->Size() > 0) {
+      spilled_.push_back({std::move(file), level});
+    }
+  }
+  partitions->clear();
+}
+
+bool AggregationExecutor::MergeNextPartition() {
+  aht_->Clear();
+  next_group_ = 0;
+  if (spilled_.empty()) {
+    return false;
+  }
+  SpilledPartition partition = std::move(spilled_.back());
+  spilled_.pop_back();
+
+  // past the last level, or down to one group, the partition is merged in memory regardless
+  const uint32_t level = partition.level_ + 1;
+  std::vector<std::unique_ptr<TmpTupleFile>> partitions;
+  std::vector<Tuple> partials;
+  for (size_t page = 0; page < partition.file_->NumPages(); page++) {
+    partials.clear();
+    partition.file_->ReadPage(page, &partials);
+    aht_->MergePartials(partials);
+    if (level < MAX_SPILL_LEVELS && aht_->Size() > 1 && aht_->MemoryUsage() > exec_ctx_->GetMemoryBudget()) {
+      Spill(&partitions, level);
+    }
+  }
+  partition.file_.reset();
+  if (!partitions.empty()) {
+    Spill(&partitions, level);
+    FinishSpill(&partitions, level);
+  }
+  return true;
+}
+
+bool AggregationExecutor::NextTable() {
+  if (next_merged_ < merged_.size()) {
+    aht_ = std::move(merged_[next_merged_++]);
+    next_group_ = 0;
+    return true;
+  }
+  return MergeNextPartition();
+}
+
+void AggregationExecutor::FetchGroups() {
+  const size_t num_groups = std::min<size_t>(ExpressionProgram::MAX_LANES, aht_->Size() - next_group_);
+  chunk_group_bys_.resize(num_groups);
+  chunk_aggregates_.resize(num_groups);
+  for (size_t i = 0; i < num_groups; i++) {
+    aht_->GetGroup(next_group_++, &chunk_group_bys_[i], &chunk_aggregates_[i]);
+  }
+  chunk_matches_.assign(num_groups, 1);
+  next_in_chunk_ = 0;
+
+  const AbstractExpression *having = plan_->GetHaving();
+  if (having == nullptr || num_groups == 0) {
+    return;
+  }
+  if (!having_compiled_) {
+    // every group has the types of the first
+    std::vector<TypeId> group_by_types;
+    std::vector<TypeId> aggregate_types;
+    for (const auto &value : chunk_group_bys_[0]) {
+      group_by_types.push_back(value.GetTypeId());
+    }
+    for (const auto &value : chunk_aggregates_[0]) {
+      aggregate_types.push_back(value.GetTypeId());
+    }
+    having_program_ = ExpressionProgram::CompileAggregate(having, group_by_types, aggregate_types);
+    if (having_program_ != nullptr) {
+      having_registers_ = std::make_unique<ExpressionProgram::Registers>(*having_program_);
+    }
+    having_compiled_ = true;
+  }
+  if (having_program_ != nullptr) {
+    having_program_->MatchGroups(chunk_group_bys_.data(), chunk_aggregates_.data(), num_groups,
+                                 having_registers_.get(), chunk_matches_.data());
+    return;
+  }
+  for (size_t i = 0; i < num_groups; i++) {
+    const Value result = having->EvaluateAggregate(chunk_group_bys_[i], chunk_aggregates_[i]);
+    chunk_matches_[i] = static_cast<uint8_t>(!result.IsNull() && result.GetAs<bool>());
+  }
+}
+
+bool AggregationExecutor::NextGroup(Tuple *tuple) {
+  do {
+    while (next_in_chunk_ < chunk_matches_.size() || next_group_ < aht_->Size()) {
+      if (next_in_chunk_ == chunk_matches_.size()) {
+        FetchGroups();
+        continue;
+      }
+      const size_t i = next_in_chunk_++;
+      if (chunk_matches_[i] == 0) {
+        continue;
+      }
+
+      std::vector<Value> values;
+      values.reserve(GetOutputSchema()->GetColumnCount());
+      for (const auto &col : GetOutputSchema()->GetColumns()) {
+        values.push_back(col.GetExpr()->EvaluateAggregate(chunk_group_bys_[i], chunk_aggregates_[i]));
+      }
+      *tuple = Tuple(values, GetOutputSchema());
+      return true;
+    }
+  } while (NextTable());
+  return false;
+}
+
+bool AggregationExecutor::Next(Tuple *tuple, RID *rid) { return NextGroup(tuple); }
+
+bool AggregationExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  Tuple tuple;
+  while (!batch->IsFull() && NextGroup(&tuple)) {
+    batch->Append(std::move(tuple), RID());
+  }
+  return !batch->Empty();
+}
+
+const AbstractExecutor *AggregationExecutor::GetChildExecutor() const { return child_.get(); }
+
+}  // namespace bustub
@@ -0,0 +1,500 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_hash_table.cpp
+//
+// Identification: src/execution/aggregation_hash_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/aggregation_hash_table.h"
+
+#include <string>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/util/hash_util.h"
+#include "execution/expressions/abstract_expression.h"
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the type SUM reports for an input type */
+TypeId SumType(TypeId input) {
+  switch (input) {
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+      return input;
+    default:
+      return TypeId::INTEGER;
+  }
+}
+
+/** @return a column of a partial aggregate */
+Column MakeColumn(const std::string &name, TypeId type) {
+  return type == TypeId::VARCHAR ? Column(name, type, BUSTUB_VARCHAR_MAX_LEN) : Column(name, type);
+}
+
+}  // namespace
+
+AggregationHashTable::AggregationHashTable(const AggregationPlanNode *plan) : plan_(plan) {
+  for (const auto *group_by : plan_->GetGroupBys()) {
+    key_types_.push_back(group_by->GetReturnType());
+  }
+  BUSTUB_ASSERT(key_types_.size() <= 64, "the NULL flags of a key fit a word");
+  key_words_ = key_types_.size() + (key_types_.empty() ? 0 : 1);
+
+  for (size_t i = 0; i < plan_->GetAggregates().size(); i++) {
+    const TypeId type = plan_->GetAggregateAt(i)->GetReturnType();
+    input_types_.push_back(type);
+    const bool is_double = type == TypeId::DECIMAL;
+    const bool is_string = type == TypeId::VARCHAR;
+    switch (plan_->GetAggregateTypes()[i]) {
+      case AggregationType::CountAggregate:
+        kinds_.push_back(AccumulatorKind::Count);
+        break;
+      case AggregationType::SumAggregate:
+      case AggregationType::AvgAggregate: {
+        if (is_string || type == TypeId::BOOLEAN || type == TypeId::TIMESTAMP) {
+          throw Exception(ExceptionType::MISMATCH_TYPE, "SUM and AVG take numeric input");
+        }
+        const bool is_sum = plan_->GetAggregateTypes()[i] == AggregationType::SumAggregate;
+        if (is_sum) {
+          kinds_.push_back(is_double ? AccumulatorKind::SumDouble : AccumulatorKind::SumInt);
+        } else {
+          kinds_.push_back(is_double ? AccumulatorKind::AvgDouble : AccumulatorKind::AvgInt);
+        }
+        break;
+      }
+      case AggregationType::MinAggregate:
+        kinds_.push_back(is_string ? AccumulatorKind::MinString
+                                   : is_double ? AccumulatorKind::MinDouble : AccumulatorKind::MinInt);
+        break;
+      case AggregationType::MaxAggregate:
+        kinds_.push_back(is_string ? AccumulatorKind::MaxString
+                                   : is_double ? AccumulatorKind::MaxDouble : AccumulatorKind::MaxInt);
+        break;
+    }
+  }
+  group_words_ = key_words_ + 2 * kinds_.size();
+  slots_.assign(MIN_CAPACITY, Slot{0, nullptr});
+
+  std::vector<Column> columns;
+  for (size_t g = 0; g < key_types_.size(); g++) {
+    columns.push_back(MakeColumn("group" + std::to_string(g), key_types_[g]));
+  }
+  for (size_t agg = 0; agg < kinds_.size(); agg++) {
+    columns.emplace_back("count" + std::to_string(agg), TypeId::BIGINT);
+    if (kinds_[agg] != AccumulatorKind::Count) {
+      columns.push_back(MakeColumn("accumulator" + std::to_string(agg), AccumulatorType(agg)));
+    }
+  }
+  partial_schema_ = std::make_unique<Schema>(columns);
+}
+
+void AggregationHashTable::Clear() {
+  slots_.assign(MIN_CAPACITY, Slot{0, nullptr});
+  groups_.clear();
+  arena_.Reset();
+  string_ids_.Clear();
+  string_pool_.clear();
+  string_bytes_ = 0;
+}
+
+uint64_t AggregationHashTable::ToWord(const Value &value, TypeId type) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int8_t>()));
+    case TypeId::SMALLINT:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int16_t>()));
+    case TypeId::INTEGER:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int32_t>()));
+    case TypeId::BIGINT:
+      return static_cast<uint64_t>(value.GetAs<int64_t>());
+    case TypeId::TIMESTAMP:
+      return value.GetAs<uint64_t>();
+    case TypeId::DECIMAL: {
+      // -0.0 and 0.0 are one key
+      const double decimal = value.GetAs<double>();
+      return FromDouble(decimal == 0 ? 0.0 : decimal);
+    }
+    case TypeId::VARCHAR:
+      return Intern(std::string_view(value.GetData(), strnlen(value.GetData(), value.GetLength())));
+    default:
+      UNREACHABLE("cannot aggregate over column type");
+  }
+}
+
+Value AggregationHashTable::FromWord(uint64_t word, TypeId type) const {
+  switch (type) {
+    case TypeId::BOOLEAN:
+      return ValueFactory::GetBooleanValue(static_cast<int8_t>(word));
+    case TypeId::TINYINT:
+      return ValueFactory::GetTinyIntValue(static_cast<int8_t>(word));
+    case TypeId::SMALLINT:
+      return ValueFactory::GetSmallIntValue(static_cast<int16_t>(word));
+    case TypeId::INTEGER:
+      return ValueFactory::GetIntegerValue(static_cast<int32_t>(word));
+    case TypeId::BIGINT:
+      return ValueFactory::GetBigIntValue(static_cast<int64_t>(word));
+    case TypeId::TIMESTAMP:
+      return ValueFactory::GetTimestampValue(static_cast<int64_t>(word));
+    case TypeId::DECIMAL:
+      return ValueFactory::GetDecimalValue(ToDouble(word));
+    case TypeId::VARCHAR:
+      return ValueFactory::GetVarcharValue(string_pool_[word]);
+    default:
+      UNREACHABLE("cannot aggregate over column type");
+  }
+}
+
+uint64_t AggregationHashTable::Intern(std::string_view str) {
+  const hash_t hash = string_ids_.Hash(str);
+  if (const uint64_t *id = string_ids_.Find(str, hash); id != nullptr) {
+    return *id;
+  }
+  // the pool is a deque, so the views into it the dictionary keeps stay valid
+  string_pool_.emplace_back(str);
+  string_bytes_ += sizeof(std::string) + str.size();
+  string_ids_.FindOrInsert(std::string_view(string_pool_.back()), hash, string_pool_.size() - 1);
+  return string_pool_.size() - 1;
+}
+
+uint64_t *AggregationHashTable::FindOrInsert(const uint64_t *key, hash_t hash) {
+  if ((groups_.size() + 1) * MAX_LOAD_DENOMINATOR > slots_.size() * MAX_LOAD_NUMERATOR) {
+    Grow();
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    Slot &slot = slots_[i];
+    if (slot.group_ == nullptr) {
+      auto *group = static_cast<uint64_t *>(arena_.Allocate(group_words_ * sizeof(uint64_t), alignof(uint64_t)));
+      memcpy(group, key, key_words_ * sizeof(uint64_t));
+      memset(group + key_words_, 0, (group_words_ - key_words_) * sizeof(uint64_t));
+      slot = Slot{hash, group};
+      groups_.push_back(group);
+      return group;
+    }
+    if (slot.hash_ == hash && memcmp(slot.group_, key, key_words_ * sizeof(uint64_t)) == 0) {
+      return slot.group_;
+    }
+  }
+}
+
+void AggregationHashTable::Grow() {
+  std::vector<Slot> slots(slots_.size() * 2, Slot{0, nullptr});
+  const size_t mask = slots.size() - 1;
+  for (const auto &slot : slots_) {
+    if (slot.group_ == nullptr) {
+      continue;
+    }
+    size_t i = slot.hash_ & mask;
+    while (slots[i].group_ != nullptr) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = slot;
+  }
+  slots_ = std::move(slots);
+}
+
+void AggregationHashTable::PackKey(size_t group_by, const Value &value, uint64_t *key) {
+  // the NULL flags are the last word
+  if (value.IsNull()) {
+    key[key_words_ - 1] |= 1ULL << group_by;
+  } else {
+    key[group_by] = ToWord(value, key_types_[group_by]);
+  }
+}
+
+void AggregationHashTable::UnpackKey(const uint64_t *group, std::vector<Value> *group_bys) const {
+  group_bys->clear();
+  for (size_t g = 0; g < key_types_.size(); g++) {
+    const bool is_null = (group[key_words_ - 1] >> g & 1) != 0;
+    group_bys->push_back(is_null ? ValueFactory::GetNullValueByType(key_types_[g]) : FromWord(group[g], key_types_[g]));
+  }
+}
+
+void AggregationHashTable::FindGroups(size_t num_rows) {
+  hashes_.resize(num_rows);
+  targets_.resize(num_rows);
+  for (size_t i = 0; i < num_rows; i++) {
+    hashes_[i] = HashUtil::HashBytes(reinterpret_cast<const char *>(&keys_[i * key_words_]),
+                                     key_words_ * sizeof(uint64_t));
+  }
+  for (size_t i = 0; i < num_rows; i++) {
+    targets_[i] = FindOrInsert(&keys_[i * key_words_], hashes_[i]);
+  }
+}
+
+void AggregationHashTable::InsertBatch(const TupleBatch &batch, const Schema *schema) {
+  const size_t num_rows = batch.Size();
+  if (num_rows == 0) {
+    return;
+  }
+
+  const auto &group_bys = plan_->GetGroupBys();
+  keys_.assign(num_rows * key_words_, 0);
+  for (size_t g = 0; g < group_bys.size(); g++) {
+    for (uint32_t i = 0; i < num_rows; i++) {
+      PackKey(g, group_bys[g]->Evaluate(&batch.GetTuple(i), schema), &keys_[i * key_words_]);
+    }
+  }
+  FindGroups(num_rows);
+
+  values_.resize(num_rows);
+  for (size_t agg = 0; agg < kinds_.size(); agg++) {
+    if (kinds_[agg] != AccumulatorKind::Count) {
+      const AbstractExpression *expr = plan_->GetAggregateAt(agg);
+      for (uint32_t i = 0; i < num_rows; i++) {
+        values_[i] = expr->Evaluate(&batch.GetTuple(i), schema);
+      }
+    }
+    Accumulate(agg, key_words_ + 2 * agg, num_rows);
+  }
+}
+
+/*
+ * acc[0] counts the inputs folded so far, so the first one replaces the
+ * accumulator of MIN and MAX.
+ */
+template <AggregationHashTable::AccumulatorKind Kind>
+void AggregationHashTable::Combine(uint64_t *acc, uint64_t word) const {
+  if constexpr (Kind == AccumulatorKind::SumInt || Kind == AccumulatorKind::AvgInt) {
+    acc[1] += word;
+  } else if constexpr (Kind == AccumulatorKind::SumDouble || Kind == AccumulatorKind::AvgDouble) {
+    acc[1] = FromDouble(ToDouble(acc[1]) + ToDouble(word));
+  } else if constexpr (Kind == AccumulatorKind::MinInt) {
+    if (acc[0] == 0 || static_cast<int64_t>(word) < static_cast<int64_t>(acc[1])) {
+      acc[1] = word;
+    }
+  } else if constexpr (Kind == AccumulatorKind::MaxInt) {
+    if (acc[0] == 0 || static_cast<int64_t>(word) > static_cast<int64_t>(acc[1])) {
+      acc[1] = word;
+    }
+  } else if constexpr (Kind == AccumulatorKind::MinDouble) {
+    if (acc[0] == 0 || ToDouble(word) < ToDouble(acc[1])) {
+      acc[1] = word;
+    }
+  } else if constexpr (Kind == AccumulatorKind::MaxDouble) {
+    if (acc[0] == 0 || ToDouble(word) > ToDouble(acc[1])) {
+      acc[1] = word;
+    }
+  } else if constexpr (Kind == AccumulatorKind::MinString) {
+    if (acc[0] == 0 || string_pool_[word] < string_pool_[acc[1]]) {
+      acc[1] = word;
+    }
+  } else if constexpr (Kind == AccumulatorKind::MaxString) {
+    if (acc[0] == 0 || string_pool_[word] > string_pool_[acc[1]]) {
+      acc[1] = word;
+    }
+  }
+}
+
+void AggregationHashTable::Combine(AccumulatorKind kind, uint64_t *acc, uint64_t word) const {
+  switch (kind) {
+    case AccumulatorKind::Count:
+      break;
+    case AccumulatorKind::SumInt:
+    case AccumulatorKind::AvgInt:
+      Combine<AccumulatorKind::SumInt>(acc, word);
+      break;
+    case AccumulatorKind::SumDouble:
+    case AccumulatorKind::AvgDouble:
+      Combine<AccumulatorKind::SumDouble>(acc, word);
+      break;
+    case AccumulatorKind::MinInt:
+      Combine<AccumulatorKind::MinInt>(acc, word);
+      break;
+    case AccumulatorKind::MaxInt:
+      Combine<AccumulatorKind::MaxInt>(acc, word);
+      break;
+    case AccumulatorKind::MinDouble:
+      Combine<AccumulatorKind::MinDouble>(acc, word);
+      break;
+    case AccumulatorKind::MaxDouble:
+      Combine<AccumulatorKind::MaxDouble>(acc, word);
+      break;
+    case AccumulatorKind::MinString:
+      Combine<AccumulatorKind::MinString>(acc, word);
+      break;
+    case AccumulatorKind::MaxString:
+      Combine<AccumulatorKind::MaxString>(acc, word);
+      break;
+  }
+}
+
+template <AggregationHashTable::AccumulatorKind Kind>
+void AggregationHashTable::FoldInputs(size_t agg, size_t offset, size_t num_rows) {
+  const TypeId type = input_types_[agg];
+  for (size_t i = 0; i < num_rows; i++) {
+    if (values_[i].IsNull()) {
+      continue;
+    }
+    uint64_t *acc = targets_[i] + offset;
+    Combine<Kind>(acc, ToWord(values_[i], type));
+    acc[0]++;
+  }
+}
+
+void AggregationHashTable::Accumulate(size_t agg, size_t offset, size_t num_rows) {
+  switch (kinds_[agg]) {
+    case AccumulatorKind::Count:
+      for (size_t i = 0; i < num_rows; i++) {
+        targets_[i][offset]++;
+      }
+      break;
+    case AccumulatorKind::SumInt:
+    case AccumulatorKind::AvgInt:
+      FoldInputs<AccumulatorKind::SumInt>(agg, offset, num_rows);
+      break;
+    case AccumulatorKind::SumDouble:
+    case AccumulatorKind::AvgDouble:
+      FoldInputs<AccumulatorKind::SumDouble>(agg, offset, num_rows);
+      break;
+    case AccumulatorKind::MinInt:
+      FoldInputs<AccumulatorKind::MinInt>(agg, offset, num_rows);
+      break;
+    case AccumulatorKind::MaxInt:
+      FoldInputs<AccumulatorKind::MaxInt>(agg, offset, num_rows);
+      break;
+    case AccumulatorKind::MinDouble:
+      FoldInputs<AccumulatorKind::MinDouble>(agg, offset, num_rows);
+      break;
+    case AccumulatorKind::MaxDouble:
+      FoldInputs<AccumulatorKind::MaxDouble>(agg, offset, num_rows);
+      break;
+    case AccumulatorKind::MinString:
+      FoldInputs<AccumulatorKind::MinString>(agg, offset, num_rows);
+      break;
+    case AccumulatorKind::MaxString:
+      FoldInputs<AccumulatorKind::MaxString>(agg, offset, num_rows);
+      break;
+  }
+}
+
+void AggregationHashTable::GetGroup(size_t group, std::vector<Value> *group_bys,
+                                    std::vector<Value> *aggregates) const {
+  const uint64_t *words = groups_[group];
+  UnpackKey(words, group_bys);
+
+  aggregates->clear();
+  for (size_t agg = 0; agg < kinds_.size(); agg++) {
+    const uint64_t *acc = words + key_words_ + 2 * agg;
+    const TypeId type = input_types_[agg];
+    if (kinds_[agg] == AccumulatorKind::Count) {
+      aggregates->push_back(ValueFactory::GetIntegerValue(static_cast<int32_t>(acc[0])));
+      continue;
+    }
+    const bool is_avg = kinds_[agg] == AccumulatorKind::AvgInt || kinds_[agg] == AccumulatorKind::AvgDouble;
+    if (acc[0] == 0) {
+      const bool is_sum = kinds_[agg] == AccumulatorKind::SumInt || kinds_[agg] == AccumulatorKind::SumDouble;
+      aggregates->push_back(
+          ValueFactory::GetNullValueByType(is_avg ? TypeId::DECIMAL : is_sum ? SumType(type) : type));
+      continue;
+    }
+    switch (kinds_[agg]) {
+      case AccumulatorKind::SumInt:
+        aggregates->push_back(SumType(type) == TypeId::BIGINT
+                                  ? ValueFactory::GetBigIntValue(static_cast<int64_t>(acc[1]))
+                                  : ValueFactory::GetIntegerValue(static_cast<int32_t>(acc[1])));
+        break;
+      case AccumulatorKind::AvgInt:
+        aggregates->push_back(ValueFactory::GetDecimalValue(static_cast<double>(static_cast<int64_t>(acc[1])) /
+                                                            static_cast<double>(acc[0])));
+        break;
+      case AccumulatorKind::AvgDouble:
+        aggregates->push_back(ValueFactory::GetDecimalValue(ToDouble(acc[1]) / static_cast<double>(acc[0])));
+        break;
+      default:
+        // SUM of DECIMAL, MIN and MAX hold their result in the input's own representation
+        aggregates->push_back(FromWord(acc[1], type));
+        break;
+    }
+  }
+}
+
+size_t AggregationHashTable::MemoryUsage() const {
+  return slots_.size() * sizeof(Slot) + groups_.capacity() * sizeof(uint64_t *) + arena_.MemoryUsage() +
+         string_ids_.MemoryUsage() + string_bytes_;
+}
+
+TypeId AggregationHashTable::AccumulatorType(size_t agg) const {
+  switch (kinds_[agg]) {
+    case AccumulatorKind::Count:
+    case AccumulatorKind::SumInt:
+    case AccumulatorKind::AvgInt:
+      return TypeId::BIGINT;
+    case AccumulatorKind::SumDouble:
+    case AccumulatorKind::AvgDouble:
+      return TypeId::DECIMAL;
+    default:
+      return input_types_[agg];
+  }
+}
+
+Tuple AggregationHashTable::GetPartial(size_t group) const {
+  const uint64_t *words = groups_[group];
+  std::vector<Value> values;
+  UnpackKey(words, &values);
+  for (size_t agg = 0; agg < kinds_.size(); agg++) {
+    const uint64_t *acc = words + key_words_ + 2 * agg;
+    values.push_back(ValueFactory::GetBigIntValue(static_cast<int64_t>(acc[0])));
+    if (kinds_[agg] != AccumulatorKind::Count) {
+      const TypeId type = AccumulatorType(agg);
+      values.push_back(acc[0] == 0 ? ValueFactory::GetNullValueByType(type) : FromWord(acc[1], type));
+    }
+  }
+  return Tuple(values, partial_schema_.get());
+}
+
+hash_t AggregationHashTable::PartitionHash(size_t group) const {
+  std::vector<uint64_t> key(groups_[group], groups_[group] + key_words_);
+  for (size_t g = 0; g < key_types_.size(); g++) {
+    if (key_types_[g] == TypeId::VARCHAR && (key[key_words_ - 1] >> g & 1) == 0) {
+      const std::string &str = string_pool_[key[g]];
+      key[g] = HashUtil::HashBytes(str.data(), str.size());
+    }
+  }
+  return HashUtil::HashBytes(reinterpret_cast<const char *>(key.data()), key.size() * sizeof(uint64_t));
+}
+
+void AggregationHashTable::MergePartials(const std::vector<Tuple> &partials) {
+  const size_t num_rows = partials.size();
+  if (num_rows == 0) {
+    return;
+  }
+
+  const Schema *schema = partial_schema_.get();
+  keys_.assign(num_rows * key_words_, 0);
+  for (size_t g = 0; g < key_types_.size(); g++) {
+    for (size_t i = 0; i < num_rows; i++) {
+      PackKey(g, partials[i].GetValue(schema, g), &keys_[i * key_words_]);
+    }
+  }
+  FindGroups(num_rows);
+
+  auto col = static_cast<uint32_t>(key_types_.size());
+  for (size_t agg = 0; agg < kinds_.size(); agg++) {
+    const size_t offset = key_words_ + 2 * agg;
+    const AccumulatorKind kind = kinds_[agg];
+    const TypeId type = AccumulatorType(agg);
+    for (size_t i = 0; i < num_rows; i++) {
+      uint64_t *acc = targets_[i] + offset;
+      const auto count = static_cast<uint64_t>(partials[i].GetValue(schema, col).GetAs<int64_t>());
+      if (kind != AccumulatorKind::Count && count > 0) {
+        Combine(kind, acc, ToWord(partials[i].GetValue(schema, col + 1), type));
+      }
+      acc[0] += count;
+    }
+    col += kind == AccumulatorKind::Count ? 1 : 2;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// batch_queue.cpp
+//
+// Identification: src/execution/batch_queue.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/batch_queue.h"
+
+#include <utility>
+
+namespace bustub {
+
+BatchQueue::~BatchQueue() {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    closed_ = true;
+  }
+  not_full_.notify_all();
+  if (producer_.joinable()) {
+    producer_.join();
+  }
+}
+
+void BatchQueue::Start(std::function<void()> producer) {
+  BUSTUB_ASSERT(!producer_.joinable(), "the queue has a producer already");
+  producer_ = std::thread([this, producer = std::move(producer)] {
+    std::exception_ptr error;
+    try {
+      producer();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> guard(latch_);
+    finished_ = true;
+    error_ = error;
+    not_empty_.notify_one();
+  });
+}
+
+bool BatchQueue::Push(TupleBatch *batch) {
+  std::unique_lock<std::mutex> guard(latch_);
+  not_full_.wait(guard, [this] { return closed_ || batches_.size() < max_batches_; });
+  if (closed_) {
+    return false;
+  }
+  batches_.push_back(std::move(*batch));
+  batch->Clear();
+  not_empty_.notify_one();
+  return true;
+}
+
+bool BatchQueue::FetchBatch() {
+  std::unique_lock<std::mutex> guard(latch_);
+  not_empty_.wait(guard, [this] { return !batches_.empty() || finished_; });
+  if (batches_.empty()) {
+    if (error_ != nullptr) {
+      std::rethrow_exception(error_);
+    }
+    return false;
+  }
+  current_ = std::move(batches_.front());
+  batches_.pop_front();
+  current_cursor_ = 0;
+  guard.unlock();
+  not_full_.notify_one();
+  return true;
+}
+
+bool BatchQueue::Next(Tuple *tuple, RID *rid) {
+  if (current_cursor_ == current_.Size() && !FetchBatch()) {
+    return false;
+  }
+  *rid = current_.GetRid(current_cursor_);
+  *tuple = std::move(*current_.MutableTuple(current_cursor_++));
+  return true;
+}
+
+bool BatchQueue::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  while (!batch->IsFull() && (current_cursor_ < current_.Size() || FetchBatch())) {
+    if (current_cursor_ == 0 && current_.Capacity() == batch->Capacity() && batch->Empty()) {
+      // hand over the producer's batch as a whole
+      std::swap(*batch, current_);
+      current_.Clear();
+      break;
+    }
+    batch->Append(std::move(*current_.MutableTuple(current_cursor_)), current_.GetRid(current_cursor_));
+    current_cursor_++;
+  }
+  return !batch->Empty();
+}
+
+}  // namespace bustub
@@ -0,0 +1,498 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// expression_program.cpp
+//
+// Identification: src/execution/expression_program.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/expression_program.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+namespace {
+
+bool IsInteger(TypeId type) {
+  return type == TypeId::TINYINT || type == TypeId::SMALLINT || type == TypeId::INTEGER || type == TypeId::BIGINT;
+}
+
+/** @return the value of an integer or BOOLEAN Value that is not NULL, widened */
+int64_t IntegerOf(const Value &value) {
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return value.GetAs<int8_t>();
+    case TypeId::SMALLINT:
+      return value.GetAs<int16_t>();
+    case TypeId::INTEGER:
+      return value.GetAs<int32_t>();
+    case TypeId::BIGINT:
+      return value.GetAs<int64_t>();
+    default:
+      UNREACHABLE("not an integer type");
+  }
+}
+
+/** @return the bytes of a VARCHAR Value that is not NULL, without the terminating NUL */
+std::string_view StringOf(const Value &value) {
+  const uint32_t len = value.GetLength();
+  return len == 0 ? std::string_view{} : std::string_view{value.GetData(), len - 1};
+}
+
+/** @return the comparison that holds with its operands swapped */
+ComparisonType Swapped(ComparisonType comparison) {
+  switch (comparison) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return comparison;
+  }
+}
+
+/** Call fn with the function object of a comparison, so the loop it runs is instantiated once per comparison */
+template <typename Fn>
+void WithComparison(ComparisonType comparison, Fn &&fn) {
+  switch (comparison) {
+    case ComparisonType::Equal:
+      fn(std::equal_to<>());
+      break;
+    case ComparisonType::NotEqual:
+      fn(std::not_equal_to<>());
+      break;
+    case ComparisonType::LessThan:
+      fn(std::less<>());
+      break;
+    case ComparisonType::LessThanOrEqual:
+      fn(std::less_equal<>());
+      break;
+    case ComparisonType::GreaterThan:
+      fn(std::greater<>());
+      break;
+    case ComparisonType::GreaterThanOrEqual:
+      fn(std::greater_equal<>());
+      break;
+  }
+}
+
+/** Load an inline column of type T, NULL where it holds null, of the rows into a register */
+template <typename T, typename R>
+void LoadColumn(const Tuple *const *rows, uint32_t num_rows, uint32_t offset, T null, R *values, uint8_t *nulls) {
+  for (uint32_t i = 0; i < num_rows; i++) {
+    T value;
+    memcpy(&value, rows[i]->GetData() + offset, sizeof(T));
+    values[i] = value;
+    nulls[i] = static_cast<uint8_t>(value == null);
+  }
+}
+
+/** Compare the lanes of two registers, or of a register and an immediate */
+template <typename T, typename Rhs>
+void CompareLanes(ComparisonType comparison, const T *lhs, const uint8_t *lhs_nulls, Rhs rhs,
+                  const uint8_t *rhs_nulls, uint32_t num_rows, int64_t *dst, uint8_t *dst_nulls) {
+  WithComparison(comparison, [&](auto op) {
+    for (uint32_t i = 0; i < num_rows; i++) {
+      if constexpr (std::is_pointer_v<Rhs>) {
+        dst[i] = static_cast<int64_t>(op(lhs[i], rhs[i]));
+      } else {
+        dst[i] = static_cast<int64_t>(op(lhs[i], rhs));
+      }
+    }
+  });
+  for (uint32_t i = 0; i < num_rows; i++) {
+    dst_nulls[i] = rhs_nulls == nullptr ? lhs_nulls[i] : lhs_nulls[i] | rhs_nulls[i];
+  }
+}
+
+}  // namespace
+
+ExpressionProgram::Registers::Registers(const ExpressionProgram &program)
+    : ints_(program.num_ints_), doubles_(program.num_doubles_), strings_(program.num_strings_) {}
+
+std::unique_ptr<ExpressionProgram> ExpressionProgram::Compile(const AbstractExpression *expr, const Schema *schema) {
+  CompileContext context;
+  context.schema_ = schema;
+  return CompileRoot(expr, context);
+}
+
+std::unique_ptr<ExpressionProgram> ExpressionProgram::CompileAggregate(const AbstractExpression *expr,
+                                                                       const std::vector<TypeId> &group_by_types,
+                                                                       const std::vector<TypeId> &aggregate_types) {
+  CompileContext context;
+  context.group_by_types_ = &group_by_types;
+  context.aggregate_types_ = &aggregate_types;
+  return CompileRoot(expr, context);
+}
+
+std::unique_ptr<ExpressionProgram> ExpressionProgram::CompileRoot(const AbstractExpression *expr,
+                                                                  const CompileContext &context) {
+  std::unique_ptr<ExpressionProgram> program{new ExpressionProgram()};
+  Operand result;
+  if (expr == nullptr || !program->CompileNode(expr, context, &result) || result.is_immediate_ ||
+      result.type_ != TypeId::BOOLEAN) {
+    return nullptr;
+  }
+  program->result_ = result.reg_;
+  return program;
+}
+
+uint32_t ExpressionProgram::NewRegister(Kind kind) {
+  switch (kind) {
+    case Kind::Int:
+      return num_ints_++;
+    case Kind::Double:
+      return num_doubles_++;
+    case Kind::String:
+      return num_strings_++;
+  }
+  UNREACHABLE("unknown register kind");
+}
+
+bool ExpressionProgram::CompileNode(const AbstractExpression *expr, const CompileContext &context,
+                                    Operand *operand) {
+  if (const auto *comparison = dynamic_cast<const ComparisonExpression *>(expr); comparison != nullptr) {
+    Operand lhs;
+    Operand rhs;
+    return CompileNode(comparison->GetChildAt(0), context, &lhs) &&
+           CompileNode(comparison->GetChildAt(1), context, &rhs) &&
+           CompileComparison(comparison->GetComparisonType(), std::move(lhs), std::move(rhs), operand);
+  }
+
+  if (const auto *constant = dynamic_cast<const ConstantValueExpression *>(expr); constant != nullptr) {
+    const Value value = constant->Evaluate(nullptr, nullptr);
+    // a NULL constant makes every comparison NULL, that is left to the tree
+    if (value.IsNull()) {
+      return false;
+    }
+    operand->type_ = value.GetTypeId();
+    operand->is_immediate_ = true;
+    if (IsInteger(operand->type_) || operand->type_ == TypeId::BOOLEAN) {
+      operand->kind_ = Kind::Int;
+      operand->int_immediate_ = IntegerOf(value);
+    } else if (operand->type_ == TypeId::DECIMAL) {
+      operand->kind_ = Kind::Double;
+      operand->double_immediate_ = value.GetAs<double>();
+    } else if (operand->type_ == TypeId::VARCHAR) {
+      operand->kind_ = Kind::String;
+      operand->string_immediate_ = std::string(StringOf(value));
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  Instruction load;
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+    if (context.schema_ == nullptr || column->GetColIdx() >= context.schema_->GetColumnCount()) {
+      return false;
+    }
+    const Column &col = context.schema_->GetColumn(column->GetColIdx());
+    operand->type_ = col.GetType();
+    load.lhs_ = col.GetOffset();
+    switch (col.GetType()) {
+      case TypeId::TINYINT:
+        load.op_ = OpCode::LoadTinyInt;
+        break;
+      case TypeId::SMALLINT:
+        load.op_ = OpCode::LoadSmallInt;
+        break;
+      case TypeId::INTEGER:
+        load.op_ = OpCode::LoadInteger;
+        break;
+      case TypeId::BIGINT:
+        load.op_ = OpCode::LoadBigInt;
+        break;
+      case TypeId::BOOLEAN:
+        load.op_ = OpCode::LoadBoolean;
+        break;
+      case TypeId::DECIMAL:
+        load.op_ = OpCode::LoadDecimal;
+        break;
+      case TypeId::VARCHAR:
+        load.op_ = OpCode::LoadVarchar;
+        break;
+      default:
+        return false;
+    }
+  } else if (const auto *term = dynamic_cast<const AggregateValueExpression *>(expr); term != nullptr) {
+    const std::vector<TypeId> *types = term->IsGroupByTerm() ? context.group_by_types_ : context.aggregate_types_;
+    if (types == nullptr || term->GetTermIdx() >= types->size()) {
+      return false;
+    }
+    operand->type_ = (*types)[term->GetTermIdx()];
+    load.lhs_ = term->GetTermIdx();
+    load.group_by_ = term->IsGroupByTerm();
+    load.type_ = operand->type_;
+    if (IsInteger(operand->type_) || operand->type_ == TypeId::BOOLEAN) {
+      load.op_ = OpCode::LoadTermInt;
+    } else if (operand->type_ == TypeId::DECIMAL) {
+      load.op_ = OpCode::LoadTermDouble;
+    } else if (operand->type_ == TypeId::VARCHAR) {
+      load.op_ = OpCode::LoadTermString;
+    } else {
+      return false;
+    }
+  } else {
+    return false;
+  }
+
+  if (operand->type_ == TypeId::DECIMAL) {
+    operand->kind_ = Kind::Double;
+  } else if (operand->type_ == TypeId::VARCHAR) {
+    operand->kind_ = Kind::String;
+  } else {
+    operand->kind_ = Kind::Int;
+  }
+  operand->reg_ = NewRegister(operand->kind_);
+  load.dst_ = operand->reg_;
+  instructions_.push_back(std::move(load));
+  return true;
+}
+
+void ExpressionProgram::ToDouble(Operand *operand) {
+  if (operand->kind_ == Kind::Double) {
+    return;
+  }
+  operand->kind_ = Kind::Double;
+  if (operand->is_immediate_) {
+    operand->double_immediate_ = static_cast<double>(operand->int_immediate_);
+    return;
+  }
+  Instruction convert;
+  convert.op_ = OpCode::IntToDouble;
+  convert.lhs_ = operand->reg_;
+  convert.dst_ = NewRegister(Kind::Double);
+  operand->reg_ = convert.dst_;
+  instructions_.push_back(std::move(convert));
+}
+
+bool ExpressionProgram::CompileComparison(ComparisonType comparison, Operand lhs, Operand rhs, Operand *result) {
+  if (lhs.is_immediate_ && rhs.is_immediate_) {
+    return false;
+  }
+  const bool lhs_numeric = IsInteger(lhs.type_) || lhs.type_ == TypeId::DECIMAL;
+  const bool rhs_numeric = IsInteger(rhs.type_) || rhs.type_ == TypeId::DECIMAL;
+  if (lhs_numeric && rhs_numeric) {
+    if (lhs.type_ == TypeId::DECIMAL || rhs.type_ == TypeId::DECIMAL) {
+      ToDouble(&lhs);
+      ToDouble(&rhs);
+    }
+  } else if (lhs.type_ != rhs.type_ || (lhs.type_ != TypeId::VARCHAR && lhs.type_ != TypeId::BOOLEAN)) {
+    return false;
+  }
+  // the immediate goes to the right
+  if (lhs.is_immediate_) {
+    std::swap(lhs, rhs);
+    comparison = Swapped(comparison);
+  }
+
+  Instruction compare;
+  compare.comparison_ = comparison;
+  compare.lhs_ = lhs.reg_;
+  compare.rhs_ = rhs.reg_;
+  switch (lhs.kind_) {
+    case Kind::Int:
+      compare.op_ = rhs.is_immediate_ ? OpCode::CompareIntImmediate : OpCode::CompareInt;
+      compare.int_immediate_ = rhs.int_immediate_;
+      break;
+    case Kind::Double:
+      compare.op_ = rhs.is_immediate_ ? OpCode::CompareDoubleImmediate : OpCode::CompareDouble;
+      compare.double_immediate_ = rhs.double_immediate_;
+      break;
+    case Kind::String:
+      compare.op_ = rhs.is_immediate_ ? OpCode::CompareStringImmediate : OpCode::CompareString;
+      compare.string_immediate_ = std::move(rhs.string_immediate_);
+      break;
+  }
+  compare.dst_ = NewRegister(Kind::Int);
+
+  result->kind_ = Kind::Int;
+  result->type_ = TypeId::BOOLEAN;
+  result->is_immediate_ = false;
+  result->reg_ = compare.dst_;
+  instructions_.push_back(std::move(compare));
+  return true;
+}
+
+void ExpressionProgram::Run(const Tuple *const *rows, const std::vector<Value> *group_bys,
+                            const std::vector<Value> *aggregates, uint32_t num_rows, Registers *regs,
+                            uint8_t *matches) const {
+  BUSTUB_ASSERT(num_rows <= MAX_LANES, "a program runs over at most MAX_LANES rows at once");
+  auto &ints = regs->ints_;
+  auto &doubles = regs->doubles_;
+  auto &strings = regs->strings_;
+  for (const Instruction &ins : instructions_) {
+    switch (ins.op_) {
+      case OpCode::LoadTinyInt:
+        LoadColumn<int8_t>(rows, num_rows, ins.lhs_, BUSTUB_INT8_NULL, ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::LoadSmallInt:
+        LoadColumn<int16_t>(rows, num_rows, ins.lhs_, BUSTUB_INT16_NULL, ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::LoadInteger:
+        LoadColumn<int32_t>(rows, num_rows, ins.lhs_, BUSTUB_INT32_NULL, ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::LoadBigInt:
+        LoadColumn<int64_t>(rows, num_rows, ins.lhs_, BUSTUB_INT64_NULL, ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::LoadBoolean:
+        LoadColumn<int8_t>(rows, num_rows, ins.lhs_, BUSTUB_BOOLEAN_NULL, ints.Values(ins.dst_),
+                           ints.Nulls(ins.dst_));
+        break;
+      case OpCode::LoadDecimal:
+        LoadColumn<double>(rows, num_rows, ins.lhs_, BUSTUB_DECIMAL_NULL, doubles.Values(ins.dst_),
+                           doubles.Nulls(ins.dst_));
+        break;
+      case OpCode::LoadVarchar: {
+        // the column holds the offset of a length, which counts a terminating NUL, followed by the bytes
+        std::string_view *values = strings.Values(ins.dst_);
+        uint8_t *nulls = strings.Nulls(ins.dst_);
+        for (uint32_t i = 0; i < num_rows; i++) {
+          const char *data = rows[i]->GetData();
+          int32_t offset;
+          memcpy(&offset, data + ins.lhs_, sizeof(offset));
+          uint32_t len;
+          memcpy(&len, data + offset, sizeof(len));
+          nulls[i] = static_cast<uint8_t>(len == BUSTUB_VALUE_NULL);
+          values[i] = nulls[i] != 0 || len == 0 ? std::string_view{}
+                                                : std::string_view{data + offset + sizeof(len), len - 1};
+        }
+        break;
+      }
+      case OpCode::LoadTermInt:
+      case OpCode::LoadTermDouble:
+      case OpCode::LoadTermString: {
+        const std::vector<Value> *terms = ins.group_by_ ? group_bys : aggregates;
+        uint8_t *nulls = ins.op_ == OpCode::LoadTermInt      ? ints.Nulls(ins.dst_)
+                         : ins.op_ == OpCode::LoadTermDouble ? doubles.Nulls(ins.dst_)
+                                                             : strings.Nulls(ins.dst_);
+        for (uint32_t i = 0; i < num_rows; i++) {
+          const Value &value = terms[i][ins.lhs_];
+          BUSTUB_ASSERT(value.GetTypeId() == ins.type_, "a term has the type the program was compiled for");
+          nulls[i] = static_cast<uint8_t>(value.IsNull());
+          if (nulls[i] != 0) {
+            continue;
+          }
+          if (ins.op_ == OpCode::LoadTermInt) {
+            ints.Values(ins.dst_)[i] = IntegerOf(value);
+          } else if (ins.op_ == OpCode::LoadTermDouble) {
+            doubles.Values(ins.dst_)[i] = value.GetAs<double>();
+          } else {
+            strings.Values(ins.dst_)[i] = StringOf(value);
+          }
+        }
+        break;
+      }
+      case OpCode::IntToDouble: {
+        const int64_t *src = ints.Values(ins.lhs_);
+        double *dst = doubles.Values(ins.dst_);
+        for (uint32_t i = 0; i < num_rows; i++) {
+          dst[i] = static_cast<double>(src[i]);
+        }
+        memcpy(doubles.Nulls(ins.dst_), ints.Nulls(ins.lhs_), num_rows);
+        break;
+      }
+      case OpCode::CompareInt:
+        CompareLanes(ins.comparison_, ints.Values(ins.lhs_), ints.Nulls(ins.lhs_),
+                     static_cast<const int64_t *>(ints.Values(ins.rhs_)), ints.Nulls(ins.rhs_), num_rows,
+                     ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::CompareDouble:
+        CompareLanes(ins.comparison_, doubles.Values(ins.lhs_), doubles.Nulls(ins.lhs_),
+                     static_cast<const double *>(doubles.Values(ins.rhs_)), doubles.Nulls(ins.rhs_), num_rows,
+                     ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::CompareString:
+        CompareLanes(ins.comparison_, strings.Values(ins.lhs_), strings.Nulls(ins.lhs_),
+                     static_cast<const std::string_view *>(strings.Values(ins.rhs_)), strings.Nulls(ins.rhs_),
+                     num_rows, ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::CompareIntImmediate:
+        CompareLanes(ins.comparison_, ints.Values(ins.lhs_), ints.Nulls(ins.lhs_), ins.int_immediate_, nullptr,
+                     num_rows, ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::CompareDoubleImmediate:
+        CompareLanes(ins.comparison_, doubles.Values(ins.lhs_), doubles.Nulls(ins.lhs_), ins.double_immediate_,
+                     nullptr, num_rows, ints.Values(ins.dst_), ints.Nulls(ins.dst_));
+        break;
+      case OpCode::CompareStringImmediate:
+        CompareLanes(ins.comparison_, strings.Values(ins.lhs_), strings.Nulls(ins.lhs_),
+                     std::string_view{ins.string_immediate_}, nullptr, num_rows, ints.Values(ins.dst_),
+                     ints.Nulls(ins.dst_));
+        break;
+    }
+  }
+
+  const int64_t *result = ints.Values(result_);
+  const uint8_t *nulls = ints.Nulls(result_);
+  for (uint32_t i = 0; i < num_rows; i++) {
+    matches[i] = static_cast<uint8_t>(nulls[i] == 0 && result[i] != 0);
+  }
+}
+
+void ExpressionProgram::MatchRows(const Tuple *const *rows, size_t num_rows, Registers *regs,
+                                  uint8_t *matches) const {
+  for (size_t begin = 0; begin < num_rows; begin += MAX_LANES) {
+    const auto lanes = static_cast<uint32_t>(std::min<size_t>(MAX_LANES, num_rows - begin));
+    Run(rows + begin, nullptr, nullptr, lanes, regs, matches + begin);
+  }
+}
+
+bool ExpressionProgram::Matches(const Tuple &tuple, Registers *regs) const {
+  const Tuple *row = &tuple;
+  uint8_t match;
+  Run(&row, nullptr, nullptr, 1, regs, &match);
+  return match != 0;
+}
+
+void ExpressionProgram::Match(const std::vector<Tuple> &tuples, Registers *regs,
+                              std::vector<uint8_t> *matches) const {
+  regs->rows_.resize(tuples.size());
+  for (size_t i = 0; i < tuples.size(); i++) {
+    regs->rows_[i] = &tuples[i];
+  }
+  matches->resize(tuples.size());
+  MatchRows(regs->rows_.data(), tuples.size(), regs, matches->data());
+}
+
+void ExpressionProgram::Filter(TupleBatch *batch, Registers *regs) const {
+  const uint32_t num_rows = batch->Size();
+  regs->rows_.resize(num_rows);
+  for (uint32_t i = 0; i < num_rows; i++) {
+    regs->rows_[i] = &batch->GetTuple(i);
+  }
+  regs->matches_.resize(num_rows);
+  MatchRows(regs->rows_.data(), num_rows, regs, regs->matches_.data());
+  // Filter() asks about the selected rows in order
+  uint32_t i = 0;
+  batch->Filter([regs, &i](const Tuple & /*tuple*/) { return regs->matches_[i++] != 0; });
+}
+
+void ExpressionProgram::MatchGroups(const std::vector<Value> *group_bys, const std::vector<Value> *aggregates,
+                                    size_t num_groups, Registers *regs, uint8_t *matches) const {
+  for (size_t begin = 0; begin < num_groups; begin += MAX_LANES) {
+    const auto lanes = static_cast<uint32_t>(std::min<size_t>(MAX_LANES, num_groups - begin));
+    Run(nullptr, group_bys + begin, aggregates + begin, lanes, regs, matches + begin);
+  }
+}
+
+}  // namespace bustub
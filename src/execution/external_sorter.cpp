@@ -0,0 +1,151 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter.cpp
+//
+// Identification: src/execution/external_sorter.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/external_sorter.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "common/util/thread_util.h"
+
+namespace bustub {
+
+ExternalSorter::ExternalSorter(BufferPoolManager *bpm, size_t memory_budget, uint32_t num_workers, KeyFunction key_of)
+    : bpm_(bpm), worker_budget_(memory_budget / num_workers), key_of_(std::move(key_of)), buffers_(num_workers) {
+  BUSTUB_ASSERT(num_workers > 0, "a sorter is fed by one worker at least");
+}
+
+ExternalSorter::Entry ExternalSorter::MakeEntry(Tuple &&tuple) const {
+  Entry entry{0, {}, std::move(tuple)};
+  key_of_(entry.tuple_, &entry.key_);
+  entry.prefix_ = KeyPrefix(entry.key_);
+  return entry;
+}
+
+void ExternalSorter::Add(uint32_t worker, Tuple &&tuple) {
+  Buffer &buffer = buffers_[worker];
+  buffer.entries_.push_back(MakeEntry(std::move(tuple)));
+  buffer.bytes_ += EntryBytes(buffer.entries_.back());
+  if (buffer.bytes_ > worker_budget_) {
+    Spill(&buffer);
+  }
+}
+
+void ExternalSorter::Spill(Buffer *buffer) {
+  std::sort(buffer->entries_.begin(), buffer->entries_.end());
+  Run run;
+  run.file_ = std::make_unique<TmpTupleFile>(bpm_);
+  for (const auto &entry : buffer->entries_) {
+    run.file_->Append(entry.tuple_);
+  }
+  run.file_->Finish();
+  buffer->entries_.clear();
+  buffer->bytes_ = 0;
+
+  std::lock_guard<std::mutex> guard(runs_latch_);
+  runs_.push_back(std::move(run));
+  num_spilled_runs_++;
+}
+
+bool ExternalSorter::ReadNextPage(Run *run) const {
+  run->entries_.clear();
+  run->pos_ = 0;
+  if (run->file_ == nullptr) {
+    return false;
+  }
+  std::vector<Tuple> tuples;
+  run->file_->ReadPage(run->next_page_++, &tuples);
+  for (auto &tuple : tuples) {
+    run->entries_.push_back(MakeEntry(std::move(tuple)));
+  }
+  if (run->next_page_ == run->file_->NumPages()) {
+    run->file_.reset();
+  }
+  return true;
+}
+
+bool ExternalSorter::Advance(Run *run) const {
+  return ++run->pos_ < run->entries_.size() || ReadNextPage(run);
+}
+
+std::unique_ptr<LoserTree<ExternalSorter::HeadLess>> ExternalSorter::StartMerge(std::vector<Run> *runs) const {
+  std::vector<bool> exhausted;
+  for (auto &run : *runs) {
+    exhausted.push_back(run.entries_.empty() && !ReadNextPage(&run));
+  }
+  auto merge = std::make_unique<LoserTree<HeadLess>>(runs->size(), HeadLess{runs});
+  merge->Build(std::move(exhausted));
+  return merge;
+}
+
+bool ExternalSorter::PopMerge(LoserTree<HeadLess> *merge, std::vector<Run> *runs, Tuple *tuple) const {
+  const size_t top = merge->Top();
+  if (top == LoserTree<HeadLess>::NONE) {
+    return false;
+  }
+  Run &run = (*runs)[top];
+  *tuple = std::move(run.entries_[run.pos_].tuple_);
+  merge->Pop(!Advance(&run));
+  return true;
+}
+
+ExternalSorter::Run ExternalSorter::MergeSpilled(std::vector<Run> runs) {
+  auto merge = StartMerge(&runs);
+  Run merged;
+  merged.file_ = std::make_unique<TmpTupleFile>(bpm_);
+  Tuple tuple;
+  while (PopMerge(merge.get(), &runs, &tuple)) {
+    merged.file_->Append(tuple);
+  }
+  merged.file_->Finish();
+  num_spilled_runs_++;
+  return merged;
+}
+
+void ExternalSorter::Finish() {
+  BUSTUB_ASSERT(merge_ == nullptr, "a sorter is finished once");
+  ThreadUtil::RunWorkers(buffers_.size(), [this](uint32_t worker) {
+    std::sort(buffers_[worker].entries_.begin(), buffers_[worker].entries_.end());
+  });
+
+  // the oldest spilled runs are merged until few enough are left to be merged at once
+  std::vector<Run> spilled = std::move(runs_);
+  size_t begin = 0;
+  while (spilled.size() - begin > MAX_MERGE_FANIN) {
+    auto first = std::make_move_iterator(spilled.begin() + begin);
+    std::vector<Run> group(first, first + MAX_MERGE_FANIN);
+    begin += MAX_MERGE_FANIN;
+    spilled.push_back(MergeSpilled(std::move(group)));
+  }
+  runs_.clear();
+  runs_.insert(runs_.end(), std::make_move_iterator(spilled.begin() + begin),
+               std::make_move_iterator(spilled.end()));
+
+  // what the workers still hold fits the budget and is merged from memory
+  for (auto &buffer : buffers_) {
+    if (!buffer.entries_.empty()) {
+      Run run;
+      run.entries_ = std::move(buffer.entries_);
+      runs_.push_back(std::move(run));
+    }
+    buffer.bytes_ = 0;
+  }
+  merge_ = StartMerge(&runs_);
+}
+
+bool ExternalSorter::Next(Tuple *tuple) {
+  BUSTUB_ASSERT(merge_ != nullptr, "the sorter is finished");
+  return PopMerge(merge_.get(), &runs_, tuple);
+}
+
+}  // namespace bustub
@@ -12,15 +12,345 @@
 
 #include "execution/executors/hash_join_executor.h"
 
+#include <atomic>
+
+#include "common/util/thread_util.h"
+#include "execution/morsel_queue.h"
+
 namespace bustub {
 
 HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
                                    std::unique_ptr<AbstractExecutor> &&left_child,
                                    std::unique_ptr<AbstractExecutor> &&right_child)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_executor_(std::move(left_child)),
+      right_executor_(std::move(right_child)) {}
+
+HashJoinExecutor::SpilledSide::SpilledSide(BufferPoolManager *bpm) : bytes_(GRACE_FANOUT), latches_(GRACE_FANOUT) {
+  for (size_t p = 0; p < GRACE_FANOUT; p++) {
+    files_.push_back(std::make_unique<TmpTupleFile>(bpm));
+  }
+}
+
+void HashJoinExecutor::SpilledSide::Append(size_t partition, const Tuple &tuple) {
+  std::lock_guard<std::mutex> guard(latches_[partition]);
+  files_[partition]->Append(tuple);
+  bytes_[partition] += JoinHashTable::EntryBytes(tuple);
+}
+
+void HashJoinExecutor::SpilledSide::Finish() {
+  for (auto &file : files_) {
+    file->Finish();
+  }
+}
+
+void HashJoinExecutor::ComputeKeys(AbstractExecutor *child, const AbstractExpression *key_expr,
+                                   const TupleBatch &batch, std::vector<HashJoinKey> *keys) {
+  const Schema *schema = child->GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(batch.Size());
+  for (uint32_t i = 0; i < batch.Size(); i++) {
+    values.push_back(key_expr->Evaluate(&batch.GetTuple(i), schema));
+  }
+  HashKeys(values, keys);
+}
+
+void HashJoinExecutor::ComputeKeys(AbstractExecutor *child, const AbstractExpression *key_expr,
+                                   const std::vector<Tuple> &tuples, std::vector<HashJoinKey> *keys) {
+  const Schema *schema = child->GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(tuples.size());
+  for (const auto &tuple : tuples) {
+    values.push_back(key_expr->Evaluate(&tuple, schema));
+  }
+  HashKeys(values, keys);
+}
+
+void HashJoinExecutor::HashKeys(const std::vector<Value> &values, std::vector<HashJoinKey> *keys) {
+  std::vector<hash_t> hashes(values.size());
+  HashUtil::HashValues(values.data(), values.size(), hashes.data());
+  keys->clear();
+  for (size_t i = 0; i < values.size(); i++) {
+    keys->push_back({hashes[i], values[i]});
+  }
+}
+
+void HashJoinExecutor::Init() {
+  queue_.reset();
+  spilled_build_.reset();
+  left_executor_->Init();
+  right_executor_->Init();
+
+  // the workers add to the hash table until the budget runs out, from then on they spill
+  const size_t budget = exec_ctx_->GetMemoryBudget();
+  ht_ = std::make_unique<JoinHashTable>(exec_ctx_->GetParallelism());
+  auto spilled = std::make_unique<SpilledSide>(exec_ctx_->GetBufferPoolManager());
+  std::atomic<size_t> bytes{0};
+  std::atomic<bool> spilling{false};
+  std::vector<std::vector<HashJoinKey>> keys(exec_ctx_->GetParallelism());
+  left_executor_->ParallelDrain([&](uint32_t worker, TupleBatch *batch) {
+    ComputeKeys(left_executor_.get(), plan_->LeftJoinKeyExpression(), *batch, &keys[worker]);
+    for (uint32_t i = 0; i < batch->Size(); i++) {
+      const HashJoinKey &key = keys[worker][i];
+      if (key.key_.IsNull()) {
+        continue;
+      }
+      Tuple *tuple = batch->MutableTuple(i);
+      if (!spilling) {
+        const size_t entry_bytes = JoinHashTable::EntryBytes(*tuple);
+        if (bytes.fetch_add(entry_bytes) + entry_bytes <= budget) {
+          ht_->Add(worker, key, std::move(*tuple));
+          continue;
+        }
+        spilling = true;
+      }
+      spilled->Append(GracePartition(key.hash_, 0), *tuple);
+    }
+    return true;
+  });
+
+  if (spilling) {
+    // what the workers added before the budget ran out is spilled as well
+    ht_->TakeStaged([&spilled](hash_t hash, Tuple &&tuple) { spilled->Append(GracePartition(hash, 0), tuple); });
+    ht_.reset();
+    spilled->Finish();
+    spilled_build_ = std::move(spilled);
+  } else {
+    ht_->Build();
+  }
+
+  probe_batch_.Clear();
+  probe_keys_.clear();
+  probe_cursor_ = 0;
+  match_ = 0;
+}
+
+bool HashJoinExecutor::FetchProbeBatch() {
+  probe_cursor_ = 0;
+  match_ = 0;
+  if (!right_executor_->NextBatch(&probe_batch_)) {
+    return false;
+  }
+  ComputeKeys(right_executor_.get(), plan_->RightJoinKeyExpression(), probe_batch_, &probe_keys_);
+  return true;
+}
+
+bool HashJoinExecutor::NextMatch(const Tuple **left, uint32_t *right_idx) {
+  while (true) {
+    if (probe_cursor_ == probe_batch_.Size() && !FetchProbeBatch()) {
+      return false;
+    }
+    const HashJoinKey &key = probe_keys_[probe_cursor_];
+    match_ = key.key_.IsNull() ? 0 : ht_->FindNext(key, match_);
+    if (match_ == 0) {
+      probe_cursor_++;
+      continue;
+    }
+    *left = &ht_->GetTuple(key, match_);
+    *right_idx = static_cast<uint32_t>(probe_cursor_);
+    return true;
+  }
+}
+
+Tuple HashJoinExecutor::Project(const Tuple &left, const Tuple &right) {
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const auto &col : GetOutputSchema()->GetColumns()) {
+    values.push_back(col.GetExpr()->EvaluateJoin(&left, left_schema, &right, right_schema));
+  }
+  return Tuple(values, GetOutputSchema());
+}
+
+bool HashJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  if (IsParallel() || IsSpilled()) {
+    StartQueue();
+    return queue_->Next(tuple, rid);
+  }
+
+  const Tuple *left;
+  uint32_t right_idx;
+  if (!NextMatch(&left, &right_idx)) {
+    return false;
+  }
+  *tuple = Project(*left, probe_batch_.GetTuple(right_idx));
+  *rid = probe_batch_.GetRid(right_idx);
+  return true;
+}
+
+bool HashJoinExecutor::NextBatch(TupleBatch *batch) {
+  if (IsParallel() || IsSpilled()) {
+    StartQueue();
+    return queue_->NextBatch(batch);
+  }
+
+  batch->Clear();
+  const Tuple *left;
+  uint32_t right_idx;
+  while (!batch->IsFull() && NextMatch(&left, &right_idx)) {
+    batch->Append(Project(*left, probe_batch_.GetTuple(right_idx)), probe_batch_.GetRid(right_idx));
+  }
+  return !batch->Empty();
+}
+
+bool HashJoinExecutor::Probe(const JoinHashTable &ht, const HashJoinKey &key, const Tuple &right, RID rid,
+                             uint32_t worker, TupleBatch *output, const BatchSink &sink) {
+  for (uint32_t match = ht.FindNext(key, 0); match != 0; match = ht.FindNext(key, match)) {
+    output->Append(Project(ht.GetTuple(key, match), right), rid);
+    if (output->IsFull()) {
+      if (!sink(worker, output)) {
+        return false;
+      }
+      output->Clear();
+    }
+  }
+  return true;
+}
+
+void HashJoinExecutor::FlushOutputs(std::vector<TupleBatch> *outputs, const BatchSink &sink,
+                                    std::atomic<bool> *stopped) {
+  // the workers are done, the calling thread hands on what is left of their batches
+  for (uint32_t worker = 0; worker < outputs->size() && !*stopped; worker++) {
+    if (!(*outputs)[worker].Empty() && !sink(worker, &(*outputs)[worker])) {
+      *stopped = true;
+    }
+  }
+}
+
+void HashJoinExecutor::ParallelDrain(const BatchSink &sink) {
+  if (IsSpilled()) {
+    GraceDrain(sink);
+    return;
+  }
+  if (!IsParallel()) {
+    AbstractExecutor::ParallelDrain(sink);
+    return;
+  }
+
+  // each worker probes into its own output batch and hands it on whenever it fills up
+  const uint32_t num_workers = exec_ctx_->GetParallelism();
+  std::vector<TupleBatch> outputs(num_workers);
+  std::vector<std::vector<HashJoinKey>> keys(num_workers);
+  std::atomic<bool> stopped{false};
+  right_executor_->ParallelDrain([&](uint32_t worker, TupleBatch *batch) {
+    ComputeKeys(right_executor_.get(), plan_->RightJoinKeyExpression(), *batch, &keys[worker]);
+    for (uint32_t i = 0; i < batch->Size(); i++) {
+      const HashJoinKey &key = keys[worker][i];
+      if (!key.key_.IsNull() &&
+          !Probe(*ht_, key, batch->GetTuple(i), batch->GetRid(i), worker, &outputs[worker], sink)) {
+        stopped = true;
+        return false;
+      }
+    }
+    return !stopped;
+  });
+  FlushOutputs(&outputs, sink, &stopped);
+}
+
+void HashJoinExecutor::GraceDrain(const BatchSink &sink) {
+  const uint32_t num_workers = exec_ctx_->GetParallelism();
+  SpilledSide spilled_probe(exec_ctx_->GetBufferPoolManager());
+  std::vector<std::vector<HashJoinKey>> keys(num_workers);
+  right_executor_->ParallelDrain([&](uint32_t worker, TupleBatch *batch) {
+    ComputeKeys(right_executor_.get(), plan_->RightJoinKeyExpression(), *batch, &keys[worker]);
+    for (uint32_t i = 0; i < batch->Size(); i++) {
+      if (!keys[worker][i].key_.IsNull()) {
+        spilled_probe.Append(GracePartition(keys[worker][i].hash_, 0), batch->GetTuple(i));
+      }
+    }
+    return true;
+  });
+  spilled_probe.Finish();
+
+  // the workers take the pairs of partitions one at a time
+  std::vector<TupleBatch> outputs(num_workers);
+  std::atomic<bool> stopped{false};
+  MorselQueue pairs(GRACE_FANOUT, 1, num_workers);
+  ThreadUtil::RunWorkers(num_workers, [&](uint32_t worker) {
+    MorselQueue::Morsel pair;
+    while (!stopped && pairs.Next(worker, &pair)) {
+      const size_t p = pair.begin_;
+      JoinSpilled(worker, std::move(spilled_build_->files_[p]), spilled_build_->bytes_[p],
+                  std::move(spilled_probe.files_[p]), 0, &outputs[worker], sink, &stopped);
+    }
+  });
+  FlushOutputs(&outputs, sink, &stopped);
+}
+
+void HashJoinExecutor::JoinSpilled(uint32_t worker, std::unique_ptr<TmpTupleFile> build, size_t build_bytes,
+                                   std::unique_ptr<TmpTupleFile> probe, uint32_t level, TupleBatch *output,
+                                   const BatchSink &sink, std::atomic<bool> *stopped) {
+  if (build == nullptr || build->Size() == 0 || probe->Size() == 0) {
+    return;
+  }
+
+  if (build_bytes > exec_ctx_->GetMemoryBudget() / exec_ctx_->GetParallelism() && level < MAX_GRACE_LEVELS) {
+    auto sub_build = Split(build.get(), left_executor_.get(), plan_->LeftJoinKeyExpression(), level + 1);
+    build.reset();
+    auto sub_probe = Split(probe.get(), right_executor_.get(), plan_->RightJoinKeyExpression(), level + 1);
+    probe.reset();
+    for (size_t p = 0; p < GRACE_FANOUT && !*stopped; p++) {
+      JoinSpilled(worker, std::move(sub_build->files_[p]), sub_build->bytes_[p], std::move(sub_probe->files_[p]),
+                  level + 1, output, sink, stopped);
+    }
+    return;
+  }
+
+  JoinHashTable ht(1);
+  std::vector<Tuple> tuples;
+  std::vector<HashJoinKey> keys;
+  for (size_t page = 0; page < build->NumPages(); page++) {
+    tuples.clear();
+    build->ReadPage(page, &tuples);
+    ComputeKeys(left_executor_.get(), plan_->LeftJoinKeyExpression(), tuples, &keys);
+    for (size_t i = 0; i < tuples.size(); i++) {
+      ht.Add(0, keys[i], std::move(tuples[i]));
+    }
+  }
+  build.reset();
+  ht.Build();
+
+  for (size_t page = 0; page < probe->NumPages() && !*stopped; page++) {
+    tuples.clear();
+    probe->ReadPage(page, &tuples);
+    ComputeKeys(right_executor_.get(), plan_->RightJoinKeyExpression(), tuples, &keys);
+    for (size_t i = 0; i < tuples.size(); i++) {
+      if (!Probe(ht, keys[i], tuples[i], RID(), worker, output, sink)) {
+        *stopped = true;
+        return;
+      }
+    }
+  }
+}
 
-void HashJoinExecutor::Init() {}
+std::unique_ptr<HashJoinExecutor::SpilledSide> HashJoinExecutor::Split(TmpTupleFile *file, AbstractExecutor *child,
+                                                                       const AbstractExpression *key_expr,
+                                                                       uint32_t level) {
+  auto side = std::make_unique<SpilledSide>(exec_ctx_->GetBufferPoolManager());
+  std::vector<Tuple> tuples;
+  std::vector<HashJoinKey> keys;
+  for (size_t page = 0; page < file->NumPages(); page++) {
+    tuples.clear();
+    file->ReadPage(page, &tuples);
+    ComputeKeys(child, key_expr, tuples, &keys);
+    for (size_t i = 0; i < tuples.size(); i++) {
+      side->Append(GracePartition(keys[i].hash_, level), tuples[i]);
+    }
+  }
+  side->Finish();
+  return side;
+}
 
-bool HashJoinExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+void HashJoinExecutor::StartQueue() {
+  if (queue_ == nullptr) {
+    queue_ = std::make_unique<BatchQueue>(MAX_QUEUED_BATCHES);
+    BatchQueue *queue = queue_.get();
+    queue_->Start([this, queue] {
+      ParallelDrain([queue](uint32_t /*worker*/, TupleBatch *batch) { return queue->Push(batch); });
+    });
+  }
+}
 
 }  // namespace bustub
@@ -11,12 +11,139 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  Catalog *catalog = GetExecutorContext()->GetCatalog();
+  index_info_ = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info_->table_name_);
+  has_low_ = has_high_ = high_inclusive_ = false;
+  ComputeBounds();
+
+  rids_.clear();
+  cursor_ = 0;
+  scan_ = index_info_->index_->ScanRange(has_low_ ? &low_ : nullptr, has_high_ ? &high_ : nullptr, high_inclusive_,
+                                         GetExecutorContext()->GetTransaction());
+  if (scan_ != nullptr) {
+    return;
+  }
+
+  // Unordered index, only a point lookup can be answered from it
+  Transaction *txn = GetExecutorContext()->GetTransaction();
+  if (has_low_ && has_high_ && high_inclusive_) {
+    index_info_->index_->ScanKey(low_, &rids_, txn);
+    return;
+  }
+  for (auto iter = table_info_->table_->Begin(txn); iter != table_info_->table_->End(); ++iter) {
+    rids_.push_back(iter->GetRid());
+  }
+}
+
+void IndexScanExecutor::ComputeBounds() {
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(plan_->GetPredicate());
+  const auto &key_attrs = index_info_->index_->GetKeyAttrs();
+  if (comparison == nullptr || key_attrs.size() != 1) {
+    return;
+  }
+
+  // Accept both "key op constant" and "constant op key"
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  ComparisonType type = comparison->GetComparisonType();
+  if (column == nullptr || constant == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    switch (type) {
+      case ComparisonType::LessThan:
+        type = ComparisonType::GreaterThan;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        type = ComparisonType::GreaterThanOrEqual;
+        break;
+      case ComparisonType::GreaterThan:
+        type = ComparisonType::LessThan;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        type = ComparisonType::LessThanOrEqual;
+        break;
+      default:
+        break;
+    }
+  }
+  if (column == nullptr || constant == nullptr || column->GetColIdx() != key_attrs[0]) {
+    return;
+  }
+
+  const Schema &key_schema = index_info_->key_schema_;
+  Tuple bound{{constant->Evaluate(nullptr, nullptr).CastAs(key_schema.GetColumn(0).GetType())}, &key_schema};
+  switch (type) {
+    case ComparisonType::Equal:
+      low_ = high_ = bound;
+      has_low_ = has_high_ = high_inclusive_ = true;
+      break;
+    case ComparisonType::LessThan:
+    case ComparisonType::LessThanOrEqual:
+      high_ = bound;
+      has_high_ = true;
+      high_inclusive_ = type == ComparisonType::LessThanOrEqual;
+      break;
+    case ComparisonType::GreaterThan:
+    case ComparisonType::GreaterThanOrEqual:
+      // keys equal to a strict lower bound are dropped by the predicate
+      low_ = bound;
+      has_low_ = true;
+      break;
+    default:
+      break;
+  }
+}
+
+bool IndexScanExecutor::FetchBatch() {
+  rids_.clear();
+  cursor_ = 0;
+  if (scan_ == nullptr) {
+    return false;
+  }
+  if (!scan_->NextBatch(&rids_)) {
+    // release the pinned leaves as soon as the range is exhausted
+    scan_.reset();
+    return false;
+  }
+  return true;
+}
 
-void IndexScanExecutor::Init() {}
+bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) {
+  const Schema *table_schema = &table_info_->schema_;
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  Transaction *txn = GetExecutorContext()->GetTransaction();
+  while (true) {
+    if (cursor_ == rids_.size() && !FetchBatch()) {
+      return false;
+    }
+    RID candidate = rids_[cursor_++];
+    Tuple raw;
+    if (!table_info_->table_->GetTuple(candidate, &raw, txn)) {
+      continue;
+    }
+    if (predicate != nullptr && !predicate->Evaluate(&raw, table_schema).GetAs<bool>()) {
+      continue;
+    }
 
-bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+    std::vector<Value> values;
+    values.reserve(GetOutputSchema()->GetColumnCount());
+    for (const auto &col : GetOutputSchema()->GetColumns()) {
+      values.push_back(col.GetExpr()->Evaluate(&raw, table_schema));
+    }
+    *tuple = Tuple(values, GetOutputSchema());
+    *rid = candidate;
+    return true;
+  }
+}
 
 }  // namespace bustub
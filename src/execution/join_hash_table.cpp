@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table.cpp
+//
+// Identification: src/execution/join_hash_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/join_hash_table.h"
+
+#include <utility>
+
+#include "common/util/thread_util.h"
+#include "execution/morsel_queue.h"
+
+namespace bustub {
+
+JoinHashTable::JoinHashTable(uint32_t num_workers, size_t partition_bytes)
+    : partition_bytes_(partition_bytes), staged_(num_workers) {
+  BUSTUB_ASSERT(num_workers > 0, "a table is built by one worker at least");
+}
+
+void JoinHashTable::Add(uint32_t worker, const HashJoinKey &key, Tuple &&tuple) {
+  StagingArea &area = staged_[worker];
+  area.bytes_ += EntryBytes(tuple);
+  area.entries_.push_back({key.hash_, key.key_, std::move(tuple)});
+}
+
+void JoinHashTable::Build() {
+  const auto num_workers = static_cast<uint32_t>(staged_.size());
+  size_t bytes = 0;
+  for (const auto &area : staged_) {
+    bytes += area.bytes_;
+  }
+  partition_bits_ = 0;
+  while (partition_bits_ < MAX_PARTITION_BITS && (bytes >> partition_bits_) > partition_bytes_) {
+    partition_bits_++;
+  }
+  const size_t num_partitions = static_cast<size_t>(1) << partition_bits_;
+
+  // every worker counts its entries per partition, which gives each worker its own slots in every partition
+  std::vector<std::vector<size_t>> offsets(num_workers, std::vector<size_t>(num_partitions));
+  ThreadUtil::RunWorkers(num_workers, [&](uint32_t worker) {
+    for (const auto &entry : staged_[worker].entries_) {
+      offsets[worker][PartitionOf(entry.hash_)]++;
+    }
+  });
+  partitions_.clear();
+  partitions_.resize(num_partitions);
+  for (size_t p = 0; p < num_partitions; p++) {
+    size_t size = 0;
+    for (uint32_t worker = 0; worker < num_workers; worker++) {
+      const size_t count = offsets[worker][p];
+      offsets[worker][p] = size;
+      size += count;
+    }
+    partitions_[p].entries_.resize(size);
+  }
+
+  ThreadUtil::RunWorkers(num_workers, [&](uint32_t worker) {
+    std::vector<Entry> entries = std::move(staged_[worker].entries_);
+    staged_[worker].bytes_ = 0;
+    for (auto &entry : entries) {
+      const size_t p = PartitionOf(entry.hash_);
+      partitions_[p].entries_[offsets[worker][p]++] = std::move(entry);
+    }
+  });
+
+  MorselQueue morsels(num_partitions, 1, num_workers);
+  ThreadUtil::RunWorkers(num_workers, [&](uint32_t worker) {
+    MorselQueue::Morsel morsel;
+    while (morsels.Next(worker, &morsel)) {
+      IndexPartition(&partitions_[morsel.begin_]);
+    }
+  });
+}
+
+void JoinHashTable::IndexPartition(Partition *partition) {
+  const auto num_entries = static_cast<uint32_t>(partition->entries_.size());
+  size_t num_buckets = 1;
+  while (num_buckets < num_entries) {
+    num_buckets <<= 1;
+  }
+  partition->heads_.assign(num_buckets, 0);
+  partition->next_.assign(num_entries, 0);
+  for (uint32_t i = num_entries; i > 0; i--) {
+    uint32_t &head = partition->heads_[partition->entries_[i - 1].hash_ & (num_buckets - 1)];
+    partition->next_[i - 1] = head;
+    head = i;
+  }
+}
+
+uint32_t JoinHashTable::FindNext(const HashJoinKey &key, uint32_t after) const {
+  const Partition &partition = partitions_[PartitionOf(key.hash_)];
+  uint32_t match =
+      after == 0 ? partition.heads_[key.hash_ & (partition.heads_.size() - 1)] : partition.next_[after - 1];
+  for (; match != 0; match = partition.next_[match - 1]) {
+    const Entry &entry = partition.entries_[match - 1];
+    if (entry.hash_ == key.hash_ && entry.key_.CompareEquals(key.key_) == CmpBool::CmpTrue) {
+      return match;
+    }
+  }
+  return 0;
+}
+
+size_t JoinHashTable::Size() const {
+  size_t size = 0;
+  for (const auto &partition : partitions_) {
+    size += partition.entries_.size();
+  }
+  for (const auto &area : staged_) {
+    size += area.entries_.size();
+  }
+  return size;
+}
+
+}  // namespace bustub
@@ -10,16 +10,39 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <memory>
+#include <utility>
+
 #include "execution/executors/limit_executor.h"
 
 namespace bustub {
 
 LimitExecutor::LimitExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *plan,
                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void LimitExecutor::Init() {
+  child_executor_->Init();
+  num_produced_ = 0;
+}
 
-void LimitExecutor::Init() {}
+bool LimitExecutor::Next(Tuple *tuple, RID *rid) {
+  if (num_produced_ >= plan_->GetLimit() || !child_executor_->Next(tuple, rid)) {
+    return false;
+  }
+  num_produced_++;
+  return true;
+}
 
-bool LimitExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+bool LimitExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  if (num_produced_ >= plan_->GetLimit() || !child_executor_->NextBatch(batch)) {
+    return false;
+  }
+  batch->Truncate(static_cast<uint32_t>(std::min<size_t>(batch->Size(), plan_->GetLimit() - num_produced_)));
+  num_produced_ += batch->Size();
+  return true;
+}
 
 }  // namespace bustub
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// morsel_queue.cpp
+//
+// Identification: src/execution/morsel_queue.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/morsel_queue.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+MorselQueue::MorselQueue(size_t num_items, size_t morsel_size, uint32_t num_workers) : queues_(num_workers) {
+  BUSTUB_ASSERT(morsel_size > 0 && num_workers > 0, "morsels and workers must not be empty");
+  const size_t num_morsels = (num_items + morsel_size - 1) / morsel_size;
+  for (uint32_t worker = 0; worker < num_workers; worker++) {
+    // worker w gets the morsels [w * m / n, (w + 1) * m / n), neighbouring pages stay with one worker
+    const size_t first = worker * num_morsels / num_workers;
+    const size_t last = (worker + 1) * num_morsels / num_workers;
+    for (size_t morsel = first; morsel < last; morsel++) {
+      queues_[worker].morsels_.push_back({morsel * morsel_size, std::min(num_items, (morsel + 1) * morsel_size)});
+    }
+  }
+}
+
+bool MorselQueue::Next(uint32_t worker, Morsel *morsel) {
+  {
+    WorkerQueue &own = queues_[worker];
+    std::lock_guard<std::mutex> guard(own.latch_);
+    if (!own.morsels_.empty()) {
+      *morsel = own.morsels_.front();
+      own.morsels_.pop_front();
+      return true;
+    }
+  }
+  // steal the morsel the victim would have got to last
+  for (uint32_t i = 1; i < NumWorkers(); i++) {
+    WorkerQueue &victim = queues_[(worker + i) % NumWorkers()];
+    std::lock_guard<std::mutex> guard(victim.latch_);
+    if (!victim.morsels_.empty()) {
+      *morsel = victim.morsels_.back();
+      victim.morsels_.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace bustub
@@ -12,14 +12,105 @@
 
 #include "execution/executors/nested_index_join_executor.h"
 
+#include "execution/expressions/column_value_expression.h"
+
 namespace bustub {
 
 NestIndexJoinExecutor::NestIndexJoinExecutor(ExecutorContext *exec_ctx, const NestedIndexJoinPlanNode *plan,
                                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void NestIndexJoinExecutor::Init() {
+  child_executor_->Init();
+  Catalog *catalog = GetExecutorContext()->GetCatalog();
+  inner_table_info_ = catalog->GetTable(plan_->GetInnerTableOid());
+  index_info_ = catalog->GetIndex(plan_->GetIndexName(), inner_table_info_->name_);
+
+  // The predicate compares an outer column against the inner key column, the outer side computes the probe key
+  const AbstractExpression *predicate = plan_->Predicate();
+  BUSTUB_ASSERT(predicate != nullptr && predicate->GetChildren().size() == 2, "index join needs a key comparison");
+  const auto *right = dynamic_cast<const ColumnValueExpression *>(predicate->GetChildAt(1));
+  outer_key_expr_ =
+      right != nullptr && right->GetTupleIdx() == 0 ? predicate->GetChildAt(1) : predicate->GetChildAt(0);
+
+  outer_batch_.Clear();
+  inner_rids_.clear();
+  outer_cursor_ = inner_cursor_ = 0;
+}
+
+bool NestIndexJoinExecutor::FetchBatch() {
+  outer_cursor_ = inner_cursor_ = 0;
+  if (!child_executor_->NextBatch(&outer_batch_)) {
+    return false;
+  }
+
+  const Schema *outer_schema = child_executor_->GetOutputSchema();
+  const Schema &key_schema = index_info_->key_schema_;
+  const TypeId key_type = key_schema.GetColumn(0).GetType();
+  std::vector<Tuple> keys;
+  keys.reserve(outer_batch_.Size());
+  for (uint32_t i = 0; i < outer_batch_.Size(); i++) {
+    keys.emplace_back(
+        std::vector<Value>{outer_key_expr_->Evaluate(&outer_batch_.GetTuple(i), outer_schema).CastAs(key_type)},
+        &key_schema);
+  }
+  index_info_->index_->ScanKeys(keys, &inner_rids_, GetExecutorContext()->GetTransaction());
+  return true;
+}
+
+bool NestIndexJoinExecutor::NextMatch(Tuple *inner) {
+  const Schema *outer_schema = child_executor_->GetOutputSchema();
+  const Schema *inner_schema = &inner_table_info_->schema_;
+  Transaction *txn = GetExecutorContext()->GetTransaction();
+  while (true) {
+    if (outer_cursor_ == outer_batch_.Size() && !FetchBatch()) {
+      return false;
+    }
+    const std::vector<RID> &matches = inner_rids_[outer_cursor_];
+    if (inner_cursor_ == matches.size()) {
+      outer_cursor_++;
+      inner_cursor_ = 0;
+      continue;
+    }
+
+    const Tuple &outer = outer_batch_.GetTuple(outer_cursor_);
+    if (!inner_table_info_->table_->GetTuple(matches[inner_cursor_++], inner, txn)) {
+      continue;
+    }
+    if (plan_->Predicate()->EvaluateJoin(&outer, outer_schema, inner, inner_schema).GetAs<bool>()) {
+      return true;
+    }
+  }
+}
+
+Tuple NestIndexJoinExecutor::Project(const Tuple &outer, const Tuple &inner) {
+  const Schema *outer_schema = child_executor_->GetOutputSchema();
+  const Schema *inner_schema = &inner_table_info_->schema_;
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const auto &col : GetOutputSchema()->GetColumns()) {
+    values.push_back(col.GetExpr()->EvaluateJoin(&outer, outer_schema, &inner, inner_schema));
+  }
+  return Tuple(values, GetOutputSchema());
+}
 
-void NestIndexJoinExecutor::Init() {}
+bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  Tuple inner;
+  if (!NextMatch(&inner)) {
+    return false;
+  }
+  *tuple = Project(outer_batch_.GetTuple(outer_cursor_), inner);
+  *rid = inner.GetRid();
+  return true;
+}
 
-bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+bool NestIndexJoinExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  Tuple inner;
+  while (!batch->IsFull() && NextMatch(&inner)) {
+    batch->Append(Project(outer_batch_.GetTuple(outer_cursor_), inner), inner.GetRid());
+  }
+  return !batch->Empty();
+}
 
 }  // namespace bustub
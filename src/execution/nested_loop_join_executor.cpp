@@ -12,15 +12,91 @@
 
 #include "execution/executors/nested_loop_join_executor.h"
 
+#include <utility>
+#include <vector>
+
 namespace bustub {
 
 NestedLoopJoinExecutor::NestedLoopJoinExecutor(ExecutorContext *exec_ctx, const NestedLoopJoinPlanNode *plan,
                                                std::unique_ptr<AbstractExecutor> &&left_executor,
                                                std::unique_ptr<AbstractExecutor> &&right_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_executor_(std::move(left_executor)),
+      right_executor_(std::move(right_executor)) {}
+
+void NestedLoopJoinExecutor::Init() {
+  left_executor_->Init();
+  right_executor_->Init();
+
+  right_tuples_.clear();
+  TupleBatch batch;
+  while (right_executor_->NextBatch(&batch)) {
+    for (uint32_t i = 0; i < batch.Size(); i++) {
+      right_tuples_.push_back(std::move(*batch.MutableTuple(i)));
+    }
+  }
+
+  left_batch_.Clear();
+  left_cursor_ = 0;
+  right_cursor_ = 0;
+}
+
+bool NestedLoopJoinExecutor::NextMatch() {
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  const AbstractExpression *predicate = plan_->Predicate();
+  while (true) {
+    if (left_cursor_ == left_batch_.Size()) {
+      left_cursor_ = 0;
+      right_cursor_ = 0;
+      if (right_tuples_.empty() || !left_executor_->NextBatch(&left_batch_)) {
+        left_batch_.Clear();
+        return false;
+      }
+    }
+    if (right_cursor_ == right_tuples_.size()) {
+      left_cursor_++;
+      right_cursor_ = 0;
+      continue;
+    }
+
+    const Tuple &left = left_batch_.GetTuple(left_cursor_);
+    const Tuple &right = right_tuples_[right_cursor_++];
+    if (predicate == nullptr || predicate->EvaluateJoin(&left, left_schema, &right, right_schema).GetAs<bool>()) {
+      return true;
+    }
+  }
+}
+
+Tuple NestedLoopJoinExecutor::Project() {
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  const Tuple &left = left_batch_.GetTuple(left_cursor_);
+  const Tuple &right = right_tuples_[right_cursor_ - 1];
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const auto &col : GetOutputSchema()->GetColumns()) {
+    values.push_back(col.GetExpr()->EvaluateJoin(&left, left_schema, &right, right_schema));
+  }
+  return Tuple(values, GetOutputSchema());
+}
 
-void NestedLoopJoinExecutor::Init() {}
+bool NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  if (!NextMatch()) {
+    return false;
+  }
+  *tuple = Project();
+  *rid = left_batch_.GetRid(left_cursor_);
+  return true;
+}
 
-bool NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+bool NestedLoopJoinExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  while (!batch->IsFull() && NextMatch()) {
+    batch->Append(Project(), left_batch_.GetRid(left_cursor_));
+  }
+  return !batch->Empty();
+}
 
 }  // namespace bustub
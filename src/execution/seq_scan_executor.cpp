@@ -1,23 +1,200 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// seq_scan_executor.cpp
-//
-// Identification: src/execution/seq_scan_executor.cpp
-//
-// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-
-#include "execution/executors/seq_scan_executor.h"
-
-namespace bustub {
-
-SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx) {}
-
-void SeqScanExecutor::Init() {}
-
-bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// seq_scan_executor.cpp
+//
+// Identification: src/execution/seq_scan_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/seq_scan_executor.h"
+
+#include <utility>
+
+#include "common/util/thread_util.h"
+#include "execution/expressions/column_value_expression.h"
+
+namespace bustub {
+
+SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void SeqScanExecutor::Init() {
+  queue_.reset();
+  table_info_ = GetExecutorContext()->GetCatalog()->GetTable(plan_->GetTableOid());
+  if (IsParallel()) {
+    page_ids_ = table_info_->table_->GetPageIds();
+    morsels_ = std::make_unique<MorselQueue>(page_ids_.size(), MORSEL_PAGES, exec_ctx_->GetParallelism());
+  } else {
+    iter_ = std::make_unique<TableIterator>(table_info_->table_->Begin(GetExecutorContext()->GetTransaction()));
+  }
+
+  const Schema &table_schema = table_info_->schema_;
+  program_.reset();
+  registers_.reset();
+  if (plan_->GetPredicate() != nullptr) {
+    program_ = ExpressionProgram::Compile(plan_->GetPredicate(), &table_schema);
+    if (program_ != nullptr) {
+      registers_ = std::make_unique<ExpressionProgram::Registers>(*program_);
+    }
+  }
+
+  const Schema *output_schema = GetOutputSchema();
+  identity_projection_ = output_schema->GetColumnCount() == table_schema.GetColumnCount();
+  for (uint32_t i = 0; identity_projection_ && i < output_schema->GetColumnCount(); i++) {
+    const Column &col = output_schema->GetColumn(i);
+    const auto *expr = dynamic_cast<const ColumnValueExpression *>(col.GetExpr());
+    identity_projection_ =
+        expr != nullptr && expr->GetColIdx() == i && col.GetType() == table_schema.GetColumn(i).GetType();
+  }
+}
+
+bool SeqScanExecutor::Matches(const Tuple &raw, ExpressionProgram::Registers *regs) const {
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  if (predicate == nullptr) {
+    return true;
+  }
+  if (program_ != nullptr) {
+    return program_->Matches(raw, regs);
+  }
+  const Value result = predicate->Evaluate(&raw, &table_info_->schema_);
+  return !result.IsNull() && result.GetAs<bool>();
+}
+
+Tuple SeqScanExecutor::Project(const Tuple &raw) {
+  if (identity_projection_) {
+    return raw;
+  }
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const auto &col : GetOutputSchema()->GetColumns()) {
+    values.push_back(col.GetExpr()->Evaluate(&raw, &table_info_->schema_));
+  }
+  return Tuple(values, GetOutputSchema());
+}
+
+bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
+  if (IsParallel()) {
+    StartQueue();
+    return queue_->Next(tuple, rid);
+  }
+
+  for (; *iter_ != table_info_->table_->End(); ++(*iter_)) {
+    const Tuple &raw = **iter_;
+    if (!Matches(raw, registers_.get())) {
+      continue;
+    }
+    *tuple = Project(raw);
+    *rid = raw.GetRid();
+    ++(*iter_);
+    return true;
+  }
+  return false;
+}
+
+bool SeqScanExecutor::NextBatch(TupleBatch *batch) {
+  if (IsParallel()) {
+    StartQueue();
+    return queue_->NextBatch(batch);
+  }
+
+  const TableIterator end = table_info_->table_->End();
+  // a batch the predicate rejects entirely is not handed out, the scan moves on to the next one
+  do {
+    batch->Clear();
+    for (; !batch->IsFull() && *iter_ != end; ++(*iter_)) {
+      batch->Append(**iter_, (**iter_).GetRid());
+    }
+    if (program_ != nullptr) {
+      program_->Filter(batch, registers_.get());
+    } else if (plan_->GetPredicate() != nullptr) {
+      batch->Filter([this](const Tuple &raw) { return Matches(raw, nullptr); });
+    }
+  } while (batch->Empty() && *iter_ != end);
+
+  if (!identity_projection_) {
+    for (uint32_t i = 0; i < batch->Size(); i++) {
+      Tuple *tuple = batch->MutableTuple(i);
+      *tuple = Project(*tuple);
+    }
+  }
+  return !batch->Empty();
+}
+
+void SeqScanExecutor::ScanMorsels(uint32_t worker, const BatchSink &sink, std::atomic<bool> *stop) {
+  Transaction *txn = GetExecutorContext()->GetTransaction();
+  TupleBatch batch;
+  std::vector<Tuple> page_tuples;
+  std::vector<uint8_t> matches;
+  std::unique_ptr<ExpressionProgram::Registers> regs;
+  if (program_ != nullptr) {
+    regs = std::make_unique<ExpressionProgram::Registers>(*program_);
+  }
+  MorselQueue::Morsel morsel;
+  while (!*stop && morsels_->Next(worker, &morsel)) {
+    for (size_t i = morsel.begin_; i < morsel.end_ && !*stop; i++) {
+      page_tuples.clear();
+      table_info_->table_->ReadPage(page_ids_[i], &page_tuples, txn);
+      // the predicate runs over the whole page at once
+      if (program_ != nullptr) {
+        program_->Match(page_tuples, regs.get(), &matches);
+      } else {
+        matches.resize(page_tuples.size());
+        for (size_t row = 0; row < page_tuples.size(); row++) {
+          matches[row] = static_cast<uint8_t>(Matches(page_tuples[row], nullptr));
+        }
+      }
+      for (size_t row = 0; row < page_tuples.size(); row++) {
+        if (matches[row] == 0) {
+          continue;
+        }
+        Tuple &raw = page_tuples[row];
+        const RID rid = raw.GetRid();
+        batch.Append(identity_projection_ ? std::move(raw) : Project(raw), rid);
+        if (batch.IsFull()) {
+          if (!sink(worker, &batch)) {
+            *stop = true;
+            return;
+          }
+          batch.Clear();
+        }
+      }
+    }
+  }
+  if (!batch.Empty() && !*stop && !sink(worker, &batch)) {
+    *stop = true;
+  }
+}
+
+void SeqScanExecutor::ParallelDrain(const BatchSink &sink) {
+  if (!IsParallel()) {
+    AbstractExecutor::ParallelDrain(sink);
+    return;
+  }
+
+  // a worker that fails stops the others early
+  std::atomic<bool> stop{false};
+  ThreadUtil::RunWorkers(exec_ctx_->GetParallelism(), [&](uint32_t worker) {
+    try {
+      ScanMorsels(worker, sink, &stop);
+    } catch (...) {
+      stop = true;
+      throw;
+    }
+  });
+}
+
+void SeqScanExecutor::StartQueue() {
+  if (queue_ == nullptr) {
+    queue_ = std::make_unique<BatchQueue>(MAX_QUEUED_BATCHES);
+    BatchQueue *queue = queue_.get();
+    queue_->Start([this, queue] {
+      ParallelDrain([queue](uint32_t /*worker*/, TupleBatch *batch) { return queue->Push(batch); });
+    });
+  }
+}
+
+}  // namespace bustub
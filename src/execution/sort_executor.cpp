@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.cpp
+//
+// Identification: src/execution/sort_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/sort_executor.h"
+
+#include <memory>
+#include <utility>
+
+#include "storage/index/varlen_key.h"
+
+namespace bustub {
+
+SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
+                           std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void SortExecutor::MakeSortKey(const SortPlanNode *plan, const Schema *child_schema, const Tuple &tuple,
+                               std::string *key) {
+  key->clear();
+  for (const auto &[order_by_type, expr] : plan->GetOrderBys()) {
+    const size_t begin = key->size();
+    VarlenKey::EncodeValue(expr->Evaluate(&tuple, child_schema), key);
+    if (order_by_type == OrderByType::DESC) {
+      for (size_t i = begin; i < key->size(); i++) {
+        (*key)[i] = static_cast<char>(~(*key)[i]);
+      }
+    }
+  }
+}
+
+void SortExecutor::Init() {
+  child_executor_->Init();
+  const Schema *child_schema = child_executor_->GetOutputSchema();
+  sorter_ = std::make_unique<ExternalSorter>(
+      exec_ctx_->GetBufferPoolManager(), exec_ctx_->GetMemoryBudget(), exec_ctx_->GetParallelism(),
+      [this, child_schema](const Tuple &tuple, std::string *key) { MakeSortKey(plan_, child_schema, tuple, key); });
+  child_executor_->ParallelDrain([this](uint32_t worker, TupleBatch *batch) {
+    for (uint32_t i = 0; i < batch->Size(); i++) {
+      sorter_->Add(worker, std::move(*batch->MutableTuple(i)));
+    }
+    return true;
+  });
+  sorter_->Finish();
+}
+
+bool SortExecutor::Next(Tuple *tuple, RID *rid) {
+  *rid = RID();
+  return sorter_->Next(tuple);
+}
+
+bool SortExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  Tuple tuple;
+  while (!batch->IsFull() && sorter_->Next(&tuple)) {
+    batch->Append(std::move(tuple), RID());
+  }
+  return !batch->Empty();
+}
+
+}  // namespace bustub
@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_executor.cpp
+//
+// Identification: src/execution/topn_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/topn_executor.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "execution/executors/sort_executor.h"
+#include "execution/external_sorter.h"
+
+namespace bustub {
+
+TopNExecutor::TopNExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *limit_plan, const SortPlanNode *sort_plan,
+                           std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx),
+      limit_plan_(limit_plan),
+      sort_plan_(sort_plan),
+      child_executor_(std::move(child_executor)) {}
+
+void TopNExecutor::Offer(Heap *heap, uint64_t prefix, std::string *key, Tuple *tuple) const {
+  if (heap->entries_.size() < limit_plan_->GetLimit()) {
+    heap->entries_.push_back({prefix, std::move(*key), static_cast<uint32_t>(heap->slots_.size())});
+    heap->slots_.push_back(std::move(*tuple));
+    std::push_heap(heap->entries_.begin(), heap->entries_.end());
+    return;
+  }
+  const HeapEntry &worst = heap->entries_.front();
+  if (prefix != worst.prefix_ ? prefix > worst.prefix_ : *key >= worst.key_) {
+    return;
+  }
+  // the worst tuple makes room, its entry and slot are reused
+  std::pop_heap(heap->entries_.begin(), heap->entries_.end());
+  HeapEntry &entry = heap->entries_.back();
+  entry.prefix_ = prefix;
+  entry.key_.swap(*key);
+  heap->slots_[entry.slot_] = std::move(*tuple);
+  std::push_heap(heap->entries_.begin(), heap->entries_.end());
+}
+
+void TopNExecutor::Init() {
+  child_executor_->Init();
+  output_.clear();
+  next_ = 0;
+  if (limit_plan_->GetLimit() == 0) {
+    return;
+  }
+
+  const Schema *child_schema = child_executor_->GetOutputSchema();
+  std::vector<Heap> heaps(exec_ctx_->GetParallelism());
+  child_executor_->ParallelDrain([&](uint32_t worker, TupleBatch *batch) {
+    Heap &heap = heaps[worker];
+    for (uint32_t i = 0; i < batch->Size(); i++) {
+      SortExecutor::MakeSortKey(sort_plan_, child_schema, batch->GetTuple(i), &heap.key_);
+      Offer(&heap, ExternalSorter::KeyPrefix(heap.key_), &heap.key_, batch->MutableTuple(i));
+    }
+    return true;
+  });
+
+  // the best of the other workers' tuples go into the heap of the first
+  Heap &top = heaps[0];
+  for (size_t worker = 1; worker < heaps.size(); worker++) {
+    for (auto &entry : heaps[worker].entries_) {
+      Offer(&top, entry.prefix_, &entry.key_, &heaps[worker].slots_[entry.slot_]);
+    }
+  }
+  std::sort_heap(top.entries_.begin(), top.entries_.end());
+  output_.reserve(top.entries_.size());
+  for (const auto &entry : top.entries_) {
+    output_.push_back(std::move(top.slots_[entry.slot_]));
+  }
+}
+
+bool TopNExecutor::Next(Tuple *tuple, RID *rid) {
+  if (next_ == output_.size()) {
+    return false;
+  }
+  *tuple = std::move(output_[next_++]);
+  *rid = RID();
+  return true;
+}
+
+bool TopNExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  while (!batch->IsFull() && next_ < output_.size()) {
+    batch->Append(std::move(output_[next_++]), RID());
+  }
+  return !batch->Empty();
+}
+
+}  // namespace bustub
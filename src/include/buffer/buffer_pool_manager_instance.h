@@ -14,6 +14,7 @@
 
 #include <list>
 #include <mutex>  // NOLINT
+#include <set>
 #include <unordered_map>
 
 #include "buffer/buffer_pool_manager.h"
@@ -101,18 +102,18 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Allocate a page on disk, reusing the lowest deallocated page id first.
+   * Caller must hold latch_.
    * @return the id of the allocated page
    */
   page_id_t AllocatePage();
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, its id is handed out again by AllocatePage.
+   * Caller must hold latch_.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id) { free_page_ids_.insert(page_id); }
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -121,6 +122,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
+  /**
+   * Take a frame from the free list, or evict the least recently used unpinned page and write it back if dirty.
+   * Caller must hold latch_.
+   * @param[out] frame_id the acquired frame, no longer present in the page table
+   * @return false if every frame is pinned
+   */
+  bool AcquireFrame(frame_id_t *frame_id);
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
@@ -143,6 +152,8 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   Replacer *replacer_;
   /** List of free pages.没有被使用的页框号*/
   std::list<frame_id_t> free_list_;
+  /** Deallocated page ids, the set ignores a page deleted twice */
+  std::set<page_id_t> free_page_ids_;
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
 };
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <memory>
+#include <numeric>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -21,9 +22,16 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
+#include "execution/external_sorter.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/cuckoo_hash_table_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
+#include "storage/index/integer_key.h"
+#include "storage/index/varlen_b_plus_tree_index.h"
+#include "storage/index/varlen_key.h"
 #include "storage/table/table_heap.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -34,6 +42,13 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/**
+ * The kind of index structure built by Catalog::CreateIndex. HashTableIndex is
+ * extendible hashing; CuckooHashTableIndex bounds every lookup to two bucket
+ * pages and suits read-mostly point lookups.
+ */
+enum class IndexType { BPlusTreeIndex, HashTableIndex, CuckooHashTableIndex };
+
 /**
  * The TableInfo class maintains metadata about a table.
  */
@@ -105,6 +120,12 @@ class Catalog {
   /** Indicates that an operation returning a `IndexInfo*` failed */
   static constexpr IndexInfo *NULL_INDEX_INFO{nullptr};
 
+  /** Buckets a new cuckoo hash index starts with; it doubles them as it fills */
+  static constexpr std::size_t CUCKOO_INDEX_NUM_BUCKETS{4};
+
+  /** The memory the build of a B+ tree index sorts its keys in before it spills them to temporary pages */
+  static constexpr std::size_t INDEX_BUILD_SORT_BUDGET{16 << 20};
+
   /**
    * Construct a new Catalog instance.
    * @param bpm The buffer pool manager backing tables created by this catalog
@@ -192,18 +213,7 @@ class Catalog {
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
                          std::size_t keysize, HashFunction<KeyType> hash_function) {
-    // Reject the creation request for nonexistent table
-    if (table_names_.find(table_name) == table_names_.end()) {
-      return NULL_INDEX_INFO;
-    }
-
-    // If the table exists, an entry for the table should already be present in index_names_
-    BUSTUB_ASSERT((index_names_.find(table_name) != index_names_.end()), "Broken Invariant");
-
-    // Determine if the requested index already exists for this table
-    auto &table_indexes = index_names_.find(table_name)->second;
-    if (table_indexes.find(index_name) != table_indexes.end()) {
-      // The requested index already exists for this table
+    if (!CanCreateIndex(index_name, table_name)) {
       return NULL_INDEX_INFO;
     }
 
@@ -211,32 +221,45 @@ class Catalog {
     auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
 
     // Construct the index, take ownership of metadata
-    // TODO(Kyle): We should update the API for CreateIndex
-    // to allow specification of the index type itself, not
-    // just the key, value, and comparator types
     auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
                                                                                                hash_function);
 
-    // Populate the index with all tuples in table heap
-    auto *table_meta = GetTable(table_name);
-    auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
-    }
-
-    // Get the next OID for the new index
-    const auto index_oid = next_index_oid_.fetch_add(1);
+    return AddIndex(txn, std::move(index), index_name, table_name, schema, key_schema, key_attrs, keysize);
+  }
 
-    // Construct index information; IndexInfo takes ownership of the Index itself
-    auto index_info =
-        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
-    auto *tmp = index_info.get();
+  /**
+   * Create a new index, populate existing data of the table and return its metadata.
+   *
+   * The key type is picked from the key schema: keys made only of fixed-width integer
+   * columns use the memcmp-able IntegerKey, everything else uses the smallest GenericKey
+   * that holds `keysize` bytes.
+   *
+   * @param txn The transaction in which the table is being created
+   * @param index_name The name of the new index
+   * @param table_name The name of the table
+   * @param schema The schema of the table
+   * @param key_schema The schema of the key
+   * @param key_attrs Key attributes
+   * @param keysize Size of the key
+   * @param index_type The kind of index to build
+   * @return A (non-owning) pointer to the metadata of the new table, NULL_INDEX_INFO if
+   * no supported key type is large enough
+   */
+  IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                         const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
+                         std::size_t keysize, IndexType index_type = IndexType::HashTableIndex) {
+    if (!CanCreateIndex(index_name, table_name)) {
+      return NULL_INDEX_INFO;
+    }
 
-    // Update internal tracking
-    indexes_.emplace(index_oid, std::move(index_info));
-    table_indexes.emplace(index_name, index_oid);
+    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
+    auto index = MakeIndex(std::move(meta), key_schema, keysize, index_type);
+    if (index == nullptr) {
+      return NULL_INDEX_INFO;
+    }
 
-    return tmp;
+    return AddIndex(txn, std::move(index), index_name, table_name, schema, key_schema, key_attrs, keysize,
+                    index_type == IndexType::BPlusTreeIndex);
   }
 
   /**
@@ -323,6 +346,141 @@ class Catalog {
   }
 
  private:
+  /**
+   * @return true if table `table_name` exists and has no index named `index_name`
+   */
+  bool CanCreateIndex(const std::string &index_name, const std::string &table_name) {
+    // Reject the creation request for nonexistent table
+    if (table_names_.find(table_name) == table_names_.end()) {
+      return false;
+    }
+
+    // If the table exists, an entry for the table should already be present in index_names_
+    BUSTUB_ASSERT((index_names_.find(table_name) != index_names_.end()), "Broken Invariant");
+
+    // Determine if the requested index already exists for this table
+    auto &table_indexes = index_names_.find(table_name)->second;
+    return table_indexes.find(index_name) == table_indexes.end();
+  }
+
+  /**
+   * Construct an index keyed on `key_schema`, using the most specialized key type that fits.
+   * B+ tree indexes on keys with VARCHAR columns store their keys unpadded in a VarlenBPlusTree.
+   * @return An owning pointer to the index, nullptr if the key does not fit any key type
+   */
+  std::unique_ptr<Index> MakeIndex(std::unique_ptr<IndexMetadata> &&meta, const Schema &key_schema,
+                                   std::size_t keysize, IndexType index_type) {
+    if (index_type == IndexType::BPlusTreeIndex && HasVarlenColumn(key_schema)) {
+      return std::make_unique<VarlenBPlusTreeIndex>(std::move(meta), bpm_);
+    }
+    const auto integer_key_size = IntegerKeySize(key_schema);
+    if (integer_key_size != 0 && integer_key_size <= 4) {
+      return MakeIndex<IntegerKey<4>, IntegerComparator<4>>(std::move(meta), index_type);
+    }
+    if (integer_key_size != 0 && integer_key_size <= 8) {
+      return MakeIndex<IntegerKey<8>, IntegerComparator<8>>(std::move(meta), index_type);
+    }
+    if (integer_key_size != 0 && integer_key_size <= 16) {
+      return MakeIndex<IntegerKey<16>, IntegerComparator<16>>(std::move(meta), index_type);
+    }
+    if (keysize <= 4) {
+      return MakeIndex<GenericKey<4>, GenericComparator<4>>(std::move(meta), index_type);
+    }
+    if (keysize <= 8) {
+      return MakeIndex<GenericKey<8>, GenericComparator<8>>(std::move(meta), index_type);
+    }
+    if (keysize <= 16) {
+      return MakeIndex<GenericKey<16>, GenericComparator<16>>(std::move(meta), index_type);
+    }
+    if (keysize <= 32) {
+      return MakeIndex<GenericKey<32>, GenericComparator<32>>(std::move(meta), index_type);
+    }
+    if (keysize <= 64) {
+      return MakeIndex<GenericKey<64>, GenericComparator<64>>(std::move(meta), index_type);
+    }
+    return nullptr;
+  }
+
+  template <class KeyType, class KeyComparator>
+  std::unique_ptr<Index> MakeIndex(std::unique_ptr<IndexMetadata> &&meta, IndexType index_type) {
+    switch (index_type) {
+      case IndexType::BPlusTreeIndex:
+        return std::make_unique<BPlusTreeIndex<KeyType, RID, KeyComparator>>(std::move(meta), bpm_);
+      case IndexType::HashTableIndex:
+        return std::make_unique<ExtendibleHashTableIndex<KeyType, RID, KeyComparator>>(std::move(meta), bpm_,
+                                                                                      HashFunction<KeyType>());
+      case IndexType::CuckooHashTableIndex:
+        return std::make_unique<CuckooHashTableIndex<KeyType, RID, KeyComparator>>(
+            std::move(meta), bpm_, CUCKOO_INDEX_NUM_BUCKETS, HashFunction<KeyType>());
+    }
+    UNREACHABLE("Unknown index type");
+  }
+
+  /**
+   * Populate `index` with all tuples in the table heap and register it with the catalog.
+   * @param sort_keys insert the keys in key order, which a B+ tree fills faster from: the inserts follow the same path
+   * down the tree and fill one leaf after another
+   * @return A (non-owning) pointer to the metadata of the new index
+   */
+  IndexInfo *AddIndex(Transaction *txn, std::unique_ptr<Index> &&index, const std::string &index_name,
+                      const std::string &table_name, const Schema &schema, const Schema &key_schema,
+                      const std::vector<uint32_t> &key_attrs, std::size_t keysize, bool sort_keys = false) {
+    // Populate the index with all tuples in table heap
+    auto *table_meta = GetTable(table_name);
+    auto *heap = table_meta->table_.get();
+    if (sort_keys) {
+      InsertSorted(txn, index.get(), heap, schema, key_schema, key_attrs);
+    } else {
+      for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
+        index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+      }
+    }
+
+    // Get the next OID for the new index
+    const auto index_oid = next_index_oid_.fetch_add(1);
+
+    // Construct index information; IndexInfo takes ownership of the Index itself
+    auto index_info =
+        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    auto *tmp = index_info.get();
+
+    // Update internal tracking
+    indexes_.emplace(index_oid, std::move(index_info));
+    index_names_.find(table_name)->second.emplace(index_name, index_oid);
+
+    return tmp;
+  }
+
+  /** Insert the keys of all tuples in heap into index in key order, sorted by an ExternalSorter */
+  void InsertSorted(Transaction *txn, Index *index, TableHeap *heap, const Schema &schema, const Schema &key_schema,
+                    const std::vector<uint32_t> &key_attrs) {
+    // the sorted tuples are the key columns followed by the RID
+    std::vector<Column> columns = key_schema.GetColumns();
+    columns.emplace_back("rid", TypeId::BIGINT);
+    const Schema sort_schema(columns);
+    std::vector<uint32_t> sort_key_attrs(key_schema.GetColumnCount());
+    std::iota(sort_key_attrs.begin(), sort_key_attrs.end(), 0);
+
+    ExternalSorter sorter(bpm_, INDEX_BUILD_SORT_BUDGET, 1, [&key_schema](const Tuple &tuple, std::string *key) {
+      VarlenKey::Encode(tuple, key_schema, key);
+    });
+    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
+      std::vector<Value> values;
+      for (auto idx : key_attrs) {
+        values.push_back(tuple->GetValue(&schema, idx));
+      }
+      values.push_back(ValueFactory::GetBigIntValue(tuple->GetRid().Get()));
+      sorter.Add(0, Tuple(values, &sort_schema));
+    }
+    sorter.Finish();
+
+    Tuple sorted;
+    while (sorter.Next(&sorted)) {
+      const RID rid(sorted.GetValue(&sort_schema, key_schema.GetColumnCount()).GetAs<int64_t>());
+      index->InsertEntry(sorted.KeyFromTuple(sort_schema, key_schema, sort_key_attrs), rid, txn);
+    }
+  }
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena.h
+//
+// Identification: src/include/common/arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * Bump allocator for objects that live exactly as long as the structure
+ * holding them, such as the entries of an in-memory hash table.
+ *
+ * Memory comes in blocks that double in size up to MAX_BLOCK_SIZE, and an
+ * allocation moves a cursor through the current block. Nothing is freed
+ * until Reset or the arena's destruction, and no destructors are run: an
+ * owner of objects that need one calls it itself. Addresses handed out stay
+ * valid until then, also when the arena is moved.
+ *
+ * An arena is not thread-safe; give each thread its own.
+ */
+class Arena {
+ public:
+  /** Size of the first block */
+  static constexpr size_t DEFAULT_BLOCK_SIZE = 64 << 10;
+  /** Blocks stop doubling at this size, larger allocations get a block of their own */
+  static constexpr size_t MAX_BLOCK_SIZE = 16 << 20;
+
+  explicit Arena(size_t block_size = DEFAULT_BLOCK_SIZE) : initial_block_size_(block_size) {}
+
+  DISALLOW_COPY(Arena);
+  Arena(Arena &&other) noexcept;
+  Arena &operator=(Arena &&other) noexcept;
+  ~Arena() = default;
+
+  /**
+   * @param size bytes to allocate
+   * @param alignment a power of two
+   * @return uninitialized memory, valid until Reset
+   */
+  void *Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    const auto cursor = reinterpret_cast<uintptr_t>(cursor_);
+    const uintptr_t aligned = (cursor + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    if (cursor_ == nullptr || aligned + size > reinterpret_cast<uintptr_t>(end_)) {
+      return AllocateSlow(size, alignment);
+    }
+    cursor_ = reinterpret_cast<char *>(aligned + size);
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  /** Frees every block at once */
+  void Reset();
+
+  /** @return the bytes of all blocks held, used or not */
+  size_t MemoryUsage() const { return memory_usage_; }
+
+ private:
+  /** Starts a new block big enough for the allocation and allocates from it */
+  void *AllocateSlow(size_t size, size_t alignment);
+
+  size_t initial_block_size_;
+  size_t next_block_size_{0};
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char *cursor_{nullptr};
+  char *end_{nullptr};
+  size_t memory_usage_{0};
+};
+
+}  // namespace bustub
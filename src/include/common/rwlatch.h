@@ -48,6 +48,19 @@ class ReaderWriterLatch {
     }
   }
 
+  /**
+   * Acquire a write latch only if no reader or writer holds or waits for it.
+   * @return true if the write latch was acquired
+   */
+  bool TryWLock() {
+    std::lock_guard<mutex_t> guard(mutex_);
+    if (writer_entered_ || reader_count_ > 0) {
+      return false;
+    }
+    writer_entered_ = true;
+    return true;
+  }
+
   /**
    * Release a write latch.
    */
@@ -0,0 +1,32 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_util.h
+//
+// Identification: src/include/common/util/thread_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace bustub {
+
+/**
+ * ThreadUtil provides helpers for running the workers of a parallel operator.
+ */
+class ThreadUtil {
+ public:
+  /**
+   * Run work(0) on the calling thread and work(1) to work(num_threads - 1) on threads of their own, and wait for all
+   * of them. The first exception any of them throws is rethrown once all are done.
+   */
+  static void RunWorkers(uint32_t num_threads, const std::function<void(uint32_t worker)> &work);
+};
+
+}  // namespace bustub
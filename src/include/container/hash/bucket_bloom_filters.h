@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bucket_bloom_filters.h
+//
+// Identification: src/include/container/hash/bucket_bloom_filters.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/rwlatch.h"
+
+namespace bustub {
+
+/**
+ * Blocked Bloom filter over 32-bit hashes. A hash picks one 64-byte block and
+ * sets one bit in each of the block's eight words, so an insert or a probe
+ * touches a single cache line. Bits are set atomically, so inserts may run
+ * alongside probes.
+ */
+class BlockedBloomFilter {
+ public:
+  static constexpr size_t BLOCK_SIZE = 64;
+
+  explicit BlockedBloomFilter(size_t num_blocks) : num_blocks_(num_blocks), words_(num_blocks * WORDS_PER_BLOCK) {}
+
+  void Insert(uint32_t hash);
+
+  /** @return false if no hash inserted so far equals hash */
+  bool MayContain(uint32_t hash) const;
+
+  /** @return the bytes taken by the filter bits */
+  size_t MemoryUsage() const { return num_blocks_ * BLOCK_SIZE; }
+
+ private:
+  static constexpr size_t WORDS_PER_BLOCK = BLOCK_SIZE / sizeof(uint64_t);
+
+  size_t BlockOf(uint32_t hash) const { return static_cast<size_t>((static_cast<uint64_t>(hash) * num_blocks_) >> 32); }
+
+  /** @return the bit hash sets in word i of its block */
+  static uint64_t BitOf(uint32_t hash, size_t i);
+
+  size_t num_blocks_;
+  std::vector<std::atomic<uint64_t>> words_;
+};
+
+/** Counters of the lookups that consulted BucketBloomFilters */
+struct BloomFilterStats {
+  /** Bytes held by the filters */
+  size_t memory_bytes_{0};
+  /** Lookups answered as misses by a filter, without reading their bucket */
+  uint64_t negatives_{0};
+  /** Lookups that got past the filters but found nothing in their bucket */
+  uint64_t false_positives_{0};
+
+  /**
+   * @return the fraction of lookups of absent keys that still read their
+   * bucket, counting buckets left without a filter by the memory budget
+   */
+  double FalsePositiveRate() const {
+    const uint64_t misses = negatives_ + false_positives_;
+    return misses == 0 ? 0.0 : static_cast<double>(false_positives_) / static_cast<double>(misses);
+  }
+};
+
+/**
+ * In-memory Bloom filters for the buckets of an ExtendibleHashTable, kept
+ * beside its directory so that a lookup can rule out an absent key without
+ * fetching the header, directory or bucket page.
+ *
+ * Each bucket has one BlockedBloomFilter, and the filters are indexed like
+ * the directory: entry i of a directory of global depth G covers the hashes
+ * whose low G bits are i, and all entries of a bucket share its filter. The
+ * filters use the high 32 bits of the 64-bit key hash, which stay independent
+ * of the low bits that pick the bucket.
+ *
+ * Inserts set bits in the key's filter. Removes leave their bits, so a
+ * filter only gains false positives until its bucket is split or merged and
+ * the filter is rebuilt from the bucket's keys.
+ *
+ * Memory: a bucket of local depth L gets at most budget / 2^L bytes, so the
+ * filters never exceed the budget together, and no more than BITS_PER_KEY
+ * bits per slot of a full bucket. A bucket whose share is below one block
+ * has no filter and every lookup of it reads the bucket. The directory-sized
+ * array of filter pointers comes on top of the budget.
+ *
+ * Concurrency: the table calls SetGlobalDepth and Rebuild only while it holds
+ * its directory latch exclusively, and Insert while it holds the directory
+ * latch shared and the bucket latch exclusively. MayContain runs without the
+ * table's latches and is kept apart from SetGlobalDepth and Rebuild by the
+ * filters' own latch.
+ */
+class BucketBloomFilters {
+ public:
+  /** Filter bits per bucket slot, about a 1% false positive rate for a full bucket */
+  static constexpr size_t BITS_PER_KEY = 10;
+
+  /**
+   * @param budget_bytes the most memory the filters may take, 0 turns the filters off
+   * @param bucket_capacity the number of slots of a bucket
+   */
+  BucketBloomFilters(size_t budget_bytes, size_t bucket_capacity);
+
+  /** @return false if the key with this hash is definitely not in the table */
+  bool MayContain(uint64_t hash);
+
+  /** Adds a key inserted into its bucket */
+  void Insert(uint64_t hash);
+
+  /** Counts a lookup that passed MayContain but found no value */
+  void RecordFalsePositive() { false_positives_.fetch_add(1, std::memory_order_relaxed); }
+
+  /** Follows the directory to global depth depth, new entries mirror the lower half as in a directory */
+  void SetGlobalDepth(uint32_t depth);
+
+  /**
+   * Replaces the filter of the bucket at directory entries first, first +
+   * step, ... with one holding hashes.
+   * @param local_depth the bucket's local depth, which sets its share of the budget
+   */
+  void Rebuild(uint32_t first, uint32_t step, uint32_t local_depth, const std::vector<uint64_t> &hashes);
+
+  BloomFilterStats GetStats();
+
+ private:
+  static uint32_t FilterHash(uint64_t hash) { return static_cast<uint32_t>(hash >> 32); }
+
+  size_t budget_bytes_;
+  size_t bucket_capacity_;
+  /** Guards the filter array, not the filter bits */
+  ReaderWriterLatch latch_;
+  /** The filter of each directory entry, nullptr for a bucket without one */
+  std::vector<std::shared_ptr<BlockedBloomFilter>> filters_;
+  std::atomic<uint64_t> negatives_{0};
+  std::atomic<uint64_t> false_positives_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// cuckoo_hash_table.h
+//
+// Identification: src/include/container/hash/cuckoo_hash_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "container/hash/hash_function.h"
+#include "container/hash/hash_table.h"
+#include "storage/page/hash_table_cuckoo_bucket_page.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+#define CUCKOO_HASH_TABLE_TYPE CuckooHashTable<KeyType, ValueType, KeyComparator>
+
+/**
+ * Implementation of bucketized cuckoo hashing backed by a buffer pool
+ * manager. Non-unique keys are supported. Supports insert and delete. The
+ * table dynamically grows once full.
+ *
+ * Every bucket is a page, and a key may live in one of two buckets only, one
+ * picked by the low and one by the high half of its 64-bit hash, so a lookup
+ * reads at most two pages whatever the load. An insert into two full buckets
+ * makes room by moving pairs to their other bucket: a breadth-first search
+ * over at most MAX_SEARCH_BUCKETS buckets looks for a chain of moves ending
+ * in a bucket with a free slot, and the moves run from its end, so that each
+ * pair lands in a free slot and is in its new bucket before it leaves the
+ * old. When no such chain exists and the table is at least half full, the
+ * number of buckets doubles: bucket i keeps the pairs still mapping to it
+ * and gives the others to the new bucket i + n. Otherwise the two buckets
+ * are full of values of one key, and the insert fails.
+ *
+ * The bucket page ids are kept in memory only, in a directory of chunks
+ * that each doubling adds one to; bucket pages are never freed, the table
+ * does not shrink.
+ *
+ * Concurrency: lookups take no latch. They read both buckets optimistically
+ * under the bucket versions (see HashTableCuckooBucketPage) and a table
+ * version bumped around every doubling, retrying until neither changed, and
+ * compare keys only on a consistent copy. Inserts and removes are
+ * serialized with one another. A doubling makes lookups wait until it ends.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class CuckooHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
+ public:
+  /**
+   * Creates a new CuckooHashTable
+   *
+   * @param buffer_pool_manager buffer pool manager to be used
+   * @param comparator comparator for keys
+   * @param num_buckets initial number of buckets, rounded up to a power of two
+   * @param hash_fn the hash function
+   */
+  explicit CuckooHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                           const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn);
+
+  /**
+   * Inserts a key-value pair into the hash table.
+   * @param transaction the current transaction
+   * @param key the key to create
+   * @param value the value to be associated with the key
+   * @return true if insert succeeded, false otherwise
+   */
+  bool Insert(Transaction *transaction, const KeyType &key, const ValueType &value) override;
+
+  /**
+   * Deletes the associated value for the given key.
+   * @param transaction the current transaction
+   * @param key the key to delete
+   * @param value the value to delete
+   * @return true if remove succeeded, false otherwise
+   */
+  bool Remove(Transaction *transaction, const KeyType &key, const ValueType &value) override;
+
+  /**
+   * Performs a point query on the hash table.
+   * @param transaction the current transaction
+   * @param key the key to look up
+   * @param[out] result the value(s) associated with a given key
+   * @return the value(s) associated with the given key
+   */
+  bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
+
+  /**
+   * Gets the size of the hash table
+   * @return current size of the hash table
+   */
+  size_t GetSize() const { return num_pairs_.load(std::memory_order_relaxed); }
+
+  size_t GetNumBuckets() const { return num_buckets_.load(std::memory_order_acquire); }
+
+  /** Most buckets the search for a chain of moves visits before the table doubles instead */
+  static constexpr size_t MAX_SEARCH_BUCKETS = 64;
+
+ private:
+  /** Bucket of the directory, the pair count is a copy for the writers' bookkeeping only */
+  struct BucketEntry {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    uint32_t num_pairs_{0};
+  };
+
+  /** Bucket of the breadth-first search for a chain of moves */
+  struct SearchNode {
+    size_t bucket_idx_;
+    // node of the bucket that moves a pair into this one, SIZE_MAX for the buckets of the key inserted
+    size_t parent_;
+    // slot of the parent bucket holding that pair
+    uint32_t parent_slot_;
+  };
+
+  // a directory of 2^32 times the initial number of buckets is more than any buffer pool can hold
+  static constexpr size_t MAX_DIRECTORY_CHUNKS = 33;
+
+  uint64_t Hash(const KeyType &key) { return hash_fn_.GetHash(key); }
+
+  static size_t FirstBucket(uint64_t hash, size_t num_buckets) {
+    return static_cast<uint32_t>(hash) & (num_buckets - 1);
+  }
+
+  static size_t SecondBucket(uint64_t hash, size_t num_buckets) { return (hash >> 32) & (num_buckets - 1); }
+
+  /** @return the bucket other than bucket_idx a key with this hash may live in, bucket_idx if both are the same */
+  size_t OtherBucket(uint64_t hash, size_t bucket_idx) const;
+
+  /** @return the directory entry of a bucket, num_buckets_ must already include it */
+  BucketEntry &Entry(size_t bucket_idx) const;
+
+  /** Fetch the page of a bucket, throwing if the buffer pool is out of frames */
+  Page *FetchBucket(size_t bucket_idx) const;
+
+  /**
+   * Free a slot in the first or second bucket of a key by moving pairs to
+   * their other buckets. The caller holds write_latch_.
+   * @return false if no chain of moves within MAX_SEARCH_BUCKETS buckets frees one
+   */
+  bool MakeRoom(size_t first_bucket, size_t second_bucket);
+
+  /** Move the pair in slot of one bucket to another bucket with a free slot, the caller holds write_latch_ */
+  void MovePair(size_t from_bucket, uint32_t slot, size_t to_bucket);
+
+  /** Double the number of buckets, the caller holds write_latch_ */
+  void Grow();
+
+  // member variable
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+
+  // Serializes inserts, removes and with them moves and doublings
+  std::mutex write_latch_;
+  // odd while a doubling is in progress
+  std::atomic<uint64_t> table_version_{0};
+  std::atomic<size_t> num_buckets_{0};
+  size_t initial_num_buckets_;
+  // chunk 0 holds the initial buckets, chunk k > 0 the buckets added by the k-th doubling; chunks never move
+  std::array<std::unique_ptr<BucketEntry[]>, MAX_DIRECTORY_CHUNKS> directory_;
+  std::atomic<size_t> num_pairs_{0};
+
+  // Hash function
+  HashFunction<KeyType> hash_fn_;
+};
+
+}  // namespace bustub
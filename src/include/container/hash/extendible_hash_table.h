@@ -12,15 +12,21 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction.h"
+#include "container/hash/bucket_bloom_filters.h"
 #include "container/hash/hash_function.h"
-#include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_directory_header_page.h"
+#include "storage/page/hash_table_tagged_bucket_page.h"
 
 namespace bustub {
 
@@ -29,20 +35,64 @@ namespace bustub {
 /**
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
- * table grows/shrinks dynamically as buckets become full/empty.
+ * table grows/shrinks dynamically as buckets become full/empty. Buckets are
+ * HashTableTaggedBucketPages, so a probe compares full keys only on slots
+ * whose hash tag matched.
+ *
+ * The directory spans as many directory pages as its global depth needs,
+ * listed in a header page (see HashTableDirectoryHeaderPage), so it can grow
+ * to DIRECTORY_ARRAY_SIZE * DIRECTORY_HEADER_ARRAY_SIZE entries. A lookup
+ * reads the header, one directory page and one bucket whatever the table's
+ * size.
+ *
+ * Concurrency: the header page latch guards the whole directory, directory
+ * pages themselves are never latched. Lookups, inserts and removes hold the
+ * header latch in shared mode for their whole run, and latch only the bucket
+ * they touch (shared for lookups, exclusive for updates). Operations on
+ * different buckets therefore run in parallel. Only a bucket split or merge,
+ * which rewrites the directory, takes the header latch exclusively; it
+ * excludes every other operation, so it needs no bucket latches.
+ *
+ * Removes never wait for the exclusive latch. A remove that leaves a bucket
+ * at most a quarter full queues it, and merges queued buckets with their
+ * split images only if the header latch is free at that moment; MergeBuckets
+ * merges whatever is still queued. Images merge while their pairs fit in
+ * half a bucket, the directory shrinks once no bucket needs its global depth,
+ * and the freed bucket and directory pages are deleted from the buffer pool,
+ * which hands their page ids out again.
+ *
+ * Lookups first ask in-memory Bloom filters of the buckets (see
+ * BucketBloomFilters), which answer most lookups of absent keys without
+ * reading a page.
+ *
+ * A key with more values than a bucket holds cannot be split apart. When a
+ * full bucket is at least half taken by pairs of the inserted key's 64-bit
+ * hash, those pairs move to a chain of overflow pages hung off the bucket
+ * instead of the bucket splitting, and later pairs of that hash join them.
+ * Inserts fill the newest overflow page and push a fresh one onto the front
+ * of the chain when it is full, and duplicates are ruled out by an in-memory
+ * Bloom filter over the chain's pairs, so an insert of a hot key touches two
+ * pages whatever the chain's length. The chain follows its
+ * hash when the bucket splits, an emptied overflow page is unlinked and
+ * freed, and a bucket with a chain is never merged.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
  public:
+  /** Default memory budget of the bucket Bloom filters, in bytes */
+  static constexpr size_t DEFAULT_BLOOM_FILTER_BUDGET = 1 << 20;
+
   /**
    * Creates a new ExtendibleHashTable.
    *
    * @param buffer_pool_manager buffer pool manager to be used
    * @param comparator comparator for keys
    * @param hash_fn the hash function
+   * @param bloom_filter_budget the most memory the bucket Bloom filters may take, 0 turns them off
    */
   explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
+                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                               size_t bloom_filter_budget = DEFAULT_BLOOM_FILTER_BUDGET);
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -74,6 +124,30 @@ class ExtendibleHashTable {
    */
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result);
 
+  /**
+   * Performs a point query for each of a batch of keys. The keys are hashed
+   * together with HashFunction::GetHashBatch and probed under one directory
+   * latch.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] result one vector per key holding the values associated with it
+   */
+  void GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                 std::vector<std::vector<ValueType>> *result);
+
+  /** @return the memory taken by the bucket Bloom filters and how well they answered lookups of absent keys */
+  BloomFilterStats GetBloomFilterStats() { return filters_.GetStats(); }
+
+  /**
+   * Merges every bucket queued for merging by Remove that still can, waiting
+   * for the directory latch. Removes merge queued buckets themselves only when
+   * the latch is free, so this catches up after a busy period.
+   *
+   * @return the number of bucket pages freed
+   */
+  size_t MergeBuckets();
+
   /**
    * Returns the global depth.  Do not touch.
    */
@@ -95,46 +169,152 @@ class ExtendibleHashTable {
   inline uint32_t Hash(KeyType key);
 
   /**
-   * KeyToDirectoryIndex - maps a key to a directory index
+   * Fetches the header page from the buffer pool manager.
+   *
+   * @return the pinned page holding the header, its latch guards the whole directory
+   */
+  Page *FetchHeaderPage();
+
+  /**
+   * Fetches the bucket that directory entry bucket_idx points at, reading the
+   * entry from its directory page on the way.
+   *
+   * @param header the hash table's header page, latched by the caller
+   * @param bucket_idx the directory index to follow
+   * @return the pinned page holding the bucket, its latch guards the bucket's slots; nullptr if the buffer pool
+   * cannot supply a page
+   */
+  Page *FetchBucketPage(HashTableDirectoryHeaderPage *header, uint32_t bucket_idx);
+
+  /**
+   * Reads one directory entry.
+   *
+   * @return false if the buffer pool cannot supply the directory page
+   */
+  bool GetDirectoryEntry(HashTableDirectoryHeaderPage *header, uint32_t bucket_idx, page_id_t *bucket_page_id,
+                         uint32_t *local_depth);
+
+  /**
+   * Calls fn on the directory entries first, first + step, ... below the
+   * directory size, fetching each directory page they live in once. fn gets
+   * the directory page, the entry's slot in it and the entry's index, and
+   * returns whether it changed the page.
+   *
+   * @return false if the buffer pool cannot supply a directory page
+   */
+  bool ForEachDirectoryEntry(HashTableDirectoryHeaderPage *header, uint32_t first, uint32_t step,
+                             const std::function<bool(HashTableDirectoryPage *, uint32_t, uint32_t)> &fn);
+
+  /**
+   * Doubles the directory: the new upper half mirrors the lower half, on
+   * new directory pages once the directory spans more than one.
+   *
+   * @return false if the buffer pool cannot supply the pages, the directory is left as it was
+   */
+  bool GrowDirectory(HashTableDirectoryHeaderPage *header);
+
+  /**
+   * Halves the directory while no bucket uses the global depth, freeing the
+   * directory pages of the upper half.
+   *
+   * @return whether the directory shrank
+   */
+  bool ShrinkDirectory(HashTableDirectoryHeaderPage *header);
+
+  /**
+   * Rebuilds the Bloom filter of a bucket from the keys it holds.
    *
-   * In Extendible Hashing we map a key to a directory index
-   * using the following hash + mask function.
+   * @param bucket_idx any directory index of the bucket
+   * @param local_depth the bucket's local depth
+   */
+  void RebuildFilter(HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, uint32_t bucket_idx, uint32_t local_depth);
+
+  /**
+   * Collects the values of key from the overflow chain of bucket, if the
+   * chain holds key's hash. The caller latches the bucket.
    *
-   * DirectoryIndex = Hash(key) & GLOBAL_DEPTH_MASK
+   * @param[out] found set if a value was collected
+   * @return false if the buffer pool cannot supply an overflow page
+   */
+  bool GetOverflowValues(HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, const KeyType &key, uint64_t full_hash,
+                         std::vector<ValueType> *result, bool *found);
+
+  /**
+   * Inserts a pair into the bucket, or into its overflow chain if the bucket
+   * is full and the pair's hash is the chain's. The caller latches the bucket
+   * exclusively.
    *
-   * where GLOBAL_DEPTH_MASK is a mask with exactly GLOBAL_DEPTH 1's from LSB
-   * upwards.  For example, global depth 3 corresponds to 0x00000007 in a 32-bit
-   * representation.
+   * @param may_start_chain start a chain for a full bucket holding at least MIN_OVERFLOW_PAIRS pairs of the key's
+   * hash, only done with the header latched exclusively
+   * @param[out] inserted set if the pair went in
+   * @param[out] needs_split set if the bucket is full and the pair has no chain to go to
+   * @return false if the buffer pool cannot supply an overflow page
+   */
+  bool InsertIntoBucket(Page *bucket_page, const KeyType &key, const ValueType &value, uint64_t full_hash,
+                        bool may_start_chain, bool *inserted, bool *needs_split);
+
+  /**
+   * Checks whether the overflow chain of a bucket holds a pair, consulting
+   * the chain's pair filter first and rebuilding the filter whenever the
+   * chain has outgrown it.
    *
-   * @param key the key to use for lookup
-   * @param dir_page to use for lookup of global depth
-   * @return the directory index
+   * @return false if the buffer pool cannot supply an overflow page
    */
-  inline uint32_t KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page);
+  bool OverflowContains(page_id_t bucket_page_id, HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, const KeyType &key,
+                        const ValueType &value, uint64_t full_hash, bool *contains);
 
   /**
-   * Get the bucket page_id corresponding to a key.
+   * Adds a pair known to be absent to the overflow chain of bucket, starting
+   * the chain if there is none.
    *
-   * @param key the key for lookup
-   * @param dir_page a pointer to the hash table's directory page
-   * @return the bucket page_id corresponding to the input key
+   * @return false if the buffer pool cannot supply an overflow page
    */
-  inline uint32_t KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page);
+  bool AppendOverflow(page_id_t bucket_page_id, HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, const KeyType &key,
+                      const ValueType &value, uint64_t full_hash);
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Removes a pair from the overflow chain of bucket, unlinking and freeing
+   * the overflow page it leaves empty.
    *
-   * @return a pointer to the directory page
+   * @param[out] removed set if the pair was found
+   * @return false if the buffer pool cannot supply an overflow page
    */
-  HashTableDirectoryPage *FetchDirectoryPage();
+  bool RemoveOverflow(page_id_t bucket_page_id, HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, const KeyType &key,
+                      const ValueType &value, uint64_t full_hash, bool *removed);
+
+  /** @return the number of pairs in the bucket with the 64-bit key hash full_hash */
+  uint32_t CountHash(HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, uint64_t full_hash);
 
   /**
-   * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
+   * Moves the pairs of hash full_hash from a full bucket without a chain to
+   * a new overflow page, which starts the bucket's chain.
    *
-   * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
+   * @return false if the buffer pool cannot supply the page, the bucket is left as it was
    */
-  HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
+  bool StartOverflow(HASH_TABLE_TAGGED_BUCKET_TYPE *bucket, uint64_t full_hash);
+
+  /** @return the hash of a pair in an overflow chain's pair filter */
+  static uint32_t PairHash(uint64_t full_hash, const ValueType &value) {
+    return static_cast<uint32_t>(HashUtil::CombineHashes(full_hash, HashUtil::Hash(&value)));
+  }
+
+  /**
+   * Unlatches and unpins the header page, then reports that the buffer pool
+   * could not supply a page.
+   */
+  [[noreturn]] void ThrowOutOfMemory(Page *header_page, bool exclusive, bool is_dirty, const std::string &message);
+
+  static HashTableDirectoryHeaderPage *AsHeaderPage(Page *page) {
+    return reinterpret_cast<HashTableDirectoryHeaderPage *>(page->GetData());
+  }
+
+  static HashTableDirectoryPage *AsDirectoryPage(Page *page) {
+    return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  }
+
+  static HASH_TABLE_TAGGED_BUCKET_TYPE *AsBucketPage(Page *page) {
+    return reinterpret_cast<HASH_TABLE_TAGGED_BUCKET_TYPE *>(page->GetData());
+  }
 
   /**
    * Performs insertion with an optional bucket splitting.
@@ -147,28 +327,85 @@ class ExtendibleHashTable {
   bool SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value);
 
   /**
-   * Optionally merges an empty bucket into it's pair.  This is called by Remove,
-   * if Remove makes a bucket empty.
+   * Queues a bucket that a remove left underfull for merging with its split
+   * image. hash is the hash of a key that was in the bucket, which finds the
+   * bucket again however the directory has changed meanwhile.
+   */
+  void QueueMerge(page_id_t bucket_page_id, uint32_t hash);
+
+  /**
+   * Runs queued merges if the directory latch is free right now, so that a
+   * remove never waits behind other operations to merge.
+   */
+  void TryMergeQueued();
+
+  /**
+   * Merges queued buckets, cascading each merged bucket into its own split
+   * image while they fit together. The caller holds the header latch
+   * exclusively.
    *
-   * There are three conditions under which we skip the merge:
-   * 1. The bucket is no longer empty.
-   * 2. The bucket has local depth 0.
-   * 3. The bucket's local depth doesn't match its split image's local depth.
+   * @param max_buckets how many queued buckets to take off the queue
+   * @param[out] header_dirty set if the directory shrank
+   * @return the number of bucket pages freed
+   */
+  size_t RunQueuedMerges(HashTableDirectoryHeaderPage *header, size_t max_buckets, bool *header_dirty);
+
+  /**
+   * Folds the bucket at bucket_idx and its split image into one bucket,
+   * freeing the page of the emptier one. Skipped if the bucket has local
+   * depth 0, if its image has another local depth, if either has an
+   * overflow chain, or if their pairs would fill more than MERGE_MAX_SIZE
+   * slots. The caller holds the header latch exclusively.
    *
-   * @param transaction a pointer to the current transaction
-   * @param key the key that was removed
-   * @param value the value that was removed
+   * @param[out] header_dirty set if the directory shrank
+   * @return whether the buckets merged
    */
-  void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
+  bool MergeBucket(HashTableDirectoryHeaderPage *header, uint32_t bucket_idx, bool *header_dirty);
+
+  /** A remove that leaves a bucket with at most this many pairs queues it for merging */
+  static constexpr uint32_t MERGE_CANDIDATE_SIZE = TAGGED_BUCKET_ARRAY_SIZE / 4;
+  /** Split images merge if their pairs fill at most this many slots together, half a bucket */
+  static constexpr uint32_t MERGE_MAX_SIZE = TAGGED_BUCKET_ARRAY_SIZE / 2;
+  /** Queued buckets a remove merges when it finds the directory latch free */
+  static constexpr size_t MERGES_PER_REMOVE = 4;
+  /** A full bucket with this many pairs of the inserted key's hash moves them to an overflow chain */
+  static constexpr uint32_t MIN_OVERFLOW_PAIRS = TAGGED_BUCKET_ARRAY_SIZE / 2;
+  /**
+   * Filter bits per pair of a chain's pair filter. A false positive walks the
+   * whole chain, so the filter gets more bits than the bucket filters.
+   */
+  static constexpr size_t OVERFLOW_FILTER_BITS_PER_PAIR = 16;
+  /** Pairs a chain's pair filter is first sized for; it doubles whenever the chain outgrows it */
+  static constexpr size_t MIN_OVERFLOW_FILTER_PAIRS = 1024;
+
+  /** Bloom filter over the pairs of one overflow chain, rebuilt from the chain when it is lost or outgrown */
+  struct OverflowFilter {
+    std::unique_ptr<BlockedBloomFilter> filter_;
+    /** Pairs the filter was sized for */
+    size_t capacity_;
+    /** Pairs added since it was built, removes are not counted */
+    size_t size_;
+  };
 
   // member variables
-  page_id_t directory_page_id_;
+  page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
-  ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
+  BucketBloomFilters filters_;
+
+  /** Buckets queued for merging, each with the hash of a key that was in it */
+  std::mutex merge_queue_latch_;
+  std::unordered_map<page_id_t, uint32_t> merge_queue_;
+
+  /**
+   * Pair filters of the overflow chains, keyed by the page id of the bucket
+   * heading the chain. The latch guards the map; a filter itself is guarded
+   * by its bucket's latch.
+   */
+  std::mutex overflow_filters_latch_;
+  std::unordered_map<page_id_t, OverflowFilter> overflow_filters_;
 };
 
 }  // namespace bustub
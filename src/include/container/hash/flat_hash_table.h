@@ -0,0 +1,278 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// flat_hash_table.h
+//
+// Identification: src/include/container/hash/flat_hash_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/arena.h"
+#include "common/macros.h"
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * Default hash of FlatHashTable. Integers go through HashUtil, since their
+ * std::hash is the identity and the table needs every bit of the hash mixed;
+ * other keys use std::hash.
+ */
+template <typename KeyType>
+struct FlatHash {
+  hash_t operator()(const KeyType &key) const {
+    if constexpr (std::is_integral<KeyType>::value) {
+      return HashUtil::HashInt(static_cast<uint64_t>(key));
+    } else {
+      return std::hash<KeyType>()(key);
+    }
+  }
+};
+
+/**
+ * In-memory open-addressing hash table from unique keys to values, for
+ * executor state such as join and aggregation hash tables.
+ *
+ * The slot array is flat: a slot is the key's hash and a pointer to its
+ * entry, 16 bytes, and a probe walks consecutive slots from the one the low
+ * bits of the hash pick, comparing the stored hashes before touching any
+ * key. Entries (a key next to its value) are allocated from an Arena in
+ * insertion order, so growing the table only rewrites the slot array, and a
+ * pointer to a value stays valid until the table is cleared or destroyed.
+ * The table doubles once it is MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR
+ * full. Keys are never removed.
+ *
+ * Callers pass the key's hash to every operation, so that they can hash a
+ * batch of keys at once or reuse a hash they already have; Hash computes it
+ * with the table's hash function. The hash must be well mixed in all its
+ * bits.
+ *
+ * Not thread-safe; see PartitionedFlatHashTable for parallel builds.
+ */
+template <typename KeyType, typename ValueType, typename KeyHash = FlatHash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class FlatHashTable {
+  struct Entry {
+    template <typename... Args>
+    explicit Entry(const KeyType &key, Args &&... args) : key_(key), value_(std::forward<Args>(args)...) {}
+
+    KeyType key_;
+    ValueType value_;
+  };
+
+  struct Slot {
+    hash_t hash_;
+    /** nullptr for an empty slot */
+    Entry *entry_;
+  };
+
+ public:
+  /** The table doubles when an insert would make it fuller than this fraction */
+  static constexpr size_t MAX_LOAD_NUMERATOR = 3;
+  static constexpr size_t MAX_LOAD_DENOMINATOR = 4;
+  /** Slots of the smallest table */
+  static constexpr size_t MIN_CAPACITY = 16;
+
+  /** Visits the entries in slot order */
+  class Iterator {
+   public:
+    const KeyType &Key() const { return slot_->entry_->key_; }
+
+    ValueType &Value() const { return slot_->entry_->value_; }
+
+    /** @return the key's hash, as it was inserted */
+    hash_t Hash() const { return slot_->hash_; }
+
+    Iterator &operator++() {
+      ++slot_;
+      SkipEmpty();
+      return *this;
+    }
+
+    bool operator==(const Iterator &other) const { return slot_ == other.slot_; }
+
+    bool operator!=(const Iterator &other) const { return slot_ != other.slot_; }
+
+   private:
+    friend class FlatHashTable;
+
+    Iterator(const Slot *slot, const Slot *end) : slot_(slot), end_(end) { SkipEmpty(); }
+
+    void SkipEmpty() {
+      while (slot_ != end_ && slot_->entry_ == nullptr) {
+        ++slot_;
+      }
+    }
+
+    const Slot *slot_;
+    const Slot *end_;
+  };
+
+  /**
+   * @param expected_size number of keys to make room for up front
+   */
+  explicit FlatHashTable(size_t expected_size = 0, const KeyHash &hash_fn = KeyHash(),
+                         const KeyEqual &key_equal = KeyEqual())
+      : hash_fn_(hash_fn), key_equal_(key_equal) {
+    slots_.resize(CapacityFor(expected_size), Slot{0, nullptr});
+  }
+
+  DISALLOW_COPY(FlatHashTable);
+
+  FlatHashTable(FlatHashTable &&other) noexcept
+      : hash_fn_(std::move(other.hash_fn_)),
+        key_equal_(std::move(other.key_equal_)),
+        slots_(std::move(other.slots_)),
+        arena_(std::move(other.arena_)),
+        size_(other.size_) {
+    other.slots_ = std::vector<Slot>(MIN_CAPACITY, Slot{0, nullptr});
+    other.size_ = 0;
+  }
+
+  FlatHashTable &operator=(FlatHashTable &&other) noexcept {
+    if (this != &other) {
+      DestroyEntries();
+      hash_fn_ = std::move(other.hash_fn_);
+      key_equal_ = std::move(other.key_equal_);
+      slots_ = std::move(other.slots_);
+      arena_ = std::move(other.arena_);
+      size_ = other.size_;
+      other.slots_ = std::vector<Slot>(MIN_CAPACITY, Slot{0, nullptr});
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  ~FlatHashTable() { DestroyEntries(); }
+
+  /** @return the hash of key under the table's hash function */
+  hash_t Hash(const KeyType &key) const { return hash_fn_(key); }
+
+  /**
+   * Finds the value of key, inserting a value constructed from args if the
+   * key is absent.
+   *
+   * @param hash the key's hash, as Hash would compute it
+   * @return the key's value, and whether it was inserted
+   */
+  template <typename... Args>
+  std::pair<ValueType *, bool> FindOrInsert(const KeyType &key, hash_t hash, Args &&... args) {
+    if ((size_ + 1) * MAX_LOAD_DENOMINATOR > slots_.size() * MAX_LOAD_NUMERATOR) {
+      Rehash(slots_.size() * 2);
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+      Slot &slot = slots_[idx];
+      if (slot.entry_ == nullptr) {
+        void *memory = arena_.Allocate(sizeof(Entry), alignof(Entry));
+        slot.hash_ = hash;
+        slot.entry_ = new (memory) Entry(key, std::forward<Args>(args)...);
+        size_++;
+        return {&slot.entry_->value_, true};
+      }
+      if (slot.hash_ == hash && key_equal_(slot.entry_->key_, key)) {
+        return {&slot.entry_->value_, false};
+      }
+    }
+  }
+
+  /**
+   * @param hash the key's hash, as Hash would compute it
+   * @return the key's value, nullptr if the key is absent
+   */
+  ValueType *Find(const KeyType &key, hash_t hash) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+      const Slot &slot = slots_[idx];
+      if (slot.entry_ == nullptr) {
+        return nullptr;
+      }
+      if (slot.hash_ == hash && key_equal_(slot.entry_->key_, key)) {
+        return &slot.entry_->value_;
+      }
+    }
+  }
+
+  /** Grows the slot array now so that expected_size keys fit without another rehash */
+  void Reserve(size_t expected_size) {
+    const size_t capacity = CapacityFor(expected_size);
+    if (capacity > slots_.size()) {
+      Rehash(capacity);
+    }
+  }
+
+  /** Removes every entry and gives back the memory of their arena */
+  void Clear() {
+    DestroyEntries();
+    slots_ = std::vector<Slot>(MIN_CAPACITY, Slot{0, nullptr});
+    arena_.Reset();
+    size_ = 0;
+  }
+
+  size_t Size() const { return size_; }
+
+  bool Empty() const { return size_ == 0; }
+
+  /** @return the bytes held by the slot array and the entries */
+  size_t MemoryUsage() const { return slots_.size() * sizeof(Slot) + arena_.MemoryUsage(); }
+
+  Iterator Begin() const { return Iterator(slots_.data(), slots_.data() + slots_.size()); }
+
+  Iterator End() const { return Iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size()); }
+
+ private:
+  /** @return the smallest power of two number of slots holding expected_size keys under the maximum load */
+  static size_t CapacityFor(size_t expected_size) {
+    size_t capacity = MIN_CAPACITY;
+    while (expected_size * MAX_LOAD_DENOMINATOR > capacity * MAX_LOAD_NUMERATOR) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  /** Moves the slots to a slot array of capacity slots, placing them by their stored hashes */
+  void Rehash(size_t capacity) {
+    std::vector<Slot> slots(capacity, Slot{0, nullptr});
+    const size_t mask = capacity - 1;
+    for (const Slot &slot : slots_) {
+      if (slot.entry_ != nullptr) {
+        size_t idx = slot.hash_ & mask;
+        while (slots[idx].entry_ != nullptr) {
+          idx = (idx + 1) & mask;
+        }
+        slots[idx] = slot;
+      }
+    }
+    slots_ = std::move(slots);
+  }
+
+  void DestroyEntries() {
+    if constexpr (!std::is_trivially_destructible<Entry>::value) {
+      for (const Slot &slot : slots_) {
+        if (slot.entry_ != nullptr) {
+          slot.entry_->~Entry();
+        }
+      }
+    }
+  }
+
+  KeyHash hash_fn_;
+  KeyEqual key_equal_;
+  std::vector<Slot> slots_;
+  Arena arena_;
+  size_t size_{0};
+};
+
+}  // namespace bustub
@@ -13,11 +13,19 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
-#include "murmur3/MurmurHash3.h"
+#include "common/util/hash_util.h"
 
 namespace bustub {
 
+/**
+ * Hashes index keys with HashUtil. A key that fits in a machine word, such as
+ * an int or a GenericKey<4> or <8>, is hashed as one integer with
+ * HashUtil::HashInt; wider keys are hashed eight bytes at a time with
+ * HashUtil::HashBytes.
+ */
 template <typename KeyType>
 class HashFunction {
  public:
@@ -26,10 +34,27 @@ class HashFunction {
    * @return the hashed value
    */
   virtual uint64_t GetHash(KeyType key) {
-    uint64_t hash[2];
-    murmur3::MurmurHash3_x64_128(reinterpret_cast<const void *>(&key), static_cast<int>(sizeof(KeyType)), 0,
-                                 reinterpret_cast<void *>(&hash));
-    return hash[0];
+    if constexpr (std::is_integral<KeyType>::value) {
+      return HashUtil::HashInt(static_cast<uint64_t>(key));
+    } else if constexpr (sizeof(KeyType) <= sizeof(uint64_t)) {
+      uint64_t word = 0;
+      memcpy(&word, &key, sizeof(KeyType));
+      return HashUtil::HashInt(word);
+    } else {
+      return HashUtil::HashBytes(reinterpret_cast<const char *>(&key), sizeof(KeyType));
+    }
+  }
+
+  /**
+   * Hash a batch of keys, the same as calling GetHash on each of them.
+   * @param keys the keys to be hashed
+   * @param n the number of keys
+   * @param[out] out the n hashed values
+   */
+  virtual void GetHashBatch(const KeyType *keys, size_t n, uint64_t *out) {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = GetHash(keys[i]);
+    }
   }
 };
 
@@ -12,11 +12,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
 #include "container/hash/hash_table.h"
@@ -26,12 +29,28 @@
 
 namespace bustub {
 
-#define HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
+#define LINEAR_PROBE_HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
 
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * The slots live in block pages listed by a header page. Removing a pair
+ * leaves a tombstone, so once three quarters of the slots are occupied the
+ * table is rebuilt into a new block array: twice as large if most occupied
+ * slots hold live pairs, the same size otherwise. The rebuild is incremental:
+ * the old and the new block arrays stay alive together, and every insert or
+ * remove first migrates the next migrate_slots_per_op slots of the old array
+ * into the new one. Lookups probe the old array before the new one, a pair
+ * being moved is added to the new array before it leaves the old, so no
+ * lookup misses it. The old array is freed once its last slot has moved.
+ * Block pages of the new array are allocated on first use.
+ *
+ * Concurrency: lookups run in parallel, latching one block page at a time.
+ * Inserts and removes, and with them the migration, are serialized with one
+ * another. Swapping in a new block array and freeing the old one take the
+ * table latch exclusively.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
@@ -43,9 +62,11 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    * @param comparator comparator for keys
    * @param num_buckets initial number of buckets contained by this hash table
    * @param hash_fn the hash function
+   * @param migrate_slots_per_op how many slots of the old block array each insert or remove migrates during a resize
    */
   explicit LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn);
+                                const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn,
+                                size_t migrate_slots_per_op = DEFAULT_MIGRATE_SLOTS_PER_OP);
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -75,7 +96,9 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Resizes the table to at least twice the initial size provided. Finishes
+   * a resize in progress first, the new one then proceeds with later inserts
+   * and removes.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
@@ -86,14 +109,94 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    */
   size_t GetSize();
 
+  /** @return true while pairs are still being migrated out of an old block array */
+  bool IsResizing();
+
+  static constexpr size_t DEFAULT_MIGRATE_SLOTS_PER_OP = 4;
+
  private:
+  /** A header page and the block pages it lists, cached in memory */
+  struct BlockArray {
+    page_id_t header_page_id_{INVALID_PAGE_ID};
+    size_t num_slots_{0};
+    // INVALID_PAGE_ID for a block not allocated yet, which reads as all empty
+    std::vector<std::atomic<page_id_t>> block_page_ids_;
+  };
+
+  uint32_t Hash(const KeyType &key) { return static_cast<uint32_t>(hash_fn_.GetHash(key)); }
+
+  /** Allocate the header of a block array with room for num_buckets slots, its blocks come on first use */
+  void NewBlockArray(BlockArray *blocks, size_t num_buckets);
+
+  /** Delete the pages of a block array, nothing may use it any more */
+  void DeleteBlockArray(BlockArray *blocks);
+
+  /**
+   * Fetch a block page of a block array.
+   * @param create allocate the block if it does not exist yet, otherwise return nullptr for it
+   */
+  Page *FetchBlock(BlockArray *blocks, size_t block_idx, bool create);
+
+  /**
+   * Visit the slots of the probe sequence of hash in order, latching their
+   * block pages shared or exclusive, until visit returns true, a slot that
+   * was never occupied has been visited, or every slot has been.
+   * @param create allocate the blocks the probe reaches, otherwise an unallocated block ends it
+   */
+  template <typename Visitor>
+  void Probe(BlockArray *blocks, uint32_t hash, bool exclusive, bool create, Visitor &&visit);
+
+  /**
+   * Append the values of key in blocks to result, skipping the ones result already holds from index first on: a
+   * lookup racing with the migration may meet a pair in both block arrays.
+   */
+  void CollectValues(BlockArray *blocks, const KeyType &key, uint32_t hash, size_t first,
+                     std::vector<ValueType> *result);
+
+  bool Contains(BlockArray *blocks, const KeyType &key, const ValueType &value, uint32_t hash);
+
+  /** @return true if inserted, false if the pair is present (when checked) or blocks has no free slot */
+  bool InsertInto(BlockArray *blocks, const KeyType &key, const ValueType &value, uint32_t hash,
+                  bool check_duplicate);
+
+  bool RemoveFrom(BlockArray *blocks, const KeyType &key, const ValueType &value, uint32_t hash);
+
+  /** Move up to max_slots slots of old_blocks_ into blocks_, the caller holds write_latch_ and the table latch */
+  void MigrateSlots(size_t max_slots);
+
+  /**
+   * After an insert or remove: free the old block array once migrated, and
+   * start a resize once too many slots are occupied. The caller holds
+   * write_latch_ but not the table latch.
+   */
+  void MaintainBlockArrays();
+
+  /** Start migrating into a new block array of num_buckets slots, the caller holds write_latch_ */
+  void StartResize(size_t num_buckets);
+
+  /** Free the old block array if its last slot has been migrated, the caller holds write_latch_ */
+  void FinishResize();
+
   // member variable
   page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writer is only resize
+  // Readers include inserts and removes, writers only swap block arrays
   ReaderWriterLatch table_latch_;
+  // Serializes inserts, removes and with them the migration
+  std::mutex write_latch_;
+
+  // the block array every insert goes to, and the one being migrated out of during a resize
+  BlockArray blocks_;
+  BlockArray old_blocks_;
+  // next slot of old_blocks_ to migrate
+  size_t migrate_cursor_{0};
+  size_t migrate_slots_per_op_;
+  // occupied slots of blocks_, tombstones included
+  size_t num_occupied_{0};
+  // live pairs in both block arrays
+  size_t num_pairs_{0};
 
   // Hash function
   HashFunction<KeyType> hash_fn_;
@@ -0,0 +1,206 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// partitioned_flat_hash_table.h
+//
+// Identification: src/include/container/hash/partitioned_flat_hash_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "container/hash/flat_hash_table.h"
+
+namespace bustub {
+
+/**
+ * FlatHashTable split into partitions by ranges of the key hash, built by
+ * several threads at once without any locking.
+ *
+ * A build runs in two phases. First each thread inserts through its own
+ * Builder, which keeps one private FlatHashTable per partition, so inserts
+ * share nothing and values can be updated in place (pre-aggregated) as in a
+ * plain FlatHashTable. Then Merge folds the builders' tables of each
+ * partition into one, calling a combine function for keys that more than
+ * one builder saw; partitions are independent, so they merge in parallel.
+ * Afterwards Find looks up the partition of the hash's top bits, and the
+ * partition's table probes from its low bits.
+ *
+ * Concurrency: each Builder is used by one thread at a time, and different
+ * builders may insert concurrently. MergePartition may run concurrently for
+ * different partitions once every builder is done. Find is read-only and may
+ * run concurrently once every partition is merged.
+ */
+template <typename KeyType, typename ValueType, typename KeyHash = FlatHash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class PartitionedFlatHashTable {
+ public:
+  using Table = FlatHashTable<KeyType, ValueType, KeyHash, KeyEqual>;
+
+  /** Thread-private inserts into every partition */
+  class Builder {
+   public:
+    /** Same as FlatHashTable::FindOrInsert, seeing only this builder's keys */
+    template <typename... Args>
+    std::pair<ValueType *, bool> FindOrInsert(const KeyType &key, hash_t hash, Args &&... args) {
+      return tables_[owner_->PartitionOf(hash)].FindOrInsert(key, hash, std::forward<Args>(args)...);
+    }
+
+    /** @return the hash of key under the table's hash function */
+    hash_t Hash(const KeyType &key) const { return owner_->Hash(key); }
+
+   private:
+    friend class PartitionedFlatHashTable;
+
+    explicit Builder(const PartitionedFlatHashTable *owner) : owner_(owner) {
+      for (size_t i = 0; i < owner->NumPartitions(); i++) {
+        tables_.emplace_back(0, owner->hash_fn_, owner->key_equal_);
+      }
+    }
+
+    const PartitionedFlatHashTable *owner_;
+    std::vector<Table> tables_;
+  };
+
+  /**
+   * @param num_partitions number of partitions, rounded up to a power of two
+   * @param num_builders number of threads that will insert at once
+   */
+  PartitionedFlatHashTable(size_t num_partitions, size_t num_builders, const KeyHash &hash_fn = KeyHash(),
+                           const KeyEqual &key_equal = KeyEqual())
+      : hash_fn_(hash_fn), key_equal_(key_equal) {
+    while ((size_t{1} << partition_bits_) < num_partitions) {
+      partition_bits_++;
+    }
+    for (size_t i = 0; i < NumPartitions(); i++) {
+      partitions_.emplace_back(0, hash_fn_, key_equal_);
+    }
+    builders_.reserve(num_builders);
+    for (size_t i = 0; i < num_builders; i++) {
+      builders_.push_back(Builder(this));
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(PartitionedFlatHashTable);
+
+  ~PartitionedFlatHashTable() = default;
+
+  /** @return the builder the builder_idx-th inserting thread uses */
+  Builder *GetBuilder(size_t builder_idx) { return &builders_[builder_idx]; }
+
+  /** @return the hash of key under the table's hash function */
+  hash_t Hash(const KeyType &key) const { return hash_fn_(key); }
+
+  /** @return the partition of the keys with this hash */
+  size_t PartitionOf(hash_t hash) const {
+    return partition_bits_ == 0 ? 0 : static_cast<size_t>(hash >> (sizeof(hash_t) * 8 - partition_bits_));
+  }
+
+  size_t NumPartitions() const { return size_t{1} << partition_bits_; }
+
+  /**
+   * Folds the builders' tables of one partition into the partition's table,
+   * reusing the largest as it is, and frees the others.
+   *
+   * @param combine called as combine(ValueType *into, ValueType *from) when two builders saw one key
+   */
+  template <typename Combine>
+  void MergePartition(size_t partition, Combine combine) {
+    size_t largest = 0;
+    for (size_t i = 1; i < builders_.size(); i++) {
+      if (builders_[i].tables_[partition].Size() > builders_[largest].tables_[partition].Size()) {
+        largest = i;
+      }
+    }
+    Table &table = partitions_[partition];
+    if (!builders_.empty()) {
+      table = std::move(builders_[largest].tables_[partition]);
+    }
+    for (size_t i = 0; i < builders_.size(); i++) {
+      Table &from = builders_[i].tables_[partition];
+      for (auto it = from.Begin(); it != from.End(); ++it) {
+        auto [value, inserted] = table.FindOrInsert(it.Key(), it.Hash(), std::move(it.Value()));
+        if (!inserted) {
+          combine(value, &it.Value());
+        }
+      }
+      from.Clear();
+    }
+  }
+
+  /**
+   * Merges every partition, on num_threads threads taking partitions in turn.
+   *
+   * @param combine as for MergePartition
+   */
+  template <typename Combine>
+  void Merge(Combine combine, size_t num_threads = 1) {
+    std::atomic<size_t> next_partition{0};
+    auto work = [&] {
+      for (size_t p = next_partition++; p < NumPartitions(); p = next_partition++) {
+        MergePartition(p, combine);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++) {
+      threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  /**
+   * @param hash the key's hash, as Hash would compute it
+   * @return the key's value in the merged table, nullptr if the key is absent
+   */
+  ValueType *Find(const KeyType &key, hash_t hash) const { return partitions_[PartitionOf(hash)].Find(key, hash); }
+
+  /** @return the merged table of one partition */
+  Table *GetPartition(size_t partition) { return &partitions_[partition]; }
+
+  /** @return the number of keys in the merged partitions */
+  size_t Size() const {
+    size_t size = 0;
+    for (const Table &table : partitions_) {
+      size += table.Size();
+    }
+    return size;
+  }
+
+  /** @return the bytes held by the builders and the merged partitions */
+  size_t MemoryUsage() const {
+    size_t bytes = 0;
+    for (const Table &table : partitions_) {
+      bytes += table.MemoryUsage();
+    }
+    for (const Builder &builder : builders_) {
+      for (const Table &table : builder.tables_) {
+        bytes += table.MemoryUsage();
+      }
+    }
+    return bytes;
+  }
+
+ private:
+  KeyHash hash_fn_;
+  KeyEqual key_equal_;
+  size_t partition_bits_{0};
+  std::vector<Table> partitions_;
+  std::vector<Builder> builders_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,222 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_hash_table.h
+//
+// Identification: src/include/execution/aggregation_hash_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/arena.h"
+#include "common/macros.h"
+#include "container/hash/flat_hash_table.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/tuple_batch.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * AggregationHashTable holds the groups of an aggregation in typed slots
+ * instead of vectors of Values.
+ *
+ * A group is a row of 8-byte words allocated from an Arena: its packed key,
+ * one word per group-by value plus a word of NULL flags, followed by two
+ * accumulator words per aggregate. Integer keys are sign-extended, DECIMAL
+ * keys are their bits and VARCHAR keys are ids in a dictionary of the strings
+ * seen, so every key has the same width and two keys are equal if their
+ * words are. The rows are found through an open-addressing table of slots,
+ * a slot being the hash of the key and the row, probed linearly.
+ *
+ * An aggregate keeps the number of non-NULL inputs and an accumulator typed
+ * by its input: an int64 for integer types, a double for DECIMAL, a string id
+ * for VARCHAR. COUNT counts every input row, SUM, MIN and MAX skip NULLs and
+ * are NULL for a group without any input that is not, and AVG is SUM over
+ * the inputs counted, as a DECIMAL. SUM of an integer type narrower than
+ * BIGINT is reported as an INTEGER.
+ *
+ * InsertBatch() works a column at a time: it packs and hashes the keys of
+ * all rows of a batch, looks up their groups, then evaluates one aggregate
+ * over the batch and folds it into the groups in a loop specialized for its
+ * type, without dispatching through a Type per value.
+ *
+ * To spill, GetPartial() turns a group into a tuple of PartialSchema(): its
+ * group-bys and, per aggregate, the inputs counted and the accumulator. Any
+ * table of the same plan folds such tuples back in with MergePartials(), and
+ * PartitionHash() spreads the groups over partitions the same way in every
+ * table, hashing VARCHAR keys by their strings rather than by their ids.
+ */
+class AggregationHashTable {
+ public:
+  /**
+   * Construct a new, empty AggregationHashTable instance. Throws MISMATCH_TYPE for a SUM or AVG over a
+   * non-numeric type.
+   * @param plan the aggregation plan, which must outlive the table
+   */
+  explicit AggregationHashTable(const AggregationPlanNode *plan);
+
+  DISALLOW_COPY_AND_MOVE(AggregationHashTable);
+
+  /**
+   * Aggregate the selected tuples of a batch.
+   * @param batch the tuples
+   * @param schema the schema of the tuples, which the plan's expressions are evaluated over
+   */
+  void InsertBatch(const TupleBatch &batch, const Schema *schema);
+
+  /** @return the number of groups */
+  size_t Size() const { return groups_.size(); }
+
+  /** Remove all groups */
+  void Clear();
+
+  /**
+   * Unpack a group, the groups being numbered in the order they were first seen.
+   * @param group the number of the group, below Size()
+   * @param[out] group_bys the group-by values of the group
+   * @param[out] aggregates the aggregate values of the group
+   */
+  void GetGroup(size_t group, std::vector<Value> *group_bys, std::vector<Value> *aggregates) const;
+
+  /** @return the bytes of memory the groups, their slots and the dictionary take */
+  size_t MemoryUsage() const;
+
+  /**
+   * @return the schema of partial aggregates: the group-bys, then per aggregate a BIGINT count of its inputs and,
+   * but for COUNT, its accumulator
+   */
+  const Schema *PartialSchema() const { return partial_schema_.get(); }
+
+  /** @return a group as a tuple of PartialSchema() */
+  Tuple GetPartial(size_t group) const;
+
+  /** @return a hash of the group-bys of a group that, unlike the one the table finds it by, is alike in every table */
+  hash_t PartitionHash(size_t group) const;
+
+  /**
+   * Fold partial aggregates into the groups.
+   * @param partials tuples of PartialSchema(), as GetPartial() of a table of the same plan made them
+   */
+  void MergePartials(const std::vector<Tuple> &partials);
+
+ private:
+  /** The accumulator of an aggregate, by aggregation type and the representation of its input */
+  enum class AccumulatorKind {
+    Count,
+    SumInt,
+    SumDouble,
+    AvgInt,
+    AvgDouble,
+    MinInt,
+    MaxInt,
+    MinDouble,
+    MaxDouble,
+    MinString,
+    MaxString
+  };
+
+  /** A slot of the lookup table, the hash of a key and its group, nullptr if the slot is empty */
+  struct Slot {
+    hash_t hash_;
+    uint64_t *group_;
+  };
+
+  /** The most a table is filled before its slots double, as a fraction */
+  static constexpr size_t MAX_LOAD_NUMERATOR = 3;
+  static constexpr size_t MAX_LOAD_DENOMINATOR = 4;
+  /** The slots of an empty table */
+  static constexpr size_t MIN_CAPACITY = 64;
+
+  static uint64_t FromDouble(double value) {
+    uint64_t word;
+    memcpy(&word, &value, sizeof(word));
+    return word;
+  }
+
+  static double ToDouble(uint64_t word) {
+    double value;
+    memcpy(&value, &word, sizeof(value));
+    return value;
+  }
+
+  /** @return the type of the accumulator of an aggregate in a partial aggregate */
+  TypeId AccumulatorType(size_t agg) const;
+
+  /** @return the word of a value that is not NULL, as a key or an accumulator input */
+  uint64_t ToWord(const Value &value, TypeId type);
+
+  /** @return the value of a word of a given type, as ToWord() made it */
+  Value FromWord(uint64_t word, TypeId type) const;
+
+  /** @return the id of a string in the dictionary, added if it is new */
+  uint64_t Intern(std::string_view str);
+
+  /** Pack one group-by value into a key */
+  void PackKey(size_t group_by, const Value &value, uint64_t *key);
+
+  /** Unpack the group-by values of a group */
+  void UnpackKey(const uint64_t *group, std::vector<Value> *group_bys) const;
+
+  /** Hash the first num_rows packed keys and look up their groups */
+  void FindGroups(size_t num_rows);
+
+  /** @return the group of a packed key, added with zeroed accumulators if it is new */
+  uint64_t *FindOrInsert(const uint64_t *key, hash_t hash);
+
+  /** Double the slots */
+  void Grow();
+
+  /** Fold the values of one aggregate over the rows of a batch into their groups */
+  void Accumulate(size_t agg, size_t offset, size_t num_rows);
+
+  /** Fold each non-NULL value of an aggregate into the accumulator at offset of its group, and count it */
+  template <AccumulatorKind Kind>
+  void FoldInputs(size_t agg, size_t offset, size_t num_rows);
+
+  /** Fold one input, or the accumulator of a partial aggregate, into an accumulator, before it is counted */
+  template <AccumulatorKind Kind>
+  void Combine(uint64_t *acc, uint64_t word) const;
+
+  /** Combine() for a kind known only at run time */
+  void Combine(AccumulatorKind kind, uint64_t *acc, uint64_t word) const;
+
+  const AggregationPlanNode *plan_;
+  /** The type of each group-by and of each aggregate's input */
+  std::vector<TypeId> key_types_;
+  std::vector<TypeId> input_types_;
+  std::vector<AccumulatorKind> kinds_;
+  std::unique_ptr<Schema> partial_schema_;
+  /** The words of a packed key, and of a whole group */
+  size_t key_words_;
+  size_t group_words_;
+
+  std::vector<Slot> slots_;
+  /** The groups in the order they were first seen */
+  std::vector<uint64_t *> groups_;
+  Arena arena_;
+  /** The dictionary of VARCHAR keys and MIN or MAX inputs, an id being the index of the string in the pool */
+  std::deque<std::string> string_pool_;
+  FlatHashTable<std::string_view, uint64_t> string_ids_;
+  size_t string_bytes_{0};
+
+  /** Per batch, the packed keys, their hashes, the groups of the rows and the values of one expression */
+  std::vector<uint64_t> keys_;
+  std::vector<hash_t> hashes_;
+  std::vector<uint64_t *> targets_;
+  std::vector<Value> values_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// batch_queue.h
+//
+// Identification: src/include/execution/batch_queue.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+#include "common/macros.h"
+#include "execution/tuple_batch.h"
+
+namespace bustub {
+
+/**
+ * BatchQueue turns the push-based output of a parallel executor back into the
+ * pull-based Next()/NextBatch() stream.
+ *
+ * Start() runs a producer on a background thread, typically a call to the
+ * executor's own ParallelDrain() whose sink Push()es into the queue from any
+ * number of worker threads. Next() and NextBatch() hand the queued tuples to
+ * the consumer. The queue holds at most max_batches batches, Push() waits
+ * while it is full, so the workers never get far ahead of the consumer.
+ *
+ * An exception of the producer is rethrown to the consumer once the batches
+ * queued before it are taken. Destroying the queue early, e.g. once a limit
+ * is reached, makes every Push() fail so that the producer can give up, and
+ * waits for it.
+ */
+class BatchQueue {
+ public:
+  /** @param max_batches the most batches queued at once */
+  explicit BatchQueue(size_t max_batches) : max_batches_(max_batches) {}
+
+  /** Stops the producer and waits for it */
+  ~BatchQueue();
+
+  DISALLOW_COPY_AND_MOVE(BatchQueue);
+
+  /** Run producer on a background thread, the queue is finished once it returns or throws */
+  void Start(std::function<void()> producer);
+
+  /**
+   * Queue the rows of a batch, leaving it empty. Waits while the queue is full.
+   * @return `false` if the consumer is gone, the producer should stop
+   */
+  bool Push(TupleBatch *batch);
+
+  /** Take the next tuple, false once the producer is done and all tuples are taken */
+  bool Next(Tuple *tuple, RID *rid);
+
+  /** Take the next tuples, at most the capacity of batch, false once the producer is done and all tuples are taken */
+  bool NextBatch(TupleBatch *batch);
+
+ private:
+  /** Make the next queued batch current_, false once the producer is done and all batches are taken */
+  bool FetchBatch();
+
+  size_t max_batches_;
+  std::thread producer_;
+  std::mutex latch_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<TupleBatch> batches_;
+  bool finished_{false};
+  bool closed_{false};
+  std::exception_ptr error_;
+  /** The batch the consumer takes tuples from, only touched by the consumer */
+  TupleBatch current_;
+  uint32_t current_cursor_{0};
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <limits>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -60,6 +61,28 @@ class ExecutorContext {
   /** @return the transaction manager */
   TransactionManager *GetTransactionManager() { return txn_mgr_; }
 
+  /** @return the number of worker threads a parallel executor may run */
+  uint32_t GetParallelism() const { return parallelism_; }
+
+  /**
+   * Set the number of worker threads a parallel executor may run. With more
+   * than one, such executors produce their tuples in no particular order.
+   * @param parallelism the number of workers, 1 runs everything on the calling thread
+   */
+  void SetParallelism(uint32_t parallelism) {
+    BUSTUB_ASSERT(parallelism > 0, "at least one worker is needed");
+    parallelism_ = parallelism;
+  }
+
+  /** @return the bytes of memory an executor may hold in one hash table or sort before it spills to temporary pages */
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  /**
+   * Set the memory budget of the executors, which is unlimited unless set.
+   * @param memory_budget the bytes of memory an executor may hold in one hash table or sort
+   */
+  void SetMemoryBudget(size_t memory_budget) { memory_budget_ = memory_budget; }
+
  private:
   /** The transaction context associated with this executor context */
   Transaction *transaction_;
@@ -71,6 +94,10 @@ class ExecutorContext {
   TransactionManager *txn_mgr_;
   /** The lock manager associated with this executor context */
   LockManager *lock_mgr_;
+  /** The number of worker threads a parallel executor may run */
+  uint32_t parallelism_{1};
+  /** The bytes of memory an executor may hold in one hash table or sort */
+  size_t memory_budget_{std::numeric_limits<size_t>::max()};
 };
 
 }  // namespace bustub
@@ -12,7 +12,11 @@
 
 #pragma once
 
+#include <functional>
+#include <utility>
+
 #include "execution/executor_context.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -20,9 +24,24 @@ namespace bustub {
  * The AbstractExecutor implements the Volcano tuple-at-a-time iterator model.
  * This is the base class from which all executors in the BustTub execution
  * engine inherit, and defines the minimal interface that all executors support.
+ *
+ * Next() yields one tuple per virtual call. NextBatch() yields a TupleBatch at
+ * a time; executors on the hot path override it to fill the batch in one go,
+ * all others get an adapter looping over Next(). Both draw from the same
+ * stream, so a consumer may mix them.
+ *
+ * ParallelDrain() pushes the stream instead: a pipeline breaker such as a
+ * hash table build hands in the part of its work that runs per batch, and a
+ * parallel executor runs it on its own worker threads.
  */
 class AbstractExecutor {
  public:
+  /**
+   * Consumer of ParallelDrain(), called with the index of the worker thread calling it and a batch of tuples.
+   * It returns `false` to stop the drain early.
+   */
+  using BatchSink = std::function<bool(uint32_t worker, TupleBatch *batch)>;
+
   /**
    * Construct a new AbstractExecutor instance.
    * @param exec_ctx the executor context that the executor runs with
@@ -46,6 +65,38 @@ class AbstractExecutor {
    */
   virtual bool Next(Tuple *tuple, RID *rid) = 0;
 
+  /**
+   * Yield the next batch of tuples from this executor. The batch is cleared
+   * first and holds at most its capacity of rows afterwards.
+   * @param[out] batch The next tuples produced by this executor, with their RIDs
+   * @return `true` if at least one tuple was produced, `false` if there are no more tuples
+   */
+  virtual bool NextBatch(TupleBatch *batch) {
+    batch->Clear();
+    Tuple tuple;
+    RID rid;
+    while (!batch->IsFull() && Next(&tuple, &rid)) {
+      batch->Append(std::move(tuple), rid);
+    }
+    return !batch->Empty();
+  }
+
+  /**
+   * Push all remaining tuples of this executor through sink. A parallel
+   * executor calls sink from up to GetExecutorContext()->GetParallelism()
+   * threads at once, each with a worker index of its own below that number,
+   * and returns once all of them are done. The adapter calls it on the
+   * calling thread as worker 0.
+   * @param sink the consumer of the batches, which may move tuples out of a batch but not keep the batch
+   */
+  virtual void ParallelDrain(const BatchSink &sink) {
+    TupleBatch batch;
+    bool more = true;
+    while (more && NextBatch(&batch)) {
+      more = sink(0, &batch);
+    }
+  }
+
   /** @return The schema of the tuples that this executor produces */
   virtual const Schema *GetOutputSchema() = 0;
 
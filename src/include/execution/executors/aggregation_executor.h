@@ -13,148 +13,54 @@
 #pragma once
 
 #include <memory>
-#include <unordered_map>
+#include <mutex>  // NOLINT
 #include <utility>
 #include <vector>
 
-#include "common/util/hash_util.h"
-#include "container/hash/hash_function.h"
+#include "execution/aggregation_hash_table.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expression_program.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/aggregation_plan.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tmp_tuple_file.h"
 #include "storage/table/tuple.h"
-#include "type/value_factory.h"
 
 namespace bustub {
 
 /**
- * A simplified hash table that has all the necessary functionality for aggregations.
- */
-class SimpleAggregationHashTable {
- public:
-  /**
-   * Construct a new SimpleAggregationHashTable instance.
-   * @param agg_exprs the aggregation expressions
-   * @param agg_types the types of aggregations
-   */
-  SimpleAggregationHashTable(const std::vector<const AbstractExpression *> &agg_exprs,
-                             const std::vector<AggregationType> &agg_types)
-      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {}
-
-  /** @return The initial aggregrate value for this aggregation executor */
-  AggregateValue GenerateInitialAggregateValue() {
-    std::vector<Value> values{};
-    for (const auto &agg_type : agg_types_) {
-      switch (agg_type) {
-        case AggregationType::CountAggregate:
-          // Count starts at zero.
-          values.emplace_back(ValueFactory::GetIntegerValue(0));
-          break;
-        case AggregationType::SumAggregate:
-          // Sum starts at zero.
-          values.emplace_back(ValueFactory::GetIntegerValue(0));
-          break;
-        case AggregationType::MinAggregate:
-          // Min starts at INT_MAX.
-          values.emplace_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MAX));
-          break;
-        case AggregationType::MaxAggregate:
-          // Max starts at INT_MIN.
-          values.emplace_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MIN));
-          break;
-      }
-    }
-    return {values};
-  }
-
-  /**
-   * Combines the input into the aggregation result.
-   * @param[out] result The output aggregate value
-   * @param input The input value
-   */
-  void CombineAggregateValues(AggregateValue *result, const AggregateValue &input) {
-    for (uint32_t i = 0; i < agg_exprs_.size(); i++) {
-      switch (agg_types_[i]) {
-        case AggregationType::CountAggregate:
-          // Count increases by one.
-          result->aggregates_[i] = result->aggregates_[i].Add(ValueFactory::GetIntegerValue(1));
-          break;
-        case AggregationType::SumAggregate:
-          // Sum increases by addition.
-          result->aggregates_[i] = result->aggregates_[i].Add(input.aggregates_[i]);
-          break;
-        case AggregationType::MinAggregate:
-          // Min is just the min.
-          result->aggregates_[i] = result->aggregates_[i].Min(input.aggregates_[i]);
-          break;
-        case AggregationType::MaxAggregate:
-          // Max is just the max.
-          result->aggregates_[i] = result->aggregates_[i].Max(input.aggregates_[i]);
-          break;
-      }
-    }
-  }
-
-  /**
-   * Inserts a value into the hash table and then combines it with the current aggregation.
-   * @param agg_key the key to be inserted
-   * @param agg_val the value to be inserted
-   */
-  void InsertCombine(const AggregateKey &agg_key, const AggregateValue &agg_val) {
-    if (ht_.count(agg_key) == 0) {
-      ht_.insert({agg_key, GenerateInitialAggregateValue()});
-    }
-    CombineAggregateValues(&ht_[agg_key], agg_val);
-  }
-
-  /** An iterator over the aggregation hash table */
-  class Iterator {
-   public:
-    /** Creates an iterator for the aggregate map. */
-    explicit Iterator(std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter) : iter_{iter} {}
-
-    /** @return The key of the iterator */
-    const AggregateKey &Key() { return iter_->first; }
-
-    /** @return The value of the iterator */
-    const AggregateValue &Val() { return iter_->second; }
-
-    /** @return The iterator before it is incremented */
-    Iterator &operator++() {
-      ++iter_;
-      return *this;
-    }
-
-    /** @return `true` if both iterators are identical */
-    bool operator==(const Iterator &other) { return this->iter_ == other.iter_; }
-
-    /** @return `true` if both iterators are different */
-    bool operator!=(const Iterator &other) { return this->iter_ != other.iter_; }
-
-   private:
-    /** Aggregates map */
-    std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter_;
-  };
-
-  /** @return Iterator to the start of the hash table */
-  Iterator Begin() { return Iterator{ht_.cbegin()}; }
-
-  /** @return Iterator to the end of the hash table */
-  Iterator End() { return Iterator{ht_.cend()}; }
-
- private:
-  /** The hash table is just a map from aggregate keys to aggregate values */
-  std::unordered_map<AggregateKey, AggregateValue> ht_{};
-  /** The aggregate expressions that we have */
-  const std::vector<const AbstractExpression *> &agg_exprs_;
-  /** The types of aggregations that we have */
-  const std::vector<AggregationType> &agg_types_;
-};
-
-/**
- * AggregationExecutor executes an aggregation operation (e.g. COUNT, SUM, MIN, MAX)
+ * AggregationExecutor executes an aggregation operation (e.g. COUNT, SUM, MIN, MAX, AVG)
  * over the tuples produced by a child executor.
+ *
+ * Init drains the child a batch at a time into the hash table, Next and
+ * NextBatch then hand out the groups that pass the HAVING clause. The groups
+ * are unpacked ExpressionProgram::MAX_LANES at a time and HAVING is
+ * evaluated over all of them at once, compiled into an ExpressionProgram
+ * for the types of the first group unless it does not compile.
+ *
+ * Once the hash table exceeds the memory budget of the executor context, its
+ * groups are spilled as partial aggregates to SPILL_FANOUT partitions of
+ * TmpTuplePages by the top bits of their hashes, and it starts over empty;
+ * when the child is drained the rest of its groups are spilled too. Every
+ * group then lies in one partition only, possibly in several partial
+ * aggregates, and the partitions are merged into the hash table one after
+ * the other and handed out. A partition whose groups exceed the budget while
+ * it is merged is spilled again on the next bits of the hashes, at most
+ * MAX_SPILL_LEVELS deep and as long as it holds more than one group, so
+ * memory stays bounded by the budget however many groups there are.
+ *
+ * With a parallelism above one the aggregation runs in two phases. First the
+ * child drains into the workers, each of which pre-aggregates its batches
+ * into a small table of its own and, whenever that holds
+ * PREAGGREGATION_GROUPS groups, hands them on as partial aggregates,
+ * buffered by partition. A worker whose table folded fewer than
+ * MIN_REDUCTION rows into a group on average stops pre-aggregating and hands
+ * on every batch right away, aggregated only within itself. Then each
+ * worker merges the buffers of a share of the partitions into tables of
+ * their own, which are handed out one after the other. A worker whose
+ * buffers exceed its share of the memory budget spills them to the
+ * partitions of a spill instead, which are then merged one at a time.
  */
 class AggregationExecutor : public AbstractExecutor {
  public:
@@ -178,39 +84,111 @@ class AggregationExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of groups from the aggregation.
+   * @param[out] batch The next tuples produced by the aggregation
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
   /** @return The output schema for the aggregation */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
+  /** The number of hash bits a spill splits the groups on, and the number of partitions that makes */
+  static constexpr uint32_t SPILL_BITS = 4;
+  static constexpr size_t SPILL_FANOUT = 1 << SPILL_BITS;
+  /** The most levels of partitions a spilled aggregation splits into */
+  static constexpr uint32_t MAX_SPILL_LEVELS = 8;
+  /** The most groups a worker of a parallel aggregation pre-aggregates before it hands them on */
+  static constexpr size_t PREAGGREGATION_GROUPS = 1 << 12;
+  /** The fewest input rows per group a worker's pre-aggregation folds to be kept up */
+  static constexpr size_t MIN_REDUCTION = 2;
+
   /** Do not use or remove this function, otherwise you will get zero points. */
   const AbstractExecutor *GetChildExecutor() const;
 
  private:
-  /** @return The tuple as an AggregateKey */
-  AggregateKey MakeAggregateKey(const Tuple *tuple) {
-    std::vector<Value> keys;
-    for (const auto &expr : plan_->GetGroupBys()) {
-      keys.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
-    }
-    return {keys};
-  }
+  /** Advance to the next group passing the HAVING clause and project it, false once all groups are out */
+  bool NextGroup(Tuple *tuple);
+
+  /** Unpack the next chunk of groups of the hash table and evaluate HAVING over them */
+  void FetchGroups();
+
+  /** A worker of a parallel aggregation */
+  struct Worker {
+    explicit Worker(const AggregationPlanNode *plan) : table_(plan), partials_(SPILL_FANOUT) {}
+
+    /** The pre-aggregation of the worker */
+    AggregationHashTable table_;
+    /** The input rows folded into table_ since it was last handed on */
+    size_t rows_{0};
+    /** Set once pre-aggregating stopped paying off */
+    bool pass_through_{false};
+    /** The partial aggregates handed on, by partition, and the memory they take */
+    std::vector<std::vector<Tuple>> partials_;
+    size_t partial_bytes_{0};
+  };
 
-  /** @return The tuple as an AggregateValue */
-  AggregateValue MakeAggregateValue(const Tuple *tuple) {
-    std::vector<Value> vals;
-    for (const auto &expr : plan_->GetAggregates()) {
-      vals.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
-    }
-    return {vals};
+  /** A partition of spilled partial aggregates */
+  struct SpilledPartition {
+    std::unique_ptr<TmpTupleFile> file_;
+    /** The level the partition was split at */
+    uint32_t level_;
+  };
+
+  /**
+   * @return the partition of a hash at a level of a spill, picked by bits from the top, since the hash table probes
+   * from the bottom ones
+   */
+  static size_t SpillPartition(hash_t hash, uint32_t level) {
+    return (hash >> (sizeof(hash_t) * 8 - (level + 1) * SPILL_BITS)) & (SPILL_FANOUT - 1);
   }
 
- private:
+  /** Spill the groups of the hash table to partitions split at a level, the partitions created if there are none */
+  void Spill(std::vector<std::unique_ptr<TmpTupleFile>> *partitions, uint32_t level);
+
+  /** Finish the partitions of a spill and queue those that are not empty to be merged */
+  void FinishSpill(std::vector<std::unique_ptr<TmpTupleFile>> *partitions, uint32_t level);
+
+  /** Empty the hash table and merge the next spilled partition into it, false if none is left */
+  bool MergeNextPartition();
+
+  /** Init() with a parallelism above one */
+  void ParallelInit();
+
+  /** Hand the groups of a worker's pre-aggregation on to its buffers, spilling them if they exceed its budget */
+  void HandOn(Worker *worker);
+
+  /** Spill the buffers of a worker to the partitions of the spill, created if there are none */
+  void SpillPartials(Worker *worker);
+
+  /** Move on to the next table of groups, merged in parallel or from a spilled partition, false if none is left */
+  bool NextTable();
+
   /** The aggregation plan node */
   const AggregationPlanNode *plan_;
   /** The child executor that produces tuples over which the aggregation is computed */
   std::unique_ptr<AbstractExecutor> child_;
-  /** Simple aggregation hash table */
-  // TODO(Student): Uncomment SimpleAggregationHashTable aht_;
-  /** Simple aggregation hash table iterator */
-  // TODO(Student): Uncomment SimpleAggregationHashTable::Iterator aht_iterator_;
+  /** The aggregation hash table the groups are handed out from */
+  std::unique_ptr<AggregationHashTable> aht_;
+  /** The tables of a parallel aggregation not handed out yet, and the next of them */
+  std::vector<std::unique_ptr<AggregationHashTable>> merged_;
+  size_t next_merged_{0};
+  /** The partitions the workers of a parallel aggregation spill to, latched while they do */
+  std::mutex spill_latch_;
+  std::vector<std::unique_ptr<TmpTupleFile>> parallel_spill_;
+  /** The next group of the hash table to unpack */
+  size_t next_group_{0};
+  /** The groups unpacked, whether each passes HAVING, and the next of them to yield */
+  std::vector<std::vector<Value>> chunk_group_bys_;
+  std::vector<std::vector<Value>> chunk_aggregates_;
+  std::vector<uint8_t> chunk_matches_;
+  size_t next_in_chunk_{0};
+  /** HAVING compiled once the first groups are unpacked, nullptr if it did not compile, and its registers */
+  bool having_compiled_{false};
+  std::unique_ptr<ExpressionProgram> having_program_;
+  std::unique_ptr<ExpressionProgram::Registers> having_registers_;
+  /** The spilled partitions not merged yet */
+  std::vector<SpilledPartition> spilled_;
 };
 }  // namespace bustub
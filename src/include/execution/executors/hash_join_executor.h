@@ -12,18 +12,50 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <utility>
+#include <vector>
 
+#include "execution/batch_queue.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/join_hash_table.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tmp_tuple_file.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
- * HashJoinExecutor executes a nested-loop JOIN on two tables.
+ * HashJoinExecutor executes an equi-JOIN on two tables with a hash table,
+ * in memory unless the left side exceeds the memory budget.
+ *
+ * Init builds a JoinHashTable over all tuples of the left child, then Next
+ * and NextBatch stream the right child through it. The join keys of a batch
+ * are hashed with one HashUtil::HashValues call.
+ *
+ * With a parallelism above one in the executor context both sides run on
+ * the workers: Init drains the left child in parallel, every worker adding
+ * to the hash table, which the workers then partition and index together.
+ * ParallelDrain() drains the right child in parallel, every worker probing
+ * the batches it gets into output batches of its own. Next and NextBatch run
+ * ParallelDrain() behind a BatchQueue, at most MAX_QUEUED_BATCHES batches
+ * ahead of the consumer, and the tuples come out in no particular order.
+ *
+ * Once the left tuples exceed the memory budget of the executor context the
+ * join turns into a Grace hash join. The build spills every left tuple to
+ * GRACE_FANOUT partitions of TmpTuplePages by bits of its hash, and the
+ * probe first splits the right tuples the same way. Then each pair of
+ * partitions is joined on its own, by one worker within its share of the
+ * budget; a pair whose left partition still exceeds it is split again on
+ * the next bits of the hashes, at most MAX_GRACE_LEVELS times, beyond which
+ * its keys are too few to be split and it is joined in memory regardless.
+ * A spilled join always runs behind the queue, and its tuples come without
+ * RIDs.
  */
 class HashJoinExecutor : public AbstractExecutor {
  public:
@@ -48,12 +80,132 @@ class HashJoinExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of tuples from the join.
+   * @param[out] batch The next tuples produced by the join
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
+  /**
+   * Push the remaining tuples of the join through sink, on the worker threads when the join is parallel.
+   * @param sink the consumer of the batches
+   */
+  void ParallelDrain(const BatchSink &sink) override;
+
   /** @return The output schema for the join */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
+  /** The most batches the background workers produce ahead of Next and NextBatch */
+  static constexpr size_t MAX_QUEUED_BATCHES = 16;
+  /** The number of hash bits a spilled join splits a partition on, and the number of partitions that makes */
+  static constexpr uint32_t GRACE_BITS = 4;
+  static constexpr size_t GRACE_FANOUT = 1 << GRACE_BITS;
+  /** The most times a spilled partition is split again */
+  static constexpr uint32_t MAX_GRACE_LEVELS = 8;
+
  private:
-  /** The NestedLoopJoin plan node to be executed. */
+  /** One side of a spilled join, split into GRACE_FANOUT partitions that workers append to under their latches */
+  struct SpilledSide {
+    explicit SpilledSide(BufferPoolManager *bpm);
+    /** Append a tuple to a partition */
+    void Append(size_t partition, const Tuple &tuple);
+    /** Finish the files of all partitions */
+    void Finish();
+
+    std::vector<std::unique_ptr<TmpTupleFile>> files_;
+    /** The memory the tuples of each partition would take in a JoinHashTable */
+    std::vector<size_t> bytes_;
+    std::vector<std::mutex> latches_;
+  };
+
+  /** Compute the hashed join keys of the selected tuples of a batch of child */
+  static void ComputeKeys(AbstractExecutor *child, const AbstractExpression *key_expr, const TupleBatch &batch,
+                          std::vector<HashJoinKey> *keys);
+
+  /** Compute the hashed join keys of tuples of child */
+  static void ComputeKeys(AbstractExecutor *child, const AbstractExpression *key_expr, const std::vector<Tuple> &tuples,
+                          std::vector<HashJoinKey> *keys);
+
+  /** Hash key values into keys */
+  static void HashKeys(const std::vector<Value> &values, std::vector<HashJoinKey> *keys);
+
+  /** @return the partition of a hash at a level of a spilled join, the levels split on bits below the radix bits */
+  static size_t GracePartition(hash_t hash, uint32_t level) {
+    return (hash >> (GRACE_SHIFT + level * GRACE_BITS)) & (GRACE_FANOUT - 1);
+  }
+
+  /** Pull the next batch of right tuples and compute their keys, false once the right child is exhausted */
+  bool FetchProbeBatch();
+
+  /**
+   * Advance to the next pair of matching tuples.
+   * @return `false` once the right child is exhausted
+   */
+  bool NextMatch(const Tuple **left, uint32_t *right_idx);
+
+  /** @return The output tuple of a matching pair */
+  Tuple Project(const Tuple &left, const Tuple &right);
+
+  /**
+   * Append the join of a right tuple with its matches in ht to a worker's output batch, which goes to sink when full.
+   * @return `false` if the sink asked to stop
+   */
+  bool Probe(const JoinHashTable &ht, const HashJoinKey &key, const Tuple &right, RID rid, uint32_t worker,
+             TupleBatch *output, const BatchSink &sink);
+
+  /** Hand the outputs the workers did not fill up to sink, unless it asked to stop */
+  static void FlushOutputs(std::vector<TupleBatch> *outputs, const BatchSink &sink, std::atomic<bool> *stopped);
+
+  /** @return `true` if the left side was spilled */
+  bool IsSpilled() const { return spilled_build_ != nullptr; }
+
+  /** ParallelDrain() of a spilled join */
+  void GraceDrain(const BatchSink &sink);
+
+  /**
+   * Join a pair of spilled partitions on a worker, splitting them again if the left one exceeds the worker's budget.
+   * @param build the left partition, whose pages are deleted as soon as they are read
+   * @param build_bytes the memory the left partition would take in a JoinHashTable
+   * @param probe the right partition
+   * @param level the level the partitions were split at
+   */
+  void JoinSpilled(uint32_t worker, std::unique_ptr<TmpTupleFile> build, size_t build_bytes,
+                   std::unique_ptr<TmpTupleFile> probe, uint32_t level, TupleBatch *output, const BatchSink &sink,
+                   std::atomic<bool> *stopped);
+
+  /** @return the tuples of a spilled partition of child split at a level */
+  std::unique_ptr<SpilledSide> Split(TmpTupleFile *file, AbstractExecutor *child, const AbstractExpression *key_expr,
+                                     uint32_t level);
+
+  /** @return `true` if the join runs on worker threads */
+  bool IsParallel() const { return exec_ctx_->GetParallelism() > 1; }
+
+  /** Start ParallelDrain() behind queue_, unless it runs already */
+  void StartQueue();
+
+  /** The number of tuples whose keys are hashed together. */
+  static constexpr size_t BATCH_SIZE = 128;
+  /** The lowest hash bit the partitions of a spilled join are picked by. */
+  static constexpr uint32_t GRACE_SHIFT = 16;
+  static_assert(GRACE_SHIFT + (MAX_GRACE_LEVELS + 1) * GRACE_BITS <= sizeof(hash_t) * 8 - JoinHashTable::MAX_PARTITION_BITS,
+                "the levels of a spilled join split on bits below those the JoinHashTable partitions on");
+
+  /** The HashJoin plan node to be executed. */
   const HashJoinPlanNode *plan_;
+  /** The build (left) and probe (right) side child executors. */
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  std::unique_ptr<AbstractExecutor> right_executor_;
+  /** The left tuples by join key, unless they were spilled. */
+  std::unique_ptr<JoinHashTable> ht_;
+  std::unique_ptr<SpilledSide> spilled_build_;
+  /** The current batch of right tuples, their keys and the position of the probe within them. */
+  TupleBatch probe_batch_{BATCH_SIZE};
+  std::vector<HashJoinKey> probe_keys_;
+  size_t probe_cursor_{0};
+  uint32_t match_{0};
+  /** The output of the workers for Next and NextBatch, started by the first call of either */
+  std::unique_ptr<BatchQueue> queue_;
 };
 
 }  // namespace bustub
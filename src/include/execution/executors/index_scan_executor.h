@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "common/rid.h"
@@ -24,6 +25,10 @@ namespace bustub {
 
 /**
  * IndexScanExecutor executes an index scan over a table.
+ *
+ * A predicate comparing the (single) key column against a constant is turned
+ * into a key range, which an ordered index answers with a batched range scan.
+ * Other predicates are still applied to every tuple fetched from the table.
  */
 
 class IndexScanExecutor : public AbstractExecutor {
@@ -42,7 +47,28 @@ class IndexScanExecutor : public AbstractExecutor {
   bool Next(Tuple *tuple, RID *rid) override;
 
  private:
+  /** Derive the key range to scan from the plan predicate, leaving the bounds open if none applies */
+  void ComputeBounds();
+
+  /** Refill rids_ with the next batch of candidate RIDs, return false once the scan is exhausted */
+  bool FetchBatch();
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  /** The index being scanned. */
+  IndexInfo *index_info_{nullptr};
+  /** The table the index points into. */
+  TableInfo *table_info_{nullptr};
+  /** Range bounds as key tuples, only meaningful when has_low_ / has_high_ are set. */
+  Tuple low_;
+  Tuple high_;
+  bool has_low_{false};
+  bool has_high_{false};
+  bool high_inclusive_{false};
+  /** The range scan cursor, nullptr once exhausted or if the index is unordered. */
+  std::unique_ptr<IndexRangeScan> scan_;
+  /** The current batch of candidate RIDs and the position within it. */
+  std::vector<RID> rids_;
+  size_t cursor_{0};
 };
 }  // namespace bustub
@@ -17,6 +17,7 @@
 
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/limit_plan.h"
+#include "execution/tuple_batch.h"
 
 namespace bustub {
 
@@ -45,6 +46,13 @@ class LimitExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of tuples from the limit, the child's batch cut at the limit.
+   * @param[out] batch The next tuples produced by the limit
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
   /** @return The output schema for the limit */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
@@ -53,5 +61,7 @@ class LimitExecutor : public AbstractExecutor {
   const LimitPlanNode *plan_;
   /** The child executor from which tuples are obtained */
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The number of tuples produced so far */
+  size_t num_produced_{0};
 };
 }  // namespace bustub
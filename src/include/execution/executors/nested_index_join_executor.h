@@ -22,6 +22,7 @@
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/nested_index_join_plan.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tmp_tuple.h"
 #include "storage/table/tuple.h"
 
@@ -29,6 +30,11 @@ namespace bustub {
 
 /**
  * IndexJoinExecutor executes index join operations.
+ *
+ * Outer tuples are pulled from the child with NextBatch. The inner index keys of a
+ * whole batch are probed with one Index::ScanKeys() call, which lets an ordered
+ * index answer them in a single sorted pass over its leaves instead of one
+ * root-to-leaf descent per outer tuple. Results come out in outer tuple order.
  */
 class NestIndexJoinExecutor : public AbstractExecutor {
  public:
@@ -47,8 +53,38 @@ class NestIndexJoinExecutor : public AbstractExecutor {
 
   bool Next(Tuple *tuple, RID *rid) override;
 
+  bool NextBatch(TupleBatch *batch) override;
+
  private:
+  /** Pull the next batch of outer tuples and probe the index for all of them, false once the child is exhausted */
+  bool FetchBatch();
+
+  /**
+   * Advance to the next outer tuple and inner tuple satisfying the predicate.
+   * @param[out] inner the inner tuple, the outer one is outer_batch_'s at outer_cursor_
+   * @return `false` once the child is exhausted
+   */
+  bool NextMatch(Tuple *inner);
+
+  /** @return The output tuple of a matching pair */
+  Tuple Project(const Tuple &outer, const Tuple &inner);
+
+  /** The number of outer tuples probed together. */
+  static constexpr size_t BATCH_SIZE = 128;
+
   /** The nested index join plan node. */
   const NestedIndexJoinPlanNode *plan_;
+  /** The outer table child executor. */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The inner table and the index probed on it. */
+  TableInfo *inner_table_info_{nullptr};
+  IndexInfo *index_info_{nullptr};
+  /** The expression computing the inner index key from an outer tuple. */
+  const AbstractExpression *outer_key_expr_{nullptr};
+  /** The current batch of outer tuples and, for each of them, the matching inner RIDs. */
+  TupleBatch outer_batch_{BATCH_SIZE};
+  std::vector<std::vector<RID>> inner_rids_;
+  size_t outer_cursor_{0};
+  size_t inner_cursor_{0};
 };
 }  // namespace bustub
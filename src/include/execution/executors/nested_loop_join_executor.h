@@ -14,16 +14,22 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/nested_loop_join_plan.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
  * NestedLoopJoinExecutor executes a nested-loop JOIN on two tables.
+ *
+ * Init drains the right child into memory once. The left child is then
+ * pulled with NextBatch, and every left tuple of a batch is compared against
+ * all right tuples in right child order.
  */
 class NestedLoopJoinExecutor : public AbstractExecutor {
  public:
@@ -49,12 +55,38 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of tuples from the join.
+   * @param[out] batch The next tuples produced by the join
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
   /** @return The output schema for the insert */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
  private:
+  /**
+   * Advance to the next pair of tuples satisfying the predicate, the left one is left_batch_'s at left_cursor_ and
+   * the right one right_tuples_[right_cursor_ - 1].
+   * @return `false` once the left child is exhausted
+   */
+  bool NextMatch();
+
+  /** @return The output tuple of the current pair */
+  Tuple Project();
+
   /** The NestedLoopJoin plan node to be executed. */
   const NestedLoopJoinPlanNode *plan_;
+  /** The outer (left) and inner (right) side child executors. */
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  std::unique_ptr<AbstractExecutor> right_executor_;
+  /** All tuples of the right child. */
+  std::vector<Tuple> right_tuples_;
+  /** The current batch of left tuples. */
+  TupleBatch left_batch_;
+  uint32_t left_cursor_{0};
+  size_t right_cursor_{0};
 };
 
 }  // namespace bustub
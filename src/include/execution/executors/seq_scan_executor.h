@@ -12,17 +12,41 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "execution/executor_context.h"
+#include "execution/batch_queue.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expression_program.h"
+#include "execution/morsel_queue.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
  * The SeqScanExecutor executor executes a sequential table scan.
+ *
+ * NextBatch() copies a batch of raw tuples out of the heap, evaluates the
+ * predicate over the batch into its selection vector and projects only the
+ * selected rows. Init compiles the predicate into an ExpressionProgram,
+ * which evaluates it over all rows of a batch or a page at once; a
+ * predicate that does not compile is evaluated as a tree, row by row. A
+ * row whose predicate is NULL does not pass. A projection that merely
+ * lists the table columns in order is skipped, the raw tuples are the
+ * output.
+ *
+ * With a parallelism above one in the executor context the scan is morsel
+ * driven: Init lists the pages of the table, a MorselQueue deals runs of
+ * MORSEL_PAGES pages out to the workers and lets idle workers steal, and
+ * each worker reads, filters and projects whole pages of its morsels.
+ * ParallelDrain() runs the consumer's sink on the workers, right behind the
+ * scan. Next and NextBatch instead run ParallelDrain() behind a BatchQueue,
+ * at most MAX_QUEUED_BATCHES batches ahead of the consumer. Either way the
+ * tuples come out in no particular order.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -44,11 +68,62 @@ class SeqScanExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of tuples from the sequential scan.
+   * @param[out] batch The next tuples produced by the scan
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
+  /**
+   * Push the remaining tuples of the scan through sink, on the worker threads when the scan is parallel.
+   * @param sink the consumer of the batches
+   */
+  void ParallelDrain(const BatchSink &sink) override;
+
   /** @return The output schema for the sequential scan */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
+  /** The number of consecutive pages in a morsel */
+  static constexpr size_t MORSEL_PAGES = 8;
+  /** The most batches the background workers produce ahead of Next and NextBatch */
+  static constexpr size_t MAX_QUEUED_BATCHES = 16;
+
  private:
+  /** @return `true` if the raw tuple passes the predicate, compiled into regs if it compiled */
+  bool Matches(const Tuple &raw, ExpressionProgram::Registers *regs) const;
+
+  /** @return The raw tuple projected onto the output schema */
+  Tuple Project(const Tuple &raw);
+
+  /** @return `true` if the scan runs on worker threads */
+  bool IsParallel() const { return exec_ctx_->GetParallelism() > 1; }
+
+  /**
+   * Scan the morsels a worker takes and pass the tuples that pass the predicate to sink in full batches.
+   * @param stop set by any worker whose sink asked to stop, the others give up as soon as they see it
+   */
+  void ScanMorsels(uint32_t worker, const BatchSink &sink, std::atomic<bool> *stop);
+
+  /** Start ParallelDrain() behind queue_, unless it runs already */
+  void StartQueue();
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
+  /** The table being scanned */
+  TableInfo *table_info_{nullptr};
+  /** The position of the scan within the table heap */
+  std::unique_ptr<TableIterator> iter_;
+  /** The predicate compiled, nullptr if there is none or it did not compile, and the registers of Next and NextBatch */
+  std::unique_ptr<ExpressionProgram> program_;
+  std::unique_ptr<ExpressionProgram::Registers> registers_;
+  /** Whether the output schema is the table schema, column for column */
+  bool identity_projection_{false};
+
+  /** The pages of the table and the morsels over them, for a parallel scan */
+  std::vector<page_id_t> page_ids_;
+  std::unique_ptr<MorselQueue> morsels_;
+  /** The output of the workers for Next and NextBatch, started by the first call of either */
+  std::unique_ptr<BatchQueue> queue_;
 };
 }  // namespace bustub
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.h
+//
+// Identification: src/include/execution/executors/sort_executor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/external_sorter.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SortExecutor orders the tuples of its child.
+ *
+ * Init drains the child, in parallel if the child runs on workers, into an
+ * ExternalSorter keyed on the normalized key of the sort terms: the VarlenKey
+ * encoding of each term's value, with every byte of a descending term
+ * inverted. Past the memory budget of the executor context the sorter spills
+ * sorted runs to temporary pages. Next and NextBatch then stream its merge,
+ * and the tuples come without RIDs.
+ */
+class SortExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new SortExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The sort plan to be executed
+   * @param child_executor The child executor from which tuples are pulled
+   */
+  SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child_executor);
+
+  /** Initialize the sort, which sorts all tuples of the child */
+  void Init() override;
+
+  /**
+   * Yield the next tuple from the sort.
+   * @param[out] tuple The next tuple produced by the sort
+   * @param[out] rid Reset, the tuples have no RIDs
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  /**
+   * Yield the next batch of tuples from the sort.
+   * @param[out] batch The next tuples produced by the sort
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
+  /** @return The output schema for the sort */
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
+
+  /**
+   * Replace key with the normalized key of a tuple of child for the sort terms of plan.
+   * @param plan the sort plan
+   * @param child_schema the schema of the tuples sorted
+   * @param tuple the tuple
+   * @param[out] key the key, whose memcmp order is the order of the tuples
+   */
+  static void MakeSortKey(const SortPlanNode *plan, const Schema *child_schema, const Tuple &tuple, std::string *key);
+
+ private:
+  /** The sort plan node to be executed */
+  const SortPlanNode *plan_;
+  /** The child executor from which tuples are obtained */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The sorted tuples of the child */
+  std::unique_ptr<ExternalSorter> sorter_;
+};
+
+}  // namespace bustub
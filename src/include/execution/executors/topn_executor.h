@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_executor.h
+//
+// Identification: src/include/execution/executors/topn_executor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TopNExecutor runs a limit directly over a sort: it yields the first
+ * `limit` tuples of the sort order without sorting all of them.
+ *
+ * Init drains the sort's child, in parallel if the child runs on workers,
+ * into a bounded max-heap per worker holding the best `limit` tuples seen.
+ * The heap is ordered on the normalized sort keys of SortExecutor and their
+ * integer prefixes, not on the tuples: a tuple whose key does not beat the
+ * worst in a full heap is rejected without being copied, and one that does
+ * takes over the slot of the tuple it evicts. That is O(n log k) time and
+ * O(k) memory per worker for n tuples and a limit of k. The heaps are then
+ * merged and sorted, and the tuples come without RIDs.
+ */
+class TopNExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new TopNExecutor instance.
+   * @param exec_ctx The executor context
+   * @param limit_plan The limit plan to be executed
+   * @param sort_plan The sort plan right under the limit
+   * @param child_executor The executor of the sort's child, from which tuples are pulled
+   */
+  TopNExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *limit_plan, const SortPlanNode *sort_plan,
+               std::unique_ptr<AbstractExecutor> &&child_executor);
+
+  /** Initialize the top-N, which reads all tuples of the child */
+  void Init() override;
+
+  /**
+   * Yield the next tuple from the top-N.
+   * @param[out] tuple The next tuple produced by the top-N
+   * @param[out] rid Reset, the tuples have no RIDs
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  /**
+   * Yield the next batch of tuples from the top-N.
+   * @param[out] batch The next tuples produced by the top-N
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
+  /** @return The output schema for the top-N */
+  const Schema *GetOutputSchema() override { return limit_plan_->OutputSchema(); };
+
+ private:
+  /** A heap entry, the sort key of the tuple in a slot */
+  struct HeapEntry {
+    uint64_t prefix_;
+    std::string key_;
+    uint32_t slot_;
+
+    bool operator<(const HeapEntry &other) const {
+      return prefix_ != other.prefix_ ? prefix_ < other.prefix_ : key_ < other.key_;
+    }
+  };
+
+  /** The best tuples one worker saw, the worst on top of the heap */
+  struct alignas(64) Heap {
+    std::vector<HeapEntry> entries_;
+    std::vector<Tuple> slots_;
+    /** The key of the tuple offered last */
+    std::string key_;
+  };
+
+  /**
+   * Offer a tuple to a heap, which takes it if it is among the best `limit` so far.
+   * @param heap the heap
+   * @param prefix the prefix of the tuple's sort key
+   * @param key the tuple's sort key, swapped with that of an evicted tuple if the heap takes it
+   * @param tuple the tuple, moved into the heap if the heap takes it
+   */
+  void Offer(Heap *heap, uint64_t prefix, std::string *key, Tuple *tuple) const;
+
+  /** The limit plan node to be executed */
+  const LimitPlanNode *limit_plan_;
+  /** The sort plan node under the limit */
+  const SortPlanNode *sort_plan_;
+  /** The child executor from which tuples are obtained */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The tuples to yield, in order, and the position of the next one */
+  std::vector<Tuple> output_;
+  size_t next_{0};
+};
+
+}  // namespace bustub
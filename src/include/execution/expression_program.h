@@ -0,0 +1,233 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// expression_program.h
+//
+// Identification: src/include/execution/expression_program.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/macros.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * ExpressionProgram is a predicate compiled from an expression tree into a
+ * flat program that is evaluated over many rows at a time.
+ *
+ * Compiling walks the tree once and emits its nodes, operands first, as
+ * instructions that each write a register: a lane per row for up to
+ * MAX_LANES rows, holding int64s, doubles or string_views, and a NULL flag
+ * per lane. The opcodes are specialized by type at compile time. A load
+ * reads an INTEGER column straight out of the tuple bytes, and comparing it
+ * with a constant is one loop over the lanes with the constant as an
+ * immediate. Evaluating the tree instead makes a virtual call and a Value
+ * per node per row.
+ *
+ * Only comparisons of columns, constants, group-by and aggregate terms and
+ * other comparisons compile, over the types Value compares alike: integer
+ * types as int64s, with a DECIMAL on either side as doubles, VARCHARs byte by
+ * byte and BOOLEANs with BOOLEANs. For any other tree compiling returns
+ * nullptr and the caller evaluates the tree. A comparison with a NULL
+ * operand is NULL, and a row whose predicate is NULL does not match.
+ *
+ * A program does not change once compiled, so threads may share it, each
+ * evaluating it into Registers of its own.
+ */
+class ExpressionProgram {
+ public:
+  /** The most rows a program evaluates at once */
+  static constexpr uint32_t MAX_LANES = TupleBatch::DEFAULT_CAPACITY;
+
+  /** The registers a program is evaluated into, one set per thread */
+  class Registers {
+   public:
+    explicit Registers(const ExpressionProgram &program);
+
+    DISALLOW_COPY(Registers);
+
+   private:
+    friend class ExpressionProgram;
+
+    /** The registers of one kind, MAX_LANES values and NULL flags each */
+    template <typename T>
+    struct File {
+      explicit File(uint32_t num_registers)
+          : values_(num_registers * MAX_LANES), nulls_(num_registers * MAX_LANES) {}
+
+      T *Values(uint32_t reg) { return &values_[reg * MAX_LANES]; }
+      uint8_t *Nulls(uint32_t reg) { return &nulls_[reg * MAX_LANES]; }
+
+      std::vector<T> values_;
+      std::vector<uint8_t> nulls_;
+    };
+
+    File<int64_t> ints_;
+    File<double> doubles_;
+    File<std::string_view> strings_;
+    /** The rows of a chunk and whether they match, gathered for Filter() */
+    std::vector<const Tuple *> rows_;
+    std::vector<uint8_t> matches_;
+  };
+
+  /**
+   * Compile a predicate over tuples.
+   * @param expr the predicate
+   * @param schema the schema of the tuples
+   * @return the program, nullptr if the predicate does not compile
+   */
+  static std::unique_ptr<ExpressionProgram> Compile(const AbstractExpression *expr, const Schema *schema);
+
+  /**
+   * Compile a predicate over the groups of an aggregation, such as HAVING.
+   * @param expr the predicate
+   * @param group_by_types the types of the group-by values of the groups
+   * @param aggregate_types the types of the aggregate values of the groups
+   * @return the program, nullptr if the predicate does not compile
+   */
+  static std::unique_ptr<ExpressionProgram> CompileAggregate(const AbstractExpression *expr,
+                                                             const std::vector<TypeId> &group_by_types,
+                                                             const std::vector<TypeId> &aggregate_types);
+
+  /** @return `true` if a tuple matches the predicate */
+  bool Matches(const Tuple &tuple, Registers *regs) const;
+
+  /**
+   * Evaluate the predicate over tuples.
+   * @param tuples the tuples
+   * @param regs the registers to evaluate in
+   * @param[out] matches 1 for each tuple that matches, 0 for each that does not
+   */
+  void Match(const std::vector<Tuple> &tuples, Registers *regs, std::vector<uint8_t> *matches) const;
+
+  /** Narrow the selection of a batch to the tuples that match the predicate */
+  void Filter(TupleBatch *batch, Registers *regs) const;
+
+  /**
+   * Evaluate the predicate over groups of a program from CompileAggregate().
+   * @param group_bys the group-by values of each group
+   * @param aggregates the aggregate values of each group
+   * @param num_groups the number of groups
+   * @param regs the registers to evaluate in
+   * @param[out] matches 1 for each group that matches, 0 for each that does not
+   */
+  void MatchGroups(const std::vector<Value> *group_bys, const std::vector<Value> *aggregates, size_t num_groups,
+                   Registers *regs, uint8_t *matches) const;
+
+ private:
+  enum class OpCode : uint8_t {
+    /** Load a column of the tuples into a register, by the type of the column */
+    LoadTinyInt,
+    LoadSmallInt,
+    LoadInteger,
+    LoadBigInt,
+    LoadBoolean,
+    LoadDecimal,
+    LoadVarchar,
+    /** Load a group-by or aggregate term of the groups into a register, by its kind */
+    LoadTermInt,
+    LoadTermDouble,
+    LoadTermString,
+    /** Convert an int register into a double register */
+    IntToDouble,
+    /** Compare two registers of a kind into an int register of 0s and 1s */
+    CompareInt,
+    CompareDouble,
+    CompareString,
+    /** Compare a register with an immediate into an int register of 0s and 1s */
+    CompareIntImmediate,
+    CompareDoubleImmediate,
+    CompareStringImmediate
+  };
+
+  /** The kind of value a register or an immediate holds */
+  enum class Kind : uint8_t { Int, Double, String };
+
+  struct Instruction {
+    OpCode op_;
+    ComparisonType comparison_{ComparisonType::Equal};
+    /** The register written */
+    uint32_t dst_{0};
+    /** The registers read; for a load of a column lhs_ is its offset in the tuple, for a load of a term its index */
+    uint32_t lhs_{0};
+    uint32_t rhs_{0};
+    /** For a load of a term, whether it is a group-by and its type */
+    bool group_by_{false};
+    TypeId type_{TypeId::INVALID};
+    /** The immediate of a comparison with one */
+    int64_t int_immediate_{0};
+    double double_immediate_{0};
+    std::string string_immediate_;
+  };
+
+  /** A compiled operand, a register or an immediate of a kind, and the SQL type of its value */
+  struct Operand {
+    Kind kind_;
+    TypeId type_;
+    bool is_immediate_{false};
+    uint32_t reg_{0};
+    int64_t int_immediate_{0};
+    double double_immediate_{0};
+    std::string string_immediate_;
+  };
+
+  /** What the nodes of a tree compile against */
+  struct CompileContext {
+    const Schema *schema_{nullptr};
+    const std::vector<TypeId> *group_by_types_{nullptr};
+    const std::vector<TypeId> *aggregate_types_{nullptr};
+  };
+
+  ExpressionProgram() = default;
+
+  /** Compile the root of a predicate, which must yield a BOOLEAN register */
+  static std::unique_ptr<ExpressionProgram> CompileRoot(const AbstractExpression *expr,
+                                                        const CompileContext &context);
+
+  /** Compile a node into an operand, false if it does not compile */
+  bool CompileNode(const AbstractExpression *expr, const CompileContext &context, Operand *operand);
+
+  /** Compile a comparison of two operands into a BOOLEAN register, false if they do not compare */
+  bool CompileComparison(ComparisonType comparison, Operand lhs, Operand rhs, Operand *result);
+
+  /** Convert an integer operand into a double one */
+  void ToDouble(Operand *operand);
+
+  /** @return a new register of a kind */
+  uint32_t NewRegister(Kind kind);
+
+  /**
+   * Run the program over at most MAX_LANES rows, read from tuples or from groups, and write whether each matches.
+   */
+  void Run(const Tuple *const *rows, const std::vector<Value> *group_bys, const std::vector<Value> *aggregates,
+           uint32_t num_rows, Registers *regs, uint8_t *matches) const;
+
+  /** Run the program over any number of tuples */
+  void MatchRows(const Tuple *const *rows, size_t num_rows, Registers *regs, uint8_t *matches) const;
+
+  std::vector<Instruction> instructions_;
+  /** The number of registers of each kind */
+  uint32_t num_ints_{0};
+  uint32_t num_doubles_{0};
+  uint32_t num_strings_{0};
+  /** The int register holding the result */
+  uint32_t result_{0};
+};
+
+}  // namespace bustub
@@ -54,6 +54,11 @@ class AggregateValueExpression : public AbstractExpression {
     return is_group_by_term_ ? group_bys[term_idx_] : aggregates[term_idx_];
   }
 
+  /** @return true if this expression is a group-by term, false if it is an aggregate */
+  bool IsGroupByTerm() const { return is_group_by_term_; }
+  /** @return the index of the term in the group-bys or the aggregates */
+  uint32_t GetTermIdx() const { return term_idx_; }
+
  private:
   /** The flag indicating if this expression is a group-by term */
   bool is_group_by_term_;
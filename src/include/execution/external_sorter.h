@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter.h
+//
+// Identification: src/include/execution/external_sorter.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "execution/loser_tree.h"
+#include "storage/table/tmp_tuple_file.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ExternalSorter sorts tuples by a normalized key, a byte string whose memcmp
+ * order is the order of the tuples, e.g. the VarlenKey encoding of the sort
+ * columns. It feeds both SortExecutor and the build of a B+ tree index.
+ *
+ * Every tuple added is kept with its key and the first eight key bytes as a
+ * big-endian integer, so most comparisons are one integer compare. Workers
+ * add concurrently, each to a buffer of its own; a buffer that exceeds its
+ * worker's share of the memory budget is sorted and spilled to a run of
+ * TmpTuplePages. Finish() sorts what is left in the buffers and merges all
+ * runs through a LoserTree. Spilled runs are read back a page at a time, their
+ * keys computed again, and if there are more than MAX_MERGE_FANIN of them the
+ * oldest are first merged into longer runs, so the merge holds only so many
+ * pages of them at once. The pages of a run are deleted once it is read.
+ */
+class ExternalSorter {
+ public:
+  /** Replaces key with the normalized key of tuple */
+  using KeyFunction = std::function<void(const Tuple &tuple, std::string *key)>;
+
+  /** The most spilled runs merged at once */
+  static constexpr size_t MAX_MERGE_FANIN = 32;
+
+  /**
+   * Construct a new, empty ExternalSorter instance.
+   * @param bpm the buffer pool the spilled runs live in
+   * @param memory_budget the bytes of tuples and keys the workers hold in memory together
+   * @param num_workers the number of workers adding tuples, and threads sorting them in Finish()
+   * @param key_of computes the normalized keys, may be called from all workers at once
+   */
+  ExternalSorter(BufferPoolManager *bpm, size_t memory_budget, uint32_t num_workers, KeyFunction key_of);
+
+  DISALLOW_COPY_AND_MOVE(ExternalSorter);
+
+  /**
+   * Add a tuple. Workers may add concurrently, each with its own index. Throws OUT_OF_MEMORY if a run cannot spill.
+   * @param worker the worker adding the tuple, below num_workers
+   * @param tuple the tuple, moved into the sorter
+   */
+  void Add(uint32_t worker, Tuple &&tuple);
+
+  /** Sort the tuples and start the merge, after which no more tuples may be added */
+  void Finish();
+
+  /**
+   * Yield the next tuple in key order, ties in no particular order.
+   * @param[out] tuple the tuple
+   * @return `false` once every tuple was yielded
+   */
+  bool Next(Tuple *tuple);
+
+  /** @return the number of runs spilled so far, including those of the merges in Finish() */
+  size_t NumSpilledRuns() const { return num_spilled_runs_; }
+
+  /** @return the first eight bytes of a normalized key as a big-endian integer, padded with zeros */
+  static uint64_t KeyPrefix(const std::string &key) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+      prefix = prefix << 8 | (i < key.size() ? static_cast<uint8_t>(key[i]) : 0);
+    }
+    return prefix;
+  }
+
+ private:
+  struct Entry {
+    /** The first eight bytes of key_, big-endian and padded with zeros */
+    uint64_t prefix_;
+    std::string key_;
+    Tuple tuple_;
+
+    bool operator<(const Entry &other) const {
+      return prefix_ != other.prefix_ ? prefix_ < other.prefix_ : key_ < other.key_;
+    }
+  };
+
+  /** A sorted run, either all in entries_ or spilled to file_ and read into entries_ a page at a time */
+  struct Run {
+    std::vector<Entry> entries_;
+    /** The position of the head within entries_ */
+    size_t pos_{0};
+    std::unique_ptr<TmpTupleFile> file_;
+    /** The next page of file_ to read */
+    size_t next_page_{0};
+  };
+
+  /** Compares the heads of two runs of a merge */
+  struct HeadLess {
+    const std::vector<Run> *runs_;
+    bool operator()(size_t a, size_t b) const {
+      return (*runs_)[a].entries_[(*runs_)[a].pos_] < (*runs_)[b].entries_[(*runs_)[b].pos_];
+    }
+  };
+
+  /** The tuples one worker added that were not spilled yet */
+  struct alignas(64) Buffer {
+    std::vector<Entry> entries_;
+    size_t bytes_{0};
+  };
+
+  /** @return the entry of a tuple */
+  Entry MakeEntry(Tuple &&tuple) const;
+
+  /** @return the memory an entry takes */
+  static size_t EntryBytes(const Entry &entry) { return sizeof(Entry) + entry.tuple_.GetLength() + entry.key_.size(); }
+
+  /** Sort a buffer and spill it to a new run, leaving it empty */
+  void Spill(Buffer *buffer);
+
+  /** Read the next page of a spilled run, deleting its pages once all are read; false if none is left */
+  bool ReadNextPage(Run *run) const;
+
+  /** Move a run on to its next head, false if it has none left */
+  bool Advance(Run *run) const;
+
+  /** @return a merge over runs, after reading the first page of each spilled one */
+  std::unique_ptr<LoserTree<HeadLess>> StartMerge(std::vector<Run> *runs) const;
+
+  /** Yield the smallest head of a merge over runs, false once all runs are exhausted */
+  bool PopMerge(LoserTree<HeadLess> *merge, std::vector<Run> *runs, Tuple *tuple) const;
+
+  /** @return a spilled run of the merged runs */
+  Run MergeSpilled(std::vector<Run> runs);
+
+  BufferPoolManager *bpm_;
+  size_t worker_budget_;
+  KeyFunction key_of_;
+  std::vector<Buffer> buffers_;
+  /** The runs, latched while workers spill to them */
+  std::mutex runs_latch_;
+  std::vector<Run> runs_;
+  size_t num_spilled_runs_{0};
+  /** The merge of runs_, set by Finish() */
+  std::unique_ptr<LoserTree<HeadLess>> merge_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table.h
+//
+// Identification: src/include/execution/join_hash_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "common/util/hash_util.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** HashJoinKey is a join key value together with its hash */
+struct HashJoinKey {
+  /** The hash of the key, computed along with the rest of its batch */
+  hash_t hash_;
+  /** The join key */
+  Value key_;
+
+  /** @return `true` if both keys are equal, a NULL key equals nothing */
+  bool operator==(const HashJoinKey &other) const { return key_.CompareEquals(other.key_) == CmpBool::CmpTrue; }
+};
+
+/**
+ * JoinHashTable holds the build side of a hash join, radix partitioned so
+ * that each partition fits in a core's L2 cache.
+ *
+ * Building takes two steps. First the workers Add() their tuples, each to a
+ * staging area of its own, without any synchronization. Then Build() picks
+ * the number of partitions, a power of two such that one partition takes
+ * about partition_bytes, and runs two passes on as many threads as there are
+ * workers: each worker scatters its staging area into the partitions by the
+ * top bits of the hashes, every worker writing to slots of its own, and the
+ * workers then take whole partitions from a MorselQueue and chain their
+ * entries into a bucket array indexed by the low bits of the hashes. The
+ * random accesses of the second pass stay within one partition at a time.
+ *
+ * Once built the table is read only, any number of threads probe it at once.
+ * Matches of a key come out in the order they were added by each worker.
+ */
+class JoinHashTable {
+ public:
+  /** The size of a partition unless asked for otherwise, that of a typical L2 cache */
+  static constexpr size_t DEFAULT_PARTITION_BYTES = 256 << 10;
+  /** The most radix bits the table partitions on */
+  static constexpr uint32_t MAX_PARTITION_BITS = 12;
+
+  /**
+   * Construct a new, empty JoinHashTable instance.
+   * @param num_workers the number of workers adding tuples, and threads building the table
+   * @param partition_bytes the memory one partition should take
+   */
+  explicit JoinHashTable(uint32_t num_workers, size_t partition_bytes = DEFAULT_PARTITION_BYTES);
+
+  DISALLOW_COPY_AND_MOVE(JoinHashTable);
+
+  /**
+   * Stage a tuple. Workers may add concurrently, each with its own index.
+   * @param worker the worker adding the tuple, below num_workers
+   * @param key the join key of the tuple, not NULL
+   * @param tuple the tuple, moved into the table
+   */
+  void Add(uint32_t worker, const HashJoinKey &key, Tuple &&tuple);
+
+  /** Partition and index the staged tuples, after which no more tuples may be added */
+  void Build();
+
+  /**
+   * Hand the staged tuples out instead of building the table, e.g. to spill them, leaving the table empty.
+   * @param consumer called with the hash of the key and the tuple of each staged tuple
+   */
+  template <typename Consumer>
+  void TakeStaged(Consumer &&consumer) {
+    for (auto &area : staged_) {
+      for (auto &entry : area.entries_) {
+        consumer(entry.hash_, std::move(entry.tuple_));
+      }
+      area.entries_.clear();
+      area.bytes_ = 0;
+    }
+  }
+
+  /**
+   * Find the next tuple matching a key.
+   * @param key the key looked up
+   * @param after the match to continue after, 0 to start at the first
+   * @return the match, 0 if there is none left
+   */
+  uint32_t FindNext(const HashJoinKey &key, uint32_t after) const;
+
+  /** @return the tuple of a match FindNext() returned for key */
+  const Tuple &GetTuple(const HashJoinKey &key, uint32_t match) const {
+    return partitions_[PartitionOf(key.hash_)].entries_[match - 1].tuple_;
+  }
+
+  /** @return the number of partitions, 0 before Build() */
+  size_t NumPartitions() const { return partitions_.size(); }
+
+  /** @return the number of tuples in the table */
+  size_t Size() const;
+
+  /** @return the memory a tuple takes in the table, including its share of the index */
+  static size_t EntryBytes(const Tuple &tuple) { return sizeof(Entry) + tuple.GetLength() + 2 * sizeof(uint32_t); }
+
+ private:
+  struct Entry {
+    hash_t hash_;
+    Value key_;
+    Tuple tuple_;
+  };
+
+  /** A partition chains its entries per bucket, heads_ and next_ hold entry indexes plus one, 0 ends a chain */
+  struct Partition {
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> heads_;
+    std::vector<uint32_t> next_;
+  };
+
+  /** The tuples one worker added before Build() */
+  struct alignas(64) StagingArea {
+    std::vector<Entry> entries_;
+    size_t bytes_{0};
+  };
+
+  size_t PartitionOf(hash_t hash) const { return partition_bits_ == 0 ? 0 : hash >> (HASH_BITS - partition_bits_); }
+
+  /** Chain the entries of a partition, in reverse so that each chain lists its entries in order */
+  static void IndexPartition(Partition *partition);
+
+  static constexpr uint32_t HASH_BITS = sizeof(hash_t) * 8;
+
+  size_t partition_bytes_;
+  std::vector<StagingArea> staged_;
+  uint32_t partition_bits_{0};
+  std::vector<Partition> partitions_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// loser_tree.h
+//
+// Identification: src/include/execution/loser_tree.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * LoserTree picks the smallest head among a number of sorted sources, e.g.
+ * the runs of a multi-way merge, with one comparison per level of the tree.
+ *
+ * The sources are the leaves of a tournament tree and every inner node keeps
+ * the loser of the match played there, the overall winner sits on top. Once
+ * the winner's source moved on to its next head, Pop() replays only the
+ * matches on the path from its leaf to the top, against the losers stored
+ * there, which is half the comparisons a binary heap needs to sift down.
+ *
+ * The tree does not hold the heads itself: less(a, b) compares the heads of
+ * the sources a and b. An exhausted source loses every match.
+ */
+template <typename Less>
+class LoserTree {
+ public:
+  /** What Top() returns once every source is exhausted */
+  static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  /**
+   * Construct a new LoserTree instance.
+   * @param num_sources the number of sources
+   * @param less compares the heads of two sources that are not exhausted
+   */
+  LoserTree(size_t num_sources, Less less)
+      : num_sources_(num_sources), less_(std::move(less)), tree_(std::max<size_t>(num_sources, 1), NONE) {}
+
+  /**
+   * Play all matches on the current heads of the sources.
+   * @param exhausted whether each source is exhausted, i.e. has no head
+   */
+  void Build(std::vector<bool> exhausted) {
+    BUSTUB_ASSERT(exhausted.size() == num_sources_, "one flag per source");
+    exhausted_ = std::move(exhausted);
+    if (num_sources_ == 0) {
+      return;
+    }
+    // the leaves are the nodes num_sources_ to 2 * num_sources_ - 1, below any number of sources
+    std::vector<size_t> winners(2 * num_sources_);
+    for (size_t source = 0; source < num_sources_; source++) {
+      winners[num_sources_ + source] = source;
+    }
+    for (size_t node = num_sources_ - 1; node >= 1; node--) {
+      const size_t left = winners[2 * node];
+      const size_t right = winners[2 * node + 1];
+      const bool left_wins = Beats(left, right);
+      winners[node] = left_wins ? left : right;
+      tree_[node] = left_wins ? right : left;
+    }
+    tree_[0] = num_sources_ > 1 ? winners[1] : 0;
+  }
+
+  /** @return the source with the smallest head, NONE if all are exhausted */
+  size_t Top() const { return num_sources_ == 0 || exhausted_[tree_[0]] ? NONE : tree_[0]; }
+
+  /**
+   * Replay the matches of the top source after it moved on to its next head.
+   * @param exhausted `true` if the top source has no head left
+   */
+  void Pop(bool exhausted) {
+    size_t winner = tree_[0];
+    exhausted_[winner] = exhausted;
+    for (size_t node = (winner + num_sources_) / 2; node >= 1; node /= 2) {
+      if (Beats(tree_[node], winner)) {
+        std::swap(tree_[node], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+
+ private:
+  /** @return `true` if source a wins over source b, which it does on ties */
+  bool Beats(size_t a, size_t b) const {
+    if (exhausted_[a]) {
+      return false;
+    }
+    return exhausted_[b] || !less_(b, a);
+  }
+
+  size_t num_sources_;
+  Less less_;
+  /** The overall winner, followed by the loser of each inner node */
+  std::vector<size_t> tree_;
+  std::vector<bool> exhausted_;
+};
+
+}  // namespace bustub
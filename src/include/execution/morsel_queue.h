@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// morsel_queue.h
+//
+// Identification: src/include/execution/morsel_queue.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * MorselQueue hands out the work of a parallel operator to its workers in
+ * morsels, consecutive runs of items such as the pages of a table.
+ *
+ * Each worker starts with its own share of the morsels, a contiguous stretch
+ * of the items, and takes them from the front. A worker whose share is used
+ * up steals from the back of another's, so a worker that got cheap morsels,
+ * e.g. pages whose tuples the predicate rejects early, helps out the others
+ * until no morsel is left anywhere.
+ */
+class MorselQueue {
+ public:
+  /** A morsel covers the items [begin_, end_) */
+  struct Morsel {
+    size_t begin_;
+    size_t end_;
+  };
+
+  /**
+   * Split items into morsels and deal them out.
+   * @param num_items the number of items
+   * @param morsel_size the number of items per morsel, only the last morsel may be smaller
+   * @param num_workers the number of workers taking morsels
+   */
+  MorselQueue(size_t num_items, size_t morsel_size, uint32_t num_workers);
+
+  DISALLOW_COPY_AND_MOVE(MorselQueue);
+
+  /**
+   * Take the next morsel for a worker, its own or a stolen one.
+   * @param worker the worker taking it, below num_workers
+   * @param[out] morsel the morsel taken
+   * @return `false` if no morsel is left
+   */
+  bool Next(uint32_t worker, Morsel *morsel);
+
+  /** @return the number of workers */
+  uint32_t NumWorkers() const { return static_cast<uint32_t>(queues_.size()); }
+
+ private:
+  /** The morsels of one worker, on a cache line of its own */
+  struct alignas(64) WorkerQueue {
+    std::mutex latch_;
+    std::deque<Morsel> morsels_;
+  };
+
+  std::vector<WorkerQueue> queues_;
+};
+
+}  // namespace bustub
@@ -22,11 +22,11 @@
 namespace bustub {
 
 /** AggregationType enumerates all the possible aggregation functions in our system */
-enum class AggregationType { CountAggregate, SumAggregate, MinAggregate, MaxAggregate };
+enum class AggregationType { CountAggregate, SumAggregate, MinAggregate, MaxAggregate, AvgAggregate };
 
 /**
  * AggregationPlanNode represents the various SQL aggregation functions.
- * For example, COUNT(), SUM(), MIN() and MAX().
+ * For example, COUNT(), SUM(), MIN(), MAX() and AVG().
  *
  * NOTE: To simplify this project, AggregationPlanNode must always have exactly one child.
  */
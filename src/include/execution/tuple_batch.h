@@ -0,0 +1,149 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_batch.h
+//
+// Identification: src/include/execution/tuple_batch.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TupleBatch is the unit AbstractExecutor::NextBatch() hands out: up to a
+ * fixed number of rows, each a tuple and its RID, plus a selection vector.
+ *
+ * While no selection is active every row is selected. A filter does not move
+ * or free the rows it drops, it only narrows the selection to the indexes of
+ * the rows it keeps, so that a predicate costs one pass over the rows it
+ * reads. Readers go through the selection: Size() is the number of selected
+ * rows and GetTuple(i) the i-th of them.
+ *
+ * Clear() keeps the allocations of both vectors, so a batch that is refilled
+ * over and over allocates only the data of its tuples.
+ */
+class TupleBatch {
+ public:
+  /** The capacity of a batch unless asked for otherwise */
+  static constexpr uint32_t DEFAULT_CAPACITY = 256;
+
+  /**
+   * Construct a new, empty TupleBatch instance.
+   * @param capacity the most rows the batch holds
+   */
+  explicit TupleBatch(uint32_t capacity = DEFAULT_CAPACITY) : capacity_(capacity) {
+    BUSTUB_ASSERT(capacity > 0, "a batch holds at least one row");
+    tuples_.reserve(capacity);
+    rids_.reserve(capacity);
+  }
+
+  DISALLOW_COPY(TupleBatch);
+
+  TupleBatch(TupleBatch &&other) = default;
+  TupleBatch &operator=(TupleBatch &&other) = default;
+
+  /** @return the most rows the batch holds */
+  uint32_t Capacity() const { return capacity_; }
+
+  /** @return the number of rows in the batch, selected or not */
+  uint32_t NumRows() const { return static_cast<uint32_t>(tuples_.size()); }
+
+  /** @return the number of selected rows */
+  uint32_t Size() const { return selection_active_ ? static_cast<uint32_t>(selection_.size()) : NumRows(); }
+
+  /** @return `true` if no row is selected */
+  bool Empty() const { return Size() == 0; }
+
+  /** @return `true` if no more rows fit */
+  bool IsFull() const { return NumRows() >= capacity_; }
+
+  /** Drop all rows and the selection */
+  void Clear() {
+    tuples_.clear();
+    rids_.clear();
+    selection_.clear();
+    selection_active_ = false;
+  }
+
+  /** Add a row, which is selected */
+  void Append(Tuple &&tuple, RID rid) {
+    BUSTUB_ASSERT(!IsFull(), "batch is full");
+    if (selection_active_) {
+      selection_.push_back(NumRows());
+    }
+    tuples_.push_back(std::move(tuple));
+    rids_.push_back(rid);
+  }
+
+  /** Add a copy of a row, which is selected */
+  void Append(const Tuple &tuple, RID rid) { Append(Tuple(tuple), rid); }
+
+  /** @return the row index of the i-th selected row */
+  uint32_t RowOf(uint32_t i) const { return selection_active_ ? selection_[i] : i; }
+
+  /** @return the tuple of the i-th selected row */
+  const Tuple &GetTuple(uint32_t i) const { return tuples_[RowOf(i)]; }
+
+  /** @return the tuple of the i-th selected row, e.g. to move it out or to replace it with its projection */
+  Tuple *MutableTuple(uint32_t i) { return &tuples_[RowOf(i)]; }
+
+  /** @return the RID of the i-th selected row */
+  RID GetRid(uint32_t i) const { return rids_[RowOf(i)]; }
+
+  /**
+   * Narrow the selection to the selected rows pred accepts.
+   * @param pred called with the tuple of each selected row, in order
+   */
+  template <typename Predicate>
+  void Filter(Predicate &&pred) {
+    if (!selection_active_) {
+      selection_.clear();
+      for (uint32_t row = 0; row < NumRows(); row++) {
+        if (pred(tuples_[row])) {
+          selection_.push_back(row);
+        }
+      }
+      selection_active_ = true;
+      return;
+    }
+    auto kept = std::remove_if(selection_.begin(), selection_.end(),
+                               [this, &pred](uint32_t row) { return !pred(tuples_[row]); });
+    selection_.erase(kept, selection_.end());
+  }
+
+  /** Keep only the first n selected rows selected */
+  void Truncate(uint32_t n) {
+    if (n >= Size()) {
+      return;
+    }
+    if (!selection_active_) {
+      tuples_.resize(n);
+      rids_.resize(n);
+      return;
+    }
+    selection_.resize(n);
+  }
+
+ private:
+  uint32_t capacity_;
+  std::vector<Tuple> tuples_;
+  std::vector<RID> rids_;
+  // the selected row indexes in increasing order, only meaningful while selection_active_
+  std::vector<uint32_t> selection_;
+  bool selection_active_{false};
+};
+
+}  // namespace bustub
@@ -10,14 +10,18 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <memory>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
+#include "storage/index/range_scan_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
@@ -28,7 +32,8 @@ namespace bustub {
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique by default; a tree built with unique_keys = false keeps
+ *     every value of a duplicate key in a posting list behind its leaf entry
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
@@ -39,8 +44,13 @@ class BPlusTree {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  /**
+   * @param header_page_id the header page recording this tree's root page id, INVALID_PAGE_ID to keep it in memory only
+   * @param unique_keys reject a second value for an existing key, otherwise collect the values in a posting list
+   */
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     page_id_t header_page_id = HEADER_PAGE_ID, bool unique_keys = true);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -51,14 +61,26 @@ class BPlusTree {
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove one value of a key, the key itself goes once its last value is removed.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // return the values associated with a given key
   bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
 
+  // look up a batch of keys sorted in ascending order, (*result)[i] receives the values of keys[i];
+  // returns the number of keys found
+  size_t GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *result,
+                   Transaction *transaction = nullptr);
+
   // index iterator
   INDEXITERATOR_TYPE Begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
   INDEXITERATOR_TYPE End();
 
+  // scan the values of keys in [low, high) in key order, one leaf per batch;
+  // a null bound leaves that side of the range open
+  std::unique_ptr<RANGESCAN_TYPE> RangeScan(const KeyType *low, const KeyType *high, bool high_inclusive = false);
+
   void Print(BufferPoolManager *bpm) {
     ToString(reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(root_page_id_)->GetData()), bpm);
   }
@@ -80,6 +102,24 @@ class BPlusTree {
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
  private:
+  enum class Operation { SEARCH, INSERT, DELETE };
+
+  // descend to a leaf holding only read latches, returns the leaf read latched or nullptr for an empty tree
+  Page *FindLeafPageRead(const KeyType &key, bool left_most);
+
+  // like FindLeafPageRead, but the leaf's parent (nullptr if the leaf is the root) is kept read latched in *parent,
+  // and *parent_upper / *parent_bounded receive the separator bounding the parent's subtree from above
+  Page *FindLeafAndParentRead(const KeyType &key, Page **parent, KeyType *parent_upper, bool *parent_bounded);
+
+  // descend to a leaf crabbing write latches, latched pages stay in the transaction page set
+  Page *FindLeafPageWrite(const KeyType &key, Operation op, Transaction *transaction);
+
+  // true if an insert or delete in node cannot propagate to its parent
+  bool IsSafe(BPlusTreePage *node, Operation op) const;
+
+  // release every latch in the transaction page set and drop the pages it deleted
+  void ReleaseWriteLatches(Transaction *transaction, bool is_dirty);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
@@ -116,6 +156,10 @@ class BPlusTree {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  page_id_t header_page_id_;
+  bool unique_keys_;
+  // protects root_page_id_, held until the root is known not to change
+  ReaderWriterLatch root_latch_;
 };
 
 }  // namespace bustub
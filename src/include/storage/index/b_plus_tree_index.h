@@ -23,6 +23,20 @@ namespace bustub {
 
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
+/**
+ * Adapts a B+ tree range scan to the IndexRangeScan interface.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeIndexRangeScan : public IndexRangeScan {
+ public:
+  explicit BPlusTreeIndexRangeScan(std::unique_ptr<RANGESCAN_TYPE> &&iterator) : iterator_(std::move(iterator)) {}
+
+  bool NextBatch(std::vector<RID> *result) override { return iterator_->NextBatch(result); }
+
+ private:
+  std::unique_ptr<RANGESCAN_TYPE> iterator_;
+};
+
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
@@ -34,6 +48,12 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                Transaction *transaction) override;
+
+  std::unique_ptr<IndexRangeScan> ScanRange(const Tuple *low_key, const Tuple *high_key, bool high_inclusive,
+                                            Transaction *transaction) override;
+
   INDEXITERATOR_TYPE GetBeginIterator();
 
   INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key);
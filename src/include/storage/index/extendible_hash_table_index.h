@@ -39,6 +39,12 @@ class ExtendibleHashTableIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                Transaction *transaction) override;
+
+  /** @return how well the bucket Bloom filters answer scans of absent keys */
+  BloomFilterStats GetBloomFilterStats() { return container_.GetBloomFilterStats(); }
+
  protected:
   // comparator for key
   KeyComparator comparator_;
@@ -35,6 +35,9 @@ class GenericKey {
     memcpy(data_, tuple.GetData(), tuple.GetLength());
   }
 
+  // the raw tuple bytes are compared column by column through the key schema, so no encoding is needed here
+  inline void SetFromKey(const Tuple &tuple, const Schema & /*key_schema*/) { SetFromKey(tuple); }
+
   // NOTE: for test purpose only
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
@@ -96,6 +96,28 @@ class IndexMetadata {
   Schema *key_schema_;
 };
 
+/////////////////////////////////////////////////////////////////////
+// IndexRangeScan class definition
+/////////////////////////////////////////////////////////////////////
+
+/**
+ * class IndexRangeScan - Cursor over the RIDs of an ordered index range
+ *
+ * Returned by Index::ScanRange. RIDs come out in key order, one batch
+ * (typically one leaf page) at a time.
+ */
+class IndexRangeScan {
+ public:
+  virtual ~IndexRangeScan() = default;
+
+  /**
+   * Append the next batch of RIDs in range to result.
+   * @param result The collection of RIDs that the batch is appended to
+   * @return false once the range is exhausted and nothing was appended
+   */
+  virtual bool NextBatch(std::vector<RID> *result) = 0;
+};
+
 /////////////////////////////////////////////////////////////////////
 // Index class definition
 /////////////////////////////////////////////////////////////////////
@@ -175,6 +197,35 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for a batch of keys, given in any order.
+   * Ordered indexes answer the whole batch in one sorted pass over the leaves.
+   * @param keys The index keys
+   * @param result On return, (*result)[i] holds the RIDs found for keys[i]
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                        Transaction *transaction) {
+    result->assign(keys.size(), std::vector<RID>{});
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*result)[i], transaction);
+    }
+  }
+
+  /**
+   * Scan the index for all keys in [low_key, high_key) in key order.
+   * Only ordered indexes support range scans.
+   * @param low_key The inclusive lower bound, nullptr to start at the smallest key
+   * @param high_key The upper bound, nullptr to scan to the largest key
+   * @param high_inclusive Treat high_key as an inclusive bound
+   * @param transaction The transaction context
+   * @return A cursor over the matching RIDs, nullptr if the index is unordered
+   */
+  virtual std::unique_ptr<IndexRangeScan> ScanRange(const Tuple *low_key, const Tuple *high_key, bool high_inclusive,
+                                                    Transaction *transaction) {
+    return nullptr;
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
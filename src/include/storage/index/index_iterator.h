@@ -13,17 +13,34 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <vector>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * Iterates over the key & value pairs of the leaf level in key order.
+ *
+ * The iterator keeps its current leaf pinned but only latches it while
+ * reading, so it never holds a latch between calls. A default constructed
+ * iterator is the end iterator. A key with a posting list is visited once per
+ * value, the list is decoded when the iterator first reaches the key.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
   IndexIterator();
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index);
+  IndexIterator(IndexIterator &&other) noexcept;
+  IndexIterator &operator=(IndexIterator &&other) noexcept;
+  IndexIterator(const IndexIterator &) = delete;
+  IndexIterator &operator=(const IndexIterator &) = delete;
   ~IndexIterator();
 
   bool IsEnd();
@@ -32,12 +49,26 @@ class IndexIterator {
 
   IndexIterator &operator++();
 
-  bool operator==(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator==(const IndexIterator &itr) const {
+    return page_ == itr.page_ && index_ == itr.index_ && posting_index_ == itr.posting_index_;
+  }
 
-  bool operator!=(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator!=(const IndexIterator &itr) const { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  // step to the next leaf while the current one is exhausted
+  void SkipExhaustedLeaves();
+
+  // copy the current entry into current_, decoding its posting list on first visit
+  void LoadCurrent();
+
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  Page *page_{nullptr};
+  int index_{0};
+  // values of the current key if it has a posting list, and the position within them
+  std::vector<ValueType> postings_;
+  size_t posting_index_{0};
+  MappingType current_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// integer_key.h
+//
+// Identification: src/include/storage/index/integer_key.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#include "catalog/schema.h"
+#include "common/macros.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * @return the number of bytes needed to hold a normalized IntegerKey for key_schema,
+ * or 0 if some key column is not a fixed-width integer type
+ */
+inline size_t IntegerKeySize(const Schema &key_schema) {
+  size_t size = 0;
+  for (const auto &col : key_schema.GetColumns()) {
+    switch (col.GetType()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT:
+      case TypeId::TIMESTAMP:
+        size += Type::GetTypeSize(col.GetType());
+        break;
+      default:
+        return 0;
+    }
+  }
+  return size;
+}
+
+/**
+ * Integer key is used for indexing on fixed-width integer columns.
+ *
+ * Every key column is stored big-endian with its sign bit flipped and the
+ * columns are concatenated in key order, so comparing two keys byte by byte
+ * gives the same order as comparing their column values one at a time.
+ * Unused trailing bytes are zero. This lets IntegerComparator compare keys
+ * with a few word compares instead of deserializing each column into a Value.
+ */
+template <size_t KeySize>
+class IntegerKey {
+  static_assert(KeySize == 4 || KeySize % 8 == 0, "IntegerKey is compared in 4 or 8 byte words");
+
+ public:
+  inline void SetFromKey(const Tuple &tuple, const Schema &key_schema) {
+    memset(data_, 0, KeySize);
+    size_t offset = 0;
+    for (const auto &col : key_schema.GetColumns()) {
+      const char *src = tuple.GetData() + col.GetOffset();
+      switch (col.GetType()) {
+        case TypeId::BOOLEAN:
+        case TypeId::TINYINT:
+          offset = Put(offset, Load<int8_t>(src));
+          break;
+        case TypeId::SMALLINT:
+          offset = Put(offset, Load<int16_t>(src));
+          break;
+        case TypeId::INTEGER:
+          offset = Put(offset, Load<int32_t>(src));
+          break;
+        case TypeId::BIGINT:
+          offset = Put(offset, Load<int64_t>(src));
+          break;
+        case TypeId::TIMESTAMP:
+          offset = Put(offset, Load<uint64_t>(src));
+          break;
+        default:
+          UNREACHABLE("IntegerKey only holds fixed-width integer columns");
+      }
+    }
+  }
+
+  // NOTE: for test purpose only
+  // encodes key as a single INTEGER column for IntegerKey<4>, a single BIGINT column otherwise
+  inline void SetFromInteger(int64_t key) {
+    memset(data_, 0, KeySize);
+    if constexpr (KeySize == 4) {
+      Put(0, static_cast<int32_t>(key));
+    } else {
+      Put(0, key);
+    }
+  }
+
+  // NOTE: for test purpose only
+  // decodes the value written by SetFromInteger
+  inline int64_t ToString() const {
+    if constexpr (KeySize == 4) {
+      return static_cast<int32_t>(static_cast<uint32_t>(LoadWord<uint32_t>(0) ^ (1U << 31)));
+    } else {
+      return static_cast<int64_t>(LoadWord<uint64_t>(0) ^ (1ULL << 63));
+    }
+  }
+
+  // NOTE: for test purpose only
+  friend std::ostream &operator<<(std::ostream &os, const IntegerKey &key) {
+    os << key.ToString();
+    return os;
+  }
+
+  /** @return the big-endian word of type T starting at offset, as an unsigned integer */
+  template <typename T>
+  inline T LoadWord(size_t offset) const {
+    T word;
+    memcpy(&word, data_ + offset, sizeof(T));
+    if constexpr (sizeof(T) == 4) {
+      return __builtin_bswap32(word);
+    } else {
+      return __builtin_bswap64(word);
+    }
+  }
+
+  // normalized key bytes
+  char data_[KeySize];
+
+ private:
+  template <typename T>
+  static inline T Load(const char *src) {
+    T value;
+    memcpy(&value, src, sizeof(T));
+    return value;
+  }
+
+  /** Append value big-endian with its sign bit flipped, return the offset past it */
+  template <typename T>
+  inline size_t Put(size_t offset, T value) {
+    using U = std::make_unsigned_t<T>;
+    auto bits = static_cast<U>(value);
+    if constexpr (std::is_signed_v<T>) {
+      bits ^= static_cast<U>(U{1} << (sizeof(T) * 8 - 1));
+    }
+    for (size_t i = 0; i < sizeof(T); i++) {
+      data_[offset + i] = static_cast<char>(bits >> (8 * (sizeof(T) - 1 - i)));
+    }
+    return offset + sizeof(T);
+  }
+};
+
+/**
+ * Function object return is > 0 if lhs > rhs, < 0 if lhs < rhs,
+ * = 0 if lhs = rhs. Compares normalized keys word by word without
+ * looking at the key schema.
+ */
+template <size_t KeySize>
+class IntegerComparator {
+ public:
+  inline int operator()(const IntegerKey<KeySize> &lhs, const IntegerKey<KeySize> &rhs) const {
+    if constexpr (KeySize == 4) {
+      auto l = lhs.template LoadWord<uint32_t>(0);
+      auto r = rhs.template LoadWord<uint32_t>(0);
+      return static_cast<int>(l > r) - static_cast<int>(l < r);
+    } else {
+      for (size_t i = 0; i < KeySize; i += 8) {
+        auto l = lhs.template LoadWord<uint64_t>(i);
+        auto r = rhs.template LoadWord<uint64_t>(i);
+        if (l != r) {
+          return static_cast<int>(l > r) - static_cast<int>(l < r);
+        }
+      }
+      return 0;
+    }
+  }
+
+  IntegerComparator() = default;
+
+  // the key schema is baked into the key encoding; accepted for parity with GenericComparator
+  explicit IntegerComparator(Schema * /*key_schema*/) {}
+};
+
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// range_scan_iterator.h
+//
+// Identification: src/include/storage/index/range_scan_iterator.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <future>  // NOLINT
+#include <vector>
+
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
+
+namespace bustub {
+
+#define RANGESCAN_TYPE RangeScanIterator<KeyType, ValueType, KeyComparator>
+
+/**
+ * RangeScanIterator hands out the values of all keys in [low, high) in key
+ * order, one leaf worth of values per NextBatch() call.
+ *
+ * While a leaf is being copied out, the next leaf on the sibling chain is
+ * already being fetched through the buffer pool on a helper thread, so the
+ * disk read of leaf i+1 overlaps with consuming leaf i. The prefetch is only
+ * issued when the range extends past the current leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class RangeScanIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
+ public:
+  /**
+   * @param buffer_pool_manager the buffer pool holding the tree
+   * @param comparator the key comparator of the tree
+   * @param page the pinned, unlatched leaf page holding the first candidate key, nullptr for an empty range
+   * @param index the slot of the first candidate key in page
+   * @param high the exclusive upper bound, nullptr to scan to the end of the tree
+   * @param high_inclusive treat high as an inclusive bound
+   */
+  RangeScanIterator(BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator, Page *page, int index,
+                    const KeyType *high, bool high_inclusive = false);
+  RangeScanIterator(const RangeScanIterator &) = delete;
+  RangeScanIterator &operator=(const RangeScanIterator &) = delete;
+  ~RangeScanIterator();
+
+  /**
+   * Append the values of the next run of keys in range to result.
+   * @return false once the range is exhausted and nothing was appended
+   */
+  bool NextBatch(std::vector<ValueType> *result);
+
+ private:
+  /** @return true if key lies past the upper bound */
+  bool PastHigh(const KeyType &key) const;
+
+  /** Unpin the current leaf and move to the prefetched (or freshly fetched) next leaf */
+  void AdvanceLeaf(page_id_t next_page_id);
+
+  /** Unpin everything this scan still holds */
+  void Finish();
+
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  Page *page_;
+  int index_;
+  KeyType high_{};
+  bool has_high_;
+  bool high_inclusive_;
+  std::future<Page *> prefetch_;
+};
+
+}  // namespace bustub
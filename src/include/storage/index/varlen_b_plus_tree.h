@@ -0,0 +1,130 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_b_plus_tree.h
+//
+// Identification: src/include/storage/index/varlen_b_plus_tree.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
+#include "concurrency/transaction.h"
+#include "storage/page/b_plus_tree_posting_page.h"
+#include "storage/page/b_plus_tree_varlen_page.h"
+
+namespace bustub {
+
+/**
+ * Scans the RIDs of a key range of a VarlenBPlusTree one leaf at a time,
+ * prefetching the next leaf like RangeScanIterator.
+ */
+class VarlenRangeScan {
+ public:
+  VarlenRangeScan(BufferPoolManager *buffer_pool_manager, Page *page, int index, const std::string_view *high,
+                  bool high_inclusive);
+  VarlenRangeScan(const VarlenRangeScan &) = delete;
+  VarlenRangeScan &operator=(const VarlenRangeScan &) = delete;
+  ~VarlenRangeScan();
+
+  /** Append the RIDs of the next leaf in range to result, return false once the range is exhausted */
+  bool NextBatch(std::vector<RID> *result);
+
+ private:
+  bool PastHigh(std::string_view key) const;
+  void AdvanceLeaf(page_id_t next_page_id);
+  void Finish();
+
+  BufferPoolManager *buffer_pool_manager_;
+  // current leaf, pinned but not latched between batches
+  Page *page_;
+  int index_;
+  std::string high_;
+  bool has_high_;
+  bool high_inclusive_;
+  std::future<Page *> prefetch_;
+};
+
+/**
+ * B+ tree over variable-length byte-string keys, such as the ones made by
+ * VarlenKey, mapping each key to RIDs.
+ *
+ * Pages are slotted (see BPlusTreeVarlenPage), so a page holds as many keys as
+ * their actual lengths allow instead of a fixed count of padded keys. Leaf
+ * splits push up the shortest prefix of the new right leaf's first key that
+ * still sorts above the left leaf's last key, which keeps internal pages dense
+ * on keys sharing long prefixes. Keys may be up to MAX_KEY_SIZE bytes.
+ *
+ * Concurrency follows BPlusTree: readers crab read latches, writers crab write
+ * latches and release ancestors once a node has room for any entry. Removing
+ * never merges pages; an emptied leaf stays in the leaf chain until keys land
+ * in it again.
+ */
+class VarlenBPlusTree {
+ public:
+  /** Longest key the tree accepts, in bytes */
+  static constexpr size_t MAX_KEY_SIZE = PAGE_SIZE / 8;
+
+  /** @param unique_keys reject a second RID for an existing key, otherwise collect the RIDs in a posting list */
+  VarlenBPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, bool unique_keys = true);
+
+  bool IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID; }
+
+  /**
+   * Insert a key and RID pair.
+   * @return false if the pair (or the key, for unique keys) is already present
+   */
+  bool Insert(std::string_view key, const RID &rid, Transaction *transaction = nullptr);
+
+  // Remove a key and all of its RIDs.
+  void Remove(std::string_view key, Transaction *transaction = nullptr);
+
+  // Remove one RID of a key, the key itself goes once its last RID is removed.
+  void Remove(std::string_view key, const RID &rid, Transaction *transaction = nullptr);
+
+  // append the RIDs of key to result, return true if the key exists
+  bool GetValue(std::string_view key, std::vector<RID> *result, Transaction *transaction = nullptr);
+
+  // scan the RIDs of keys in [low, high) in key order, a null bound leaves that side of the range open
+  std::unique_ptr<VarlenRangeScan> RangeScan(const std::string_view *low, const std::string_view *high,
+                                             bool high_inclusive = false);
+
+ private:
+  // descend to the leaf covering key (or the leftmost leaf) holding only read latches, nullptr for an empty tree
+  Page *FindLeafPageRead(std::string_view key, bool left_most);
+
+  // descend to the leaf covering key crabbing write latches, latched pages stay in the transaction page set;
+  // with for_insert false no page can change shape, so only the leaf stays latched
+  Page *FindLeafPageWrite(std::string_view key, bool for_insert, Transaction *transaction);
+
+  void ReleaseWriteLatches(Transaction *transaction, bool is_dirty);
+
+  void StartNewTree(std::string_view key, const RID &rid);
+
+  BPlusTreeVarlenPage *NewNode(IndexPageType page_type);
+
+  // after the page old_page_id at position depth of the transaction page set split, insert separator for
+  // new_page_id into its parent, splitting upwards as needed
+  void InsertIntoParent(size_t depth, page_id_t old_page_id, const std::string &separator, page_id_t new_page_id,
+                        Transaction *transaction);
+
+  std::string index_name_;
+  page_id_t root_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  bool unique_keys_;
+  // protects root_page_id_, held until the root is known not to change
+  ReaderWriterLatch root_latch_;
+};
+
+}  // namespace bustub
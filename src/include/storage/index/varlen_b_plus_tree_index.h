@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_b_plus_tree_index.h
+//
+// Identification: src/include/storage/index/varlen_b_plus_tree_index.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "storage/index/index.h"
+#include "storage/index/varlen_b_plus_tree.h"
+#include "storage/index/varlen_key.h"
+
+namespace bustub {
+
+/**
+ * Adapts a varlen B+ tree range scan to the IndexRangeScan interface.
+ */
+class VarlenBPlusTreeIndexRangeScan : public IndexRangeScan {
+ public:
+  explicit VarlenBPlusTreeIndexRangeScan(std::unique_ptr<VarlenRangeScan> &&iterator)
+      : iterator_(std::move(iterator)) {}
+
+  bool NextBatch(std::vector<RID> *result) override { return iterator_->NextBatch(result); }
+
+ private:
+  std::unique_ptr<VarlenRangeScan> iterator_;
+};
+
+/**
+ * B+ tree index over keys of any column types, stored as VarlenKey encodings
+ * in a VarlenBPlusTree. Used for keys with VARCHAR columns, which a fixed-size
+ * GenericKey would have to pad to the longest possible value.
+ */
+class VarlenBPlusTreeIndex : public Index {
+ public:
+  VarlenBPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+
+  void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  std::unique_ptr<IndexRangeScan> ScanRange(const Tuple *low_key, const Tuple *high_key, bool high_inclusive,
+                                            Transaction *transaction) override;
+
+ protected:
+  // container
+  VarlenBPlusTree container_;
+};
+
+}  // namespace bustub
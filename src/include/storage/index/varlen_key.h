@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_key.h
+//
+// Identification: src/include/storage/index/varlen_key.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "catalog/schema.h"
+#include "common/macros.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** @return true if some key column is a VARCHAR, which fixed-size keys can only hold padded */
+inline bool HasVarlenColumn(const Schema &key_schema) {
+  for (const auto &col : key_schema.GetColumns()) {
+    if (col.GetType() == TypeId::VARCHAR) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Encodes index keys of any column types into byte strings whose memcmp order
+ * matches the column-by-column order of the key values, so variable-length
+ * keys can be stored and compared without the key schema.
+ *
+ * Each column starts with a marker byte, 0 for NULL (which sorts first) and 1
+ * otherwise. Integers follow big-endian with the sign bit flipped, decimals
+ * with the sign bit flipped for positive values and every bit flipped for
+ * negative ones, and VARCHARs as their bytes up to the first NUL followed by a
+ * NUL terminator, so a string sorts before every string it is a prefix of.
+ */
+class VarlenKey {
+ public:
+  /** Replace out with the encoding of the key columns of tuple */
+  static void Encode(const Tuple &tuple, const Schema &key_schema, std::string *out) {
+    out->clear();
+    for (uint32_t i = 0; i < key_schema.GetColumnCount(); i++) {
+      EncodeValue(tuple.GetValue(&key_schema, i), out);
+    }
+  }
+
+  /** Append the encoding of one column value to out */
+  static void EncodeValue(const Value &value, std::string *out) {
+    if (value.IsNull()) {
+      out->push_back('\0');
+      return;
+    }
+    out->push_back('\1');
+    switch (value.GetTypeId()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        Put(out, value.GetAs<int8_t>());
+        break;
+      case TypeId::SMALLINT:
+        Put(out, value.GetAs<int16_t>());
+        break;
+      case TypeId::INTEGER:
+        Put(out, value.GetAs<int32_t>());
+        break;
+      case TypeId::BIGINT:
+        Put(out, value.GetAs<int64_t>());
+        break;
+      case TypeId::TIMESTAMP:
+        Put(out, value.GetAs<uint64_t>());
+        break;
+      case TypeId::DECIMAL: {
+        uint64_t bits;
+        const double decimal = value.GetAs<double>();
+        memcpy(&bits, &decimal, sizeof(bits));
+        // negative values sort in reverse magnitude order
+        Put(out, (bits >> 63) != 0 ? ~bits : bits | (1ULL << 63));
+        break;
+      }
+      case TypeId::VARCHAR:
+        out->append(value.GetData(), strnlen(value.GetData(), value.GetLength()));
+        out->push_back('\0');
+        break;
+      default:
+        UNREACHABLE("cannot index column type");
+    }
+  }
+
+ private:
+  /** Append value big-endian, with its sign bit flipped if T is signed */
+  template <typename T>
+  static void Put(std::string *out, T value) {
+    using U = std::make_unsigned_t<T>;
+    auto bits = static_cast<U>(value);
+    if constexpr (std::is_signed_v<T>) {
+      bits ^= static_cast<U>(U{1} << (sizeof(T) * 8 - 1));
+    }
+    for (size_t i = 0; i < sizeof(T); i++) {
+      out->push_back(static_cast<char>(bits >> (8 * (sizeof(T) - 1 - i))));
+    }
+  }
+};
+
+}  // namespace bustub
@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_posting_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+#define POSTING_PAGE_HEADER_SIZE 20
+
+/**
+ * Posting page holds (part of) the RID list of a single key in a B+ tree that
+ * allows duplicate keys.
+ *
+ * A leaf entry stores its only RID inline. Once a second RID arrives, the
+ * entry's value is replaced by a posting reference (see MakeRef) naming the
+ * head of a chain of posting pages. RIDs are sorted across the chain, and each
+ * page stores its share delta-encoded as varints: a RID on the same table page
+ * as its predecessor costs varint(slot delta << 1), otherwise
+ * varint(page delta << 1 | 1) followed by varint(slot). Rows inserted in heap
+ * order therefore take one or two bytes each instead of eight.
+ *
+ * All posting pages of a key are protected by the latch of the leaf holding
+ * the key; they are never latched themselves.
+ *
+ * Posting page format:
+ *  -------------------------------------------------------------------------------------------------
+ * | LastPageId (4) | LastSlotNum (4) | NextPageId (4) | Count (4) | Bytes (4) | ENCODED RIDS ... |
+ *  -------------------------------------------------------------------------------------------------
+ */
+class BPlusTreePostingPage {
+ public:
+  /** @return true if a leaf value is a posting reference rather than an inline RID */
+  static bool IsRef(const RID &value) { return value.GetSlotNum() == REF_SLOT; }
+
+  /** @return the leaf value referring to the posting chain starting at head_page_id */
+  static RID MakeRef(page_id_t head_page_id) { return RID(head_page_id, REF_SLOT); }
+
+  /**
+   * Add rid to the RIDs behind a leaf value, turning an inline RID into a posting chain if needed.
+   * @param[in,out] value the leaf value, updated when it changes representation
+   * @return false if rid is already present
+   */
+  static bool Insert(BufferPoolManager *buffer_pool_manager, RID *value, const RID &rid);
+
+  /**
+   * Remove rid from the RIDs behind a leaf value. A chain left with a single RID is folded back inline.
+   * @param[in,out] value the leaf value, updated when it changes representation
+   * @param[out] now_empty set to true if no RID is left and the leaf entry should be removed
+   * @return false if rid is not present
+   */
+  static bool Remove(BufferPoolManager *buffer_pool_manager, RID *value, const RID &rid, bool *now_empty);
+
+  /** Append every RID behind a leaf value to result, in RID order */
+  static void Collect(BufferPoolManager *buffer_pool_manager, const RID &value, std::vector<RID> *result);
+
+  /** Delete the posting chain behind a leaf value, if any */
+  static void Free(BufferPoolManager *buffer_pool_manager, const RID &value);
+
+  // page level helpers
+  void Init();
+  page_id_t GetNextPageId() const { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+  int GetCount() const { return count_; }
+  RID GetLastRid() const { return RID(last_page_id_, last_slot_num_); }
+
+  /** Append the RIDs stored on this page to result */
+  void Decode(std::vector<RID> *result) const;
+
+  /** Replace the contents of this page with count sorted RIDs, which must fit */
+  void Encode(const RID *rids, int count);
+
+  /** Append a RID sorting after every RID on this page, return false if it does not fit */
+  bool Append(const RID &rid);
+
+  /** @return the number of bytes needed to encode count sorted RIDs */
+  static size_t EncodedSize(const RID *rids, int count);
+
+  /** Bytes available for encoded RIDs on one page */
+  static constexpr size_t CAPACITY = PAGE_SIZE - POSTING_PAGE_HEADER_SIZE;
+
+ private:
+  /** Slot number marking a posting reference, table pages never hand out this slot */
+  static constexpr uint32_t REF_SLOT = UINT32_MAX;
+
+  /** Store rids into a fresh page, return the pinned page */
+  static BPlusTreePostingPage *NewPostingPage(BufferPoolManager *buffer_pool_manager, const RID *rids, int count,
+                                              page_id_t *page_id);
+
+  static BPlusTreePostingPage *FetchPostingPage(BufferPoolManager *buffer_pool_manager, page_id_t page_id);
+
+  page_id_t last_page_id_;
+  uint32_t last_slot_num_;
+  page_id_t next_page_id_;
+  int32_t count_;
+  int32_t bytes_;
+  uint8_t data_[0];
+};
+
+static_assert(sizeof(BPlusTreePostingPage) == POSTING_PAGE_HEADER_SIZE, "posting page header size mismatch");
+
+}  // namespace bustub
@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varlen_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_varlen_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define VARLEN_PAGE_HEADER_SIZE 28
+#define VARLEN_PAGE_SLOT_SIZE 4
+
+/**
+ * Slotted page of a B+ tree over variable-length byte-string keys, used as
+ * both leaf and internal page.
+ *
+ * A slot array grows from the header towards the end of the page and an entry
+ * heap grows from the end of the page towards the slots. Slots are kept in key
+ * order and each names the offset and key length of one heap entry: the key
+ * bytes followed by a RID in a leaf, or by a child page id in an internal page.
+ * Keys compare as unsigned bytes. The key of an internal page's first slot is
+ * empty and never looked at, as in BPlusTreeInternalPage.
+ *
+ * Removing an entry only drops its slot and counts its bytes as garbage; the
+ * heap is compacted once an insert needs that space back.
+ *
+ * Page format:
+ *  ------------------------------------------------------------------------
+ * | HEADER | SLOT(1) | SLOT(2) | ... | SLOT(n) | FREE | ... | KEY + VALUE |
+ *  ------------------------------------------------------------------------
+ *
+ * Header format (size in byte, 28 bytes in total):
+ *  -------------------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | HeapStart (4) | PageId (4) |
+ *  -------------------------------------------------------------------------------
+ * | NextPageId (4) | GarbageBytes (4) |
+ *  ------------------------------------
+ */
+class BPlusTreeVarlenPage {
+ public:
+  /** After creating a new page from the buffer pool, must call Init to set default values */
+  void Init(page_id_t page_id, IndexPageType page_type);
+
+  bool IsLeafPage() const { return page_type_ == IndexPageType::LEAF_PAGE; }
+  int GetSize() const { return size_; }
+  page_id_t GetPageId() const { return page_id_; }
+  page_id_t GetNextPageId() const { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  std::string_view KeyAt(int index) const;
+  RID RidAt(int index) const;
+  void SetRidAt(int index, const RID &rid);
+  page_id_t ChildAt(int index) const;
+
+  /** @return the first index whose key is >= key, GetSize() if there is none */
+  int KeyIndex(std::string_view key) const;
+
+  /** @return the index of the child of an internal page whose subtree covers key */
+  int ChildIndex(std::string_view key) const;
+
+  /** @return the index of the slot pointing at child_page_id, -1 if there is none */
+  int ChildIndexOf(page_id_t child_page_id) const;
+
+  /** @return true if an entry with a key of key_size bytes fits, after compaction if need be */
+  bool HasRoomFor(size_t key_size) const;
+
+  /** Insert an entry at index in a leaf page, HasRoomFor(key.size()) must hold */
+  void InsertRid(int index, std::string_view key, const RID &rid);
+
+  /** Insert an entry at index in an internal page, HasRoomFor(key.size()) must hold */
+  void InsertChild(int index, std::string_view key, page_id_t child_page_id);
+
+  void RemoveAt(int index);
+
+  /**
+   * Move the upper half of the entries, by bytes, to the empty page recipient.
+   * @return the key of the first entry moved; in an internal page it becomes the separator for recipient and
+   * recipient's first key is emptied
+   */
+  std::string MoveHalfTo(BPlusTreeVarlenPage *recipient);
+
+  /** Turn this internal page into a root with two children */
+  void PopulateNewRoot(page_id_t old_page_id, std::string_view key, page_id_t new_page_id);
+
+ private:
+  struct Slot {
+    uint16_t offset_;
+    uint16_t key_size_;
+  };
+
+  size_t ValueSize() const { return IsLeafPage() ? sizeof(RID) : sizeof(page_id_t); }
+  size_t EntrySize(int index) const { return slots_[index].key_size_ + ValueSize(); }
+  const char *ValueAt(int index) const { return Data() + slots_[index].offset_ + slots_[index].key_size_; }
+  char *ValueAt(int index) { return Data() + slots_[index].offset_ + slots_[index].key_size_; }
+  const char *Data() const { return reinterpret_cast<const char *>(this); }
+  char *Data() { return reinterpret_cast<char *>(this); }
+  size_t FreeBytes() const { return heap_start_ - VARLEN_PAGE_HEADER_SIZE - size_ * VARLEN_PAGE_SLOT_SIZE; }
+
+  void Insert(int index, std::string_view key, const char *value);
+
+  /** Rewrite the heap without the bytes of removed entries */
+  void Compact();
+
+  IndexPageType page_type_;
+  lsn_t lsn_;
+  int32_t size_;
+  int32_t heap_start_;
+  page_id_t page_id_;
+  page_id_t next_page_id_;
+  int32_t garbage_bytes_;
+  Slot slots_[0];
+};
+
+static_assert(sizeof(BPlusTreeVarlenPage) == VARLEN_PAGE_HEADER_SIZE, "varlen page header size mismatch");
+
+}  // namespace bustub
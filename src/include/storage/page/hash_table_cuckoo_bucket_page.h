@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_cuckoo_bucket_page.h
+//
+// Identification: src/include/storage/page/hash_table_cuckoo_bucket_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/index/int_comparator.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+/**
+ * Bucket page of CuckooHashTable. Supports non-unique keys.
+ *
+ * Pairs are packed at the front of the bucket in no particular order:
+ * removing a pair moves the last pair into its slot, so there are no
+ * tombstones and a probe looks at exactly NumReadable() slots. Each pair has
+ * a one-byte tag taken from its key's hash, and probes compare a group of
+ * BUCKET_TAG_GROUP_SIZE tags at once, as in HashTableTaggedBucketPage.
+ *
+ * The page carries a version for optimistic reads, used like a sequence
+ * lock. A writer makes the version odd with WriteBegin before it changes the
+ * bucket and even again with WriteEnd. A reader takes no latch: it reads the
+ * version with ReadBegin, copies out the pairs it wants with
+ * CollectTagMatches, and keeps them only if ReadValidate finds the version
+ * unchanged. Pairs copied during a write may be torn, so a reader must not
+ * look into them, not even with the key comparator, before they validate.
+ *
+ * Bucket page format:
+ *  ----------------------------------------------------------------------------------------
+ * | Version (8) | Size (4) | PADDING (4) | TAG(1) ... TAG(n) | PADDING | KEY(1) + VALUE(1) | ...
+ *  ----------------------------------------------------------------------------------------
+ *
+ *  More information is in storage/page/hash_table_page_defs.h.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class HashTableCuckooBucketPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableCuckooBucketPage() = delete;
+
+  /** Sets up a freshly allocated page as an empty bucket */
+  void Init() {
+    version_.store(0, std::memory_order_relaxed);
+    size_ = 0;
+  }
+
+  /** @return the tag stored for a key with the given 64-bit hash */
+  static uint8_t TagOf(uint64_t hash) { return static_cast<uint8_t>(hash >> 24); }
+
+  /** @return the version to validate an optimistic read against, waiting out a write in progress */
+  uint64_t ReadBegin() const;
+
+  /** @return true if no write started since ReadBegin returned version */
+  bool ReadValidate(uint64_t version) const;
+
+  /** Start a write, which makes optimistic reads of the bucket fail until WriteEnd */
+  void WriteBegin();
+
+  void WriteEnd();
+
+  /**
+   * Copy every pair whose tag is tag to matches, without comparing keys. May
+   * run concurrently with a writer; see the class comment.
+   */
+  void CollectTagMatches(uint8_t tag, std::vector<MappingType> *matches) const;
+
+  /** @return the slot holding the pair, -1 if the bucket does not hold it */
+  int64_t Find(const KeyType &key, const ValueType &value, uint8_t tag, KeyComparator cmp) const;
+
+  /**
+   * Appends a pair without looking for a duplicate.
+   *
+   * @return true if inserted, false if the bucket is full
+   */
+  bool Insert(const KeyType &key, const ValueType &value, uint8_t tag);
+
+  KeyType KeyAt(uint32_t bucket_idx) const { return array_[bucket_idx].first; }
+
+  ValueType ValueAt(uint32_t bucket_idx) const { return array_[bucket_idx].second; }
+
+  uint8_t TagAt(uint32_t bucket_idx) const { return tags_[bucket_idx]; }
+
+  /** Remove the KV pair at bucket_idx, moving the last pair into its slot */
+  void RemoveAt(uint32_t bucket_idx);
+
+  /**
+   * @return the number of readable elements, i.e. current size
+   */
+  uint32_t NumReadable() const { return size_; }
+
+  bool IsFull() const { return size_ == CUCKOO_BUCKET_ARRAY_SIZE; }
+
+  bool IsEmpty() const { return size_ == 0; }
+
+ private:
+  static constexpr uint32_t NUM_GROUPS = (CUCKOO_BUCKET_ARRAY_SIZE - 1) / BUCKET_TAG_GROUP_SIZE + 1;
+
+  /** @return a mask with bit i set if tag i of the group starting at tags_[group * BUCKET_TAG_GROUP_SIZE] is tag */
+  uint32_t MatchGroup(uint32_t group, uint8_t tag) const;
+
+  std::atomic<uint64_t> version_;
+  uint32_t size_;
+  uint32_t padding_;
+  uint8_t tags_[NUM_GROUPS * BUCKET_TAG_GROUP_SIZE];
+  MappingType array_[0];
+};
+
+}  // namespace bustub
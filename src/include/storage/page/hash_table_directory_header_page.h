@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_header_page.h
+//
+// Identification: src/include/storage/page/hash_table_directory_header_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ * Directory Header Page for extendible hash table.
+ *
+ * The directory of an extendible hash table is split into directory pages of
+ * DIRECTORY_ARRAY_SIZE entries each. Entry i of the directory lives at slot
+ * i % DIRECTORY_ARRAY_SIZE of directory page i / DIRECTORY_ARRAY_SIZE, so the
+ * low DIRECTORY_MAX_DEPTH bits of a key's hash pick the slot and the bits
+ * above them pick the directory page. The header holds the global depth and
+ * the page ids of the directory pages in use: one page up to global depth
+ * DIRECTORY_MAX_DEPTH, and 2^(global depth - DIRECTORY_MAX_DEPTH) above it.
+ *
+ * Header format (size in byte):
+ * --------------------------------------------------------------------------
+ * | LSN (4) | PageId(4) | GlobalDepth(4) | DirectoryPageIds(2048) | Free(2036)
+ * --------------------------------------------------------------------------
+ */
+class HashTableDirectoryHeaderPage {
+ public:
+  page_id_t GetPageId() const;
+
+  void SetPageId(page_id_t page_id);
+
+  lsn_t GetLSN() const;
+
+  void SetLSN(lsn_t lsn);
+
+  /**
+   * @param directory_idx the index of a directory page, below NumDirectoryPages()
+   * @return the page id of that directory page
+   */
+  page_id_t GetDirectoryPageId(uint32_t directory_idx) const;
+
+  void SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id);
+
+  /** @return the global depth of the hash table directory */
+  uint32_t GetGlobalDepth() const;
+
+  /** @return mask of global_depth 1's and the rest 0's (with 1's from LSB upwards) */
+  uint32_t GetGlobalDepthMask() const;
+
+  /** Increment the global depth, the caller fills in the directory entries and pages this adds */
+  void IncrGlobalDepth();
+
+  /** Decrement the global depth, the caller frees the directory pages this drops */
+  void DecrGlobalDepth();
+
+  /** @return the number of entries in the directory */
+  uint32_t Size() const;
+
+  /** @return true if the directory can double once more */
+  bool CanGrow() const;
+
+  /** @return the number of directory pages in use */
+  uint32_t NumDirectoryPages() const;
+
+  /** @return the index of the directory page holding directory entry bucket_idx */
+  static uint32_t DirectoryIndex(uint32_t bucket_idx) { return bucket_idx >> DIRECTORY_MAX_DEPTH; }
+
+  /** @return the slot of directory entry bucket_idx within its directory page */
+  static uint32_t DirectorySlot(uint32_t bucket_idx) { return bucket_idx & (DIRECTORY_ARRAY_SIZE - 1); }
+
+ private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t global_depth_{0};
+  page_id_t directory_page_ids_[DIRECTORY_HEADER_ARRAY_SIZE];
+};
+
+static_assert(1 << DIRECTORY_MAX_DEPTH == DIRECTORY_ARRAY_SIZE, "directory depth does not match its size");
+static_assert(sizeof(HashTableDirectoryHeaderPage) <= PAGE_SIZE, "hash table header page too large");
+
+}  // namespace bustub
@@ -84,17 +84,30 @@ class HashTableHeaderPage {
    */
   page_id_t GetBlockPageId(size_t index);
 
+  /**
+   * Replaces the page_id of the index-th block
+   *
+   * @param index the index of the block
+   * @param page_id the block's new page_id
+   */
+  void SetBlockPageId(size_t index, page_id_t page_id);
+
   /**
    * @return the number of blocks currently stored in the header page
    */
   size_t NumBlocks();
 
+  /**
+   * @return the number of block page_ids a header page has room for
+   */
+  static size_t MaxBlocks();
+
  private:
-  __attribute__((unused)) lsn_t lsn_;
-  __attribute__((unused)) size_t size_;
-  __attribute__((unused)) page_id_t page_id_;
-  __attribute__((unused)) size_t next_ind_;
-  __attribute__((unused)) page_id_t block_page_ids_[0];
+  lsn_t lsn_;
+  size_t size_;
+  page_id_t page_id_;
+  size_t next_ind_;
+  page_id_t block_page_ids_[0];
 };
 
 }  // namespace bustub
@@ -33,6 +33,10 @@
  */
 #define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
 #define DIRECTORY_ARRAY_SIZE 512
+/** log2 of DIRECTORY_ARRAY_SIZE, the number of low hash bits one directory page resolves */
+#define DIRECTORY_MAX_DEPTH 9
+/** The number of directory pages a directory header page can point at */
+#define DIRECTORY_HEADER_ARRAY_SIZE 512
 
 /**
  * BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hashing bucket page.
@@ -42,3 +46,39 @@
  * to maintain the occupied and readable flags for a key value pair.
  */
 #define BUCKET_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+
+/**
+ * Tagged Extendible Hashing Bucket Definitions
+ */
+#define HASH_TABLE_TAGGED_BUCKET_TYPE HashTableTaggedBucketPage<KeyType, ValueType, KeyComparator>
+
+/** Number of tag bytes compared at once by a tagged bucket probe */
+#define BUCKET_TAG_GROUP_SIZE 16
+
+/** Bytes taken by the overflow page id and overflow hash at the start of a tagged bucket page */
+#define TAGGED_BUCKET_HEADER_SIZE 16
+
+/**
+ * TAGGED_BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in a tagged bucket page. Each pair
+ * needs one tag byte next to it, and the tag array is padded up to a whole group of BUCKET_TAG_GROUP_SIZE bytes so that
+ * the last group can be loaded as one vector:
+ * (PAGE_SIZE - TAGGED_BUCKET_HEADER_SIZE - BUCKET_TAG_GROUP_SIZE) / (sizeof (MappingType) + 1).
+ */
+#define TAGGED_BUCKET_ARRAY_SIZE \
+  ((PAGE_SIZE - TAGGED_BUCKET_HEADER_SIZE - BUCKET_TAG_GROUP_SIZE) / (sizeof(MappingType) + 1))
+
+/**
+ * Cuckoo Hashing Bucket Definitions
+ */
+#define HASH_TABLE_CUCKOO_BUCKET_TYPE HashTableCuckooBucketPage<KeyType, ValueType, KeyComparator>
+
+/** Bytes taken by the version and the size at the start of a cuckoo bucket page */
+#define CUCKOO_BUCKET_HEADER_SIZE 16
+
+/**
+ * CUCKOO_BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in a cuckoo bucket page. As in a
+ * tagged bucket page each pair needs one tag byte, and the tag array is padded up to a whole group:
+ * (PAGE_SIZE - CUCKOO_BUCKET_HEADER_SIZE - BUCKET_TAG_GROUP_SIZE) / (sizeof (MappingType) + 1).
+ */
+#define CUCKOO_BUCKET_ARRAY_SIZE \
+  ((PAGE_SIZE - CUCKOO_BUCKET_HEADER_SIZE - BUCKET_TAG_GROUP_SIZE) / (sizeof(MappingType) + 1))
@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_tagged_bucket_page.h
+//
+// Identification: src/include/storage/page/hash_table_tagged_bucket_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/index/int_comparator.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+/**
+ * Extendible hashing bucket page that keeps a one-byte tag per slot in place
+ * of the occupied_ and readable_ bitmaps of HashTableBucketPage. Supports
+ * non-unique keys.
+ *
+ * A tag is 0 for a slot never used, 1 for a tombstone, and otherwise the high
+ * bit set plus the top seven bits of the key's hash. Probes compare a whole
+ * group of BUCKET_TAG_GROUP_SIZE tags against the key's tag with one SIMD
+ * compare, and call the key comparator only for slots whose tag matched, so a
+ * lookup of a wide key does about one full key comparison instead of one per
+ * slot in the bucket.
+ *
+ * Every operation takes the key's 32-bit hash along with the key. The
+ * directory indexes buckets by the low bits of the hash, so the tag uses the
+ * high bits which still differ between keys of one bucket.
+ *
+ * A bucket may head a chain of overflow pages, themselves tagged bucket
+ * pages, holding pairs that no split could move out of it because they all
+ * share one 64-bit key hash, the bucket's overflow hash. The bucket itself
+ * does not follow the chain; ExtendibleHashTable does.
+ *
+ * Bucket page format:
+ *  ----------------------------------------------------------------------------------------------
+ * | OverflowPageId (4) | PADDING (4) | OverflowHash (8) | TAG(1) ... TAG(n) | PADDING | KEY(1) + VALUE(1) | ...
+ *  ----------------------------------------------------------------------------------------------
+ *
+ *  The padding fills the tag array to a multiple of BUCKET_TAG_GROUP_SIZE and
+ *  is always 0. More information is in storage/page/hash_table_page_defs.h.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class HashTableTaggedBucketPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableTaggedBucketPage() = delete;
+
+  /** Sets up a freshly allocated page as a bucket without overflow pages */
+  void Init() {
+    overflow_page_id_ = INVALID_PAGE_ID;
+    overflow_hash_ = 0;
+  }
+
+  /** @return the first overflow page chained from this page, INVALID_PAGE_ID if there is none */
+  page_id_t GetOverflowPageId() const { return overflow_page_id_; }
+
+  void SetOverflowPageId(page_id_t overflow_page_id) { overflow_page_id_ = overflow_page_id; }
+
+  bool HasOverflow() const { return overflow_page_id_ != INVALID_PAGE_ID; }
+
+  /** @return the 64-bit key hash shared by every pair in the overflow chain */
+  uint64_t GetOverflowHash() const { return overflow_hash_; }
+
+  void SetOverflowHash(uint64_t overflow_hash) { overflow_hash_ = overflow_hash; }
+
+  /** @return the tag stored for a key with the given hash */
+  static uint8_t TagOf(uint32_t hash) { return static_cast<uint8_t>(READABLE_TAG_BIT | (hash >> 25)); }
+
+  /**
+   * Scan the bucket and collect values that have the matching key
+   *
+   * @return true if at least one key matched
+   */
+  bool GetValue(KeyType key, uint32_t hash, KeyComparator cmp, std::vector<ValueType> *result);
+
+  /**
+   * Attempts to insert a key and value in the bucket, reusing the first
+   * tombstone if there is one.
+   *
+   * @return true if inserted, false if duplicate KV pair or bucket is full
+   */
+  bool Insert(KeyType key, ValueType value, uint32_t hash, KeyComparator cmp);
+
+  /**
+   * Removes a key and value.
+   *
+   * @return true if removed, false if not found
+   */
+  bool Remove(KeyType key, ValueType value, uint32_t hash, KeyComparator cmp);
+
+  KeyType KeyAt(uint32_t bucket_idx) const { return array_[bucket_idx].first; }
+
+  ValueType ValueAt(uint32_t bucket_idx) const { return array_[bucket_idx].second; }
+
+  /** Remove the KV pair at bucket_idx, leaving a tombstone */
+  void RemoveAt(uint32_t bucket_idx) { tags_[bucket_idx] = TOMBSTONE_TAG; }
+
+  /** @return true if the slot holds a key/value pair or a tombstone */
+  bool IsOccupied(uint32_t bucket_idx) const { return tags_[bucket_idx] != EMPTY_TAG; }
+
+  /** @return true if the slot holds a key/value pair */
+  bool IsReadable(uint32_t bucket_idx) const { return (tags_[bucket_idx] & READABLE_TAG_BIT) != 0; }
+
+  /**
+   * @return the number of readable elements, i.e. current size
+   */
+  uint32_t NumReadable() const;
+
+  bool IsFull() const { return NumReadable() == TAGGED_BUCKET_ARRAY_SIZE; }
+
+  bool IsEmpty() const { return NumReadable() == 0; }
+
+ private:
+  static constexpr uint8_t EMPTY_TAG = 0;
+  static constexpr uint8_t TOMBSTONE_TAG = 1;
+  static constexpr uint8_t READABLE_TAG_BIT = 0x80;
+  static constexpr uint32_t NUM_GROUPS = (TAGGED_BUCKET_ARRAY_SIZE - 1) / BUCKET_TAG_GROUP_SIZE + 1;
+
+  /** @return a mask with bit i set if tag i of the group starting at tags_[group * BUCKET_TAG_GROUP_SIZE] is tag */
+  uint32_t MatchGroup(uint32_t group, uint8_t tag) const;
+
+  /** @return a mask with bit i set if tag i of the group is readable */
+  uint32_t ReadableInGroup(uint32_t group) const;
+
+  page_id_t overflow_page_id_;
+  uint64_t overflow_hash_;
+  uint8_t tags_[NUM_GROUPS * BUCKET_TAG_GROUP_SIZE];
+  MappingType array_[0];
+};
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -99,6 +101,17 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
+  /** @return the ids of all pages of this table, in list order */
+  std::vector<page_id_t> GetPageIds();
+
+  /**
+   * Read all tuples of one page of this table, holding the page latch once for all of them.
+   * @param page_id id of the page to read
+   * @param[out] tuples the tuples of the page are appended here, in slot order
+   * @param txn transaction performing the read
+   */
+  void ReadPage(page_id_t page_id, std::vector<Tuple> *tuples, Transaction *txn);
+
   /** @return the begin iterator of this table */
   TableIterator Begin(Transaction *txn);
 
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tmp_tuple_file.h
+//
+// Identification: src/include/storage/table/tmp_tuple_file.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "storage/page/tmp_tuple_page.h"
+#include "storage/table/tmp_tuple.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TmpTupleFile is an append-only run of temporary tuples, e.g. the part of a
+ * join input spilled out of memory, stored in TmpTuplePages of the buffer
+ * pool. Like any other page they are written out to disk when evicted.
+ *
+ * The page being appended to stays pinned until Finish(), after which the
+ * file is read back a page at a time. The pages are deleted with the file.
+ * A file is not thread safe.
+ */
+class TmpTupleFile {
+ public:
+  /** @param bpm the buffer pool the pages of the file live in */
+  explicit TmpTupleFile(BufferPoolManager *bpm) : bpm_(bpm) {}
+
+  /** Deletes the pages of the file */
+  ~TmpTupleFile();
+
+  DISALLOW_COPY_AND_MOVE(TmpTupleFile);
+
+  /**
+   * Append a tuple, which must fit in an empty page. Throws OUT_OF_MEMORY if no frame is free for a new page.
+   * @return where the tuple went
+   */
+  TmpTuple Append(const Tuple &tuple);
+
+  /** Unpin the page being appended to, no more tuples may be appended */
+  void Finish();
+
+  /** @return the number of tuples in the file */
+  size_t Size() const { return num_tuples_; }
+
+  /** @return the number of pages of the file */
+  size_t NumPages() const { return page_ids_.size(); }
+
+  /**
+   * Read the tuples of a page of a finished file, in the order they were appended.
+   * Throws OUT_OF_MEMORY if no frame is free for the page.
+   * @param page the index of the page within the file
+   * @param[out] tuples where the tuples are appended to
+   */
+  void ReadPage(size_t page, std::vector<Tuple> *tuples);
+
+ private:
+  BufferPoolManager *bpm_;
+  std::vector<page_id_t> page_ids_;
+  /** The last page, pinned while tuples are appended to it */
+  TmpTuplePage *current_{nullptr};
+  size_t num_tuples_{0};
+};
+
+}  // namespace bustub
@@ -48,6 +48,12 @@ class Tuple {
   // assign operator, deep copy
   Tuple &operator=(const Tuple &other);
 
+  // move constructor, takes over the data and leaves other a dummy tuple
+  Tuple(Tuple &&other) noexcept;
+
+  // move assign operator, takes over the data and leaves other a dummy tuple
+  Tuple &operator=(Tuple &&other) noexcept;
+
   ~Tuple() {
     if (allocated_) {
       delete[] data_;
@@ -9,7 +9,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -19,30 +22,108 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, page_id_t header_page_id, bool unique_keys)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      leaf_max_size_(std::min(leaf_max_size, static_cast<int>(LEAF_PAGE_SIZE))),
+      // an internal page briefly holds max size + 1 children before it splits
+      internal_max_size_(std::min(
+          internal_max_size,
+          static_cast<int>((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(std::pair<KeyType, page_id_t>)) - 1)),
+      header_page_id_(header_page_id),
+      unique_keys_(unique_keys) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID; }
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 /*
- * Return the only value that associated with input key
+ * Return the values associated with input key, all taken from one leaf visit
  * This method is used for point query
  * @return : true means key exists
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  return false;
+  Page *page = FindLeafPageRead(key, false);
+  if (page == nullptr) {
+    return false;
+  }
+  ValueType value;
+  bool found = reinterpret_cast<LeafPage *>(page->GetData())->Lookup(key, &value, comparator_);
+  if (found) {
+    BPlusTreePostingPage::Collect(buffer_pool_manager_, value, result);
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return found;
+}
+
+/*
+ * Look up a batch of keys sorted in ascending order
+ * The tree is descended once for the first key, then the leaf's parent stays
+ * read latched while the following keys are answered from its children left to
+ * right. Keys that share a leaf share one page fetch, and the tree is only
+ * descended again once a key falls past the parent's subtree.
+ * @return : the number of keys found
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *result,
+                                 Transaction *transaction) {
+  result->assign(keys.size(), std::vector<ValueType>{});
+  size_t found = 0;
+  size_t i = 0;
+  while (i < keys.size()) {
+    Page *parent_page = nullptr;
+    KeyType parent_upper{};
+    bool parent_bounded = false;
+    Page *page = FindLeafAndParentRead(keys[i], &parent_page, &parent_upper, &parent_bounded);
+    if (page == nullptr) {
+      return 0;
+    }
+    auto *parent = parent_page == nullptr ? nullptr : reinterpret_cast<InternalPage *>(parent_page->GetData());
+    int child_index = parent == nullptr ? 0 : parent->ChildIndex(keys[i], comparator_);
+
+    while (true) {
+      // the leaf covers every key below its upper fence
+      const bool last_child = parent == nullptr || child_index + 1 == parent->GetSize();
+      const KeyType &upper = last_child ? parent_upper : parent->KeyAt(child_index + 1);
+      const bool bounded = last_child ? parent_bounded : true;
+      auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+      for (; i < keys.size() && (!bounded || comparator_(keys[i], upper) < 0); i++) {
+        ValueType value;
+        if (leaf->Lookup(keys[i], &value, comparator_)) {
+          BPlusTreePostingPage::Collect(buffer_pool_manager_, value, &(*result)[i]);
+          found++;
+        }
+      }
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+
+      if (i == keys.size() || parent == nullptr || (parent_bounded && comparator_(keys[i], parent_upper) >= 0)) {
+        break;
+      }
+      // the next key is still under this parent, move right to the child covering it
+      child_index = parent->ChildIndex(keys[i], comparator_);
+      page = buffer_pool_manager_->FetchPage(parent->ValueAt(child_index));
+      if (page == nullptr) {
+        parent_page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), false);
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch leaf page");
+      }
+      page->RLatch();
+    }
+    if (parent_page != nullptr) {
+      parent_page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), false);
+    }
+  }
+  return found;
 }
 
 /*****************************************************************************
@@ -56,7 +137,21 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) { return false; }
+bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  Page *page = FindLeafPageWrite(key, Operation::INSERT, transaction);
+  if (page == nullptr) {
+    StartNewTree(key, value);
+    ReleaseWriteLatches(transaction, true);
+    return true;
+  }
+  bool inserted = InsertIntoLeaf(key, value, transaction);
+  ReleaseWriteLatches(transaction, inserted);
+  return inserted;
+}
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -64,19 +159,54 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate root page");
+  }
+  auto *root = reinterpret_cast<LeafPage *>(page->GetData());
+  root->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
- * immdiately, otherwise insert entry. Remember to deal with split if necessary.
+ * immdiately (or add the value to the key's posting list if duplicate keys are
+ * allowed), otherwise insert entry. Remember to deal with split if necessary.
+ * The target leaf is the last page in the transaction page set.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  return false;
+  auto *leaf = reinterpret_cast<LeafPage *>(transaction->GetPageSet()->back()->GetData());
+  int index = leaf->KeyIndex(key, comparator_);
+  if (index < leaf->GetSize() && comparator_(leaf->KeyAt(index), key) == 0) {
+    if (unique_keys_) {
+      return false;
+    }
+    // duplicate key, the value joins the key's posting list and the leaf layout stays as is
+    ValueType values = leaf->ValueAt(index);
+    if (!BPlusTreePostingPage::Insert(buffer_pool_manager_, &values, value)) {
+      return false;
+    }
+    leaf->SetValueAt(index, values);
+    return true;
+  }
+  if (leaf->Insert(key, value, comparator_) >= leaf->GetMaxSize()) {
+    LeafPage *new_leaf = Split(leaf);
+    new_leaf->SetNextPageId(leaf->GetNextPageId());
+    leaf->SetNextPageId(new_leaf->GetPageId());
+    InsertIntoParent(leaf, new_leaf->KeyAt(0), new_leaf, transaction);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+  }
+  return true;
 }
 
 /*
@@ -89,7 +219,19 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 N *BPLUSTREE_TYPE::Split(N *node) {
-  return nullptr;
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate page to split into");
+  }
+  auto *new_node = reinterpret_cast<N *>(page->GetData());
+  new_node->Init(page_id, node->GetParentPageId(), node->GetMaxSize());
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    node->MoveHalfTo(new_node);
+  } else {
+    node->MoveHalfTo(new_node, buffer_pool_manager_);
+  }
+  return new_node;
 }
 
 /*
@@ -103,7 +245,36 @@ N *BPLUSTREE_TYPE::Split(N *node) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    page_id_t root_id;
+    Page *page = buffer_pool_manager_->NewPage(&root_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new root page");
+    }
+    auto *root = reinterpret_cast<InternalPage *>(page->GetData());
+    root->Init(root_id, INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_id);
+    new_node->SetParentPageId(root_id);
+    // the root latch is still held, the old root was not safe
+    root_page_id_ = root_id;
+    UpdateRootPageId(0);
+    buffer_pool_manager_->UnpinPage(root_id, true);
+    return;
+  }
+
+  // the parent is write latched in the transaction page set, this only adds a pin
+  page_id_t parent_id = old_node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_id)->GetData());
+  new_node->SetParentPageId(parent_id);
+  if (parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId()) > parent->GetMaxSize()) {
+    InternalPage *new_parent = Split(parent);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent, transaction);
+    buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(parent_id, true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -116,19 +287,114 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  Page *page = FindLeafPageWrite(key, Operation::DELETE, transaction);
+  if (page == nullptr) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType values;
+  if (!leaf->Lookup(key, &values, comparator_)) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  BPlusTreePostingPage::Free(buffer_pool_manager_, values);
+  leaf->RemoveAndDeleteRecord(key, comparator_);
+  CoalesceOrRedistribute(leaf, transaction);
+  ReleaseWriteLatches(transaction, true);
+}
+
+/*
+ * Delete a single value of input key. The key's entry is removed like above
+ * once its last value is gone, otherwise only its posting list shrinks.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  Page *page = FindLeafPageWrite(key, Operation::DELETE, transaction);
+  if (page == nullptr) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int index = leaf->KeyIndex(key, comparator_);
+  if (index == leaf->GetSize() || comparator_(leaf->KeyAt(index), key) != 0) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  ValueType values = leaf->ValueAt(index);
+  bool now_empty;
+  if (!BPlusTreePostingPage::Remove(buffer_pool_manager_, &values, value, &now_empty)) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  if (!now_empty) {
+    leaf->SetValueAt(index, values);
+    ReleaseWriteLatches(transaction, true);
+    return;
+  }
+  leaf->RemoveAndDeleteRecord(key, comparator_);
+  CoalesceOrRedistribute(leaf, transaction);
+  ReleaseWriteLatches(transaction, true);
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
+ * Pages that end up empty are recorded in the transaction's deleted page set.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  return false;
+  if (node->IsRootPage()) {
+    if (AdjustRoot(node)) {
+      transaction->AddIntoDeletedPageSet(node->GetPageId());
+      return true;
+    }
+    return false;
+  }
+  if (node->GetSize() >= node->GetMinSize()) {
+    return false;
+  }
+
+  page_id_t parent_id = node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_id)->GetData());
+  int index = parent->ValueIndex(node->GetPageId());
+  page_id_t sibling_id = parent->ValueAt(index == 0 ? 1 : index - 1);
+  Page *sibling_page = buffer_pool_manager_->FetchPage(sibling_id);
+  if (sibling_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(parent_id, false);
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch sibling page");
+  }
+  sibling_page->WLatch();
+  auto *sibling = reinterpret_cast<N *>(sibling_page->GetData());
+
+  // a merged leaf must stay below max size, a merged internal page may reach it
+  bool fits = node->IsLeafPage() ? sibling->GetSize() + node->GetSize() < node->GetMaxSize()
+                                 : sibling->GetSize() + node->GetSize() <= node->GetMaxSize();
+  bool node_deleted = false;
+  if (fits) {
+    node_deleted = index != 0;
+    Coalesce(&sibling, &node, &parent, index, transaction);
+  } else {
+    Redistribute(sibling, node, index);
+  }
+
+  sibling_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(sibling_id, true);
+  buffer_pool_manager_->UnpinPage(parent_id, true);
+  return node_deleted;
 }
 
 /*
@@ -137,6 +403,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
  * take info of deletion into account. Remember to deal with coalesce or
  * redistribute recursively if necessary.
  * Using template N to represent either internal page or leaf page.
+ * The right page of the pair is always merged into the left one.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  * @param   parent             parent page of input "node"
@@ -148,7 +415,22 @@ template <typename N>
 bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
                               Transaction *transaction) {
-  return false;
+  N *left = *neighbor_node;
+  N *right = *node;
+  int right_index = index;
+  if (index == 0) {
+    std::swap(left, right);
+    right_index = 1;
+  }
+
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    right->MoveAllTo(left);
+  } else {
+    right->MoveAllTo(left, (*parent)->KeyAt(right_index), buffer_pool_manager_);
+  }
+  transaction->AddIntoDeletedPageSet(right->GetPageId());
+  (*parent)->Remove(right_index);
+  return CoalesceOrRedistribute(*parent, transaction);
 }
 
 /*
@@ -162,7 +444,27 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+  // the parent is write latched in the transaction page set, this only adds a pin
+  page_id_t parent_id = node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_id)->GetData());
+  if (index == 0) {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveFirstToEndOf(node);
+    } else {
+      neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1), buffer_pool_manager_);
+    }
+    parent->SetKeyAt(1, neighbor_node->KeyAt(0));
+  } else {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveLastToFrontOf(node);
+    } else {
+      neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(index), buffer_pool_manager_);
+    }
+    parent->SetKeyAt(index, node->KeyAt(0));
+  }
+  buffer_pool_manager_->UnpinPage(parent_id, true);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -170,11 +472,29 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * case 1: when you delete the last element in root page, but root page still
  * has one last child
  * case 2: when you delete the last element in whole b+ tree
+ * The root latch is still held whenever the root can change.
  * @return : true means root page should be deleted, false means no deletion
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
+bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0) {
+      return false;
+    }
+    root_page_id_ = INVALID_PAGE_ID;
+  } else {
+    if (old_root_node->GetSize() > 1) {
+      return false;
+    }
+    root_page_id_ = reinterpret_cast<InternalPage *>(old_root_node)->RemoveAndReturnOnlyChild();
+    Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+    reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  }
+  UpdateRootPageId(0);
+  return true;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -185,7 +505,14 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  Page *page = FindLeafPageRead(KeyType{}, true);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  page->RUnlatch();
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, 0);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -193,7 +520,15 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+  Page *page = FindLeafPageRead(key, false);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  int index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(key, comparator_);
+  page->RUnlatch();
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index);
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -203,16 +538,205 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) { return INDEXITERA
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::End() { return INDEXITERATOR_TYPE(); }
 
+/*
+ * Position a range scan on the first key >= low (or the leftmost key) and hand
+ * it the upper bound. The scan keeps the starting leaf pinned.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+std::unique_ptr<RANGESCAN_TYPE> BPLUSTREE_TYPE::RangeScan(const KeyType *low, const KeyType *high,
+                                                          bool high_inclusive) {
+  Page *page = FindLeafPageRead(low == nullptr ? KeyType{} : *low, low == nullptr);
+  int index = 0;
+  if (page != nullptr) {
+    if (low != nullptr) {
+      index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(*low, comparator_);
+    }
+    page->RUnlatch();
+  }
+  return std::make_unique<RANGESCAN_TYPE>(buffer_pool_manager_, comparator_, page, index, high, high_inclusive);
+}
+
 /*****************************************************************************
  * UTILITIES AND DEBUG
  *****************************************************************************/
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * The returned page is pinned but not latched.
  */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  Page *page = FindLeafPageRead(key, leftMost);
+  if (page != nullptr) {
+    page->RUnlatch();
+  }
+  return page;
+}
+
+/*
+ * Hand-over-hand read latching: latch the child before releasing the parent.
+ * The root latch is held until the root page itself is latched.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageRead(const KeyType &key, bool left_most) {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (page == nullptr) {
+    root_latch_.RUnlock();
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch root page");
+  }
+  page->RLatch();
+  root_latch_.RUnlock();
+
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    page_id_t child_id = left_most ? internal->ValueAt(0) : internal->Lookup(key, comparator_);
+    Page *child = buffer_pool_manager_->FetchPage(child_id);
+    if (child == nullptr) {
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch child page");
+    }
+    child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+/*
+ * Hand-over-hand read latching that keeps two levels latched, so the leaf's
+ * parent can be used to move on to the leaf's siblings. While descending, the
+ * tightest separator above the search key is tracked as the subtree's upper
+ * fence.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafAndParentRead(const KeyType &key, Page **parent, KeyType *parent_upper,
+                                            bool *parent_bounded) {
+  *parent = nullptr;
+  *parent_bounded = false;
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (page == nullptr) {
+    root_latch_.RUnlock();
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch root page");
+  }
+  page->RLatch();
+  root_latch_.RUnlock();
+
+  KeyType upper{};
+  bool bounded = false;
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    int index = internal->ChildIndex(key, comparator_);
+    // the current node becomes the parent, its own fence is the one tracked so far
+    *parent_upper = upper;
+    *parent_bounded = bounded;
+    if (index + 1 < internal->GetSize()) {
+      upper = internal->KeyAt(index + 1);
+      bounded = true;
+    }
+    Page *child = buffer_pool_manager_->FetchPage(internal->ValueAt(index));
+    if (child == nullptr) {
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      if (*parent != nullptr) {
+        (*parent)->RUnlatch();
+        buffer_pool_manager_->UnpinPage((*parent)->GetPageId(), false);
+      }
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch child page");
+    }
+    child->RLatch();
+    if (*parent != nullptr) {
+      (*parent)->RUnlatch();
+      buffer_pool_manager_->UnpinPage((*parent)->GetPageId(), false);
+    }
+    *parent = page;
+    page = child;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+/*
+ * Latch crabbing for writers: every page on the path is write latched and kept
+ * in the transaction page set until a safe node is reached, at which point all
+ * ancestors are released. A nullptr entry in the page set stands for the root
+ * latch. Returns the leaf (also the last page in the set), or nullptr with the
+ * root latch still held if the tree is empty.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageWrite(const KeyType &key, Operation op, Transaction *transaction) {
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      ReleaseWriteLatches(transaction, false);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch tree page");
+    }
+    page->WLatch();
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op)) {
+      ReleaseWriteLatches(transaction, false);
+    }
+    transaction->AddIntoPageSet(page);
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    page_id = reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, Operation op) const {
+  switch (op) {
+    case Operation::SEARCH:
+      return true;
+    case Operation::INSERT:
+      return node->IsLeafPage() ? node->GetSize() + 1 < node->GetMaxSize() : node->GetSize() < node->GetMaxSize();
+    case Operation::DELETE:
+      return node->GetSize() > node->GetMinSize();
+  }
+  UNREACHABLE("Unknown operation");
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseWriteLatches(Transaction *transaction, bool is_dirty) {
+  auto page_set = transaction->GetPageSet();
+  while (!page_set->empty()) {
+    Page *page = page_set->front();
+    page_set->pop_front();
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+      continue;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+
+  auto deleted_pages = transaction->GetDeletedPageSet();
+  for (page_id_t page_id : *deleted_pages) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  deleted_pages->clear();
 }
 
 /*
@@ -225,7 +749,10 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  if (header_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id_));
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -233,7 +760,7 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
 }
 
 /*
@@ -399,4 +926,8 @@ template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class BPlusTree<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class BPlusTree<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class BPlusTree<IntegerKey<16>, RID, IntegerComparator<16>>;
+
 }  // namespace bustub
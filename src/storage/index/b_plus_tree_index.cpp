@@ -9,6 +9,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "storage/index/b_plus_tree_index.h"
 
 namespace bustub {
@@ -19,13 +21,16 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      // page 0 may belong to a table here, so the root page id is kept in memory only;
+      // secondary indexes map a key to every row holding it
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE,
+                 INVALID_PAGE_ID, false) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
   container_.Insert(index_key, rid, transaction);
 }
@@ -34,20 +39,64 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
-  container_.Remove(index_key, transaction);
+  container_.Remove(index_key, rid, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                                    Transaction *transaction) {
+  // construct scan index keys and sort them in tree order
+  std::vector<KeyType> index_keys(keys.size());
+  std::vector<size_t> order(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i], *GetKeySchema());
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t lhs, size_t rhs) { return comparator_(index_keys[lhs], index_keys[rhs]) < 0; });
+  std::vector<KeyType> sorted_keys;
+  sorted_keys.reserve(keys.size());
+  for (size_t i : order) {
+    sorted_keys.push_back(index_keys[i]);
+  }
+
+  std::vector<std::vector<RID>> sorted_result;
+  container_.GetValues(sorted_keys, &sorted_result, transaction);
+  result->assign(keys.size(), std::vector<RID>{});
+  for (size_t i = 0; i < order.size(); i++) {
+    (*result)[order[i]] = std::move(sorted_result[i]);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+std::unique_ptr<IndexRangeScan> BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *low_key, const Tuple *high_key,
+                                                                bool high_inclusive, Transaction *transaction) {
+  // construct range bound keys
+  KeyType low;
+  KeyType high;
+  if (low_key != nullptr) {
+    low.SetFromKey(*low_key, *GetKeySchema());
+  }
+  if (high_key != nullptr) {
+    high.SetFromKey(*high_key, *GetKeySchema());
+  }
+
+  auto iterator = container_.RangeScan(low_key == nullptr ? nullptr : &low, high_key == nullptr ? nullptr : &high,
+                                       high_inclusive);
+  return std::make_unique<BPlusTreeIndexRangeScan<KeyType, ValueType, KeyComparator>>(std::move(iterator));
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator() { return container_.Begin(); }
 
@@ -63,4 +112,8 @@ template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class BPlusTreeIndex<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class BPlusTreeIndex<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class BPlusTreeIndex<IntegerKey<16>, RID, IntegerComparator<16>>;
+
 }  // namespace bustub
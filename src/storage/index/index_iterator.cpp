@@ -2,29 +2,121 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
+#include "common/exception.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index)
+    : buffer_pool_manager_(buffer_pool_manager), page_(page), index_(index) {
+  SkipExhaustedLeaves();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept
+    : buffer_pool_manager_(other.buffer_pool_manager_),
+      page_(other.page_),
+      index_(other.index_),
+      postings_(std::move(other.postings_)),
+      posting_index_(other.posting_index_) {
+  other.page_ = nullptr;
+  other.index_ = 0;
+  other.posting_index_ = 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept {
+  if (this != &other) {
+    if (page_ != nullptr) {
+      buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    }
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = other.page_;
+    index_ = other.index_;
+    postings_ = std::move(other.postings_);
+    posting_index_ = other.posting_index_;
+    other.page_ = nullptr;
+    other.index_ = 0;
+    other.posting_index_ = 0;
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() {
+  if (page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::IsEnd() { return page_ == nullptr; }
 
 INDEX_TEMPLATE_ARGUMENTS
-bool INDEXITERATOR_TYPE::IsEnd() { throw std::runtime_error("unimplemented"); }
+const MappingType &INDEXITERATOR_TYPE::operator*() {
+  LoadCurrent();
+  return current_;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &INDEXITERATOR_TYPE::operator*() { throw std::runtime_error("unimplemented"); }
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  LoadCurrent();
+  if (posting_index_ + 1 < postings_.size()) {
+    posting_index_++;
+    return *this;
+  }
+  postings_.clear();
+  posting_index_ = 0;
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::LoadCurrent() {
+  page_->RLatch();
+  const MappingType &item = reinterpret_cast<LeafPage *>(page_->GetData())->GetItem(index_);
+  current_.first = item.first;
+  if (BPlusTreePostingPage::IsRef(item.second)) {
+    if (postings_.empty()) {
+      BPlusTreePostingPage::Collect(buffer_pool_manager_, item.second, &postings_);
+    }
+    current_.second = postings_[posting_index_];
+  } else {
+    current_.second = item.second;
+  }
+  page_->RUnlatch();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (page_ != nullptr) {
+    page_->RLatch();
+    auto *leaf = reinterpret_cast<LeafPage *>(page_->GetData());
+    int size = leaf->GetSize();
+    page_id_t next_page_id = leaf->GetNextPageId();
+    page_->RUnlatch();
+    if (index_ < size) {
+      return;
+    }
+    // release the current leaf before pinning the next one, writers latch siblings right to left
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+    index_ = 0;
+    if (next_page_id != INVALID_PAGE_ID) {
+      page_ = buffer_pool_manager_->FetchPage(next_page_id);
+      if (page_ == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch next leaf page");
+      }
+    }
+  }
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -36,4 +128,8 @@ template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class IndexIterator<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class IndexIterator<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class IndexIterator<IntegerKey<16>, RID, IntegerComparator<16>>;
+
 }  // namespace bustub
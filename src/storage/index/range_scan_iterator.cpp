@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// range_scan_iterator.cpp
+//
+// Identification: src/storage/index/range_scan_iterator.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/range_scan_iterator.h"
+
+#include "common/exception.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+RANGESCAN_TYPE::RangeScanIterator(BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator, Page *page,
+                                  int index, const KeyType *high, bool high_inclusive)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      page_(page),
+      index_(index),
+      has_high_(high != nullptr),
+      high_inclusive_(high_inclusive) {
+  if (high != nullptr) {
+    high_ = *high;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+RANGESCAN_TYPE::~RangeScanIterator() { Finish(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool RANGESCAN_TYPE::NextBatch(std::vector<ValueType> *result) {
+  while (page_ != nullptr) {
+    page_->RLatch();
+    auto *leaf = reinterpret_cast<LeafPage *>(page_->GetData());
+    const int size = leaf->GetSize();
+    const page_id_t next_page_id = leaf->GetNextPageId();
+
+    // Only prefetch when the range runs past this leaf
+    bool range_ends_here = index_ < size && PastHigh(leaf->KeyAt(size - 1));
+    if (next_page_id != INVALID_PAGE_ID && !range_ends_here && !prefetch_.valid()) {
+      auto *bpm = buffer_pool_manager_;
+      prefetch_ = std::async(std::launch::async, [bpm, next_page_id] { return bpm->FetchPage(next_page_id); });
+    }
+
+    const size_t old_size = result->size();
+    for (; index_ < size; index_++) {
+      const MappingType &item = leaf->GetItem(index_);
+      if (PastHigh(item.first)) {
+        range_ends_here = true;
+        break;
+      }
+      BPlusTreePostingPage::Collect(buffer_pool_manager_, item.second, result);
+    }
+    page_->RUnlatch();
+
+    if (range_ends_here) {
+      Finish();
+    } else {
+      AdvanceLeaf(next_page_id);
+    }
+    if (result->size() != old_size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool RANGESCAN_TYPE::PastHigh(const KeyType &key) const {
+  if (!has_high_) {
+    return false;
+  }
+  int cmp = comparator_(key, high_);
+  return high_inclusive_ ? cmp > 0 : cmp >= 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void RANGESCAN_TYPE::AdvanceLeaf(page_id_t next_page_id) {
+  // Release the current leaf before taking the next one, writers latch siblings right to left
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+  index_ = 0;
+  if (next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  if (prefetch_.valid()) {
+    page_ = prefetch_.get();
+  }
+  if (page_ == nullptr) {
+    page_ = buffer_pool_manager_->FetchPage(next_page_id);
+  }
+  if (page_ == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch next leaf page");
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void RANGESCAN_TYPE::Finish() {
+  if (prefetch_.valid()) {
+    Page *prefetched = prefetch_.get();
+    if (prefetched != nullptr) {
+      buffer_pool_manager_->UnpinPage(prefetched->GetPageId(), false);
+    }
+  }
+  if (page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+  }
+}
+
+template class RangeScanIterator<GenericKey<4>, RID, GenericComparator<4>>;
+template class RangeScanIterator<GenericKey<8>, RID, GenericComparator<8>>;
+template class RangeScanIterator<GenericKey<16>, RID, GenericComparator<16>>;
+template class RangeScanIterator<GenericKey<32>, RID, GenericComparator<32>>;
+template class RangeScanIterator<GenericKey<64>, RID, GenericComparator<64>>;
+
+template class RangeScanIterator<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class RangeScanIterator<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class RangeScanIterator<IntegerKey<16>, RID, IntegerComparator<16>>;
+
+}  // namespace bustub
@@ -0,0 +1,418 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_b_plus_tree.cpp
+//
+// Identification: src/storage/index/varlen_b_plus_tree.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/varlen_b_plus_tree.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+BPlusTreeVarlenPage *AsNode(Page *page) { return reinterpret_cast<BPlusTreeVarlenPage *>(page->GetData()); }
+
+/**
+ * @return the shortest prefix of right_first that sorts after left_last, which separates the two leaves
+ * as well as right_first itself does
+ */
+std::string ShortestSeparator(std::string_view left_last, std::string_view right_first) {
+  size_t common = 0;
+  const size_t limit = std::min(left_last.size(), right_first.size());
+  while (common < limit && left_last[common] == right_first[common]) {
+    common++;
+  }
+  return std::string(right_first.substr(0, common + 1));
+}
+
+}  // namespace
+
+VarlenBPlusTree::VarlenBPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, bool unique_keys)
+    : index_name_(std::move(name)),
+      root_page_id_(INVALID_PAGE_ID),
+      buffer_pool_manager_(buffer_pool_manager),
+      unique_keys_(unique_keys) {}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+bool VarlenBPlusTree::GetValue(std::string_view key, std::vector<RID> *result, Transaction *transaction) {
+  Page *page = FindLeafPageRead(key, false);
+  if (page == nullptr) {
+    return false;
+  }
+  auto *leaf = AsNode(page);
+  int index = leaf->KeyIndex(key);
+  bool found = index < leaf->GetSize() && leaf->KeyAt(index) == key;
+  if (found) {
+    BPlusTreePostingPage::Collect(buffer_pool_manager_, leaf->RidAt(index), result);
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return found;
+}
+
+std::unique_ptr<VarlenRangeScan> VarlenBPlusTree::RangeScan(const std::string_view *low, const std::string_view *high,
+                                                            bool high_inclusive) {
+  Page *page = FindLeafPageRead(low == nullptr ? std::string_view() : *low, low == nullptr);
+  int index = 0;
+  if (page != nullptr) {
+    if (low != nullptr) {
+      index = AsNode(page)->KeyIndex(*low);
+    }
+    page->RUnlatch();
+  }
+  return std::make_unique<VarlenRangeScan>(buffer_pool_manager_, page, index, high, high_inclusive);
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert a key and RID pair. A full leaf is split before the entry goes in,
+ * into whichever half now covers the key.
+ */
+bool VarlenBPlusTree::Insert(std::string_view key, const RID &rid, Transaction *transaction) {
+  if (key.size() > MAX_KEY_SIZE) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "index key is too long");
+  }
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  Page *page = FindLeafPageWrite(key, true, transaction);
+  if (page == nullptr) {
+    StartNewTree(key, rid);
+    ReleaseWriteLatches(transaction, true);
+    return true;
+  }
+
+  auto *leaf = AsNode(page);
+  int index = leaf->KeyIndex(key);
+  if (index < leaf->GetSize() && leaf->KeyAt(index) == key) {
+    if (unique_keys_) {
+      ReleaseWriteLatches(transaction, false);
+      return false;
+    }
+    // duplicate key, the RID joins the key's posting list and the leaf layout stays as is
+    RID values = leaf->RidAt(index);
+    bool inserted = BPlusTreePostingPage::Insert(buffer_pool_manager_, &values, rid);
+    if (inserted) {
+      leaf->SetRidAt(index, values);
+    }
+    ReleaseWriteLatches(transaction, inserted);
+    return inserted;
+  }
+  if (leaf->HasRoomFor(key.size())) {
+    leaf->InsertRid(index, key, rid);
+    ReleaseWriteLatches(transaction, true);
+    return true;
+  }
+
+  BPlusTreeVarlenPage *new_leaf = NewNode(IndexPageType::LEAF_PAGE);
+  std::string right_first = leaf->MoveHalfTo(new_leaf);
+  new_leaf->SetNextPageId(leaf->GetNextPageId());
+  leaf->SetNextPageId(new_leaf->GetPageId());
+  BPlusTreeVarlenPage *target = key < right_first ? leaf : new_leaf;
+  target->InsertRid(target->KeyIndex(key), key, rid);
+
+  std::string separator = ShortestSeparator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0));
+  InsertIntoParent(transaction->GetPageSet()->size() - 1, leaf->GetPageId(), separator, new_leaf->GetPageId(),
+                   transaction);
+  buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+  ReleaseWriteLatches(transaction, true);
+  return true;
+}
+
+void VarlenBPlusTree::StartNewTree(std::string_view key, const RID &rid) {
+  BPlusTreeVarlenPage *root = NewNode(IndexPageType::LEAF_PAGE);
+  root->InsertRid(0, key, rid);
+  root_page_id_ = root->GetPageId();
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+}
+
+BPlusTreeVarlenPage *VarlenBPlusTree::NewNode(IndexPageType page_type) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate tree page");
+  }
+  auto *node = AsNode(page);
+  node->Init(page_id, page_type);
+  return node;
+}
+
+/*
+ * The node that split is the page at depth of the transaction page set. It was
+ * not safe, so its parent is the write latched page right before it, or, if it
+ * is the root, the root latch is still held.
+ */
+void VarlenBPlusTree::InsertIntoParent(size_t depth, page_id_t old_page_id, const std::string &separator,
+                                       page_id_t new_page_id, Transaction *transaction) {
+  if (old_page_id == root_page_id_) {
+    BPlusTreeVarlenPage *root = NewNode(IndexPageType::INTERNAL_PAGE);
+    root->PopulateNewRoot(old_page_id, separator, new_page_id);
+    root_page_id_ = root->GetPageId();
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+    return;
+  }
+
+  auto *parent = AsNode((*transaction->GetPageSet())[depth - 1]);
+  int index = parent->ChildIndexOf(old_page_id);
+  BUSTUB_ASSERT(index >= 0, "split page is not a child of the latched parent");
+  if (parent->HasRoomFor(separator.size())) {
+    parent->InsertChild(index + 1, separator, new_page_id);
+    return;
+  }
+
+  BPlusTreeVarlenPage *new_parent = NewNode(IndexPageType::INTERNAL_PAGE);
+  std::string parent_separator = parent->MoveHalfTo(new_parent);
+  if (index < parent->GetSize()) {
+    parent->InsertChild(index + 1, separator, new_page_id);
+  } else {
+    new_parent->InsertChild(index - parent->GetSize() + 1, separator, new_page_id);
+  }
+  InsertIntoParent(depth - 1, parent->GetPageId(), parent_separator, new_parent->GetPageId(), transaction);
+  buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+void VarlenBPlusTree::Remove(std::string_view key, Transaction *transaction) {
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  Page *page = FindLeafPageWrite(key, false, transaction);
+  if (page == nullptr) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  auto *leaf = AsNode(page);
+  int index = leaf->KeyIndex(key);
+  if (index == leaf->GetSize() || leaf->KeyAt(index) != key) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  BPlusTreePostingPage::Free(buffer_pool_manager_, leaf->RidAt(index));
+  leaf->RemoveAt(index);
+  ReleaseWriteLatches(transaction, true);
+}
+
+void VarlenBPlusTree::Remove(std::string_view key, const RID &rid, Transaction *transaction) {
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  Page *page = FindLeafPageWrite(key, false, transaction);
+  if (page == nullptr) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  auto *leaf = AsNode(page);
+  int index = leaf->KeyIndex(key);
+  if (index == leaf->GetSize() || leaf->KeyAt(index) != key) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  RID values = leaf->RidAt(index);
+  bool now_empty;
+  if (!BPlusTreePostingPage::Remove(buffer_pool_manager_, &values, rid, &now_empty)) {
+    ReleaseWriteLatches(transaction, false);
+    return;
+  }
+  if (now_empty) {
+    leaf->RemoveAt(index);
+  } else {
+    leaf->SetRidAt(index, values);
+  }
+  ReleaseWriteLatches(transaction, true);
+}
+
+/*****************************************************************************
+ * UTILITIES
+ *****************************************************************************/
+Page *VarlenBPlusTree::FindLeafPageRead(std::string_view key, bool left_most) {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (page == nullptr) {
+    root_latch_.RUnlock();
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch root page");
+  }
+  page->RLatch();
+  root_latch_.RUnlock();
+
+  auto *node = AsNode(page);
+  while (!node->IsLeafPage()) {
+    page_id_t child_id = node->ChildAt(left_most ? 0 : node->ChildIndex(key));
+    Page *child = buffer_pool_manager_->FetchPage(child_id);
+    if (child == nullptr) {
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch child page");
+    }
+    child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = AsNode(page);
+  }
+  return page;
+}
+
+/*
+ * Latch crabbing for writers as in BPlusTree::FindLeafPageWrite. A node is safe
+ * for an insert if it has room for the largest possible entry, since a split
+ * below may hand it a separator of any length up to MAX_KEY_SIZE.
+ */
+Page *VarlenBPlusTree::FindLeafPageWrite(std::string_view key, bool for_insert, Transaction *transaction) {
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      ReleaseWriteLatches(transaction, false);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch tree page");
+    }
+    page->WLatch();
+    auto *node = AsNode(page);
+    if (!for_insert || node->HasRoomFor(MAX_KEY_SIZE)) {
+      ReleaseWriteLatches(transaction, false);
+    }
+    transaction->AddIntoPageSet(page);
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    page_id = node->ChildAt(node->ChildIndex(key));
+  }
+}
+
+void VarlenBPlusTree::ReleaseWriteLatches(Transaction *transaction, bool is_dirty) {
+  auto page_set = transaction->GetPageSet();
+  while (!page_set->empty()) {
+    Page *page = page_set->front();
+    page_set->pop_front();
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+      continue;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+}
+
+/*****************************************************************************
+ * RANGE SCAN
+ *****************************************************************************/
+VarlenRangeScan::VarlenRangeScan(BufferPoolManager *buffer_pool_manager, Page *page, int index,
+                                 const std::string_view *high, bool high_inclusive)
+    : buffer_pool_manager_(buffer_pool_manager),
+      page_(page),
+      index_(index),
+      has_high_(high != nullptr),
+      high_inclusive_(high_inclusive) {
+  if (high != nullptr) {
+    high_ = std::string(*high);
+  }
+}
+
+VarlenRangeScan::~VarlenRangeScan() { Finish(); }
+
+bool VarlenRangeScan::NextBatch(std::vector<RID> *result) {
+  while (page_ != nullptr) {
+    page_->RLatch();
+    auto *leaf = AsNode(page_);
+    const int size = leaf->GetSize();
+    const page_id_t next_page_id = leaf->GetNextPageId();
+
+    // Only prefetch when the range runs past this leaf
+    bool range_ends_here = index_ < size && PastHigh(leaf->KeyAt(size - 1));
+    if (next_page_id != INVALID_PAGE_ID && !range_ends_here && !prefetch_.valid()) {
+      auto *bpm = buffer_pool_manager_;
+      prefetch_ = std::async(std::launch::async, [bpm, next_page_id] { return bpm->FetchPage(next_page_id); });
+    }
+
+    const size_t old_size = result->size();
+    for (; index_ < size; index_++) {
+      if (PastHigh(leaf->KeyAt(index_))) {
+        range_ends_here = true;
+        break;
+      }
+      BPlusTreePostingPage::Collect(buffer_pool_manager_, leaf->RidAt(index_), result);
+    }
+    page_->RUnlatch();
+
+    if (range_ends_here) {
+      Finish();
+    } else {
+      AdvanceLeaf(next_page_id);
+    }
+    if (result->size() != old_size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool VarlenRangeScan::PastHigh(std::string_view key) const {
+  if (!has_high_) {
+    return false;
+  }
+  int cmp = key.compare(high_);
+  return high_inclusive_ ? cmp > 0 : cmp >= 0;
+}
+
+void VarlenRangeScan::AdvanceLeaf(page_id_t next_page_id) {
+  // Release the current leaf before taking the next one, writers latch siblings right to left
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+  index_ = 0;
+  if (next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  if (prefetch_.valid()) {
+    page_ = prefetch_.get();
+  }
+  if (page_ == nullptr) {
+    page_ = buffer_pool_manager_->FetchPage(next_page_id);
+  }
+  if (page_ == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch next leaf page");
+  }
+}
+
+void VarlenRangeScan::Finish() {
+  if (prefetch_.valid()) {
+    Page *prefetched = prefetch_.get();
+    if (prefetched != nullptr) {
+      buffer_pool_manager_->UnpinPage(prefetched->GetPageId(), false);
+    }
+  }
+  if (page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+  }
+}
+
+}  // namespace bustub
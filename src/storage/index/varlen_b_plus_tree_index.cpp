@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_b_plus_tree_index.cpp
+//
+// Identification: src/storage/index/varlen_b_plus_tree_index.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/varlen_b_plus_tree_index.h"
+
+namespace bustub {
+
+VarlenBPlusTreeIndex::VarlenBPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata,
+                                           BufferPoolManager *buffer_pool_manager)
+    : Index(std::move(metadata)),
+      // secondary indexes map a key to every row holding it
+      container_(GetMetadata()->GetName(), buffer_pool_manager, false) {}
+
+void VarlenBPlusTreeIndex::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  std::string index_key;
+  VarlenKey::Encode(key, *GetKeySchema(), &index_key);
+  container_.Insert(index_key, rid, transaction);
+}
+
+void VarlenBPlusTreeIndex::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  std::string index_key;
+  VarlenKey::Encode(key, *GetKeySchema(), &index_key);
+  container_.Remove(index_key, rid, transaction);
+}
+
+void VarlenBPlusTreeIndex::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  std::string index_key;
+  VarlenKey::Encode(key, *GetKeySchema(), &index_key);
+  container_.GetValue(index_key, result, transaction);
+}
+
+std::unique_ptr<IndexRangeScan> VarlenBPlusTreeIndex::ScanRange(const Tuple *low_key, const Tuple *high_key,
+                                                                bool high_inclusive, Transaction *transaction) {
+  // construct range bound keys
+  std::string low;
+  std::string high;
+  if (low_key != nullptr) {
+    VarlenKey::Encode(*low_key, *GetKeySchema(), &low);
+  }
+  if (high_key != nullptr) {
+    VarlenKey::Encode(*high_key, *GetKeySchema(), &high);
+  }
+  std::string_view low_view(low);
+  std::string_view high_view(high);
+  auto iterator = container_.RangeScan(low_key == nullptr ? nullptr : &low_view,
+                                       high_key == nullptr ? nullptr : &high_view, high_inclusive);
+  return std::make_unique<VarlenBPlusTreeIndexRangeScan>(std::move(iterator));
+}
+
+}  // namespace bustub
@@ -0,0 +1,343 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_posting_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "storage/page/b_plus_tree_posting_page.h"
+
+namespace bustub {
+
+namespace {
+
+bool RidLess(const RID &lhs, const RID &rhs) {
+  return lhs.GetPageId() != rhs.GetPageId() ? lhs.GetPageId() < rhs.GetPageId() : lhs.GetSlotNum() < rhs.GetSlotNum();
+}
+
+size_t VarintSize(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+uint8_t *PutVarint(uint8_t *out, uint64_t value) {
+  while (value >= 0x80) {
+    *out++ = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<uint8_t>(value);
+  return out;
+}
+
+const uint8_t *GetVarint(const uint8_t *in, uint64_t *value) {
+  uint64_t result = 0;
+  for (int shift = 0;; shift += 7) {
+    uint8_t byte = *in++;
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  *value = result;
+  return in;
+}
+
+/** The varints encoding rid after prev: a same-page step, or a page step followed by the slot */
+void RidCodes(const RID &prev, const RID &rid, uint64_t *first, uint64_t *second, bool *has_second) {
+  if (rid.GetPageId() == prev.GetPageId()) {
+    *first = static_cast<uint64_t>(rid.GetSlotNum() - prev.GetSlotNum()) << 1;
+    *has_second = false;
+  } else {
+    *first = static_cast<uint64_t>(rid.GetPageId() - prev.GetPageId()) << 1 | 1;
+    *second = rid.GetSlotNum();
+    *has_second = true;
+  }
+}
+
+}  // namespace
+
+/*****************************************************************************
+ * PAGE LEVEL
+ *****************************************************************************/
+void BPlusTreePostingPage::Init() {
+  last_page_id_ = INVALID_PAGE_ID;
+  last_slot_num_ = 0;
+  next_page_id_ = INVALID_PAGE_ID;
+  count_ = 0;
+  bytes_ = 0;
+}
+
+size_t BPlusTreePostingPage::EncodedSize(const RID *rids, int count) {
+  size_t size = 0;
+  RID prev(0, 0);
+  for (int i = 0; i < count; i++) {
+    uint64_t first;
+    uint64_t second = 0;
+    bool has_second;
+    RidCodes(prev, rids[i], &first, &second, &has_second);
+    size += VarintSize(first) + (has_second ? VarintSize(second) : 0);
+    prev = rids[i];
+  }
+  return size;
+}
+
+void BPlusTreePostingPage::Encode(const RID *rids, int count) {
+  uint8_t *out = data_;
+  RID prev(0, 0);
+  for (int i = 0; i < count; i++) {
+    uint64_t first;
+    uint64_t second = 0;
+    bool has_second;
+    RidCodes(prev, rids[i], &first, &second, &has_second);
+    out = PutVarint(out, first);
+    if (has_second) {
+      out = PutVarint(out, second);
+    }
+    prev = rids[i];
+  }
+  BUSTUB_ASSERT(static_cast<size_t>(out - data_) <= CAPACITY, "posting page overflow");
+  count_ = count;
+  bytes_ = static_cast<int32_t>(out - data_);
+  last_page_id_ = prev.GetPageId();
+  last_slot_num_ = prev.GetSlotNum();
+}
+
+bool BPlusTreePostingPage::Append(const RID &rid) {
+  uint64_t first;
+  uint64_t second = 0;
+  bool has_second;
+  RidCodes(GetLastRid(), rid, &first, &second, &has_second);
+  size_t size = VarintSize(first) + (has_second ? VarintSize(second) : 0);
+  if (bytes_ + size > CAPACITY) {
+    return false;
+  }
+  uint8_t *out = PutVarint(data_ + bytes_, first);
+  if (has_second) {
+    out = PutVarint(out, second);
+  }
+  count_++;
+  bytes_ = static_cast<int32_t>(out - data_);
+  last_page_id_ = rid.GetPageId();
+  last_slot_num_ = rid.GetSlotNum();
+  return true;
+}
+
+void BPlusTreePostingPage::Decode(std::vector<RID> *result) const {
+  const uint8_t *in = data_;
+  page_id_t page_id = 0;
+  uint32_t slot_num = 0;
+  for (int i = 0; i < count_; i++) {
+    uint64_t code;
+    in = GetVarint(in, &code);
+    if ((code & 1) == 0) {
+      slot_num += static_cast<uint32_t>(code >> 1);
+    } else {
+      uint64_t slot;
+      in = GetVarint(in, &slot);
+      page_id += static_cast<page_id_t>(code >> 1);
+      slot_num = static_cast<uint32_t>(slot);
+    }
+    result->emplace_back(page_id, slot_num);
+  }
+}
+
+/*****************************************************************************
+ * CHAIN LEVEL
+ *****************************************************************************/
+BPlusTreePostingPage *BPlusTreePostingPage::NewPostingPage(BufferPoolManager *buffer_pool_manager, const RID *rids,
+                                                           int count, page_id_t *page_id) {
+  Page *page = buffer_pool_manager->NewPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate posting page");
+  }
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  posting->Init();
+  posting->Encode(rids, count);
+  return posting;
+}
+
+BPlusTreePostingPage *BPlusTreePostingPage::FetchPostingPage(BufferPoolManager *buffer_pool_manager,
+                                                             page_id_t page_id) {
+  Page *page = buffer_pool_manager->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch posting page");
+  }
+  return reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+}
+
+bool BPlusTreePostingPage::Insert(BufferPoolManager *buffer_pool_manager, RID *value, const RID &rid) {
+  if (!IsRef(*value)) {
+    if (*value == rid) {
+      return false;
+    }
+    RID rids[2] = {std::min(*value, rid, RidLess), std::max(*value, rid, RidLess)};
+    page_id_t head_page_id;
+    NewPostingPage(buffer_pool_manager, rids, 2, &head_page_id);
+    buffer_pool_manager->UnpinPage(head_page_id, true);
+    *value = MakeRef(head_page_id);
+    return true;
+  }
+
+  // the first page whose last RID is not below rid takes it, or the last page of the chain
+  page_id_t page_id = value->GetPageId();
+  BPlusTreePostingPage *posting = FetchPostingPage(buffer_pool_manager, page_id);
+  while (posting->GetNextPageId() != INVALID_PAGE_ID && RidLess(posting->GetLastRid(), rid)) {
+    page_id_t next_page_id = posting->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    page_id = next_page_id;
+    posting = FetchPostingPage(buffer_pool_manager, page_id);
+  }
+
+  // rows usually arrive in heap order: append to the tail page without decoding it
+  if (posting->GetNextPageId() == INVALID_PAGE_ID && RidLess(posting->GetLastRid(), rid)) {
+    if (posting->Append(rid)) {
+      buffer_pool_manager->UnpinPage(page_id, true);
+      return true;
+    }
+    // the tail is full, continue on a fresh page instead of splitting it
+    page_id_t new_page_id;
+    NewPostingPage(buffer_pool_manager, &rid, 1, &new_page_id);
+    posting->SetNextPageId(new_page_id);
+    buffer_pool_manager->UnpinPage(new_page_id, true);
+    buffer_pool_manager->UnpinPage(page_id, true);
+    return true;
+  }
+
+  std::vector<RID> rids;
+  rids.reserve(posting->GetCount() + 1);
+  posting->Decode(&rids);
+  auto it = std::lower_bound(rids.begin(), rids.end(), rid, RidLess);
+  if (it != rids.end() && *it == rid) {
+    buffer_pool_manager->UnpinPage(page_id, false);
+    return false;
+  }
+  rids.insert(it, rid);
+
+  const int count = static_cast<int>(rids.size());
+  if (EncodedSize(rids.data(), count) <= CAPACITY) {
+    posting->Encode(rids.data(), count);
+    buffer_pool_manager->UnpinPage(page_id, true);
+    return true;
+  }
+  // split the page, the upper half moves to a new page linked right after it
+  int half = count / 2;
+  page_id_t new_page_id;
+  BPlusTreePostingPage *new_posting =
+      NewPostingPage(buffer_pool_manager, rids.data() + half, count - half, &new_page_id);
+  new_posting->SetNextPageId(posting->GetNextPageId());
+  posting->Encode(rids.data(), half);
+  posting->SetNextPageId(new_page_id);
+  buffer_pool_manager->UnpinPage(new_page_id, true);
+  buffer_pool_manager->UnpinPage(page_id, true);
+  return true;
+}
+
+bool BPlusTreePostingPage::Remove(BufferPoolManager *buffer_pool_manager, RID *value, const RID &rid,
+                                  bool *now_empty) {
+  *now_empty = false;
+  if (!IsRef(*value)) {
+    if (!(*value == rid)) {
+      return false;
+    }
+    *now_empty = true;
+    return true;
+  }
+
+  const page_id_t head_page_id = value->GetPageId();
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = head_page_id;
+  BPlusTreePostingPage *posting = FetchPostingPage(buffer_pool_manager, page_id);
+  while (posting->GetNextPageId() != INVALID_PAGE_ID && RidLess(posting->GetLastRid(), rid)) {
+    page_id_t next_page_id = posting->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    prev_page_id = page_id;
+    page_id = next_page_id;
+    posting = FetchPostingPage(buffer_pool_manager, page_id);
+  }
+
+  std::vector<RID> rids;
+  posting->Decode(&rids);
+  auto it = std::lower_bound(rids.begin(), rids.end(), rid, RidLess);
+  if (it == rids.end() || !(*it == rid)) {
+    buffer_pool_manager->UnpinPage(page_id, false);
+    return false;
+  }
+  rids.erase(it);
+
+  if (!rids.empty()) {
+    posting->Encode(rids.data(), static_cast<int>(rids.size()));
+    buffer_pool_manager->UnpinPage(page_id, true);
+  } else if (prev_page_id == INVALID_PAGE_ID) {
+    // the head page emptied, a chain holds at least two RIDs so a next page exists: pull it into the head
+    page_id_t next_page_id = posting->GetNextPageId();
+    BPlusTreePostingPage *next_posting = FetchPostingPage(buffer_pool_manager, next_page_id);
+    memcpy(reinterpret_cast<char *>(posting), reinterpret_cast<char *>(next_posting), PAGE_SIZE);
+    buffer_pool_manager->UnpinPage(next_page_id, false);
+    buffer_pool_manager->DeletePage(next_page_id);
+    buffer_pool_manager->UnpinPage(page_id, true);
+  } else {
+    // unlink the emptied page
+    page_id_t next_page_id = posting->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    buffer_pool_manager->DeletePage(page_id);
+    BPlusTreePostingPage *prev_posting = FetchPostingPage(buffer_pool_manager, prev_page_id);
+    prev_posting->SetNextPageId(next_page_id);
+    buffer_pool_manager->UnpinPage(prev_page_id, true);
+  }
+
+  // fold a single remaining RID back into the leaf entry
+  BPlusTreePostingPage *head = FetchPostingPage(buffer_pool_manager, head_page_id);
+  if (head->GetCount() == 1 && head->GetNextPageId() == INVALID_PAGE_ID) {
+    *value = head->GetLastRid();
+    buffer_pool_manager->UnpinPage(head_page_id, false);
+    buffer_pool_manager->DeletePage(head_page_id);
+  } else {
+    buffer_pool_manager->UnpinPage(head_page_id, false);
+  }
+  return true;
+}
+
+void BPlusTreePostingPage::Collect(BufferPoolManager *buffer_pool_manager, const RID &value,
+                                   std::vector<RID> *result) {
+  if (!IsRef(value)) {
+    result->push_back(value);
+    return;
+  }
+  page_id_t page_id = value.GetPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    BPlusTreePostingPage *posting = FetchPostingPage(buffer_pool_manager, page_id);
+    posting->Decode(result);
+    page_id_t next_page_id = posting->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+void BPlusTreePostingPage::Free(BufferPoolManager *buffer_pool_manager, const RID &value) {
+  if (!IsRef(value)) {
+    return;
+  }
+  page_id_t page_id = value.GetPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    BPlusTreePostingPage *posting = FetchPostingPage(buffer_pool_manager, page_id);
+    page_id_t next_page_id = posting->GetNextPageId();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    buffer_pool_manager->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varlen_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_varlen_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_varlen_page.h"
+
+#include <cstring>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void BPlusTreeVarlenPage::Init(page_id_t page_id, IndexPageType page_type) {
+  page_type_ = page_type;
+  lsn_ = INVALID_LSN;
+  size_ = 0;
+  heap_start_ = PAGE_SIZE;
+  page_id_ = page_id;
+  next_page_id_ = INVALID_PAGE_ID;
+  garbage_bytes_ = 0;
+}
+
+std::string_view BPlusTreeVarlenPage::KeyAt(int index) const {
+  return std::string_view(Data() + slots_[index].offset_, slots_[index].key_size_);
+}
+
+RID BPlusTreeVarlenPage::RidAt(int index) const {
+  RID rid;
+  memcpy(&rid, ValueAt(index), sizeof(RID));
+  return rid;
+}
+
+void BPlusTreeVarlenPage::SetRidAt(int index, const RID &rid) { memcpy(ValueAt(index), &rid, sizeof(RID)); }
+
+page_id_t BPlusTreeVarlenPage::ChildAt(int index) const {
+  page_id_t child_page_id;
+  memcpy(&child_page_id, ValueAt(index), sizeof(page_id_t));
+  return child_page_id;
+}
+
+int BPlusTreeVarlenPage::KeyIndex(std::string_view key) const {
+  int low = 0;
+  int high = size_;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (KeyAt(mid) < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+int BPlusTreeVarlenPage::ChildIndex(std::string_view key) const {
+  // the last child whose separator is <= key, the first key is never compared
+  int low = 1;
+  int high = size_;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (KeyAt(mid) <= key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low - 1;
+}
+
+int BPlusTreeVarlenPage::ChildIndexOf(page_id_t child_page_id) const {
+  for (int i = 0; i < size_; i++) {
+    if (ChildAt(i) == child_page_id) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool BPlusTreeVarlenPage::HasRoomFor(size_t key_size) const {
+  return FreeBytes() + garbage_bytes_ >= key_size + ValueSize() + VARLEN_PAGE_SLOT_SIZE;
+}
+
+void BPlusTreeVarlenPage::InsertRid(int index, std::string_view key, const RID &rid) {
+  Insert(index, key, reinterpret_cast<const char *>(&rid));
+}
+
+void BPlusTreeVarlenPage::InsertChild(int index, std::string_view key, page_id_t child_page_id) {
+  Insert(index, key, reinterpret_cast<const char *>(&child_page_id));
+}
+
+void BPlusTreeVarlenPage::Insert(int index, std::string_view key, const char *value) {
+  const size_t entry_size = key.size() + ValueSize();
+  if (FreeBytes() < entry_size + VARLEN_PAGE_SLOT_SIZE) {
+    Compact();
+  }
+  BUSTUB_ASSERT(FreeBytes() >= entry_size + VARLEN_PAGE_SLOT_SIZE, "no room for varlen entry");
+  heap_start_ -= entry_size;
+  memcpy(Data() + heap_start_, key.data(), key.size());
+  memcpy(Data() + heap_start_ + key.size(), value, ValueSize());
+  memmove(slots_ + index + 1, slots_ + index, (size_ - index) * sizeof(Slot));
+  slots_[index] = Slot{static_cast<uint16_t>(heap_start_), static_cast<uint16_t>(key.size())};
+  size_++;
+}
+
+void BPlusTreeVarlenPage::RemoveAt(int index) {
+  garbage_bytes_ += EntrySize(index);
+  memmove(slots_ + index, slots_ + index + 1, (size_ - index - 1) * sizeof(Slot));
+  size_--;
+}
+
+std::string BPlusTreeVarlenPage::MoveHalfTo(BPlusTreeVarlenPage *recipient) {
+  size_t total = 0;
+  for (int i = 0; i < size_; i++) {
+    total += EntrySize(i);
+  }
+  // split by bytes rather than by count, both halves keep at least one entry
+  int split = 1;
+  for (size_t moved = EntrySize(0); split < size_ - 1 && moved + EntrySize(split) <= total / 2; split++) {
+    moved += EntrySize(split);
+  }
+
+  std::string separator(KeyAt(split));
+  for (int i = split; i < size_; i++) {
+    std::string_view key = i == split && !IsLeafPage() ? std::string_view() : KeyAt(i);
+    recipient->Insert(i - split, key, ValueAt(i));
+    garbage_bytes_ += EntrySize(i);
+  }
+  size_ = split;
+  Compact();
+  return separator;
+}
+
+void BPlusTreeVarlenPage::PopulateNewRoot(page_id_t old_page_id, std::string_view key, page_id_t new_page_id) {
+  InsertChild(0, std::string_view(), old_page_id);
+  InsertChild(1, key, new_page_id);
+}
+
+void BPlusTreeVarlenPage::Compact() {
+  char heap[PAGE_SIZE];
+  size_t heap_start = PAGE_SIZE;
+  for (int i = 0; i < size_; i++) {
+    const size_t entry_size = EntrySize(i);
+    heap_start -= entry_size;
+    memcpy(heap + heap_start, Data() + slots_[i].offset_, entry_size);
+    slots_[i].offset_ = static_cast<uint16_t>(heap_start);
+  }
+  memcpy(Data() + heap_start, heap + heap_start, PAGE_SIZE - heap_start);
+  heap_start_ = heap_start;
+  garbage_bytes_ = 0;
+}
+
+}  // namespace bustub
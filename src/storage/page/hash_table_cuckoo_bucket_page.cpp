@@ -0,0 +1,140 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_cuckoo_bucket_page.cpp
+//
+// Identification: src/storage/page/hash_table_cuckoo_bucket_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_cuckoo_bucket_page.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <thread>  // NOLINT
+
+#include "storage/index/generic_key.h"
+#include "storage/index/integer_key.h"
+
+namespace bustub {
+
+static_assert(sizeof(std::atomic<uint64_t>) + 2 * sizeof(uint32_t) == CUCKOO_BUCKET_HEADER_SIZE,
+              "the tag array starts right after the version and the size");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the version lives in the page itself");
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_CUCKOO_BUCKET_TYPE::MatchGroup(uint32_t group, uint8_t tag) const {
+  const uint8_t *tags = tags_ + group * BUCKET_TAG_GROUP_SIZE;
+#ifdef __SSE2__
+  const __m128i group_tags = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group_tags, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < BUCKET_TAG_GROUP_SIZE; i++) {
+    mask |= static_cast<uint32_t>(tags[i] == tag) << i;
+  }
+  return mask;
+#endif
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint64_t HASH_TABLE_CUCKOO_BUCKET_TYPE::ReadBegin() const {
+  uint64_t version = version_.load(std::memory_order_acquire);
+  while ((version & 1) != 0) {
+    std::this_thread::yield();
+    version = version_.load(std::memory_order_acquire);
+  }
+  return version;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_CUCKOO_BUCKET_TYPE::ReadValidate(uint64_t version) const {
+  // keeps the reads of the bucket from moving past the second read of the version
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return version_.load(std::memory_order_relaxed) == version;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_CUCKOO_BUCKET_TYPE::WriteBegin() {
+  version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  // keeps the writes to the bucket from moving ahead of the odd version
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_CUCKOO_BUCKET_TYPE::WriteEnd() {
+  version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/*
+ * A concurrent write may leave size_ at any value, so it is clamped to keep
+ * the scan inside the page; the copy is thrown away in that case anyway.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_CUCKOO_BUCKET_TYPE::CollectTagMatches(uint8_t tag, std::vector<MappingType> *matches) const {
+  const uint32_t size = std::min<uint32_t>(size_, CUCKOO_BUCKET_ARRAY_SIZE);
+  for (uint32_t group = 0; group * BUCKET_TAG_GROUP_SIZE < size; group++) {
+    for (uint32_t hits = MatchGroup(group, tag); hits != 0; hits &= hits - 1) {
+      const uint32_t bucket_idx = group * BUCKET_TAG_GROUP_SIZE + __builtin_ctz(hits);
+      if (bucket_idx >= size) {
+        break;
+      }
+      matches->push_back(array_[bucket_idx]);
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int64_t HASH_TABLE_CUCKOO_BUCKET_TYPE::Find(const KeyType &key, const ValueType &value, uint8_t tag,
+                                            KeyComparator cmp) const {
+  for (uint32_t group = 0; group * BUCKET_TAG_GROUP_SIZE < size_; group++) {
+    for (uint32_t hits = MatchGroup(group, tag); hits != 0; hits &= hits - 1) {
+      const uint32_t bucket_idx = group * BUCKET_TAG_GROUP_SIZE + __builtin_ctz(hits);
+      if (bucket_idx >= size_) {
+        break;
+      }
+      if (cmp(key, array_[bucket_idx].first) == 0 && value == array_[bucket_idx].second) {
+        return bucket_idx;
+      }
+    }
+  }
+  return -1;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_CUCKOO_BUCKET_TYPE::Insert(const KeyType &key, const ValueType &value, uint8_t tag) {
+  if (IsFull()) {
+    return false;
+  }
+  array_[size_] = MappingType(key, value);
+  tags_[size_] = tag;
+  size_++;
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_CUCKOO_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
+  size_--;
+  array_[bucket_idx] = array_[size_];
+  tags_[bucket_idx] = tags_[size_];
+}
+
+template class HashTableCuckooBucketPage<int, int, IntComparator>;
+
+template class HashTableCuckooBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableCuckooBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableCuckooBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableCuckooBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableCuckooBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+template class HashTableCuckooBucketPage<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class HashTableCuckooBucketPage<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class HashTableCuckooBucketPage<IntegerKey<16>, RID, IntegerComparator<16>>;
+
+}  // namespace bustub
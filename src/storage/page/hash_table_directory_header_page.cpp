@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_header_page.cpp
+//
+// Identification: src/storage/page/hash_table_directory_header_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_directory_header_page.h"
+
+#include <cassert>
+
+namespace bustub {
+page_id_t HashTableDirectoryHeaderPage::GetPageId() const { return page_id_; }
+
+void HashTableDirectoryHeaderPage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
+
+lsn_t HashTableDirectoryHeaderPage::GetLSN() const { return lsn_; }
+
+void HashTableDirectoryHeaderPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+page_id_t HashTableDirectoryHeaderPage::GetDirectoryPageId(uint32_t directory_idx) const {
+  return directory_page_ids_[directory_idx];
+}
+
+void HashTableDirectoryHeaderPage::SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id) {
+  directory_page_ids_[directory_idx] = directory_page_id;
+}
+
+uint32_t HashTableDirectoryHeaderPage::GetGlobalDepth() const { return global_depth_; }
+
+uint32_t HashTableDirectoryHeaderPage::GetGlobalDepthMask() const { return (1U << global_depth_) - 1; }
+
+void HashTableDirectoryHeaderPage::IncrGlobalDepth() {
+  assert(CanGrow());
+  global_depth_++;
+}
+
+void HashTableDirectoryHeaderPage::DecrGlobalDepth() { global_depth_--; }
+
+uint32_t HashTableDirectoryHeaderPage::Size() const { return 1U << global_depth_; }
+
+bool HashTableDirectoryHeaderPage::CanGrow() const {
+  return Size() < DIRECTORY_ARRAY_SIZE * DIRECTORY_HEADER_ARRAY_SIZE;
+}
+
+uint32_t HashTableDirectoryHeaderPage::NumDirectoryPages() const { return DirectoryIndex(Size() - 1) + 1; }
+
+}  // namespace bustub
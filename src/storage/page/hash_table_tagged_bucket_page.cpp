@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_tagged_bucket_page.cpp
+//
+// Identification: src/storage/page/hash_table_tagged_bucket_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_tagged_bucket_page.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "storage/index/generic_key.h"
+#include "storage/index/integer_key.h"
+
+namespace bustub {
+
+static_assert(BUCKET_TAG_GROUP_SIZE == 16, "tag groups are matched as one 128-bit vector");
+static_assert(sizeof(page_id_t) + sizeof(uint32_t) + sizeof(uint64_t) == TAGGED_BUCKET_HEADER_SIZE,
+              "the tag array starts right after the overflow page id and hash");
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_TAGGED_BUCKET_TYPE::MatchGroup(uint32_t group, uint8_t tag) const {
+  const uint8_t *tags = tags_ + group * BUCKET_TAG_GROUP_SIZE;
+#ifdef __SSE2__
+  const __m128i group_tags = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group_tags, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < BUCKET_TAG_GROUP_SIZE; i++) {
+    mask |= static_cast<uint32_t>(tags[i] == tag) << i;
+  }
+  return mask;
+#endif
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_TAGGED_BUCKET_TYPE::ReadableInGroup(uint32_t group) const {
+  const uint8_t *tags = tags_ + group * BUCKET_TAG_GROUP_SIZE;
+#ifdef __SSE2__
+  // the readable bit is the sign bit of each byte, which is exactly what movemask collects
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(tags))));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < BUCKET_TAG_GROUP_SIZE; i++) {
+    mask |= static_cast<uint32_t>((tags[i] & READABLE_TAG_BIT) != 0) << i;
+  }
+  return mask;
+#endif
+}
+
+/*
+ * Slots are taken in order and a slot stays occupied once used, so every scan
+ * can stop after the first group holding a slot that was never occupied.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TAGGED_BUCKET_TYPE::GetValue(KeyType key, uint32_t hash, KeyComparator cmp,
+                                             std::vector<ValueType> *result) {
+  const uint8_t tag = TagOf(hash);
+  bool found = false;
+  for (uint32_t group = 0; group < NUM_GROUPS; group++) {
+    for (uint32_t hits = MatchGroup(group, tag); hits != 0; hits &= hits - 1) {
+      const uint32_t bucket_idx = group * BUCKET_TAG_GROUP_SIZE + __builtin_ctz(hits);
+      if (cmp(key, array_[bucket_idx].first) == 0) {
+        result->push_back(array_[bucket_idx].second);
+        found = true;
+      }
+    }
+    if (MatchGroup(group, EMPTY_TAG) != 0) {
+      break;
+    }
+  }
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TAGGED_BUCKET_TYPE::Insert(KeyType key, ValueType value, uint32_t hash, KeyComparator cmp) {
+  const uint8_t tag = TagOf(hash);
+  int64_t free_idx = -1;
+  for (uint32_t group = 0; group < NUM_GROUPS; group++) {
+    for (uint32_t hits = MatchGroup(group, tag); hits != 0; hits &= hits - 1) {
+      const uint32_t bucket_idx = group * BUCKET_TAG_GROUP_SIZE + __builtin_ctz(hits);
+      if (cmp(key, array_[bucket_idx].first) == 0 && value == array_[bucket_idx].second) {
+        return false;
+      }
+    }
+    const uint32_t empty = MatchGroup(group, EMPTY_TAG);
+    const uint32_t free = empty | MatchGroup(group, TOMBSTONE_TAG);
+    if (free_idx == -1 && free != 0) {
+      // the padding after the last slot reads as empty, so the slot may be past the end of the bucket
+      const uint32_t bucket_idx = group * BUCKET_TAG_GROUP_SIZE + __builtin_ctz(free);
+      if (bucket_idx < TAGGED_BUCKET_ARRAY_SIZE) {
+        free_idx = bucket_idx;
+      }
+    }
+    if (empty != 0) {
+      break;
+    }
+  }
+  if (free_idx == -1) {
+    return false;
+  }
+  array_[free_idx] = MappingType(key, value);
+  tags_[free_idx] = tag;
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TAGGED_BUCKET_TYPE::Remove(KeyType key, ValueType value, uint32_t hash, KeyComparator cmp) {
+  const uint8_t tag = TagOf(hash);
+  for (uint32_t group = 0; group < NUM_GROUPS; group++) {
+    for (uint32_t hits = MatchGroup(group, tag); hits != 0; hits &= hits - 1) {
+      const uint32_t bucket_idx = group * BUCKET_TAG_GROUP_SIZE + __builtin_ctz(hits);
+      if (cmp(key, array_[bucket_idx].first) == 0 && value == array_[bucket_idx].second) {
+        RemoveAt(bucket_idx);
+        return true;
+      }
+    }
+    if (MatchGroup(group, EMPTY_TAG) != 0) {
+      break;
+    }
+  }
+  return false;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_TAGGED_BUCKET_TYPE::NumReadable() const {
+  uint32_t count = 0;
+  for (uint32_t group = 0; group < NUM_GROUPS; group++) {
+    count += __builtin_popcount(ReadableInGroup(group));
+  }
+  return count;
+}
+
+template class HashTableTaggedBucketPage<int, int, IntComparator>;
+
+template class HashTableTaggedBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableTaggedBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableTaggedBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableTaggedBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableTaggedBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+template class HashTableTaggedBucketPage<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class HashTableTaggedBucketPage<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class HashTableTaggedBucketPage<IntegerKey<16>, RID, IntegerComparator<16>>;
+
+}  // namespace bustub
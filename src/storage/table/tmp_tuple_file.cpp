@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tmp_tuple_file.cpp
+//
+// Identification: src/storage/table/tmp_tuple_file.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/tmp_tuple_file.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+TmpTupleFile::~TmpTupleFile() {
+  Finish();
+  for (page_id_t page_id : page_ids_) {
+    bpm_->DeletePage(page_id);
+  }
+}
+
+TmpTuple TmpTupleFile::Append(const Tuple &tuple) {
+  TmpTuple tmp_tuple(INVALID_PAGE_ID, 0);
+  if (current_ == nullptr || !current_->Insert(tuple, &tmp_tuple)) {
+    Finish();
+    page_id_t page_id;
+    current_ = reinterpret_cast<TmpTuplePage *>(bpm_->NewPage(&page_id));
+    if (current_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame free for a temporary tuple page");
+    }
+    page_ids_.push_back(page_id);
+    current_->Init(page_id, PAGE_SIZE);
+    [[maybe_unused]] bool inserted = current_->Insert(tuple, &tmp_tuple);
+    BUSTUB_ASSERT(inserted, "a tuple fits in an empty page");
+  }
+  num_tuples_++;
+  return tmp_tuple;
+}
+
+void TmpTupleFile::Finish() {
+  if (current_ != nullptr) {
+    bpm_->UnpinPage(page_ids_.back(), true);
+    current_ = nullptr;
+  }
+}
+
+void TmpTupleFile::ReadPage(size_t page, std::vector<Tuple> *tuples) {
+  BUSTUB_ASSERT(current_ == nullptr, "the file is finished");
+  const page_id_t page_id = page_ids_[page];
+  auto *tmp_page = reinterpret_cast<TmpTuplePage *>(bpm_->FetchPage(page_id));
+  if (tmp_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame free to read a temporary tuple page");
+  }
+  // the page holds its tuples last to first
+  const size_t first = tuples->size();
+  for (size_t offset = tmp_page->GetFreeSpacePointer(); offset < PAGE_SIZE; offset = tmp_page->NextOffset(offset)) {
+    Tuple tuple;
+    tmp_page->Get(offset, &tuple);
+    tuples->push_back(std::move(tuple));
+  }
+  std::reverse(tuples->begin() + first, tuples->end());
+  bpm_->UnpinPage(page_id, false);
+}
+
+}  // namespace bustub
@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena_test.cpp
+//
+// Identification: test/common/arena_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "common/arena.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ArenaTest, AllocateTest) {
+  Arena arena(1024);
+  EXPECT_EQ(0, arena.MemoryUsage());
+
+  // allocations are aligned as asked and never overlap, across many blocks
+  std::vector<std::pair<char *, size_t>> allocations;
+  for (size_t i = 0; i < 2000; i++) {
+    const size_t size = 1 + i % 100;
+    const size_t alignment = size_t{1} << (i % 7);
+    auto *memory = static_cast<char *>(arena.Allocate(size, alignment));
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(memory) % alignment);
+    memset(memory, static_cast<int>(i % 256), size);
+    allocations.emplace_back(memory, size);
+  }
+  for (size_t i = 0; i < allocations.size(); i++) {
+    for (size_t j = 0; j < allocations[i].second; j++) {
+      ASSERT_EQ(static_cast<char>(i % 256), allocations[i].first[j]) << i;
+    }
+  }
+  EXPECT_GT(arena.MemoryUsage(), 1024);
+
+  // an allocation larger than any block gets a block of its own
+  const size_t large = Arena::MAX_BLOCK_SIZE + 1;
+  auto *memory = static_cast<char *>(arena.Allocate(large, 64));
+  ASSERT_EQ(0, reinterpret_cast<uintptr_t>(memory) % 64);
+  memory[0] = 1;
+  memory[large - 1] = 1;
+  EXPECT_GT(arena.MemoryUsage(), large);
+
+  // memory stays where it was when the arena moves
+  Arena moved(std::move(arena));
+  EXPECT_EQ(0, arena.MemoryUsage());  // NOLINT
+  EXPECT_EQ(static_cast<char>(5), allocations[5].first[0]);
+  moved.Reset();
+  EXPECT_EQ(0, moved.MemoryUsage());
+  EXPECT_NE(nullptr, moved.Allocate(8));
+}
+
+}  // namespace bustub
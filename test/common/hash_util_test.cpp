@@ -0,0 +1,223 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_util_test.cpp
+//
+// Identification: test/common/hash_util_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "container/hash/hash_function.h"
+#include "gtest/gtest.h"
+#include "murmur3/MurmurHash3.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// The largest bucket a table of num_buckets gets, when keys are bucketed by the bits of hash selected by the caller
+template <typename BucketOf>
+static size_t MaxBucketLoad(const std::vector<hash_t> &hashes, size_t num_buckets, BucketOf bucket_of) {
+  std::vector<size_t> load(num_buckets, 0);
+  for (hash_t hash : hashes) {
+    load[bucket_of(hash)]++;
+  }
+  return *std::max_element(load.begin(), load.end());
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, BatchMatchesScalarTest) {
+  std::vector<int64_t> ints;
+  std::vector<std::string> strings;
+  for (int64_t i = -500; i < 500; i++) {
+    ints.push_back(i * 7919);
+    strings.push_back(std::string(static_cast<size_t>(i + 500) % 70, static_cast<char>('a' + i % 26)));
+  }
+
+  std::vector<hash_t> batch(ints.size());
+  HashUtil::HashInts(ints.data(), ints.size(), batch.data());
+  for (size_t i = 0; i < ints.size(); i++) {
+    EXPECT_EQ(HashUtil::HashInt(static_cast<uint64_t>(ints[i])), batch[i]);
+    EXPECT_EQ(HashUtil::Hash(&ints[i]), batch[i]);
+  }
+
+  std::vector<const char *> bytes;
+  std::vector<size_t> lengths;
+  for (const auto &s : strings) {
+    bytes.push_back(s.data());
+    lengths.push_back(s.size());
+  }
+  HashUtil::HashBytesBatch(bytes.data(), lengths.data(), strings.size(), batch.data());
+  for (size_t i = 0; i < strings.size(); i++) {
+    EXPECT_EQ(HashUtil::HashBytes(strings[i].data(), strings[i].size()), batch[i]);
+  }
+
+  // every integer type hashes like its sign-extended 64-bit value
+  for (TypeId type : {TypeId::TINYINT, TypeId::SMALLINT, TypeId::INTEGER, TypeId::BIGINT, TypeId::VARCHAR}) {
+    std::vector<Value> values;
+    for (size_t i = 0; i < ints.size(); i++) {
+      switch (type) {
+        case TypeId::TINYINT:
+          values.push_back(ValueFactory::GetTinyIntValue(static_cast<int8_t>(ints[i] % 100)));
+          break;
+        case TypeId::SMALLINT:
+          values.push_back(ValueFactory::GetSmallIntValue(static_cast<int16_t>(ints[i] % 30000)));
+          break;
+        case TypeId::INTEGER:
+          values.push_back(ValueFactory::GetIntegerValue(static_cast<int32_t>(ints[i])));
+          break;
+        case TypeId::BIGINT:
+          values.push_back(ValueFactory::GetBigIntValue(ints[i]));
+          break;
+        default:
+          values.push_back(ValueFactory::GetVarcharValue(strings[i]));
+      }
+    }
+    HashUtil::HashValues(values.data(), values.size(), batch.data());
+    for (size_t i = 0; i < values.size(); i++) {
+      EXPECT_EQ(HashUtil::HashValue(&values[i]), batch[i]);
+    }
+  }
+
+  HashFunction<GenericKey<16>> hash_fn;
+  std::vector<GenericKey<16>> keys(ints.size());
+  for (size_t i = 0; i < ints.size(); i++) {
+    keys[i].SetFromInteger(ints[i]);
+  }
+  hash_fn.GetHashBatch(keys.data(), keys.size(), batch.data());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(hash_fn.GetHash(keys[i]), batch[i]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, DistributionTest) {
+  // dense and strided integer keys spread evenly over the low bits, which index the extendible hash directory,
+  // and over bits 25..31, which tag its bucket slots
+  const size_t num_keys = 1 << 16;
+  for (uint64_t stride : {1, 2, 1024, 1 << 20}) {
+    std::vector<uint64_t> keys(num_keys);
+    for (size_t i = 0; i < num_keys; i++) {
+      keys[i] = i * stride;
+    }
+    std::vector<hash_t> hashes(num_keys);
+    HashUtil::HashInts(keys.data(), num_keys, hashes.data());
+    EXPECT_EQ(num_keys, std::unordered_set<hash_t>(hashes.begin(), hashes.end()).size());
+    EXPECT_LT(MaxBucketLoad(hashes, 1024, [](hash_t h) { return h & 1023; }), 2 * num_keys / 1024) << stride;
+    EXPECT_LT(MaxBucketLoad(hashes, 128, [](hash_t h) { return static_cast<uint32_t>(h) >> 25; }),
+              2 * num_keys / 128)
+        << stride;
+  }
+
+  // keys differing in one byte, or only in trailing zero bytes, get different hashes
+  std::vector<hash_t> hashes;
+  for (size_t length = 0; length < 40; length++) {
+    std::string s(length, '\0');
+    hashes.push_back(HashUtil::HashBytes(s.data(), s.size()));
+    for (size_t pos = 0; pos < length; pos++) {
+      for (char c : {'\x01', '\x80'}) {
+        s[pos] = c;
+        hashes.push_back(HashUtil::HashBytes(s.data(), s.size()));
+        s[pos] = '\0';
+      }
+    }
+  }
+  EXPECT_EQ(hashes.size(), std::unordered_set<hash_t>(hashes.begin(), hashes.end()).size());
+  EXPECT_LT(MaxBucketLoad(hashes, 64, [](hash_t h) { return h & 63; }), 2 * hashes.size() / 64);
+}
+
+// Hashes per microsecond for integer keys and for byte strings, against murmur3 and the old byte-at-a-time loop.
+// NOLINTNEXTLINE
+TEST(HashUtilTest, DISABLED_ThroughputBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  const size_t num_keys = 1 << 20;
+  const int rounds = 10;
+  auto report = [&](const std::string &name, auto &&hash_all) {
+    hash_t sink = 0;
+    const auto start = Clock::now();
+    for (int r = 0; r < rounds; r++) {
+      sink += hash_all();
+    }
+    const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    std::cout << name << ": " << num_keys * rounds / us << " hashes/us (" << sink % 2 << ")" << std::endl;
+  };
+  auto murmur = [](const void *data, size_t length) {
+    uint64_t hash[2];
+    murmur3::MurmurHash3_x64_128(data, static_cast<int>(length), 0, reinterpret_cast<void *>(&hash));
+    return hash[0];
+  };
+  auto byte_loop = [](const char *bytes, size_t length) {
+    hash_t hash = length;
+    for (size_t i = 0; i < length; ++i) {
+      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+    }
+    return hash;
+  };
+
+  std::vector<int64_t> ints(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    ints[i] = static_cast<int64_t>(i * 2654435761U);
+  }
+  std::vector<hash_t> out(num_keys);
+  report("int64 HashInts", [&] {
+    HashUtil::HashInts(ints.data(), num_keys, out.data());
+    return out[num_keys / 2];
+  });
+  report("int64 murmur3", [&] {
+    for (size_t i = 0; i < num_keys; i++) {
+      out[i] = murmur(&ints[i], sizeof(int64_t));
+    }
+    return out[num_keys / 2];
+  });
+  report("int64 byte loop", [&] {
+    for (size_t i = 0; i < num_keys; i++) {
+      out[i] = byte_loop(reinterpret_cast<const char *>(&ints[i]), sizeof(int64_t));
+    }
+    return out[num_keys / 2];
+  });
+
+  for (size_t length : {16, 64}) {
+    std::vector<char> data(num_keys / 4 * length);
+    for (size_t i = 0; i < data.size(); i++) {
+      data[i] = static_cast<char>(i * 31);
+    }
+    const size_t num_strings = data.size() / length;
+    std::vector<const char *> bytes(num_strings);
+    std::vector<size_t> lengths(num_strings, length);
+    for (size_t i = 0; i < num_strings; i++) {
+      bytes[i] = data.data() + i * length;
+    }
+    const std::string suffix = "-byte string";
+    report(std::to_string(length) + suffix + " HashBytesBatch", [&] {
+      for (int k = 0; k < 4; k++) {
+        HashUtil::HashBytesBatch(bytes.data(), lengths.data(), num_strings, out.data() + k * num_strings);
+      }
+      return out[num_keys / 2];
+    });
+    report(std::to_string(length) + suffix + " murmur3", [&] {
+      for (size_t i = 0; i < num_keys; i++) {
+        out[i] = murmur(bytes[i % num_strings], length);
+      }
+      return out[num_keys / 2];
+    });
+    report(std::to_string(length) + suffix + " byte loop", [&] {
+      for (size_t i = 0; i < num_keys; i++) {
+        out[i] = byte_loop(bytes[i % num_strings], length);
+      }
+      return out[num_keys / 2];
+    });
+  }
+}
+
+}  // namespace bustub
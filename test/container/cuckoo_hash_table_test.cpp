@@ -0,0 +1,260 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// cuckoo_hash_table_test.cpp
+//
+// Identification: test/container/cuckoo_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "container/hash/cuckoo_hash_table.h"
+#include "container/hash/extendible_hash_table.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(CuckooHashTableTest, InsertRemoveTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  CuckooHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 3, HashFunction<int>());
+  EXPECT_EQ(4, ht.GetNumBuckets());
+
+  // grow through several doublings, with a second value for every fifth key
+  const int num_keys = 50000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    if (i % 5 == 0) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, -i - 1));
+    }
+  }
+  EXPECT_EQ(num_keys + num_keys / 5, ht.GetSize());
+  EXPECT_GT(ht.GetNumBuckets(), 4);
+  EXPECT_FALSE(ht.Insert(nullptr, 5, 5));
+  EXPECT_FALSE(ht.Insert(nullptr, 5, -6));
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+    std::sort(res.begin(), res.end());
+    if (i % 5 == 0) {
+      EXPECT_EQ((std::vector<int>{-i - 1, i}), res);
+    } else {
+      EXPECT_EQ(std::vector<int>{i}, res);
+    }
+  }
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, num_keys, &res));
+
+  for (int i = 0; i < num_keys; i += 2) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  EXPECT_FALSE(ht.Remove(nullptr, 0, 0));
+  for (int i = 0; i < num_keys; i++) {
+    res.clear();
+    EXPECT_EQ(i % 2 == 1 || i % 5 == 0, ht.GetValue(nullptr, i, &res)) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(CuckooHashTableTest, HotKeyTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  CuckooHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 16, HashFunction<int>());
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+
+  // one key's values fill its two buckets, pushing the other keys out, and then inserts of it fail
+  int num_values = 0;
+  while (ht.Insert(nullptr, -1, num_values)) {
+    num_values++;
+  }
+  const size_t bucket_size = (PAGE_SIZE - CUCKOO_BUCKET_HEADER_SIZE - BUCKET_TAG_GROUP_SIZE) / (2 * sizeof(int) + 1);
+  EXPECT_GE(num_values, bucket_size);
+  EXPECT_LE(num_values, 2 * bucket_size);
+  EXPECT_EQ(16, ht.GetNumBuckets());
+
+  std::vector<int> res;
+  ASSERT_TRUE(ht.GetValue(nullptr, -1, &res));
+  EXPECT_EQ(num_values, res.size());
+  for (int i = 0; i < 2000; i++) {
+    res.clear();
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(CuckooHashTableTest, ConcurrentLookupTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  CuckooHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2, HashFunction<int>());
+
+  // readers keep finding keys that are already in while the writer moves pairs around and doubles the table
+  const int num_keys = 30000;
+  std::atomic<int> inserted{0};
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 2; t++) {
+    readers.emplace_back([&ht, &inserted, &done, t] {
+      int probe = t;
+      while (!done.load()) {
+        const int limit = inserted.load();
+        if (limit == 0) {
+          continue;
+        }
+        const int key = probe++ * 7919 % limit;
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, key, &res)) << key;
+        EXPECT_EQ(std::vector<int>{key}, res) << key;
+      }
+    });
+  }
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    // a key that comes and goes moves other pairs about without changing what the readers look for
+    ASSERT_TRUE(ht.Insert(nullptr, -i - 1, i));
+    inserted.store(i + 1);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(ht.Remove(nullptr, -i - 1, i));
+    }
+  }
+  done.store(true);
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(CuckooHashTableTest, CatalogIndexTest) {
+  auto disk_manager = std::make_unique<DiskManager>("cuckoo_hash_table_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  Schema schema{{Column{"id", TypeId::INTEGER}, Column{"name", TypeId::VARCHAR, 16}}};
+  auto *table_info = catalog->CreateTable(txn.get(), "t", schema);
+  for (int i = 0; i < 1000; i++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(i % 500), ValueFactory::GetVarcharValue(std::to_string(i))}, &schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn.get()));
+  }
+
+  Schema key_schema{{Column{"id", TypeId::INTEGER}}};
+  auto *index_info = catalog->CreateIndex(txn.get(), "id_idx", "t", schema, key_schema, {0}, 4,
+                                          IndexType::CuckooHashTableIndex);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+  using IntCuckooIndex = CuckooHashTableIndex<IntegerKey<4>, RID, IntegerComparator<4>>;
+  ASSERT_NE(nullptr, dynamic_cast<IntCuckooIndex *>(index_info->index_.get()));
+
+  std::vector<RID> rids;
+  index_info->index_->ScanKey(Tuple{{ValueFactory::GetIntegerValue(7)}, &key_schema}, &rids, txn.get());
+  ASSERT_EQ(2, rids.size());
+  std::vector<std::string> names;
+  for (const auto &rid : rids) {
+    Tuple tuple;
+    ASSERT_TRUE(table_info->table_->GetTuple(rid, &tuple, txn.get()));
+    names.push_back(tuple.GetValue(&schema, 1).ToString());
+  }
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ((std::vector<std::string>{"507", "7"}), names);
+
+  rids.clear();
+  index_info->index_->ScanKey(Tuple{{ValueFactory::GetIntegerValue(500)}, &key_schema}, &rids, txn.get());
+  EXPECT_TRUE(rids.empty());
+
+  remove("cuckoo_hash_table_test.db");
+  remove("cuckoo_hash_table_test.log");
+}
+
+// Lookup latency of present keys in the three hash tables behind the hash indexes, with the keys and values the
+// indexes store, all pages resident in the buffer pool. The key count stays below what the linear probe table's single
+// header page can address.
+// NOLINTNEXTLINE
+TEST(CuckooHashTableTest, DISABLED_LookupLatencyBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  using KeyType = GenericKey<8>;
+  using KeyComparator = GenericComparator<8>;
+  const int num_keys = 150000;
+  Schema key_schema{{Column{"k", TypeId::BIGINT}}};
+  KeyComparator comparator(&key_schema);
+  auto key_of = [](int i) {
+    KeyType key;
+    key.SetFromInteger(i);
+    return key;
+  };
+
+  auto run = [&](const std::string &name, auto *ht) {
+    for (int i = 0; i < num_keys; i++) {
+      ht->Insert(nullptr, key_of(i), RID(i, i));
+    }
+    std::vector<double> latencies;
+    latencies.reserve(num_keys);
+    std::vector<RID> res;
+    for (int i = 0; i < num_keys; i++) {
+      const KeyType key = key_of(static_cast<int>(i * 2654435761ULL % num_keys));
+      res.clear();
+      const auto start = Clock::now();
+      ht->GetValue(nullptr, key, &res);
+      latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+      ASSERT_EQ(1, res.size());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    std::cout << name << ": p50 " << percentile(0.5) << " ns, p99 " << percentile(0.99) << " ns, p99.9 "
+              << percentile(0.999) << " ns, max " << latencies.back() << " ns" << std::endl;
+  };
+
+  for (int table = 0; table < 3; table++) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(20000, disk_manager);
+    if (table == 0) {
+      ExtendibleHashTable<KeyType, RID, KeyComparator> ht("blah", bpm, comparator, HashFunction<KeyType>());
+      run("ExtendibleHashTable", &ht);
+    } else if (table == 1) {
+      LinearProbeHashTable<KeyType, RID, KeyComparator> ht("blah", bpm, comparator, 1000, HashFunction<KeyType>());
+      run("LinearProbeHashTable", &ht);
+    } else {
+      CuckooHashTable<KeyType, RID, KeyComparator> ht("blah", bpm, comparator, 2, HashFunction<KeyType>());
+      run("CuckooHashTable", &ht);
+    }
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete disk_manager;
+    delete bpm;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,222 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// flat_hash_table_test.cpp
+//
+// Identification: test/container/flat_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "container/hash/flat_hash_table.h"
+#include "container/hash/partitioned_flat_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FlatHashTableTest, InsertFindTest) {
+  FlatHashTable<int64_t, int64_t> table;
+  const int64_t num_keys = 100000;
+  std::vector<int64_t *> values;
+  for (int64_t i = 0; i < num_keys; i++) {
+    auto [value, inserted] = table.FindOrInsert(i * 7, table.Hash(i * 7), i);
+    ASSERT_TRUE(inserted);
+    values.push_back(value);
+  }
+  EXPECT_EQ(num_keys, table.Size());
+
+  // a second insert finds the first value, and values stay where they were through every doubling
+  for (int64_t i = 0; i < num_keys; i++) {
+    auto [value, inserted] = table.FindOrInsert(i * 7, table.Hash(i * 7), -1);
+    ASSERT_FALSE(inserted);
+    ASSERT_EQ(values[i], value);
+    EXPECT_EQ(i, *value);
+    *value += 1;
+  }
+  for (int64_t i = 0; i < 7 * num_keys; i++) {
+    int64_t *value = table.Find(i, table.Hash(i));
+    if (i % 7 == 0) {
+      ASSERT_NE(nullptr, value) << i;
+      EXPECT_EQ(i / 7 + 1, *value);
+    } else {
+      EXPECT_EQ(nullptr, value) << i;
+    }
+  }
+
+  size_t visited = 0;
+  int64_t key_sum = 0;
+  for (auto it = table.Begin(); it != table.End(); ++it) {
+    EXPECT_EQ(it.Key() / 7 + 1, it.Value());
+    EXPECT_EQ(table.Hash(it.Key()), it.Hash());
+    key_sum += it.Key();
+    visited++;
+  }
+  EXPECT_EQ(num_keys, visited);
+  EXPECT_EQ(7 * num_keys * (num_keys - 1) / 2, key_sum);
+
+  table.Clear();
+  EXPECT_TRUE(table.Empty());
+  EXPECT_EQ(nullptr, table.Find(7, table.Hash(7)));
+  EXPECT_TRUE(table.Begin() == table.End());
+  EXPECT_TRUE(table.FindOrInsert(7, table.Hash(7), 1).second);
+}
+
+// NOLINTNEXTLINE
+TEST(FlatHashTableTest, NonTrivialEntryTest) {
+  // keys and values owning heap memory are built in the arena and destroyed with the table
+  FlatHashTable<std::string, std::vector<int>> table(10);
+  for (int i = 0; i < 5000; i++) {
+    const std::string key = "key-" + std::to_string(i % 1000) + std::string(40, 'x');
+    table.FindOrInsert(key, table.Hash(key)).first->push_back(i);
+  }
+  EXPECT_EQ(1000, table.Size());
+  for (int i = 0; i < 1000; i++) {
+    const std::string key = "key-" + std::to_string(i) + std::string(40, 'x');
+    std::vector<int> *value = table.Find(key, table.Hash(key));
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ((std::vector<int>{i, i + 1000, i + 2000, i + 3000, i + 4000}), *value);
+  }
+
+  // a moved table keeps its entries, the moved-from one is empty but usable
+  FlatHashTable<std::string, std::vector<int>> moved(std::move(table));
+  EXPECT_EQ(1000, moved.Size());
+  EXPECT_EQ(0, table.Size());  // NOLINT
+  const std::string key = "key-5" + std::string(40, 'x');
+  EXPECT_EQ(nullptr, table.Find(key, table.Hash(key)));  // NOLINT
+  ASSERT_NE(nullptr, moved.Find(key, moved.Hash(key)));
+  table.FindOrInsert(key, table.Hash(key), 3, 1);
+  EXPECT_EQ((std::vector<int>{1, 1, 1}), *table.Find(key, table.Hash(key)));
+}
+
+// NOLINTNEXTLINE
+TEST(PartitionedFlatHashTableTest, ParallelBuildTest) {
+  // every builder counts an overlapping range of keys, the merge adds the counts up
+  const size_t num_threads = 4;
+  const int64_t keys_per_thread = 50000;
+  PartitionedFlatHashTable<int64_t, int64_t> table(16, num_threads);
+  EXPECT_EQ(16, table.NumPartitions());
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&table, t, keys_per_thread] {
+      auto *builder = table.GetBuilder(t);
+      const auto first = static_cast<int64_t>(t) * keys_per_thread / 2;
+      for (int64_t key = first; key < first + keys_per_thread; key++) {
+        ++*builder->FindOrInsert(key, builder->Hash(key), 0).first;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  table.Merge([](int64_t *into, int64_t *from) { *into += *from; }, 2);
+
+  const int64_t num_keys = (num_threads + 1) * keys_per_thread / 2;
+  EXPECT_EQ(num_keys, table.Size());
+  for (int64_t key = 0; key < num_keys + 10; key++) {
+    int64_t *count = table.Find(key, table.Hash(key));
+    if (key >= num_keys) {
+      EXPECT_EQ(nullptr, count);
+      continue;
+    }
+    ASSERT_NE(nullptr, count) << key;
+    const int64_t half = keys_per_thread / 2;
+    const bool edge = key < half || key >= num_keys - half;
+    EXPECT_EQ(edge ? 1 : 2, *count) << key;
+  }
+
+  // keys spread over all partitions, and each partition holds only its hash range
+  for (size_t p = 0; p < table.NumPartitions(); p++) {
+    auto *partition = table.GetPartition(p);
+    EXPECT_GT(partition->Size(), num_keys / table.NumPartitions() / 2);
+    for (auto it = partition->Begin(); it != partition->End(); ++it) {
+      ASSERT_EQ(p, table.PartitionOf(it.Hash()));
+    }
+  }
+}
+
+// Build and probe of distinct int64 keys, against std::unordered_map, and the partitioned table built on all cores.
+// NOLINTNEXTLINE
+TEST(FlatHashTableTest, DISABLED_FlatHashTableBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  auto elapsed_ns = [](Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(ops);
+  };
+  auto key_of = [](size_t i) { return static_cast<int64_t>(i * 0x9E3779B97F4A7C15ULL >> 1); };
+  // probes visit the keys in a scattered order instead of the order they went in
+  auto probe_of = [](size_t i, size_t num_keys) { return i * 2654435761ULL % num_keys; };
+  const size_t num_threads = std::max(1U, std::thread::hardware_concurrency());
+  for (size_t num_keys : {size_t{1000000}, size_t{10000000}, size_t{100000000}}) {
+    int64_t checksum = 0;
+    {
+      std::unordered_map<int64_t, int64_t> map;
+      auto start = Clock::now();
+      for (size_t i = 0; i < num_keys; i++) {
+        ++map[key_of(i)];
+      }
+      const double build_ns = elapsed_ns(start, num_keys);
+      start = Clock::now();
+      for (size_t i = 0; i < num_keys; i++) {
+        checksum += map.find(key_of(probe_of(i, num_keys)))->second;
+      }
+      std::cout << num_keys << " keys, std::unordered_map: build " << build_ns << " ns/key, probe "
+                << elapsed_ns(start, num_keys) << " ns/key" << std::endl;
+    }
+    {
+      FlatHashTable<int64_t, int64_t> table;
+      auto start = Clock::now();
+      for (size_t i = 0; i < num_keys; i++) {
+        const int64_t key = key_of(i);
+        ++*table.FindOrInsert(key, table.Hash(key), 0).first;
+      }
+      const double build_ns = elapsed_ns(start, num_keys);
+      start = Clock::now();
+      for (size_t i = 0; i < num_keys; i++) {
+        const int64_t key = key_of(probe_of(i, num_keys));
+        checksum += *table.Find(key, table.Hash(key));
+      }
+      std::cout << num_keys << " keys, FlatHashTable: build " << build_ns << " ns/key, probe "
+                << elapsed_ns(start, num_keys) << " ns/key, " << table.MemoryUsage() / num_keys << " bytes/key"
+                << std::endl;
+    }
+    {
+      PartitionedFlatHashTable<int64_t, int64_t> table(64, num_threads);
+      auto start = Clock::now();
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+          auto *builder = table.GetBuilder(t);
+          for (size_t i = t * num_keys / num_threads; i < (t + 1) * num_keys / num_threads; i++) {
+            const int64_t key = key_of(i);
+            ++*builder->FindOrInsert(key, builder->Hash(key), 0).first;
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      table.Merge([](int64_t *into, int64_t *from) { *into += *from; }, num_threads);
+      const double build_ns = elapsed_ns(start, num_keys);
+      start = Clock::now();
+      for (size_t i = 0; i < num_keys; i++) {
+        const int64_t key = key_of(probe_of(i, num_keys));
+        checksum += *table.Find(key, table.Hash(key));
+      }
+      std::cout << num_keys << " keys, PartitionedFlatHashTable on " << num_threads << " threads: build "
+                << build_ns << " ns/key, probe " << elapsed_ns(start, num_keys) << " ns/key" << std::endl;
+    }
+    EXPECT_EQ(3 * static_cast<int64_t>(num_keys), checksum);
+  }
+}
+
+}  // namespace bustub
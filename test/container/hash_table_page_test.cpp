@@ -10,20 +10,26 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <iostream>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
+#include "container/hash/hash_function.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/index/generic_key.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_tagged_bucket_page.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
+TEST(HashTablePageTest, DirectoryPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -57,7 +63,7 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
+TEST(HashTablePageTest, BucketPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -114,4 +120,129 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, TaggedBucketPageTest) {
+  using TaggedBucket = HashTableTaggedBucketPage<int, int, IntComparator>;
+  const size_t capacity =
+      (PAGE_SIZE - TAGGED_BUCKET_HEADER_SIZE - BUCKET_TAG_GROUP_SIZE) / (sizeof(std::pair<int, int>) + 1);
+  alignas(8) char data[PAGE_SIZE] = {};
+  auto *bucket_page = reinterpret_cast<TaggedBucket *>(data);
+  HashFunction<int> hash_fn;
+  auto hash = [&hash_fn](int key) { return static_cast<uint32_t>(hash_fn.GetHash(key)); };
+
+  // fill the bucket, with a second value for every tenth key
+  int count = 0;
+  for (int i = 0; count < static_cast<int>(capacity); i++) {
+    EXPECT_TRUE(bucket_page->Insert(i, i, hash(i), IntComparator()));
+    count++;
+    if (i % 10 == 0 && count < static_cast<int>(capacity)) {
+      EXPECT_TRUE(bucket_page->Insert(i, -i - 1, hash(i), IntComparator()));
+      count++;
+    }
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  EXPECT_EQ(capacity, bucket_page->NumReadable());
+  EXPECT_FALSE(bucket_page->Insert(-1, -1, hash(-1), IntComparator()));
+
+  std::vector<int> result;
+  EXPECT_TRUE(bucket_page->GetValue(10, hash(10), IntComparator(), &result));
+  EXPECT_EQ((std::vector<int>{10, -11}), result);
+  EXPECT_FALSE(bucket_page->Insert(10, -11, hash(10), IntComparator()));
+  result.clear();
+  EXPECT_FALSE(bucket_page->GetValue(-1, hash(-1), IntComparator(), &result));
+
+  // a removed slot is reused by the next insert
+  EXPECT_TRUE(bucket_page->Remove(3, 3, hash(3), IntComparator()));
+  EXPECT_FALSE(bucket_page->Remove(3, 3, hash(3), IntComparator()));
+  EXPECT_FALSE(bucket_page->IsFull());
+  EXPECT_TRUE(bucket_page->Insert(-1, -1, hash(-1), IntComparator()));
+  EXPECT_TRUE(bucket_page->IsFull());
+  result.clear();
+  EXPECT_TRUE(bucket_page->GetValue(-1, hash(-1), IntComparator(), &result));
+  EXPECT_EQ(std::vector<int>{-1}, result);
+
+  // keys whose tags collide are still told apart by the full key comparison
+  alignas(8) char collide_data[PAGE_SIZE] = {};
+  auto *collide_page = reinterpret_cast<TaggedBucket *>(collide_data);
+  for (int i = 0; i < 40; i++) {
+    EXPECT_TRUE(collide_page->Insert(i, i, 0, IntComparator()));
+  }
+  for (int i = 0; i < 40; i += 2) {
+    EXPECT_TRUE(collide_page->Remove(i, i, 0, IntComparator()));
+  }
+  for (int i = 0; i < 40; i++) {
+    result.clear();
+    EXPECT_EQ(i % 2 == 1, collide_page->GetValue(i, 0, IntComparator(), &result)) << i;
+    EXPECT_EQ(i % 2 == 1, collide_page->IsReadable(i));
+    EXPECT_TRUE(collide_page->IsOccupied(i));
+  }
+  EXPECT_FALSE(collide_page->IsOccupied(40));
+  EXPECT_EQ(20, collide_page->NumReadable());
+}
+
+// Probe cost of the bitmap and tagged bucket layouts on 64-byte keys, from a nearly empty to a full bucket.
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, DISABLED_TaggedBucketProbeBenchmark) {
+  using KeyType = GenericKey<64>;
+  using ValueType = RID;
+  using Comparator = GenericComparator<64>;
+  using PlainBucket = HashTableBucketPage<KeyType, ValueType, Comparator>;
+  using TaggedBucket = HashTableTaggedBucketPage<KeyType, ValueType, Comparator>;
+  const size_t plain_capacity = 4 * PAGE_SIZE / (4 * sizeof(std::pair<KeyType, ValueType>) + 1);
+  const size_t tagged_capacity =
+      (PAGE_SIZE - TAGGED_BUCKET_HEADER_SIZE - BUCKET_TAG_GROUP_SIZE) / (sizeof(std::pair<KeyType, ValueType>) + 1);
+  std::cout << "bucket capacity: bitmap " << plain_capacity << ", tagged " << tagged_capacity << std::endl;
+
+  auto key_schema = ParseCreateStatement("a bigint");
+  Comparator comparator(key_schema.get());
+  HashFunction<KeyType> hash_fn;
+  using Clock = std::chrono::steady_clock;
+  const int rounds = 2000;
+
+  for (size_t fill : {size_t{4}, size_t{8}, size_t{16}, size_t{32}, tagged_capacity}) {
+    alignas(8) char plain_data[PAGE_SIZE] = {};
+    alignas(8) char tagged_data[PAGE_SIZE] = {};
+    auto *plain = reinterpret_cast<PlainBucket *>(plain_data);
+    auto *tagged = reinterpret_cast<TaggedBucket *>(tagged_data);
+    // probe every key present plus as many absent ones
+    std::vector<KeyType> keys(2 * fill);
+    std::vector<uint32_t> hashes(2 * fill);
+    for (size_t i = 0; i < 2 * fill; i++) {
+      keys[i].SetFromInteger(static_cast<int64_t>(i));
+      hashes[i] = static_cast<uint32_t>(hash_fn.GetHash(keys[i]));
+      if (i < fill) {
+        plain->Insert(keys[i], RID(static_cast<int64_t>(i)), comparator);
+        tagged->Insert(keys[i], RID(static_cast<int64_t>(i)), hashes[i], comparator);
+      }
+    }
+
+    std::vector<RID> result;
+    size_t plain_found = 0;
+    auto start = Clock::now();
+    for (int round = 0; round < rounds; round++) {
+      for (const auto &key : keys) {
+        result.clear();
+        plain_found += plain->GetValue(key, comparator, &result) ? 1 : 0;
+      }
+    }
+    const double plain_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    size_t tagged_found = 0;
+    start = Clock::now();
+    for (int round = 0; round < rounds; round++) {
+      for (size_t i = 0; i < keys.size(); i++) {
+        result.clear();
+        tagged_found += tagged->GetValue(keys[i], hashes[i], comparator, &result) ? 1 : 0;
+      }
+    }
+    const double tagged_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    EXPECT_EQ(fill * rounds, plain_found);
+    EXPECT_EQ(fill * rounds, tagged_found);
+    const double probes = static_cast<double>(rounds) * keys.size();
+    std::cout << "fill " << fill << ": bitmap " << plain_ns / probes << " ns/probe, tagged " << tagged_ns / probes
+              << " ns/probe" << std::endl;
+  }
+}
+
 }  // namespace bustub
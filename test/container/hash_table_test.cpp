@@ -10,6 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -24,7 +27,7 @@ namespace bustub {
 // NOLINTNEXTLINE
 
 // NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
   ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
@@ -117,4 +120,398 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowShrinkTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // enough keys to split the single starting bucket many times over
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    if (i % 7 == 0) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, -i - 1));
+    }
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 14, 14));
+  const uint32_t grown_depth = ht.GetGlobalDepth();
+  EXPECT_GT(grown_depth, 4);
+  ht.VerifyIntegrity();
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 7 == 0 ? 2 : 1, res.size()) << i;
+  }
+
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    if (i % 7 == 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, -i - 1));
+    }
+  }
+  EXPECT_FALSE(ht.Remove(nullptr, 0, 0));
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i += 97) {
+    std::vector<int> res;
+    EXPECT_FALSE(ht.GetValue(nullptr, i, &res));
+  }
+
+  // emptied buckets merged back into their split images
+  EXPECT_LT(ht.GetGlobalDepth(), grown_depth);
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, UnderfullMergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  const uint32_t grown_depth = ht.GetGlobalDepth();
+  page_id_t high_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&high_page_id));
+  bpm->UnpinPage(high_page_id, false);
+
+  // buckets left an eighth full merge with their images, twice over, without ever being empty
+  for (int i = 0; i < num_keys; i++) {
+    if (i % 8 != 0) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, i));
+    }
+  }
+  EXPECT_EQ(0, ht.MergeBuckets());
+  ht.VerifyIntegrity();
+  EXPECT_LE(ht.GetGlobalDepth() + 2, grown_depth);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 8 == 0, ht.GetValue(nullptr, i, &res)) << i;
+  }
+
+  // the freed bucket pages are handed out again
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_LT(page_id, high_page_id);
+  bpm->UnpinPage(page_id, false);
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, HeavyDuplicateTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // one hot key with far more values than a bucket holds, among ordinary keys
+  const int hot_key = 7;
+  const int num_values = 5000;
+  const int num_keys = 2000;
+  for (int i = 0; i < num_values; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, hot_key, i)) << i;
+    if (i < num_keys && i != hot_key) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    }
+  }
+  ht.VerifyIntegrity();
+  // splits only separate the ordinary keys, the hot key's values go to overflow pages
+  EXPECT_LE(ht.GetGlobalDepth(), 4);
+  EXPECT_FALSE(ht.Insert(nullptr, hot_key, 0));
+  EXPECT_FALSE(ht.Insert(nullptr, hot_key, num_values - 1));
+
+  std::vector<int> res;
+  ASSERT_TRUE(ht.GetValue(nullptr, hot_key, &res));
+  std::sort(res.begin(), res.end());
+  ASSERT_EQ(num_values, res.size());
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_EQ(i, res[i]);
+  }
+  for (int i = 0; i < num_keys; i++) {
+    if (i != hot_key) {
+      res.clear();
+      ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+      EXPECT_EQ(std::vector<int>{i}, res) << i;
+    }
+  }
+
+  // removes reach values in the overflow pages, and a removed value can go back in
+  for (int i = 0; i < num_values; i += 2) {
+    ASSERT_TRUE(ht.Remove(nullptr, hot_key, i)) << i;
+  }
+  EXPECT_FALSE(ht.Remove(nullptr, hot_key, 0));
+  EXPECT_TRUE(ht.Insert(nullptr, hot_key, 0));
+  EXPECT_FALSE(ht.Insert(nullptr, hot_key, 1));
+  res.clear();
+  ASSERT_TRUE(ht.GetValue(nullptr, hot_key, &res));
+  EXPECT_EQ(num_values / 2 + 1, res.size());
+
+  // emptied overflow pages are unlinked and freed, so their page ids come back
+  page_id_t high_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&high_page_id));
+  bpm->UnpinPage(high_page_id, false);
+  for (int i = 0; i < num_values; i++) {
+    ht.Remove(nullptr, hot_key, i);
+  }
+  res.clear();
+  EXPECT_FALSE(ht.GetValue(nullptr, hot_key, &res));
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_LT(page_id, high_page_id);
+  bpm->UnpinPage(page_id, false);
+  EXPECT_TRUE(ht.Insert(nullptr, hot_key, 3));
+  res.clear();
+  ASSERT_TRUE(ht.GetValue(nullptr, hot_key, &res));
+  EXPECT_EQ(std::vector<int>{3}, res);
+  ht.VerifyIntegrity();
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MultiPageDirectoryTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(1000, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // enough keys for more buckets than one directory page can point at
+  const int num_keys = 250000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  const uint32_t grown_depth = ht.GetGlobalDepth();
+  EXPECT_GT(grown_depth, DIRECTORY_MAX_DEPTH);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i += 7) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_LT(ht.GetGlobalDepth(), grown_depth);
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 1, &res));
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentInsertLookupTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // writers on disjoint key ranges split buckets while readers probe the keys already inserted
+  const int num_threads = 4;
+  const int keys_per_thread = 4000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t * keys_per_thread; i < (t + 1) * keys_per_thread; i++) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        std::vector<int> res;
+        EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+        int probe = t * keys_per_thread + (i * 7919) % (i - t * keys_per_thread + 1);
+        res.clear();
+        EXPECT_TRUE(ht.GetValue(nullptr, probe, &res)) << probe;
+      }
+      for (int i = t * keys_per_thread; i < (t + 1) * keys_per_thread; i += 2) {
+        EXPECT_TRUE(ht.Remove(nullptr, i, i));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, i, &res)) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, BatchGetValueTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  for (int i = 0; i < 2000; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    if (i % 3 == 0) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, -i - 1));
+    }
+  }
+
+  // a batch with misses and repeated keys answers each key like GetValue
+  std::vector<int> keys;
+  for (int i = -50; i < 2050; i += 7) {
+    keys.push_back(i);
+    keys.push_back(i / 2);
+  }
+  std::vector<std::vector<int>> results;
+  ht.GetValues(nullptr, keys, &results);
+  ASSERT_EQ(keys.size(), results.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::vector<int> expected;
+    ht.GetValue(nullptr, keys[i], &expected);
+    EXPECT_EQ(expected, results[i]) << keys[i];
+  }
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, BloomFilterTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  for (size_t budget : {ExtendibleHashTable<int, int, IntComparator>::DEFAULT_BLOOM_FILTER_BUDGET, size_t{2048}}) {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), budget);
+
+    // splits rebuild the filters, every inserted key must still get past them
+    const int num_keys = 20000;
+    for (int i = 0; i < num_keys; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    }
+    for (int i = 0; i < num_keys; i++) {
+      std::vector<int> res;
+      ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+    }
+    BloomFilterStats stats = ht.GetBloomFilterStats();
+    EXPECT_LE(stats.memory_bytes_, budget);
+    EXPECT_EQ(0, stats.negatives_ + stats.false_positives_);
+
+    // absent keys are mostly answered by the filters, fewer of them with the small budget
+    for (int i = num_keys; i < 2 * num_keys; i++) {
+      std::vector<int> res;
+      ASSERT_FALSE(ht.GetValue(nullptr, i, &res));
+    }
+    stats = ht.GetBloomFilterStats();
+    EXPECT_EQ(num_keys, stats.negatives_ + stats.false_positives_);
+    if (budget == ExtendibleHashTable<int, int, IntComparator>::DEFAULT_BLOOM_FILTER_BUDGET) {
+      EXPECT_LT(stats.FalsePositiveRate(), 0.05);
+    } else {
+      EXPECT_GT(stats.FalsePositiveRate(), 0.05);
+    }
+
+    // removed keys keep their bits until merges rebuild the filters, and lookups stay exact
+    for (int i = 0; i < num_keys; i++) {
+      if (i % 10 != 0) {
+        ASSERT_TRUE(ht.Remove(nullptr, i, i));
+      }
+    }
+    ht.VerifyIntegrity();
+    for (int i = 0; i < num_keys; i++) {
+      std::vector<int> res;
+      EXPECT_EQ(i % 10 == 0, ht.GetValue(nullptr, i, &res)) << i;
+    }
+    EXPECT_LE(ht.GetBloomFilterStats().memory_bytes_, budget);
+  }
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Lookups of absent keys with and without the bucket Bloom filters.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_BloomFilterMissBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  const int num_keys = 200000;
+  for (size_t budget : {ExtendibleHashTable<int, int, IntComparator>::DEFAULT_BLOOM_FILTER_BUDGET, size_t{0}}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(100, disk_manager);
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), budget);
+    for (int i = 0; i < num_keys; i++) {
+      ht.Insert(nullptr, i, i);
+    }
+    const auto start = Clock::now();
+    for (int i = num_keys; i < 2 * num_keys; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+    }
+    const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    BloomFilterStats stats = ht.GetBloomFilterStats();
+    std::cout << "budget " << budget << ": " << us / num_keys << " us per absent lookup, "
+              << stats.memory_bytes_ << " filter bytes, false positive rate " << stats.FalsePositiveRate() << std::endl;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete disk_manager;
+    delete bpm;
+  }
+}
+
+// Insert cost of one key's values as they pile up far beyond a bucket, in rounds of equal size.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_HeavyDuplicateInsertBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(1000, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+  const int round_size = 50000;
+  for (int round = 0; round < 8; round++) {
+    const auto start = Clock::now();
+    for (int i = round * round_size; i < (round + 1) * round_size; i++) {
+      ht.Insert(nullptr, 42, i);
+    }
+    const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    std::cout << "values " << (round + 1) * round_size << ": " << us / round_size << " us per insert, global depth "
+              << ht.GetGlobalDepth() << std::endl;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
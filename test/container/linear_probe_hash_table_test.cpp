@@ -0,0 +1,170 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/linear_probe_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, IncrementalResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+  const size_t initial_size = ht.GetSize();
+
+  // grow through several resizes, checking every key while pairs are spread over both block arrays
+  const int num_keys = 20000;
+  bool saw_resize = false;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    if (i % 5 == 0) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, -i - 1));
+    }
+    if (ht.IsResizing() && !saw_resize) {
+      saw_resize = true;
+      for (int j = 0; j <= i; j++) {
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, j, &res)) << j;
+        EXPECT_EQ(j % 5 == 0 ? 2 : 1, res.size()) << j;
+      }
+    }
+  }
+  EXPECT_TRUE(saw_resize);
+  EXPECT_GE(ht.GetSize(), 2 * initial_size);
+  EXPECT_FALSE(ht.Insert(nullptr, 5, 5));
+  EXPECT_FALSE(ht.Insert(nullptr, 5, -6));
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+    std::sort(res.begin(), res.end());
+    if (i % 5 == 0) {
+      EXPECT_EQ((std::vector<int>{-i - 1, i}), res);
+    } else {
+      EXPECT_EQ(std::vector<int>{i}, res);
+    }
+  }
+
+  // removes migrate too, and leave tombstones that a same-size rebuild clears out
+  for (int i = 0; i < num_keys; i += 2) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  EXPECT_FALSE(ht.Remove(nullptr, 0, 0));
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 == 1 || i % 5 == 0, ht.GetValue(nullptr, i, &res)) << i;
+  }
+
+  // an explicit resize finishes the one in progress before starting its own
+  const size_t grown_size = ht.GetSize();
+  ht.Resize(grown_size);
+  EXPECT_TRUE(ht.IsResizing());
+  EXPECT_GE(ht.GetSize(), 2 * grown_size);
+  for (int i = 1; i < num_keys; i += 2) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+  }
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentLookupDuringResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+
+  // readers keep probing keys that are already in while the writer grows the table under them
+  const int num_keys = 20000;
+  std::atomic<int> inserted{0};
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 2; t++) {
+    readers.emplace_back([&ht, &inserted, &done, t] {
+      int probe = t;
+      while (!done.load()) {
+        const int limit = inserted.load();
+        if (limit == 0) {
+          continue;
+        }
+        const int key = probe++ * 7919 % limit;
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, key, &res)) << key;
+        EXPECT_EQ(std::vector<int>{key}, res) << key;
+      }
+    });
+  }
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    inserted.store(i + 1);
+  }
+  done.store(true);
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Insert latency while a table grows from one block, with the incremental migration against moving the whole old
+// block array at once.
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, DISABLED_ResizeLatencyBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  const int num_keys = 300000;
+  for (size_t slots_per_op : {LinearProbeHashTable<int, int, IntComparator>::DEFAULT_MIGRATE_SLOTS_PER_OP,
+                              std::numeric_limits<size_t>::max()}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(2000, disk_manager);
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 0, HashFunction<int>(),
+                                                     slots_per_op);
+    std::vector<double> latencies;
+    latencies.reserve(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+      const auto start = Clock::now();
+      ht.Insert(nullptr, i, i);
+      latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    std::cout << (slots_per_op == std::numeric_limits<size_t>::max() ? "stop-the-world" : "incremental")
+              << " resize: p50 " << percentile(0.5) << " us, p99 " << percentile(0.99) << " us, p99.99 "
+              << percentile(0.9999) << " us, max " << latencies.back() << " us" << std::endl;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete disk_manager;
+    delete bpm;
+  }
+}
+
+}  // namespace bustub
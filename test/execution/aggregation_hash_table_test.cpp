@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_hash_table_test.cpp
+//
+// Identification: test/execution/aggregation_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/exception.h"
+#include "execution/aggregation_hash_table.h"
+#include "executor_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class AggregationHashTableTest : public ExecutorTest {
+ protected:
+  /** The aggregates of one group, as computed row by row */
+  struct Expected {
+    int32_t count_{0};
+    int32_t num_a_{0};
+    int64_t sum_a_{0};
+    int64_t sum_d_{0};
+    int32_t num_c_{0};
+    double sum_c_{0};
+    std::optional<std::string> min_b_;
+    std::optional<std::string> max_b_;
+    std::optional<double> min_c_;
+    std::optional<int32_t> max_a_;
+  };
+
+  /**
+   * Fill batches of rows (colA INTEGER, colB VARCHAR, colC DECIMAL, colD BIGINT), each column NULL now and then,
+   * drop every third row of a batch through its selection, and aggregate them.
+   */
+  void InsertRows(AggregationHashTable *aht, int num_rows, std::unordered_map<std::string, Expected> *expected) {
+    TupleBatch batch;
+    for (int i = 0; i < num_rows; i++) {
+      const bool a_null = i % 11 == 0;
+      const bool b_null = i % 7 == 0;
+      const bool c_null = i % 5 == 0;
+      const int32_t a = i % 37;
+      const std::string b = "s" + std::to_string(i % 13);
+      const double c = i * 0.5 - 100;
+      const int64_t d = i * 1000000000LL;
+      const bool kept = batch.NumRows() % 3 != 2;
+      batch.Append(Tuple{{a_null ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(a),
+                          b_null ? ValueFactory::GetNullValueByType(TypeId::VARCHAR) : ValueFactory::GetVarcharValue(b),
+                          c_null ? ValueFactory::GetNullValueByType(TypeId::DECIMAL) : ValueFactory::GetDecimalValue(c),
+                          ValueFactory::GetBigIntValue(d)},
+                         &schema_},
+                   RID());
+      if (kept) {
+        Expected &group = (*expected)[(a_null ? "N" : std::to_string(a)) + "|" + (b_null ? "N" : b)];
+        group.count_++;
+        group.sum_d_ += d;
+        if (!a_null) {
+          group.num_a_++;
+          group.sum_a_ += a;
+          group.max_a_ = std::max(group.max_a_.value_or(a), a);
+        }
+        if (!b_null) {
+          group.min_b_ = std::min(group.min_b_.value_or(b), b);
+          group.max_b_ = std::max(group.max_b_.value_or(b), b);
+        }
+        if (!c_null) {
+          group.num_c_++;
+          group.sum_c_ += c;
+          group.min_c_ = std::min(group.min_c_.value_or(c), c);
+        }
+      }
+      if (batch.IsFull() || i == num_rows - 1) {
+        uint32_t row = 0;
+        batch.Filter([&row](const Tuple &tuple) { return (row++) % 3 != 2; });
+        aht->InsertBatch(batch, &schema_);
+        batch.Clear();
+      }
+    }
+  }
+
+  const AbstractExpression *Col(uint32_t idx) {
+    return MakeColumnValueExpression(schema_, 0, schema_.GetColumn(idx).GetName());
+  }
+
+  Schema schema_{{Column{"colA", TypeId::INTEGER}, Column{"colB", TypeId::VARCHAR, 16},
+                  Column{"colC", TypeId::DECIMAL}, Column{"colD", TypeId::BIGINT}}};
+};
+
+// GROUP BY colA, colB with every kind of accumulator, NULL keys grouped together and NULL inputs skipped
+// NOLINTNEXTLINE
+TEST_F(AggregationHashTableTest, GroupByTest) {
+  AggregationPlanNode plan{nullptr,
+                           nullptr,
+                           nullptr,
+                           {Col(0), Col(1)},
+                           {Col(0), Col(0), Col(3), Col(2), Col(1), Col(1), Col(2), Col(0)},
+                           {AggregationType::CountAggregate, AggregationType::SumAggregate,
+                            AggregationType::SumAggregate, AggregationType::AvgAggregate,
+                            AggregationType::MinAggregate, AggregationType::MaxAggregate,
+                            AggregationType::MinAggregate, AggregationType::MaxAggregate}};
+  AggregationHashTable aht{&plan};
+
+  // a second round after Clear() starts over
+  for (int round = 0; round < 2; round++) {
+    std::unordered_map<std::string, Expected> expected;
+    aht.Clear();
+    InsertRows(&aht, 3000 + round * 1000, &expected);
+    ASSERT_EQ(expected.size(), aht.Size());
+
+    std::vector<Value> group_bys;
+    std::vector<Value> aggregates;
+    for (size_t i = 0; i < aht.Size(); i++) {
+      aht.GetGroup(i, &group_bys, &aggregates);
+      ASSERT_EQ(2, group_bys.size());
+      ASSERT_EQ(8, aggregates.size());
+      const std::string key = (group_bys[0].IsNull() ? "N" : std::to_string(group_bys[0].GetAs<int32_t>())) + "|" +
+                              (group_bys[1].IsNull() ? "N" : group_bys[1].ToString());
+      ASSERT_EQ(1, expected.count(key)) << key;
+      const Expected &group = expected[key];
+
+      EXPECT_EQ(group.count_, aggregates[0].GetAs<int32_t>());
+      EXPECT_EQ(group.num_a_ == 0, aggregates[1].IsNull());
+      EXPECT_EQ(TypeId::INTEGER, aggregates[1].GetTypeId());
+      if (group.num_a_ > 0) {
+        EXPECT_EQ(group.sum_a_, aggregates[1].GetAs<int32_t>());
+        EXPECT_EQ(*group.max_a_, aggregates[7].GetAs<int32_t>());
+      }
+      EXPECT_EQ(TypeId::BIGINT, aggregates[2].GetTypeId());
+      EXPECT_EQ(group.sum_d_, aggregates[2].GetAs<int64_t>());
+      EXPECT_EQ(TypeId::DECIMAL, aggregates[3].GetTypeId());
+      EXPECT_EQ(group.num_c_ == 0, aggregates[3].IsNull());
+      if (group.num_c_ > 0) {
+        EXPECT_DOUBLE_EQ(group.sum_c_ / group.num_c_, aggregates[3].GetAs<double>());
+        EXPECT_DOUBLE_EQ(*group.min_c_, aggregates[6].GetAs<double>());
+      }
+      EXPECT_EQ(!group.min_b_.has_value(), aggregates[4].IsNull());
+      if (group.min_b_.has_value()) {
+        EXPECT_EQ(*group.min_b_, aggregates[4].ToString());
+        EXPECT_EQ(*group.max_b_, aggregates[5].ToString());
+      }
+    }
+  }
+}
+
+// Without GROUP BY every row falls in one group, none without rows, and SUM takes numbers only
+// NOLINTNEXTLINE
+TEST_F(AggregationHashTableTest, NoGroupByTest) {
+  AggregationPlanNode plan{nullptr,
+                           nullptr,
+                           nullptr,
+                           {},
+                           {Col(0), Col(0)},
+                           {AggregationType::CountAggregate, AggregationType::SumAggregate}};
+  AggregationHashTable aht{&plan};
+  EXPECT_EQ(0, aht.Size());
+
+  std::unordered_map<std::string, Expected> expected;
+  InsertRows(&aht, 500, &expected);
+  ASSERT_EQ(1, aht.Size());
+  std::vector<Value> group_bys;
+  std::vector<Value> aggregates;
+  aht.GetGroup(0, &group_bys, &aggregates);
+  EXPECT_TRUE(group_bys.empty());
+  int32_t count = 0;
+  int64_t sum = 0;
+  for (const auto &[key, group] : expected) {
+    count += group.count_;
+    sum += group.sum_a_;
+  }
+  EXPECT_EQ(count, aggregates[0].GetAs<int32_t>());
+  EXPECT_EQ(sum, aggregates[1].GetAs<int32_t>());
+
+  AggregationPlanNode varchar_sum{nullptr, nullptr, nullptr, {}, {Col(1)}, {AggregationType::SumAggregate}};
+  EXPECT_THROW(AggregationHashTable{&varchar_sum}, Exception);
+}
+
+}  // namespace bustub
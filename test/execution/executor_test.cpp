@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <memory>
 #include <numeric>
 #include <string>
@@ -31,7 +32,9 @@
 #include "execution/plans/delete_plan.h"
 #include "execution/plans/distinct_plan.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
 #include "execution/plans/limit_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/update_plan.h"
 #include "executor_test_util.h"  // NOLINT
@@ -87,7 +90,7 @@ using ComparatorType = GenericComparator<8>;
 using HashFunctionType = HashFunction<KeyType>;
 
 // SELECT col_a, col_b FROM test_1 WHERE col_a < 500
-TEST_F(ExecutorTest, DISABLED_SimpleSeqScanTest) {
+TEST_F(ExecutorTest, SimpleSeqScanTest) {
   // Construct query plan
   TableInfo *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
   const Schema &schema = table_info->schema_;
@@ -110,6 +113,48 @@ TEST_F(ExecutorTest, DISABLED_SimpleSeqScanTest) {
   }
 }
 
+// SELECT colA, colB FROM test_1 WHERE colA <op> const, through a B+ tree index on colA
+TEST_F(ExecutorTest, SimpleIndexScanTest) {
+  TableInfo *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  const Schema &schema = table_info->schema_;
+  Schema key_schema{{Column{"colA", TypeId::INTEGER}}};
+  IndexInfo *index_info = GetExecutorContext()->GetCatalog()->CreateIndex(
+      GetTxn(), "index1", "test_1", schema, key_schema, {0}, 4, IndexType::BPlusTreeIndex);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto run = [&](const AbstractExpression *predicate) {
+    IndexScanPlanNode plan{out_schema, predicate, index_info->index_oid_};
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<int32_t> keys;
+    for (const auto &tuple : result_set) {
+      keys.push_back(tuple.GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>());
+      EXPECT_LT(tuple.GetValue(out_schema, out_schema->GetColIdx("colB")).GetAs<int32_t>(), 10);
+    }
+    return keys;
+  };
+  auto *const250 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(250));
+  auto *const700 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(700));
+
+  // Range predicates come out in key order
+  std::vector<int32_t> expected(700);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(expected, run(MakeComparisonExpression(col_a, const700, ComparisonType::LessThan)));
+  EXPECT_EQ(701, run(MakeComparisonExpression(col_a, const700, ComparisonType::LessThanOrEqual)).size());
+  auto above = run(MakeComparisonExpression(col_a, const250, ComparisonType::GreaterThan));
+  ASSERT_EQ(749, above.size());
+  EXPECT_EQ(251, above.front());
+  EXPECT_TRUE(std::is_sorted(above.begin(), above.end()));
+  above = run(MakeComparisonExpression(const250, col_a, ComparisonType::LessThanOrEqual));
+  ASSERT_EQ(750, above.size());
+  EXPECT_EQ(250, above.front());
+  EXPECT_EQ(std::vector<int32_t>{250}, run(MakeComparisonExpression(col_a, const250, ComparisonType::Equal)));
+  EXPECT_EQ(1000, run(nullptr).size());
+}
+
 // INSERT INTO empty_table2 VALUES (100, 10), (101, 11), (102, 12)
 TEST_F(ExecutorTest, DISABLED_SimpleRawInsertTest) {
   // Create Values to insert
@@ -373,8 +418,60 @@ TEST_F(ExecutorTest, DISABLED_SimpleDeleteTest) {
   ASSERT_TRUE(rids.empty());
 }
 
+// SELECT test_1.colA, test_1.colB, test_3.colB FROM test_1 JOIN test_3 ON test_1.colB = test_3.colA
+// (test_3.colA is indexed)
+TEST_F(ExecutorTest, SimpleNestedIndexJoinTest) {
+  const Schema *outer_schema;
+  std::unique_ptr<AbstractPlanNode> scan_plan;
+  {
+    auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+    auto &schema = table_info->schema_;
+    auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+    auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+    outer_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+    scan_plan = std::make_unique<SeqScanPlanNode>(outer_schema, nullptr, table_info->oid_);
+  }
+
+  TableInfo *inner_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
+  const Schema *inner_schema = &inner_info->schema_;
+  Schema key_schema{{Column{"colA", TypeId::INTEGER}}};
+  ASSERT_NE(Catalog::NULL_INDEX_INFO,
+            GetExecutorContext()->GetCatalog()->CreateIndex(GetTxn(), "index1", "test_3", *inner_schema, key_schema,
+                                                            {0}, 4, IndexType::BPlusTreeIndex));
+
+  const Schema *out_schema;
+  std::unique_ptr<NestedIndexJoinPlanNode> join_plan;
+  {
+    auto outer_col_a = MakeColumnValueExpression(*outer_schema, 0, "colA");
+    auto outer_col_b = MakeColumnValueExpression(*outer_schema, 0, "colB");
+    auto inner_col_a = MakeColumnValueExpression(*inner_schema, 1, "colA");
+    auto inner_col_b = MakeColumnValueExpression(*inner_schema, 1, "colB");
+    out_schema = MakeOutputSchema({{"outer_colA", outer_col_a},
+                                   {"outer_colB", outer_col_b},
+                                   {"inner_colA", inner_col_a},
+                                   {"inner_colB", inner_col_b}});
+    auto predicate = MakeComparisonExpression(outer_col_b, inner_col_a, ComparisonType::Equal);
+    join_plan = std::make_unique<NestedIndexJoinPlanNode>(
+        out_schema, std::vector<const AbstractPlanNode *>{scan_plan.get()}, predicate, inner_info->oid_, "index1",
+        outer_schema, inner_schema);
+  }
+
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(join_plan.get(), &result_set, GetTxn(), GetExecutorContext());
+
+  // Every outer tuple has exactly one match, and outer order is preserved although the probes were sorted
+  ASSERT_EQ(result_set.size(), TEST1_SIZE);
+  for (size_t i = 0; i < result_set.size(); i++) {
+    const Tuple &tuple = result_set[i];
+    EXPECT_EQ(i, tuple.GetValue(out_schema, out_schema->GetColIdx("outer_colA")).GetAs<int32_t>());
+    auto outer_b = tuple.GetValue(out_schema, out_schema->GetColIdx("outer_colB")).GetAs<int32_t>();
+    EXPECT_EQ(outer_b, tuple.GetValue(out_schema, out_schema->GetColIdx("inner_colA")).GetAs<int32_t>());
+    EXPECT_EQ(outer_b, tuple.GetValue(out_schema, out_schema->GetColIdx("inner_colB")).GetAs<int32_t>());
+  }
+}
+
 // SELECT test_1.col_a, test_1.col_b, test_2.col1, test_2.col3 FROM test_1 JOIN test_2 ON test_1.col_a = test_2.col1;
-TEST_F(ExecutorTest, DISABLED_SimpleNestedLoopJoinTest) {
+TEST_F(ExecutorTest, SimpleNestedLoopJoinTest) {
   const Schema *out_schema1;
   std::unique_ptr<AbstractPlanNode> scan_plan1;
   {
@@ -418,7 +515,7 @@ TEST_F(ExecutorTest, DISABLED_SimpleNestedLoopJoinTest) {
 }
 
 // SELECT test_4.colA, test_4.colB, test_6.colA, test_6.colB FROM test_4 JOIN test_6 ON test_4.colA = test_6.colA;
-TEST_F(ExecutorTest, DISABLED_SimpleHashJoinTest) {
+TEST_F(ExecutorTest, SimpleHashJoinTest) {
   // Construct sequential scan of table test_4
   const Schema *out_schema1{};
   std::unique_ptr<AbstractPlanNode> scan_plan1{};
@@ -487,7 +584,7 @@ TEST_F(ExecutorTest, DISABLED_SimpleHashJoinTest) {
 }
 
 // SELECT COUNT(col_a), SUM(col_a), min(col_a), max(col_a) from test_1;
-TEST_F(ExecutorTest, DISABLED_SimpleAggregationTest) {
+TEST_F(ExecutorTest, SimpleAggregationTest) {
   const Schema *scan_schema;
   std::unique_ptr<AbstractPlanNode> scan_plan;
   {
@@ -537,7 +634,7 @@ TEST_F(ExecutorTest, DISABLED_SimpleAggregationTest) {
 }
 
 // SELECT count(col_a), col_b, sum(col_c) FROM test_1 Group By col_b HAVING count(col_a) > 100
-TEST_F(ExecutorTest, DISABLED_SimpleGroupByAggregation) {
+TEST_F(ExecutorTest, SimpleGroupByAggregation) {
   const Schema *scan_schema;
   std::unique_ptr<AbstractPlanNode> scan_plan;
   {
@@ -590,7 +687,7 @@ TEST_F(ExecutorTest, DISABLED_SimpleGroupByAggregation) {
 }
 
 // SELECT colA, colB FROM test_3 LIMIT 10
-TEST_F(ExecutorTest, DISABLED_SimpleLimitTest) {
+TEST_F(ExecutorTest, SimpleLimitTest) {
   auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
   auto &schema = table_info->schema_;
 
@@ -617,6 +714,76 @@ TEST_F(ExecutorTest, DISABLED_SimpleLimitTest) {
   }
 }
 
+// SELECT col_a, col_b FROM test_1 WHERE col_a < 500 LIMIT 123 and joins on top of it, each pulled a batch at a time
+// and a tuple at a time
+TEST_F(ExecutorTest, BatchMatchesNextTest) {
+  auto drain = [this](const AbstractPlanNode *plan, bool batched) {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), plan);
+    executor->Init();
+    const Schema *schema = executor->GetOutputSchema();
+    std::vector<std::string> rows;
+    if (batched) {
+      // a capacity that does not divide the table size or the limit
+      TupleBatch batch(7);
+      while (executor->NextBatch(&batch)) {
+        EXPECT_LE(batch.Size(), 7);
+        for (uint32_t i = 0; i < batch.Size(); i++) {
+          rows.push_back(batch.GetTuple(i).ToString(schema));
+        }
+      }
+      EXPECT_FALSE(executor->NextBatch(&batch));
+      EXPECT_TRUE(batch.Empty());
+    } else {
+      Tuple tuple;
+      RID rid;
+      while (executor->Next(&tuple, &rid)) {
+        rows.push_back(tuple.ToString(schema));
+      }
+    }
+    return rows;
+  };
+
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *predicate = MakeComparisonExpression(col_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(500)),
+                                             ComparisonType::LessThan);
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  SeqScanPlanNode scan_plan{out_schema, predicate, table_info->oid_};
+  LimitPlanNode limit_plan{out_schema, &scan_plan, 123};
+
+  std::vector<std::string> rows = drain(&scan_plan, true);
+  ASSERT_EQ(500, rows.size());
+  EXPECT_EQ(drain(&scan_plan, false), rows);
+  rows = drain(&limit_plan, true);
+  ASSERT_EQ(123, rows.size());
+  EXPECT_EQ(drain(&limit_plan, false), rows);
+
+  // the limited rows joined with every row of test_1 of the same colB, the right side scanned as is
+  auto *all_schema = MakeOutputSchema({{"colA", col_a},
+                                       {"colB", col_b},
+                                       {"colC", MakeColumnValueExpression(schema, 0, "colC")},
+                                       {"colD", MakeColumnValueExpression(schema, 0, "colD")}});
+  SeqScanPlanNode all_plan{all_schema, nullptr, table_info->oid_};
+  auto *left_b = MakeColumnValueExpression(*out_schema, 0, "colB");
+  auto *right_a = MakeColumnValueExpression(*all_schema, 1, "colA");
+  auto *join_schema = MakeOutputSchema({{"left_colA", MakeColumnValueExpression(*out_schema, 0, "colA")},
+                                        {"right_colA", right_a}});
+  auto *right_b = MakeColumnValueExpression(*all_schema, 1, "colB");
+  HashJoinPlanNode join_plan{join_schema, {&limit_plan, &all_plan}, left_b, right_b};
+  rows = drain(&join_plan, true);
+  EXPECT_GT(rows.size(), 123);
+  EXPECT_EQ(drain(&join_plan, false), rows);
+  NestedLoopJoinPlanNode loop_plan{join_schema, {&limit_plan, &all_plan},
+                                   MakeComparisonExpression(left_b, right_b, ComparisonType::Equal)};
+  std::vector<std::string> loop_rows = drain(&loop_plan, true);
+  EXPECT_EQ(drain(&loop_plan, false), loop_rows);
+  std::sort(rows.begin(), rows.end());
+  std::sort(loop_rows.begin(), loop_rows.end());
+  EXPECT_EQ(rows, loop_rows);
+}
+
 // SELECT DISTINCT colC FROM test_7
 TEST_F(ExecutorTest, DISABLED_SimpleDistinctTest) {
   auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_7");
@@ -0,0 +1,211 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// expression_program_test.cpp
+//
+// Identification: test/execution/expression_program_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "execution/execution_engine.h"
+#include "execution/expression_program.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "executor_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class ExpressionProgramTest : public ExecutorTest {
+ protected:
+  /** Make rows of the schema, each column NULL now and then */
+  std::vector<Tuple> MakeRows(int num_rows) {
+    std::vector<Tuple> rows;
+    for (int i = 0; i < num_rows; i++) {
+      auto value_or_null = [i](int every, TypeId type, const Value &value) {
+        return i % every == 0 ? ValueFactory::GetNullValueByType(type) : value;
+      };
+      rows.emplace_back(
+          std::vector<Value>{
+              value_or_null(11, TypeId::INTEGER, ValueFactory::GetIntegerValue(i % 50 - 25)),
+              value_or_null(13, TypeId::TINYINT, ValueFactory::GetTinyIntValue(static_cast<int8_t>(i % 7))),
+              value_or_null(17, TypeId::BIGINT, ValueFactory::GetBigIntValue((i % 40 - 20) * 1000000000LL)),
+              value_or_null(7, TypeId::DECIMAL, ValueFactory::GetDecimalValue(i % 30 * 0.5 - 5)),
+              value_or_null(5, TypeId::VARCHAR, ValueFactory::GetVarcharValue(std::string(i % 4, 'b') + "a")),
+              value_or_null(3, TypeId::BOOLEAN, ValueFactory::GetBooleanValue(i % 2 == 0)),
+              ValueFactory::GetVarcharValue(std::string("b"))},
+          &schema_);
+    }
+    return rows;
+  }
+
+  const AbstractExpression *Col(const std::string &name) { return MakeColumnValueExpression(schema_, 0, name); }
+  const AbstractExpression *Const(const Value &value) { return MakeConstantValueExpression(value); }
+  const AbstractExpression *Cmp(const AbstractExpression *lhs, const AbstractExpression *rhs, ComparisonType type) {
+    return MakeComparisonExpression(lhs, rhs, type);
+  }
+
+  /** @return whether a tree evaluated to a value that is true */
+  static bool IsTrue(const Value &value) { return !value.IsNull() && value.GetAs<bool>(); }
+
+  Schema schema_{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::TINYINT}, Column{"c", TypeId::BIGINT},
+                  Column{"d", TypeId::DECIMAL}, Column{"e", TypeId::VARCHAR, 8}, Column{"f", TypeId::BOOLEAN},
+                  Column{"g", TypeId::VARCHAR, 8}}};
+};
+
+static const ComparisonType ALL_COMPARISONS[] = {ComparisonType::Equal,           ComparisonType::NotEqual,
+                                                 ComparisonType::LessThan,        ComparisonType::LessThanOrEqual,
+                                                 ComparisonType::GreaterThan,     ComparisonType::GreaterThanOrEqual};
+
+// Every comparison of every pair of operand types that compiles matches the tree, NULLs included
+// NOLINTNEXTLINE
+TEST_F(ExpressionProgramTest, MatchesTreeTest) {
+  const std::vector<Tuple> rows = MakeRows(600);
+  const std::vector<std::pair<const AbstractExpression *, const AbstractExpression *>> operands{
+      {Col("a"), Const(ValueFactory::GetIntegerValue(3))},
+      {Const(ValueFactory::GetIntegerValue(3)), Col("a")},
+      {Col("b"), Const(ValueFactory::GetBigIntValue(4))},
+      {Col("c"), Const(ValueFactory::GetIntegerValue(0))},
+      {Col("a"), Col("b")},
+      {Col("c"), Col("a")},
+      {Col("a"), Col("d")},
+      {Col("d"), Const(ValueFactory::GetIntegerValue(2))},
+      {Const(ValueFactory::GetDecimalValue(1.5)), Col("b")},
+      {Col("d"), Col("d")},
+      {Col("e"), Const(ValueFactory::GetVarcharValue(std::string("bba")))},
+      {Const(ValueFactory::GetVarcharValue(std::string("b"))), Col("e")},
+      {Col("e"), Col("g")},
+      {Col("f"), Const(ValueFactory::GetBooleanValue(true))},
+      {Cmp(Col("a"), Const(ValueFactory::GetIntegerValue(0)), ComparisonType::LessThan), Col("f")}};
+
+  for (size_t i = 0; i < operands.size(); i++) {
+    for (ComparisonType type : ALL_COMPARISONS) {
+      const AbstractExpression *predicate = Cmp(operands[i].first, operands[i].second, type);
+      auto program = ExpressionProgram::Compile(predicate, &schema_);
+      ASSERT_NE(nullptr, program) << "operands " << i;
+      ExpressionProgram::Registers regs{*program};
+
+      std::vector<uint8_t> matches;
+      program->Match(rows, &regs, &matches);
+      ASSERT_EQ(rows.size(), matches.size());
+      for (size_t row = 0; row < rows.size(); row++) {
+        const bool expected = IsTrue(predicate->Evaluate(&rows[row], &schema_));
+        ASSERT_EQ(expected, matches[row] != 0) << "operands " << i << ", row " << row;
+        ASSERT_EQ(expected, program->Matches(rows[row], &regs)) << "operands " << i << ", row " << row;
+      }
+    }
+  }
+}
+
+// Filter() narrows a selection that is already active, and predicates that do not compile are left to the tree
+// NOLINTNEXTLINE
+TEST_F(ExpressionProgramTest, FilterTest) {
+  const std::vector<Tuple> rows = MakeRows(TupleBatch::DEFAULT_CAPACITY);
+  const AbstractExpression *predicate =
+      Cmp(Col("e"), Const(ValueFactory::GetVarcharValue(std::string("ba"))), ComparisonType::GreaterThanOrEqual);
+  auto program = ExpressionProgram::Compile(predicate, &schema_);
+  ASSERT_NE(nullptr, program);
+  ExpressionProgram::Registers regs{*program};
+
+  TupleBatch batch;
+  for (const auto &row : rows) {
+    batch.Append(row, RID());
+  }
+  batch.Filter([this](const Tuple &tuple) { return !tuple.GetValue(&schema_, 1).IsNull(); });
+  uint32_t row = 0;
+  batch.Filter([&row](const Tuple & /*tuple*/) { return (row++) % 3 != 0; });
+  std::vector<const Tuple *> expected;
+  for (uint32_t i = 0; i < batch.Size(); i++) {
+    if (IsTrue(predicate->Evaluate(&batch.GetTuple(i), &schema_))) {
+      expected.push_back(&batch.GetTuple(i));
+    }
+  }
+  program->Filter(&batch, &regs);
+  ASSERT_EQ(expected.size(), batch.Size());
+  for (uint32_t i = 0; i < batch.Size(); i++) {
+    EXPECT_EQ(expected[i], &batch.GetTuple(i));
+  }
+
+  // a NULL constant, types Value casts between, two constants and a result that is not BOOLEAN
+  EXPECT_EQ(nullptr, ExpressionProgram::Compile(
+                         Cmp(Col("a"), Const(ValueFactory::GetNullValueByType(TypeId::INTEGER)), ComparisonType::Equal),
+                         &schema_));
+  EXPECT_EQ(nullptr, ExpressionProgram::Compile(Cmp(Col("a"), Col("e"), ComparisonType::Equal), &schema_));
+  EXPECT_EQ(nullptr, ExpressionProgram::Compile(Cmp(Const(ValueFactory::GetIntegerValue(1)),
+                                                    Const(ValueFactory::GetIntegerValue(2)), ComparisonType::Equal),
+                                                &schema_));
+  EXPECT_EQ(nullptr, ExpressionProgram::Compile(Col("a"), &schema_));
+  EXPECT_NE(nullptr, ExpressionProgram::Compile(Col("f"), &schema_));
+}
+
+// HAVING-like predicates over group-by and aggregate terms match the tree
+// NOLINTNEXTLINE
+TEST_F(ExpressionProgramTest, MatchGroupsTest) {
+  std::vector<std::vector<Value>> group_bys;
+  std::vector<std::vector<Value>> aggregates;
+  for (int i = 0; i < 700; i++) {
+    group_bys.push_back({i % 9 == 0 ? ValueFactory::GetNullValueByType(TypeId::VARCHAR)
+                                    : ValueFactory::GetVarcharValue("k" + std::to_string(i % 20))});
+    aggregates.push_back({ValueFactory::GetIntegerValue(i % 100),
+                          i % 8 == 0 ? ValueFactory::GetNullValueByType(TypeId::DECIMAL)
+                                     : ValueFactory::GetDecimalValue(i % 50 * 0.25)});
+  }
+  const std::vector<TypeId> group_by_types{TypeId::VARCHAR};
+  const std::vector<TypeId> aggregate_types{TypeId::INTEGER, TypeId::DECIMAL};
+
+  const std::vector<const AbstractExpression *> predicates{
+      Cmp(MakeAggregateValueExpression(false, 0), Const(ValueFactory::GetIntegerValue(40)),
+          ComparisonType::GreaterThanOrEqual),
+      Cmp(MakeAggregateValueExpression(false, 1), MakeAggregateValueExpression(false, 0), ComparisonType::LessThan),
+      Cmp(Const(ValueFactory::GetVarcharValue(std::string("k15"))), MakeAggregateValueExpression(true, 0),
+          ComparisonType::GreaterThan)};
+  for (const auto *predicate : predicates) {
+    auto program = ExpressionProgram::CompileAggregate(predicate, group_by_types, aggregate_types);
+    ASSERT_NE(nullptr, program);
+    ExpressionProgram::Registers regs{*program};
+    std::vector<uint8_t> matches(group_bys.size());
+    program->MatchGroups(group_bys.data(), aggregates.data(), group_bys.size(), &regs, matches.data());
+    for (size_t i = 0; i < group_bys.size(); i++) {
+      ASSERT_EQ(IsTrue(predicate->EvaluateAggregate(group_bys[i], aggregates[i])), matches[i] != 0) << i;
+    }
+  }
+  EXPECT_EQ(nullptr, ExpressionProgram::CompileAggregate(
+                         Cmp(MakeAggregateValueExpression(false, 2), Const(ValueFactory::GetIntegerValue(1)),
+                             ComparisonType::Equal),
+                         group_by_types, aggregate_types));
+}
+
+// A scan filters through the compiled predicate, serially and in parallel, and NULLs do not pass
+// NOLINTNEXTLINE
+TEST_F(ExpressionProgramTest, ScanTest) {
+  TableInfo *table_info = GetCatalog()->CreateTable(GetTxn(), "t", schema_);
+  int expected = 0;
+  const AbstractExpression *predicate =
+      Cmp(Const(ValueFactory::GetIntegerValue(10)), Col("a"), ComparisonType::GreaterThan);
+  for (const auto &row : MakeRows(3000)) {
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(row, &rid, GetTxn()));
+    expected += static_cast<int>(IsTrue(predicate->Evaluate(&row, &schema_)));
+  }
+
+  auto *out_schema = MakeOutputSchema({{"a", Col("a")}});
+  SeqScanPlanNode plan{out_schema, predicate, table_info->oid_};
+  for (uint32_t parallelism : {1, 4}) {
+    GetExecutorContext()->SetParallelism(parallelism);
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(expected, result_set.size()) << parallelism << " workers";
+    for (const auto &tuple : result_set) {
+      ASSERT_LT(tuple.GetValue(out_schema, 0).GetAs<int32_t>(), 10);
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// grace_hash_join_test.cpp
+//
+// Identification: test/execution/grace_hash_join_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/execution_engine.h"
+#include "execution/executor_factory.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "executor_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** Create a table of num_rows rows (colA = i, colB = key_of(i), NULL for a negative key) */
+template <typename KeyOf>
+static TableInfo *MakeTable(Catalog *catalog, Transaction *txn, const std::string &name, int num_rows,
+                            KeyOf &&key_of) {
+  Schema schema{{Column{"colA", TypeId::INTEGER}, Column{"colB", TypeId::INTEGER}}};
+  TableInfo *table_info = catalog->CreateTable(txn, name, schema);
+  for (int i = 0; i < num_rows; i++) {
+    const int key = key_of(i);
+    Tuple tuple{{ValueFactory::GetIntegerValue(i), key < 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                                           : ValueFactory::GetIntegerValue(key)},
+                &schema};
+    RID rid;
+    EXPECT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn));
+  }
+  return table_info;
+}
+
+class GraceHashJoinTest : public ExecutorTest {
+ protected:
+  /** SELECT l.colA, r.colA FROM l JOIN r ON l.colB = r.colB */
+  template <typename LeftKeyOf, typename RightKeyOf>
+  void MakeJoin(int left_rows, LeftKeyOf &&left_key_of, int right_rows, RightKeyOf &&right_key_of) {
+    TableInfo *left_info = MakeTable(GetCatalog(), GetTxn(), "l", left_rows, left_key_of);
+    TableInfo *right_info = MakeTable(GetCatalog(), GetTxn(), "r", right_rows, right_key_of);
+    auto *left_out = MakeOutputSchema({{"colA", MakeColumnValueExpression(left_info->schema_, 0, "colA")},
+                                       {"colB", MakeColumnValueExpression(left_info->schema_, 0, "colB")}});
+    auto *right_out = MakeOutputSchema({{"colA", MakeColumnValueExpression(right_info->schema_, 0, "colA")},
+                                        {"colB", MakeColumnValueExpression(right_info->schema_, 0, "colB")}});
+    left_plan_ = std::make_unique<SeqScanPlanNode>(left_out, nullptr, left_info->oid_);
+    right_plan_ = std::make_unique<SeqScanPlanNode>(right_out, nullptr, right_info->oid_);
+    join_out_ = MakeOutputSchema({{"left_a", MakeColumnValueExpression(*left_out, 0, "colA")},
+                                  {"right_a", MakeColumnValueExpression(*right_out, 1, "colA")}});
+    join_plan_ = std::make_unique<HashJoinPlanNode>(
+        join_out_, std::vector<const AbstractPlanNode *>{left_plan_.get(), right_plan_.get()},
+        MakeColumnValueExpression(*left_out, 0, "colB"), MakeColumnValueExpression(*right_out, 0, "colB"));
+
+    expected_.clear();
+    for (int l = 0; l < left_rows; l++) {
+      for (int r = 0; r < right_rows; r++) {
+        if (left_key_of(l) >= 0 && left_key_of(l) == right_key_of(r)) {
+          expected_.emplace_back(l, r);
+        }
+      }
+    }
+    std::sort(expected_.begin(), expected_.end());
+  }
+
+  /** @return the sorted (l.colA, r.colA) pairs the join produces */
+  std::vector<std::pair<int, int>> Execute(const AbstractPlanNode *plan) {
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<std::pair<int, int>> pairs;
+    for (const auto &tuple : result_set) {
+      pairs.emplace_back(tuple.GetValue(join_out_, 0).GetAs<int32_t>(), tuple.GetValue(join_out_, 1).GetAs<int32_t>());
+    }
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+  }
+
+  std::unique_ptr<SeqScanPlanNode> left_plan_;
+  std::unique_ptr<SeqScanPlanNode> right_plan_;
+  std::unique_ptr<HashJoinPlanNode> join_plan_;
+  const Schema *join_out_;
+  std::vector<std::pair<int, int>> expected_;
+};
+
+// A left side of some 170 KB spills, each partition fits a 64 KB budget, but not a 4 KB one
+// NOLINTNEXTLINE
+TEST_F(GraceHashJoinTest, SpillTest) {
+  MakeJoin(
+      2000, [](int i) { return i % 53 == 0 ? -1 : i % 300; }, 3000, [](int i) { return i % 47 == 0 ? -1 : i % 400; });
+  ASSERT_FALSE(expected_.empty());
+
+  // the budget of a single worker, then the shares of four, then a budget that splits every partition again
+  GetExecutorContext()->SetMemoryBudget(64 << 10);
+  EXPECT_EQ(expected_, Execute(join_plan_.get()));
+  GetExecutorContext()->SetParallelism(4);
+  EXPECT_EQ(expected_, Execute(join_plan_.get()));
+  GetExecutorContext()->SetParallelism(1);
+  GetExecutorContext()->SetMemoryBudget(4 << 10);
+  EXPECT_EQ(expected_, Execute(join_plan_.get()));
+
+  // Next() runs the spilled join behind the queue as well
+  auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), join_plan_.get());
+  executor->Init();
+  Tuple tuple;
+  RID rid;
+  size_t count = 0;
+  while (executor->Next(&tuple, &rid)) {
+    count++;
+  }
+  EXPECT_EQ(expected_.size(), count);
+
+  LimitPlanNode limit_plan{join_out_, join_plan_.get(), 10};
+  EXPECT_EQ(10, Execute(&limit_plan).size());
+
+  // every temporary page went back to the buffer pool
+  executor.reset();
+  std::vector<page_id_t> page_ids(32);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, GetBPM()->NewPage(&page_id));
+  }
+  for (auto page_id : page_ids) {
+    GetBPM()->UnpinPage(page_id, false);
+  }
+}
+
+// One key takes the whole left side, so no split makes its partition fit and it is joined in memory after all
+// NOLINTNEXTLINE
+TEST_F(GraceHashJoinTest, SkewTest) {
+  MakeJoin(
+      500, [](int /*i*/) { return 7; }, 300, [](int i) { return i % 100; });
+  ASSERT_EQ(500 * 3, expected_.size());
+  GetExecutorContext()->SetMemoryBudget(4 << 10);
+  EXPECT_EQ(expected_, Execute(join_plan_.get()));
+}
+
+}  // namespace bustub
@@ -0,0 +1,211 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor_test.cpp
+//
+// Identification: test/execution/sort_executor_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "execution/execution_engine.h"
+#include "execution/executor_factory.h"
+#include "execution/executors/topn_executor.h"
+#include "execution/loser_tree.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "executor_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LoserTreeTest, MergeTest) {
+  std::mt19937 rng(15445);
+  for (size_t num_sources = 0; num_sources <= 9; num_sources++) {
+    std::vector<std::vector<int>> sources(num_sources);
+    std::vector<int> expected;
+    for (auto &source : sources) {
+      source.resize(rng() % 20);
+      for (auto &value : source) {
+        value = static_cast<int>(rng() % 50);
+        expected.push_back(value);
+      }
+      std::sort(source.begin(), source.end());
+    }
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<size_t> heads(num_sources, 0);
+    auto less = [&](size_t a, size_t b) { return sources[a][heads[a]] < sources[b][heads[b]]; };
+    LoserTree<decltype(less)> tree(num_sources, less);
+    std::vector<bool> exhausted;
+    for (const auto &source : sources) {
+      exhausted.push_back(source.empty());
+    }
+    tree.Build(exhausted);
+    std::vector<int> merged;
+    for (size_t top = tree.Top(); top != LoserTree<decltype(less)>::NONE; top = tree.Top()) {
+      merged.push_back(sources[top][heads[top]++]);
+      tree.Pop(heads[top] == sources[top].size());
+    }
+    EXPECT_EQ(expected, merged) << num_sources << " sources";
+  }
+}
+
+class SortExecutorTest : public ExecutorTest {
+ protected:
+  /** A row of table t: colA is unique, colB is NULL for a negative key */
+  using Row = std::tuple<int, int, std::string>;
+
+  /** Create table t of num_rows rows with keys repeating and strings of any length */
+  void MakeTable(int num_rows) {
+    Schema schema{
+        {Column{"colA", TypeId::INTEGER}, Column{"colB", TypeId::INTEGER}, Column{"colC", TypeId::VARCHAR, 32}}};
+    table_info_ = GetCatalog()->CreateTable(GetTxn(), "t", schema);
+    rows_.clear();
+    for (int i = 0; i < num_rows; i++) {
+      const int key = i % 17 == 0 ? -1 : (i * 7919) % 101;
+      std::string str(static_cast<size_t>(i * 31 % 7), static_cast<char>('a' + i % 3));
+      Tuple tuple{{ValueFactory::GetIntegerValue(i),
+                   key < 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(key),
+                   ValueFactory::GetVarcharValue(str)},
+                  &schema};
+      RID rid;
+      ASSERT_TRUE(table_info_->table_->InsertTuple(tuple, &rid, GetTxn()));
+      rows_.emplace_back(i, key, str);
+    }
+
+    auto *out = MakeOutputSchema({{"colA", MakeColumnValueExpression(table_info_->schema_, 0, "colA")},
+                                  {"colB", MakeColumnValueExpression(table_info_->schema_, 0, "colB")},
+                                  {"colC", MakeColumnValueExpression(table_info_->schema_, 0, "colC")}});
+    scan_plan_ = std::make_unique<SeqScanPlanNode>(out, nullptr, table_info_->oid_);
+  }
+
+  /** @return the rows the sort yields */
+  std::vector<Row> Execute(const AbstractPlanNode *plan) {
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(plan, &result_set, GetTxn(), GetExecutorContext());
+    const Schema *out = plan->OutputSchema();
+    std::vector<Row> rows;
+    for (const auto &tuple : result_set) {
+      const Value key = tuple.GetValue(out, 1);
+      rows.emplace_back(tuple.GetValue(out, 0).GetAs<int32_t>(), key.IsNull() ? -1 : key.GetAs<int32_t>(),
+                        tuple.GetValue(out, 2).ToString());
+    }
+    return rows;
+  }
+
+  TableInfo *table_info_;
+  std::vector<Row> rows_;
+  std::unique_ptr<SeqScanPlanNode> scan_plan_;
+};
+
+// ORDER BY colB DESC, colC, colA DESC, in memory, then spilled to runs merged in several passes, then in parallel
+// NOLINTNEXTLINE
+TEST_F(SortExecutorTest, SortTest) {
+  MakeTable(2000);
+  const Schema *out = scan_plan_->OutputSchema();
+  SortPlanNode sort_plan{out,
+                         scan_plan_.get(),
+                         {{OrderByType::DESC, MakeColumnValueExpression(*out, 0, "colB")},
+                          {OrderByType::ASC, MakeColumnValueExpression(*out, 0, "colC")},
+                          {OrderByType::DESC, MakeColumnValueExpression(*out, 0, "colA")}}};
+
+  // NULL sorts last in descending order, and a string before those it is a prefix of
+  std::vector<Row> expected = rows_;
+  std::sort(expected.begin(), expected.end(), [](const Row &lhs, const Row &rhs) {
+    if (std::get<1>(lhs) != std::get<1>(rhs)) {
+      return std::get<1>(lhs) > std::get<1>(rhs);
+    }
+    if (std::get<2>(lhs) != std::get<2>(rhs)) {
+      return std::get<2>(lhs) < std::get<2>(rhs);
+    }
+    return std::get<0>(lhs) > std::get<0>(rhs);
+  });
+
+  EXPECT_EQ(expected, Execute(&sort_plan));
+  GetExecutorContext()->SetMemoryBudget(4 << 10);
+  EXPECT_EQ(expected, Execute(&sort_plan));
+  GetExecutorContext()->SetParallelism(4);
+  EXPECT_EQ(expected, Execute(&sort_plan));
+
+  // Next() yields the same order, from a sort that merged its runs in more than one pass
+  GetExecutorContext()->SetParallelism(1);
+  auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &sort_plan);
+  executor->Init();
+  Tuple tuple;
+  RID rid;
+  size_t count = 0;
+  while (executor->Next(&tuple, &rid)) {
+    ASSERT_EQ(std::get<0>(expected[count]), tuple.GetValue(out, 0).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(expected.size(), count);
+
+  // every temporary page went back to the buffer pool
+  executor.reset();
+  std::vector<page_id_t> page_ids(32);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, GetBPM()->NewPage(&page_id));
+  }
+  for (auto page_id : page_ids) {
+    GetBPM()->UnpinPage(page_id, false);
+  }
+}
+
+// A limit right over a sort runs as a top-N, which yields the first tuples of the sort
+// NOLINTNEXTLINE
+TEST_F(SortExecutorTest, TopNTest) {
+  MakeTable(2000);
+  const Schema *out = scan_plan_->OutputSchema();
+  SortPlanNode sort_plan{out,
+                         scan_plan_.get(),
+                         {{OrderByType::ASC, MakeColumnValueExpression(*out, 0, "colB")},
+                          {OrderByType::DESC, MakeColumnValueExpression(*out, 0, "colC")},
+                          {OrderByType::ASC, MakeColumnValueExpression(*out, 0, "colA")}}};
+  const std::vector<Row> sorted = Execute(&sort_plan);
+  ASSERT_EQ(rows_.size(), sorted.size());
+
+  for (size_t limit : {0, 1, 7, 100, 5000}) {
+    LimitPlanNode limit_plan{out, &sort_plan, limit};
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &limit_plan);
+    EXPECT_NE(nullptr, dynamic_cast<TopNExecutor *>(executor.get()));
+
+    const std::vector<Row> expected(sorted.begin(), sorted.begin() + std::min(limit, sorted.size()));
+    GetExecutorContext()->SetParallelism(1);
+    EXPECT_EQ(expected, Execute(&limit_plan)) << "limit " << limit;
+    GetExecutorContext()->SetParallelism(4);
+    EXPECT_EQ(expected, Execute(&limit_plan)) << "limit " << limit << " on 4 workers";
+  }
+}
+
+// A B+ tree index built over an existing table is fed its keys in order
+// NOLINTNEXTLINE
+TEST_F(SortExecutorTest, IndexBuildTest) {
+  MakeTable(1000);
+  Schema key_schema{{Column{"colA", TypeId::INTEGER}}};
+  IndexInfo *index_info = GetCatalog()->CreateIndex(GetTxn(), "t_colA", "t", table_info_->schema_, key_schema, {0}, 8,
+                                                    IndexType::BPlusTreeIndex);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+  for (int i = 0; i < 1000; i++) {
+    std::vector<RID> rids;
+    index_info->index_->ScanKey(Tuple{{ValueFactory::GetIntegerValue(i)}, &key_schema}, &rids, GetTxn());
+    ASSERT_EQ(1, rids.size());
+    Tuple tuple;
+    ASSERT_TRUE(table_info_->table_->GetTuple(rids[0], &tuple, GetTxn()));
+    EXPECT_EQ(i, tuple.GetValue(&table_info_->schema_, 0).GetAs<int32_t>());
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// spilling_aggregation_test.cpp
+//
+// Identification: test/execution/spilling_aggregation_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "execution/execution_engine.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "executor_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class SpillingAggregationTest : public ExecutorTest {
+ protected:
+  /** A group of the aggregation: colA, COUNT(*), SUM(colC), MAX(colC) */
+  using Row = std::tuple<int, int, int, int>;
+
+  /**
+   * Create table t of num_rows rows (colA = i % num_keys, NULL for every 97th row, colB = "k" + i % 2, colC = i)
+   * and SELECT colA, COUNT(colC), SUM(colC), MAX(colC) FROM t GROUP BY colA, colB HAVING MAX(colC) >= 100
+   */
+  void MakeAggregation(int num_rows, int num_keys) {
+    Schema schema{
+        {Column{"colA", TypeId::INTEGER}, Column{"colB", TypeId::VARCHAR, 8}, Column{"colC", TypeId::INTEGER}}};
+    TableInfo *table_info = GetCatalog()->CreateTable(GetTxn(), "t", schema);
+    std::map<std::pair<int, std::string>, Row> groups;
+    for (int i = 0; i < num_rows; i++) {
+      const int key = i % 97 == 0 ? -1 : i % num_keys;
+      const std::string str = "k" + std::to_string(i % 2);
+      Tuple tuple{{key < 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(key),
+                   ValueFactory::GetVarcharValue(str), ValueFactory::GetIntegerValue(i)},
+                  &schema};
+      RID rid;
+      ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, GetTxn()));
+
+      auto [it, inserted] = groups.try_emplace({key, str}, key, 0, 0, i);
+      std::get<1>(it->second)++;
+      std::get<2>(it->second) += i;
+      std::get<3>(it->second) = std::max(std::get<3>(it->second), i);
+    }
+    expected_.clear();
+    for (const auto &[key, row] : groups) {
+      if (std::get<3>(row) >= 100) {
+        expected_.push_back(row);
+      }
+    }
+    std::sort(expected_.begin(), expected_.end());
+
+    auto *scan_out = MakeOutputSchema({{"colA", MakeColumnValueExpression(schema, 0, "colA")},
+                                       {"colB", MakeColumnValueExpression(schema, 0, "colB")},
+                                       {"colC", MakeColumnValueExpression(schema, 0, "colC")}});
+    scan_plan_ = std::make_unique<SeqScanPlanNode>(scan_out, nullptr, table_info->oid_);
+    const AbstractExpression *col_a = MakeColumnValueExpression(*scan_out, 0, "colA");
+    const AbstractExpression *col_b = MakeColumnValueExpression(*scan_out, 0, "colB");
+    const AbstractExpression *col_c = MakeColumnValueExpression(*scan_out, 0, "colC");
+    const AbstractExpression *max_c = MakeAggregateValueExpression(false, 2);
+    const AbstractExpression *having = MakeComparisonExpression(
+        max_c, MakeConstantValueExpression(ValueFactory::GetIntegerValue(100)), ComparisonType::GreaterThanOrEqual);
+    agg_out_ = MakeOutputSchema({{"colA", MakeAggregateValueExpression(true, 0)},
+                                 {"count", MakeAggregateValueExpression(false, 0)},
+                                 {"sum", MakeAggregateValueExpression(false, 1)},
+                                 {"max", max_c}});
+    agg_plan_ = std::make_unique<AggregationPlanNode>(
+        agg_out_, scan_plan_.get(), having, std::vector<const AbstractExpression *>{col_a, col_b},
+        std::vector<const AbstractExpression *>{col_c, col_c, col_c},
+        std::vector<AggregationType>{AggregationType::CountAggregate, AggregationType::SumAggregate,
+                                     AggregationType::MaxAggregate});
+  }
+
+  /** @return the sorted groups the aggregation yields */
+  std::vector<Row> Execute() {
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(agg_plan_.get(), &result_set, GetTxn(), GetExecutorContext());
+    std::vector<Row> rows;
+    for (const auto &tuple : result_set) {
+      const Value key = tuple.GetValue(agg_out_, 0);
+      rows.emplace_back(key.IsNull() ? -1 : key.GetAs<int32_t>(), tuple.GetValue(agg_out_, 1).GetAs<int32_t>(),
+                        tuple.GetValue(agg_out_, 2).GetAs<int32_t>(), tuple.GetValue(agg_out_, 3).GetAs<int32_t>());
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  }
+
+  std::unique_ptr<SeqScanPlanNode> scan_plan_;
+  std::unique_ptr<AggregationPlanNode> agg_plan_;
+  const Schema *agg_out_;
+  std::vector<Row> expected_;
+};
+
+// Groups past the budget are spilled and merged back a partition at a time
+// NOLINTNEXTLINE
+TEST_F(SpillingAggregationTest, SpillTest) {
+  MakeAggregation(10000, 4000);
+  EXPECT_EQ(expected_, Execute());
+  GetExecutorContext()->SetMemoryBudget(256 << 10);
+  EXPECT_EQ(expected_, Execute());
+
+  // every temporary page went back to the buffer pool
+  std::vector<page_id_t> page_ids(32);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, GetBPM()->NewPage(&page_id));
+  }
+  for (auto page_id : page_ids) {
+    GetBPM()->UnpinPage(page_id, false);
+  }
+}
+
+// Workers pre-aggregate, or pass their batches through once each of them holds thousands of groups, and merge the
+// partitions in parallel, or spill them past the budget
+// NOLINTNEXTLINE
+TEST_F(SpillingAggregationTest, ParallelTest) {
+  MakeAggregation(12000, 12000);
+  for (uint32_t parallelism : {2, 4}) {
+    GetExecutorContext()->SetParallelism(parallelism);
+    GetExecutorContext()->SetMemoryBudget(std::numeric_limits<size_t>::max());
+    EXPECT_EQ(expected_, Execute()) << parallelism << " workers";
+    GetExecutorContext()->SetMemoryBudget(256 << 10);
+    EXPECT_EQ(expected_, Execute()) << parallelism << " workers within budget";
+  }
+}
+
+// A budget too small for any group spills every batch and splits each partition until it holds one group
+// NOLINTNEXTLINE
+TEST_F(SpillingAggregationTest, TinyBudgetTest) {
+  MakeAggregation(5000, 1);
+  GetExecutorContext()->SetMemoryBudget(1);
+  EXPECT_EQ(expected_, Execute());
+}
+
+}  // namespace bustub
@@ -0,0 +1,218 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_duplicate_key_test.cpp
+//
+// Identification: test/storage/b_plus_tree_duplicate_key_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+
+namespace bustub {
+
+using Tree = BPlusTree<IntegerKey<8>, RID, IntegerComparator<8>>;
+
+namespace {
+
+IntegerKey<8> MakeKey(int64_t key) {
+  IntegerKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+bool RidLess(const RID &lhs, const RID &rhs) { return lhs.Get() < rhs.Get(); }
+
+void ExpectNoPinnedPages(BufferPoolManagerInstance *bpm) {
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount()) << "frame " << i;
+  }
+}
+
+}  // namespace
+
+TEST(BPlusTreeDuplicateKeyTest, PostingPageEncodingTest) {
+  char data[PAGE_SIZE];
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(data);
+  posting->Init();
+
+  // rows in heap order cost a byte or two each
+  std::vector<RID> rids;
+  for (page_id_t page_id = 3; page_id < 30; page_id++) {
+    for (uint32_t slot = 0; slot < 60; slot++) {
+      rids.emplace_back(page_id, slot);
+    }
+  }
+  size_t size = BPlusTreePostingPage::EncodedSize(rids.data(), rids.size());
+  EXPECT_LT(size, rids.size() + 27 * 2);
+  ASSERT_LE(size, BPlusTreePostingPage::CAPACITY);
+  posting->Encode(rids.data(), rids.size());
+  EXPECT_EQ(rids.size(), posting->GetCount());
+  EXPECT_EQ(rids.back(), posting->GetLastRid());
+
+  std::vector<RID> decoded;
+  posting->Decode(&decoded);
+  EXPECT_EQ(rids, decoded);
+
+  // sparse and large ids round trip as well
+  rids = {RID(0, 0), RID(0, 1 << 20), RID(1 << 30, 7), RID((1 << 30) + 1, UINT32_MAX - 1)};
+  posting->Encode(rids.data(), rids.size());
+  decoded.clear();
+  posting->Decode(&decoded);
+  EXPECT_EQ(rids, decoded);
+}
+
+TEST(BPlusTreeDuplicateKeyTest, HeavyKeyTest) {
+  auto *disk_manager = new DiskManager("duplicate_key_test.db");
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  IntegerComparator<8> comparator;
+  Tree tree("foo_idx", bpm, comparator, 4, 4, INVALID_PAGE_ID, false);
+
+  // one key with enough rows to spill over several posting pages, surrounded by unique keys
+  std::vector<RID> heavy;
+  for (int i = 0; i < 6000; i++) {
+    heavy.emplace_back(i / 7, (i * 31) % 7);
+  }
+  // half of the rows arrive in heap order, the rest out of order
+  std::sort(heavy.begin(), heavy.end(), RidLess);
+  std::shuffle(heavy.begin() + heavy.size() / 2, heavy.end(), std::mt19937(15445));
+  std::rotate(heavy.begin(), heavy.begin() + heavy.size() / 4, heavy.end());
+  for (int64_t key = 0; key < 20; key++) {
+    tree.Insert(MakeKey(key), RID(-1, key));
+  }
+  for (const auto &rid : heavy) {
+    EXPECT_TRUE(tree.Insert(MakeKey(10), rid));
+  }
+  EXPECT_FALSE(tree.Insert(MakeKey(10), heavy[0]));
+  EXPECT_FALSE(tree.Insert(MakeKey(10), RID(-1, 10)));
+  std::sort(heavy.begin(), heavy.end(), RidLess);
+  ExpectNoPinnedPages(bpm);
+
+  // the original value of the key sorts first
+  std::vector<RID> expected{RID(-1, 10)};
+  expected.insert(expected.end(), heavy.begin(), heavy.end());
+  std::vector<RID> result;
+  EXPECT_TRUE(tree.GetValue(MakeKey(10), &result));
+  EXPECT_EQ(expected, result);
+
+  // range scans and the iterator see every value
+  auto low = MakeKey(9);
+  auto high = MakeKey(11);
+  auto scan = tree.RangeScan(&low, &high, true);
+  result.clear();
+  std::vector<RID> batch;
+  while (scan->NextBatch(&batch)) {
+    result.insert(result.end(), batch.begin(), batch.end());
+    batch.clear();
+  }
+  scan.reset();
+  EXPECT_EQ(expected.size() + 2, result.size());
+
+  size_t visited = 0;
+  size_t heavy_visited = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it) {
+    visited++;
+    if ((*it).first.ToString() == 10) {
+      EXPECT_EQ(expected[heavy_visited], (*it).second);
+      heavy_visited++;
+    }
+  }
+  EXPECT_EQ(expected.size() + 19, visited);
+  EXPECT_EQ(expected.size(), heavy_visited);
+
+  // removing values one at a time shrinks the list, the key goes with its last value
+  for (size_t i = 0; i < expected.size(); i += 2) {
+    tree.Remove(MakeKey(10), expected[i]);
+  }
+  tree.Remove(MakeKey(10), RID(12345, 0));
+  result.clear();
+  EXPECT_TRUE(tree.GetValue(MakeKey(10), &result));
+  ASSERT_EQ(expected.size() / 2, result.size());
+  for (size_t i = 0; i < result.size(); i++) {
+    EXPECT_EQ(expected[i * 2 + 1], result[i]);
+  }
+  for (const auto &rid : result) {
+    tree.Remove(MakeKey(10), rid);
+  }
+  result.clear();
+  EXPECT_FALSE(tree.GetValue(MakeKey(10), &result));
+  EXPECT_TRUE(tree.GetValue(MakeKey(11), &result));
+  ExpectNoPinnedPages(bpm);
+
+  delete bpm;
+  delete disk_manager;
+  remove("duplicate_key_test.db");
+  remove("duplicate_key_test.log");
+}
+
+TEST(BPlusTreeDuplicateKeyTest, RandomWorkloadTest) {
+  auto *disk_manager = new DiskManager("duplicate_key_test.db");
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  IntegerComparator<8> comparator;
+  Tree tree("foo_idx", bpm, comparator, 5, 4, INVALID_PAGE_ID, false);
+
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<int64_t> key_dist(0, 300);
+  std::uniform_int_distribution<int> rid_dist(0, 2000);
+  std::map<int64_t, std::set<int64_t>> expected;
+  for (int round = 0; round < 6; round++) {
+    for (int i = 0; i < 2000; i++) {
+      int64_t key = key_dist(gen);
+      RID rid(rid_dist(gen), rid_dist(gen) % 16);
+      EXPECT_EQ(expected[key].insert(rid.Get()).second, tree.Insert(MakeKey(key), rid));
+    }
+    for (int i = 0; i < 1500; i++) {
+      int64_t key = key_dist(gen);
+      auto &rids = expected[key];
+      if (rids.empty()) {
+        continue;
+      }
+      RID rid(*std::next(rids.begin(), rid_dist(gen) % rids.size()));
+      tree.Remove(MakeKey(key), rid);
+      rids.erase(rid.Get());
+    }
+    // drop a few keys entirely
+    for (int i = 0; i < 10; i++) {
+      int64_t key = key_dist(gen);
+      tree.Remove(MakeKey(key));
+      expected[key].clear();
+    }
+
+    std::vector<IntegerKey<8>> keys;
+    for (int64_t key = 0; key <= 300; key++) {
+      keys.push_back(MakeKey(key));
+    }
+    std::vector<std::vector<RID>> results;
+    tree.GetValues(keys, &results);
+    for (int64_t key = 0; key <= 300; key++) {
+      std::vector<RID> rids;
+      EXPECT_EQ(!expected[key].empty(), tree.GetValue(MakeKey(key), &rids));
+      std::vector<int64_t> got;
+      for (const auto &rid : rids) {
+        got.push_back(rid.Get());
+      }
+      EXPECT_EQ(std::vector<int64_t>(expected[key].begin(), expected[key].end()), got) << key;
+      EXPECT_EQ(rids, results[key]) << key;
+    }
+    ExpectNoPinnedPages(bpm);
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("duplicate_key_test.db");
+  remove("duplicate_key_test.log");
+}
+
+}  // namespace bustub
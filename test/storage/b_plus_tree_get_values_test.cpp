@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_get_values_test.cpp
+//
+// Identification: test/storage/b_plus_tree_get_values_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+
+namespace bustub {
+
+using Tree = BPlusTree<IntegerKey<8>, RID, IntegerComparator<8>>;
+
+namespace {
+
+/** Counts page fetches so tests can check how often the tree is descended */
+class CountingBufferPoolManager : public BufferPoolManagerInstance {
+ public:
+  using BufferPoolManagerInstance::BufferPoolManagerInstance;
+
+  size_t fetches_{0};
+
+ protected:
+  Page *FetchPgImp(page_id_t page_id) override {
+    fetches_++;
+    return BufferPoolManagerInstance::FetchPgImp(page_id);
+  }
+};
+
+IntegerKey<8> MakeKey(int64_t key) {
+  IntegerKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+}  // namespace
+
+TEST(BPlusTreeGetValuesTest, MatchesGetValueTest) {
+  auto *disk_manager = new DiskManager("get_values_test.db");
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  IntegerComparator<8> comparator;
+  Tree tree("foo_pk", bpm, comparator, 5, 4, INVALID_PAGE_ID);
+
+  // empty tree
+  std::vector<std::vector<RID>> result;
+  EXPECT_EQ(0, tree.GetValues({MakeKey(1), MakeKey(2)}, &result));
+  ASSERT_EQ(2, result.size());
+  EXPECT_TRUE(result[0].empty() && result[1].empty());
+
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<int64_t> dist(0, 4000);
+  std::set<int64_t> keys;
+  for (int i = 0; i < 1500; i++) {
+    int64_t key = dist(gen);
+    tree.Insert(MakeKey(key), RID(0, key));
+    keys.insert(key);
+  }
+
+  for (size_t batch_size : {1, 7, 64, 1000}) {
+    std::vector<int64_t> probes;
+    for (size_t i = 0; i < batch_size; i++) {
+      probes.push_back(dist(gen));
+    }
+    // duplicates and keys below / above every stored key
+    probes.push_back(probes[0]);
+    probes.push_back(-1);
+    probes.push_back(5000);
+    std::sort(probes.begin(), probes.end());
+
+    std::vector<IntegerKey<8>> probe_keys;
+    for (auto probe : probes) {
+      probe_keys.push_back(MakeKey(probe));
+    }
+    size_t found = tree.GetValues(probe_keys, &result);
+    ASSERT_EQ(probes.size(), result.size());
+
+    size_t expected_found = 0;
+    for (size_t i = 0; i < probes.size(); i++) {
+      if (keys.count(probes[i]) == 0) {
+        EXPECT_TRUE(result[i].empty()) << probes[i];
+        continue;
+      }
+      expected_found++;
+      ASSERT_EQ(1, result[i].size()) << probes[i];
+      EXPECT_EQ(probes[i], result[i][0].GetSlotNum());
+    }
+    EXPECT_EQ(expected_found, found);
+  }
+
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("get_values_test.db");
+  remove("get_values_test.log");
+}
+
+TEST(BPlusTreeGetValuesTest, SharedLeafFetchTest) {
+  auto *disk_manager = new DiskManager("get_values_test.db");
+  auto *bpm = new CountingBufferPoolManager(64, disk_manager);
+  IntegerComparator<8> comparator;
+  Tree tree("foo_pk", bpm, comparator, 16, 16, INVALID_PAGE_ID);
+
+  std::vector<IntegerKey<8>> probe_keys;
+  for (int64_t key = 0; key < 1000; key++) {
+    tree.Insert(MakeKey(key), RID(0, key));
+    probe_keys.push_back(MakeKey(key));
+  }
+
+  bpm->fetches_ = 0;
+  std::vector<RID> rids;
+  for (const auto &key : probe_keys) {
+    tree.GetValue(key, &rids);
+  }
+  size_t single_fetches = bpm->fetches_;
+
+  bpm->fetches_ = 0;
+  std::vector<std::vector<RID>> result;
+  EXPECT_EQ(probe_keys.size(), tree.GetValues(probe_keys, &result));
+  size_t batch_fetches = bpm->fetches_;
+
+  // at least 8 keys per leaf, each leaf and internal page is fetched about once
+  EXPECT_LT(batch_fetches * 4, probe_keys.size());
+  EXPECT_LT(batch_fetches * 8, single_fetches);
+
+  delete bpm;
+  delete disk_manager;
+  remove("get_values_test.db");
+  remove("get_values_test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_range_scan_test.cpp
+//
+// Identification: test/storage/b_plus_tree_range_scan_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+
+namespace bustub {
+
+using Tree = BPlusTree<IntegerKey<8>, RID, IntegerComparator<8>>;
+
+namespace {
+
+IntegerKey<8> MakeKey(int64_t key) {
+  IntegerKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+/** Drain a range scan, also checking that every batch is non-empty */
+std::vector<int64_t> Drain(Tree *tree, const int64_t *low, const int64_t *high, bool high_inclusive) {
+  IntegerKey<8> low_key;
+  IntegerKey<8> high_key;
+  if (low != nullptr) {
+    low_key = MakeKey(*low);
+  }
+  if (high != nullptr) {
+    high_key = MakeKey(*high);
+  }
+  auto scan = tree->RangeScan(low == nullptr ? nullptr : &low_key, high == nullptr ? nullptr : &high_key,
+                              high_inclusive);
+  std::vector<int64_t> keys;
+  std::vector<RID> batch;
+  while (true) {
+    batch.clear();
+    if (!scan->NextBatch(&batch)) {
+      break;
+    }
+    EXPECT_FALSE(batch.empty());
+    for (const auto &rid : batch) {
+      keys.push_back(rid.GetSlotNum());
+    }
+  }
+  EXPECT_FALSE(scan->NextBatch(&batch));
+  return keys;
+}
+
+std::vector<int64_t> Expected(const std::set<int64_t> &keys, const int64_t *low, const int64_t *high,
+                              bool high_inclusive) {
+  std::vector<int64_t> expected;
+  for (auto key : keys) {
+    if ((low == nullptr || key >= *low) && (high == nullptr || key < *high || (high_inclusive && key == *high))) {
+      expected.push_back(key);
+    }
+  }
+  return expected;
+}
+
+void ExpectNoPinnedPages(BufferPoolManagerInstance *bpm) {
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount()) << "frame " << i;
+  }
+}
+
+}  // namespace
+
+TEST(BPlusTreeRangeScanTest, BoundsTest) {
+  auto *disk_manager = new DiskManager("range_scan_test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  IntegerComparator<8> comparator;
+  Tree tree("foo_pk", bpm, comparator, 4, 4, INVALID_PAGE_ID);
+
+  // empty tree
+  EXPECT_TRUE(Drain(&tree, nullptr, nullptr, false).empty());
+
+  std::set<int64_t> keys;
+  for (int64_t key = 0; key < 200; key += 2) {
+    tree.Insert(MakeKey(key), RID(0, key));
+    keys.insert(key);
+  }
+
+  std::vector<int64_t> bounds{-5, 0, 1, 2, 7, 8, 99, 100, 198, 199, 250};
+  for (auto low : bounds) {
+    for (auto high : bounds) {
+      for (bool inclusive : {false, true}) {
+        EXPECT_EQ(Expected(keys, &low, &high, inclusive), Drain(&tree, &low, &high, inclusive))
+            << "[" << low << ", " << high << (inclusive ? "]" : ")");
+      }
+    }
+    EXPECT_EQ(Expected(keys, &low, nullptr, false), Drain(&tree, &low, nullptr, false));
+    EXPECT_EQ(Expected(keys, nullptr, &low, false), Drain(&tree, nullptr, &low, false));
+  }
+  EXPECT_EQ(Expected(keys, nullptr, nullptr, false), Drain(&tree, nullptr, nullptr, false));
+  ExpectNoPinnedPages(bpm);
+
+  delete bpm;
+  delete disk_manager;
+  remove("range_scan_test.db");
+  remove("range_scan_test.log");
+}
+
+TEST(BPlusTreeRangeScanTest, RandomWorkloadTest) {
+  // the pool is much smaller than the tree, so scans and updates go through eviction
+  auto *disk_manager = new DiskManager("range_scan_test.db");
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  IntegerComparator<8> comparator;
+  Tree tree("foo_pk", bpm, comparator, 5, 4, INVALID_PAGE_ID);
+
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<int64_t> dist(0, 3000);
+  std::set<int64_t> keys;
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < 300; i++) {
+      int64_t key = dist(gen);
+      EXPECT_EQ(keys.count(key) == 0, tree.Insert(MakeKey(key), RID(0, key)));
+      keys.insert(key);
+    }
+    for (int i = 0; i < 200; i++) {
+      int64_t key = dist(gen);
+      tree.Remove(MakeKey(key));
+      keys.erase(key);
+    }
+    for (int i = 0; i < 10; i++) {
+      int64_t low = dist(gen);
+      int64_t high = low + dist(gen) / 4;
+      EXPECT_EQ(Expected(keys, &low, &high, i % 2 == 0), Drain(&tree, &low, &high, i % 2 == 0));
+    }
+    EXPECT_EQ(Expected(keys, nullptr, nullptr, false), Drain(&tree, nullptr, nullptr, false));
+    ExpectNoPinnedPages(bpm);
+  }
+
+  // abandoning a scan midway releases its pages
+  {
+    int64_t low = 0;
+    auto low_key = MakeKey(low);
+    auto scan = tree.RangeScan(&low_key, nullptr);
+    std::vector<RID> batch;
+    EXPECT_TRUE(scan->NextBatch(&batch));
+  }
+  ExpectNoPinnedPages(bpm);
+
+  delete bpm;
+  delete disk_manager;
+  remove("range_scan_test.db");
+  remove("range_scan_test.log");
+}
+
+}  // namespace bustub
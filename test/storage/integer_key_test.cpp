@@ -0,0 +1,130 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// integer_key_test.cpp
+//
+// Identification: test/storage/integer_key_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "gtest/gtest.h"
+#include "storage/index/integer_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(IntegerKeyTest, SingleColumnOrderTest) {
+  std::vector<int64_t> values{INT64_MIN + 1, -(1LL << 40), -257, -256, -1, 0, 1, 255, 256, 1LL << 40, INT64_MAX};
+  std::vector<Column> columns{Column{"a", TypeId::BIGINT}};
+  Schema key_schema{columns};
+  IntegerComparator<8> comparator;
+
+  for (auto lhs : values) {
+    for (auto rhs : values) {
+      Tuple lhs_tuple{{ValueFactory::GetBigIntValue(lhs)}, &key_schema};
+      Tuple rhs_tuple{{ValueFactory::GetBigIntValue(rhs)}, &key_schema};
+      IntegerKey<8> lhs_key;
+      IntegerKey<8> rhs_key;
+      lhs_key.SetFromKey(lhs_tuple, key_schema);
+      rhs_key.SetFromKey(rhs_tuple, key_schema);
+
+      int expected = lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+      EXPECT_EQ(expected, comparator(lhs_key, rhs_key)) << lhs << " vs " << rhs;
+      EXPECT_EQ(lhs, lhs_key.ToString());
+    }
+  }
+}
+
+TEST(IntegerKeyTest, CompositeOrderTest) {
+  std::vector<Column> columns{Column{"a", TypeId::SMALLINT}, Column{"b", TypeId::INTEGER},
+                              Column{"c", TypeId::BIGINT}};
+  Schema key_schema{columns};
+  ASSERT_EQ(14, IntegerKeySize(key_schema));
+
+  std::vector<std::tuple<int16_t, int32_t, int64_t>> rows;
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<int> small(-3, 3);
+  for (int i = 0; i < 200; i++) {
+    rows.emplace_back(small(gen), small(gen) * 100000, small(gen) * (1LL << 35));
+  }
+
+  IntegerComparator<16> comparator;
+  auto make_key = [&](const std::tuple<int16_t, int32_t, int64_t> &row) {
+    Tuple tuple{{ValueFactory::GetSmallIntValue(std::get<0>(row)), ValueFactory::GetIntegerValue(std::get<1>(row)),
+                 ValueFactory::GetBigIntValue(std::get<2>(row))},
+                &key_schema};
+    IntegerKey<16> key;
+    key.SetFromKey(tuple, key_schema);
+    return key;
+  };
+
+  for (const auto &lhs : rows) {
+    for (const auto &rhs : rows) {
+      int expected = lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+      EXPECT_EQ(expected, comparator(make_key(lhs), make_key(rhs)));
+    }
+  }
+}
+
+TEST(IntegerKeyTest, KeySizeTest) {
+  Schema int_schema{{Column{"a", TypeId::INTEGER}}};
+  Schema pair_schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::TINYINT}, Column{"c", TypeId::BOOLEAN}}};
+  Schema mixed_schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 16}}};
+  Schema decimal_schema{{Column{"a", TypeId::DECIMAL}}};
+  EXPECT_EQ(4, IntegerKeySize(int_schema));
+  EXPECT_EQ(6, IntegerKeySize(pair_schema));
+  EXPECT_EQ(0, IntegerKeySize(mixed_schema));
+  EXPECT_EQ(0, IntegerKeySize(decimal_schema));
+}
+
+TEST(IntegerKeyTest, CatalogPicksKeyTypeTest) {
+  auto disk_manager = std::make_unique<DiskManager>("integer_key_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::BIGINT}, Column{"c", TypeId::DECIMAL}}};
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, catalog->CreateTable(txn.get(), "t", schema));
+
+  Schema a_schema{{Column{"a", TypeId::INTEGER}}};
+  auto *a_index = catalog->CreateIndex(txn.get(), "a_idx", "t", schema, a_schema, {0}, 4);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, a_index);
+  using IntHashIndex = ExtendibleHashTableIndex<IntegerKey<4>, RID, IntegerComparator<4>>;
+  EXPECT_NE(nullptr, dynamic_cast<IntHashIndex *>(a_index->index_.get()));
+
+  Schema ab_schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::BIGINT}}};
+  auto *ab_index =
+      catalog->CreateIndex(txn.get(), "ab_idx", "t", schema, ab_schema, {0, 1}, 12, IndexType::BPlusTreeIndex);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, ab_index);
+  using CompositeTreeIndex = BPlusTreeIndex<IntegerKey<16>, RID, IntegerComparator<16>>;
+  EXPECT_NE(nullptr, dynamic_cast<CompositeTreeIndex *>(ab_index->index_.get()));
+
+  Schema c_schema{{Column{"c", TypeId::DECIMAL}}};
+  auto *c_index = catalog->CreateIndex(txn.get(), "c_idx", "t", schema, c_schema, {2}, 8, IndexType::BPlusTreeIndex);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, c_index);
+  using GenericTreeIndex = BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
+  EXPECT_NE(nullptr, dynamic_cast<GenericTreeIndex *>(c_index->index_.get()));
+
+  // Keys too wide for any key type are rejected
+  EXPECT_EQ(Catalog::NULL_INDEX_INFO, catalog->CreateIndex(txn.get(), "d_idx", "t", schema, c_schema, {2}, 128));
+  // So are duplicate index names
+  EXPECT_EQ(Catalog::NULL_INDEX_INFO, catalog->CreateIndex(txn.get(), "a_idx", "t", schema, a_schema, {0}, 4));
+  EXPECT_EQ(3, catalog->GetTableIndexes("t").size());
+
+  remove("integer_key_test.db");
+  remove("integer_key_test.log");
+}
+
+}  // namespace bustub
@@ -10,20 +10,19 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <string>
 #include <vector>
 
+#include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "storage/page/tmp_tuple_page.h"
+#include "storage/table/tmp_tuple_file.h"
 #include "type/value_factory.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(TmpTuplePageTest, DISABLED_BasicTest) {
-  // There are many ways to do this assignment, and this is only one of them.
-  // If you don't like the TmpTuplePage idea, please feel free to delete this test case entirely.
-  // You will get full credit as long as you are correctly using a linear probe hash table.
-
+TEST(TmpTuplePageTest, BasicTest) {
   TmpTuplePage page{};
   page_id_t page_id = 15445;
   page.Init(page_id, PAGE_SIZE);
@@ -46,6 +45,70 @@ TEST(TmpTuplePageTest, DISABLED_BasicTest) {
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + sizeof(page_id_t) + sizeof(lsn_t)), PAGE_SIZE - 8);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + PAGE_SIZE - 8), 4);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + PAGE_SIZE - 4), 123);
+  EXPECT_EQ(page_id, tmp_tuple.GetPageId());
+  EXPECT_EQ(PAGE_SIZE - 8, tmp_tuple.GetOffset());
+
+  // fill the page, then read the tuples back from the last one inserted to the first
+  int inserted = 1;
+  while (page.Insert(Tuple({ValueFactory::GetIntegerValue(123 + inserted)}, &schema), &tmp_tuple)) {
+    inserted++;
+  }
+  EXPECT_EQ((PAGE_SIZE - 12) / 8, inserted);
+  size_t offset = page.GetFreeSpacePointer();
+  for (int i = inserted - 1; i >= 0; i--) {
+    Tuple read;
+    page.Get(offset, &read);
+    EXPECT_EQ(123 + i, read.GetValue(&schema, 0).GetAs<int32_t>());
+    offset = page.NextOffset(offset);
+  }
+  EXPECT_EQ(PAGE_SIZE, offset);
+}
+
+// NOLINTNEXTLINE
+TEST(TmpTuplePageTest, FileTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+  Schema schema{{Column{"A", TypeId::INTEGER}, Column{"B", TypeId::VARCHAR, 64}}};
+  auto tuple_of = [&schema](int i) {
+    return Tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(i % 50, 'x'))}, &schema};
+  };
+
+  // more pages than frames, the full ones are written out and read back in
+  const int num_tuples = 5000;
+  {
+    TmpTupleFile file(bpm);
+    for (int i = 0; i < num_tuples; i++) {
+      TmpTuple tmp_tuple = file.Append(tuple_of(i));
+      EXPECT_NE(INVALID_PAGE_ID, tmp_tuple.GetPageId());
+    }
+    file.Finish();
+    EXPECT_EQ(num_tuples, file.Size());
+    EXPECT_GT(file.NumPages(), 5);
+
+    int next = 0;
+    std::vector<Tuple> tuples;
+    for (size_t page = 0; page < file.NumPages(); page++) {
+      tuples.clear();
+      file.ReadPage(page, &tuples);
+      for (const auto &tuple : tuples) {
+        ASSERT_EQ(next, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+        ASSERT_EQ(std::string(next % 50, 'x'), tuple.GetValue(&schema, 1).ToString());
+        next++;
+      }
+    }
+    EXPECT_EQ(num_tuples, next);
+  }
+
+  // the file left no page pinned
+  page_id_t page_id;
+  for (int i = 0; i < 5; i++) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
 }
 
 }  // namespace bustub
@@ -0,0 +1,358 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_b_plus_tree_test.cpp
+//
+// Identification: test/storage/varlen_b_plus_tree_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/varlen_b_plus_tree.h"
+#include "storage/index/varlen_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** Counts allocated pages so trees can be compared by size */
+class CountingBufferPoolManager : public BufferPoolManagerInstance {
+ public:
+  using BufferPoolManagerInstance::BufferPoolManagerInstance;
+
+  size_t new_pages_{0};
+
+ protected:
+  Page *NewPgImp(page_id_t *page_id) override {
+    new_pages_++;
+    return BufferPoolManagerInstance::NewPgImp(page_id);
+  }
+};
+
+/** Keys sharing long prefixes, like URLs or file paths */
+std::string MakeKey(std::mt19937 *gen, size_t max_suffix) {
+  static const std::vector<std::string> prefixes{"https://example.com/catalog/products/", "https://example.com/users/",
+                                                 "/var/lib/postgresql/data/base/", "s3://bucket/logs/2021/"};
+  std::uniform_int_distribution<size_t> prefix(0, prefixes.size() - 1);
+  std::uniform_int_distribution<size_t> length(1, max_suffix);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::string key = prefixes[prefix(*gen)];
+  for (size_t i = length(*gen); i > 0; i--) {
+    key.push_back(static_cast<char>(letter(*gen)));
+  }
+  return key;
+}
+
+/** Drain a range scan, mapping each RID back to the key it was inserted under (its slot number) */
+std::vector<uint32_t> Drain(VarlenBPlusTree *tree, const std::string *low, const std::string *high) {
+  std::string_view low_view = low == nullptr ? std::string_view() : std::string_view(*low);
+  std::string_view high_view = high == nullptr ? std::string_view() : std::string_view(*high);
+  auto scan = tree->RangeScan(low == nullptr ? nullptr : &low_view, high == nullptr ? nullptr : &high_view);
+  std::vector<uint32_t> ids;
+  std::vector<RID> batch;
+  while (scan->NextBatch(&batch)) {
+    EXPECT_FALSE(batch.empty());
+    for (const auto &rid : batch) {
+      ids.push_back(rid.GetSlotNum());
+    }
+    batch.clear();
+  }
+  return ids;
+}
+
+std::vector<uint32_t> Expected(const std::map<std::string, uint32_t> &keys, const std::string *low,
+                               const std::string *high) {
+  std::vector<uint32_t> ids;
+  for (auto it = low == nullptr ? keys.begin() : keys.lower_bound(*low);
+       it != keys.end() && (high == nullptr || it->first < *high); ++it) {
+    ids.push_back(it->second);
+  }
+  return ids;
+}
+
+void ExpectNoPinnedPages(BufferPoolManagerInstance *bpm) {
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount()) << "frame " << i;
+  }
+}
+
+}  // namespace
+
+TEST(VarlenBPlusTreeTest, KeyEncodingOrderTest) {
+  Schema key_schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 16}, Column{"c", TypeId::DECIMAL}}};
+  using Row = std::tuple<int32_t, std::string, double>;
+  std::vector<Row> rows;
+  for (int32_t a : {-70000, -1, 0, 1, 256}) {
+    // std::string compares bytes as unsigned, like the encoded keys
+    for (const char *b : {"", "a", "ab", "abc", "b", "\x7f", "\x80\xff"}) {
+      for (double c : {-1e300, -2.5, 0.0, 1e-300, 3.25}) {
+        rows.emplace_back(a, b, c);
+      }
+    }
+  }
+
+  auto encode = [&](const Row &row) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(std::get<0>(row)), ValueFactory::GetVarcharValue(std::get<1>(row)),
+                 ValueFactory::GetDecimalValue(std::get<2>(row))},
+                &key_schema};
+    std::string key;
+    VarlenKey::Encode(tuple, key_schema, &key);
+    return key;
+  };
+  for (const auto &lhs : rows) {
+    for (const auto &rhs : rows) {
+      EXPECT_EQ(lhs < rhs, encode(lhs) < encode(rhs));
+      EXPECT_EQ(lhs == rhs, encode(lhs) == encode(rhs));
+    }
+  }
+
+  // NULL sorts before every value
+  Tuple null_tuple{{ValueFactory::GetIntegerValue(-70000), ValueFactory::GetNullValueByType(TypeId::VARCHAR),
+                    ValueFactory::GetDecimalValue(0)},
+                   &key_schema};
+  std::string null_key;
+  VarlenKey::Encode(null_tuple, key_schema, &null_key);
+  EXPECT_LT(null_key, encode(Row{-70000, "", -1e300}));
+  EXPECT_GT(null_key, encode(Row{-70001, "zzz", 0}));
+}
+
+TEST(VarlenBPlusTreeTest, RandomWorkloadTest) {
+  // long keys over a small pool, so leaves and internal pages split and pages get evicted
+  auto *disk_manager = new DiskManager("varlen_b_plus_tree_test.db");
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  VarlenBPlusTree tree("foo_pk", bpm);
+
+  std::mt19937 gen(15445);
+  std::vector<std::string> pool;
+  for (int i = 0; i < 6000; i++) {
+    pool.push_back(MakeKey(&gen, 300));
+  }
+  std::uniform_int_distribution<size_t> pick(0, pool.size() - 1);
+
+  std::map<std::string, uint32_t> keys;
+  EXPECT_TRUE(Drain(&tree, nullptr, nullptr).empty());
+  for (int round = 0; round < 8; round++) {
+    for (int i = 0; i < 600; i++) {
+      auto id = static_cast<uint32_t>(pick(gen));
+      const std::string &key = pool[id];
+      bool fresh = keys.count(key) == 0;
+      EXPECT_EQ(fresh, tree.Insert(key, RID(0, id)));
+      if (fresh) {
+        keys[key] = id;
+      }
+    }
+    for (int i = 0; i < 150; i++) {
+      const std::string &key = pool[pick(gen)];
+      tree.Remove(key);
+      keys.erase(key);
+    }
+
+    std::vector<RID> rids;
+    for (int i = 0; i < 200; i++) {
+      const std::string &key = pool[pick(gen)];
+      rids.clear();
+      auto it = keys.find(key);
+      ASSERT_EQ(it != keys.end(), tree.GetValue(key, &rids));
+      if (it != keys.end()) {
+        ASSERT_EQ(1, rids.size());
+        EXPECT_EQ(it->second, rids[0].GetSlotNum());
+      }
+    }
+    for (int i = 0; i < 5; i++) {
+      std::string low = pool[pick(gen)].substr(0, 30);
+      std::string high = pool[pick(gen)];
+      EXPECT_EQ(Expected(keys, &low, &high), Drain(&tree, &low, &high));
+      EXPECT_EQ(Expected(keys, &low, nullptr), Drain(&tree, &low, nullptr));
+    }
+    EXPECT_EQ(Expected(keys, nullptr, nullptr), Drain(&tree, nullptr, nullptr));
+    ExpectNoPinnedPages(bpm);
+  }
+
+  EXPECT_THROW(tree.Insert(std::string(VarlenBPlusTree::MAX_KEY_SIZE + 1, 'x'), RID(0, 0)), Exception);
+  EXPECT_TRUE(tree.Insert(std::string(VarlenBPlusTree::MAX_KEY_SIZE, 'x'), RID(0, 0)));
+  ExpectNoPinnedPages(bpm);
+
+  delete bpm;
+  delete disk_manager;
+  remove("varlen_b_plus_tree_test.db");
+  remove("varlen_b_plus_tree_test.log");
+}
+
+TEST(VarlenBPlusTreeTest, DuplicateKeyTest) {
+  auto *disk_manager = new DiskManager("varlen_b_plus_tree_test.db");
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  VarlenBPlusTree tree("foo_idx", bpm, false);
+
+  std::mt19937 gen(15445);
+  std::set<std::string> unique_keys;
+  while (unique_keys.size() < 40) {
+    unique_keys.insert(MakeKey(&gen, 60));
+  }
+  std::vector<std::string> keys(unique_keys.begin(), unique_keys.end());
+  // RIDs of each key, as RID::Get() which sorts like RIDs do
+  std::vector<std::set<int64_t>> expected(keys.size());
+  std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+  std::uniform_int_distribution<int> page(0, 50);
+  std::uniform_int_distribution<uint32_t> slot(0, 100);
+  for (int i = 0; i < 4000; i++) {
+    size_t k = pick(gen);
+    RID rid(page(gen), slot(gen));
+    EXPECT_EQ(expected[k].insert(rid.Get()).second, tree.Insert(keys[k], rid));
+  }
+  for (int i = 0; i < 3000; i++) {
+    size_t k = pick(gen);
+    RID rid(page(gen), slot(gen));
+    expected[k].erase(rid.Get());
+    tree.Remove(keys[k], rid);
+  }
+
+  for (size_t k = 0; k < keys.size(); k++) {
+    std::vector<RID> rids;
+    EXPECT_EQ(!expected[k].empty(), tree.GetValue(keys[k], &rids));
+    std::vector<int64_t> found;
+    for (const auto &rid : rids) {
+      found.push_back(rid.Get());
+    }
+    EXPECT_EQ(std::vector<int64_t>(expected[k].begin(), expected[k].end()), found);
+  }
+  ExpectNoPinnedPages(bpm);
+
+  delete bpm;
+  delete disk_manager;
+  remove("varlen_b_plus_tree_test.db");
+  remove("varlen_b_plus_tree_test.log");
+}
+
+TEST(VarlenBPlusTreeTest, CatalogIndexTest) {
+  auto disk_manager = std::make_unique<DiskManager>("varlen_b_plus_tree_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  Schema schema{{Column{"id", TypeId::INTEGER}, Column{"name", TypeId::VARCHAR, 128}}};
+  auto *table_info = catalog->CreateTable(txn.get(), "t", schema);
+  std::vector<std::string> names{"carol", "alice", "bob", "alice", "dave"};
+  for (size_t i = 0; i < names.size(); i++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(names[i])}, &schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn.get()));
+  }
+
+  Schema key_schema{{Column{"name", TypeId::VARCHAR, 128}}};
+  auto *index_info =
+      catalog->CreateIndex(txn.get(), "name_idx", "t", schema, key_schema, {1}, 128, IndexType::BPlusTreeIndex);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+  ASSERT_NE(nullptr, dynamic_cast<VarlenBPlusTreeIndex *>(index_info->index_.get()));
+
+  std::vector<RID> rids;
+  index_info->index_->ScanKey(Tuple{{ValueFactory::GetVarcharValue("alice")}, &key_schema}, &rids, txn.get());
+  EXPECT_EQ(2, rids.size());
+
+  Tuple low{{ValueFactory::GetVarcharValue("b")}, &key_schema};
+  auto scan = index_info->index_->ScanRange(&low, nullptr, false, txn.get());
+  ASSERT_NE(nullptr, scan);
+  rids.clear();
+  while (scan->NextBatch(&rids)) {
+  }
+  std::vector<std::string> scanned;
+  for (const auto &rid : rids) {
+    Tuple tuple;
+    ASSERT_TRUE(table_info->table_->GetTuple(rid, &tuple, txn.get()));
+    scanned.push_back(tuple.GetValue(&schema, 1).ToString());
+  }
+  EXPECT_EQ((std::vector<std::string>{"bob", "carol", "dave"}), scanned);
+
+  remove("varlen_b_plus_tree_test.db");
+  remove("varlen_b_plus_tree_test.log");
+}
+
+TEST(VarlenBPlusTreeTest, DISABLED_PaddedKeyBenchmark) {
+  // keys must fit a GenericKey<64> along with 17 bytes of tuple overhead, so suffixes stay short
+  const size_t num_keys = 50000;
+  std::mt19937 gen(15445);
+  std::set<std::string> unique_keys;
+  while (unique_keys.size() < num_keys) {
+    unique_keys.insert(MakeKey(&gen, 10));
+  }
+  std::vector<std::string> keys(unique_keys.begin(), unique_keys.end());
+  std::shuffle(keys.begin(), keys.end(), gen);
+
+  Schema key_schema{{Column{"url", TypeId::VARCHAR, 56}}};
+  std::vector<Tuple> tuples;
+  for (const auto &key : keys) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetVarcharValue(key)}, &key_schema);
+  }
+
+  using Clock = std::chrono::steady_clock;
+  auto elapsed_ms = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  };
+
+  {
+    auto *disk_manager = new DiskManager("varlen_b_plus_tree_test.db");
+    auto *bpm = new CountingBufferPoolManager(4096, disk_manager);
+    GenericComparator<64> comparator(&key_schema);
+    // node sizes are capped at what fits a page
+    BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("padded", bpm, comparator, PAGE_SIZE, PAGE_SIZE,
+                                                                INVALID_PAGE_ID);
+    std::vector<GenericKey<64>> index_keys(tuples.size());
+    for (size_t i = 0; i < tuples.size(); i++) {
+      index_keys[i].SetFromKey(tuples[i], key_schema);
+      tree.Insert(index_keys[i], RID(0, i));
+    }
+    auto start = Clock::now();
+    std::vector<RID> rids;
+    for (const auto &key : index_keys) {
+      tree.GetValue(key, &rids);
+    }
+    std::cout << "GenericKey<64>: " << bpm->new_pages_ << " pages, " << elapsed_ms(start) << " ms for "
+              << index_keys.size() << " lookups" << std::endl;
+    EXPECT_EQ(index_keys.size(), rids.size());
+    delete bpm;
+    delete disk_manager;
+  }
+
+  {
+    auto *disk_manager = new DiskManager("varlen_b_plus_tree_test.db");
+    auto *bpm = new CountingBufferPoolManager(4096, disk_manager);
+    VarlenBPlusTree tree("varlen", bpm);
+    std::vector<std::string> index_keys(tuples.size());
+    for (size_t i = 0; i < tuples.size(); i++) {
+      VarlenKey::Encode(tuples[i], key_schema, &index_keys[i]);
+      tree.Insert(index_keys[i], RID(0, i));
+    }
+    auto start = Clock::now();
+    std::vector<RID> rids;
+    for (const auto &key : index_keys) {
+      tree.GetValue(key, &rids);
+    }
+    std::cout << "VarlenBPlusTree: " << bpm->new_pages_ << " pages, " << elapsed_ms(start) << " ms for "
+              << index_keys.size() << " lookups" << std::endl;
+    EXPECT_EQ(index_keys.size(), rids.size());
+    delete bpm;
+    delete disk_manager;
+  }
+
+  remove("varlen_b_plus_tree_test.db");
+  remove("varlen_b_plus_tree_test.log");
+}
+
+}  // namespace bustub